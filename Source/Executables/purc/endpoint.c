@@ -1320,6 +1320,97 @@ static int on_update(pcmcth_renderer* rdr, pcmcth_endpoint* endpoint,
     return update_dom(rdr, endpoint, msg, PCRDR_K_OPERATION_UPDATE);
 }
 
+static int update_dom_by_op(pcmcth_renderer* rdr, pcmcth_endpoint* endpoint,
+        pcmcth_udom *dom, purc_variant_t op_info)
+{
+    purc_variant_t v;
+    const char *operation = NULL;
+    const char *element_value = NULL;
+    const char *property = NULL;
+    purc_variant_t data = PURC_VARIANT_INVALID;
+
+    if ((v = purc_variant_object_get_by_ckey(op_info, "operation")))
+        operation = purc_variant_get_string_const(v);
+    if ((v = purc_variant_object_get_by_ckey(op_info, "element")))
+        element_value = purc_variant_get_string_const(v);
+    if ((v = purc_variant_object_get_by_ckey(op_info, "property")))
+        property = purc_variant_get_string_const(v);
+    data = purc_variant_object_get_by_ckey(op_info, "data");
+    purc_clr_error();
+
+    unsigned int op;
+    if (operation == NULL || element_value == NULL ||
+            pcrdr_operation_from_atom(
+                pcrdr_try_operation_atom(operation), &op) == NULL ||
+            op < PCRDR_K_OPERATION_APPEND || op > PCRDR_K_OPERATION_CLEAR) {
+        return PCRDR_SC_BAD_REQUEST;
+    }
+
+    if (data != PURC_VARIANT_INVALID && !purc_variant_is_native(data)) {
+        LOG_DEBUG("Not a native entity for operation data: %p\n", data);
+        return PCRDR_SC_BAD_REQUEST;
+    }
+
+    uint64_t element_handle = strtoull(element_value, NULL, 16);
+    return rdr->cbs.update_udom(endpoint->session, dom,
+            op, element_handle, property, data);
+}
+
+static int on_batch(pcmcth_renderer* rdr, pcmcth_endpoint* endpoint,
+        const pcrdr_msg *msg)
+{
+    int retv = PCRDR_SC_OK;
+    pcmcth_udom *dom = NULL;
+    pcrdr_msg response = { };
+    size_t nr_ops;
+
+    if (msg->target == PCRDR_MSG_TARGET_DOM) {
+        dom = (pcmcth_udom *)(uintptr_t)msg->targetValue;
+    }
+    else {
+        retv = PCRDR_SC_BAD_REQUEST;
+        goto done;
+    }
+
+    if (dom == NULL) {
+        retv = PCRDR_SC_NOT_FOUND;
+        goto done;
+    }
+
+    if (msg->dataType != PCRDR_MSG_DATA_TYPE_JSON ||
+            msg->data == PURC_VARIANT_INVALID ||
+            !purc_variant_array_size(msg->data, &nr_ops)) {
+        retv = PCRDR_SC_BAD_REQUEST;
+        goto done;
+    }
+
+    if (rdr->cbs.begin_udom_batch) {
+        rdr->cbs.begin_udom_batch(endpoint->session, dom);
+    }
+
+    /* apply all operations, and report the first failure if there is any */
+    for (size_t i = 0; i < nr_ops; i++) {
+        int r = update_dom_by_op(rdr, endpoint, dom,
+                purc_variant_array_get(msg->data, i));
+        if (r != PCRDR_SC_OK && retv == PCRDR_SC_OK) {
+            retv = r;
+        }
+    }
+
+    if (rdr->cbs.end_udom_batch) {
+        rdr->cbs.end_udom_batch(endpoint->session, dom);
+    }
+
+done:
+    response.type = PCRDR_MSG_TYPE_RESPONSE;
+    response.requestId = msg->requestId;
+    response.sourceURI = PURC_VARIANT_INVALID;
+    response.retCode = retv;
+    response.resultValue = (uint64_t)(uintptr_t)dom;
+    response.dataType = PCRDR_MSG_DATA_TYPE_VOID;
+    return send_simple_response(rdr, endpoint, &response);
+}
+
 static int on_call_method(pcmcth_renderer* rdr, pcmcth_endpoint* endpoint,
         const pcrdr_msg *msg)
 {
@@ -1559,6 +1650,7 @@ static struct request_handler {
 } handlers[] = {
     { PCRDR_OPERATION_ADDPAGEGROUPS, on_add_page_groups },
     { PCRDR_OPERATION_APPEND, on_append },
+    { PCRDR_OPERATION_BATCH, on_batch },
     { PCRDR_OPERATION_CALLMETHOD, on_call_method },
     { PCRDR_OPERATION_CLEAR, on_clear },
     { PCRDR_OPERATION_CREATEPLAINWINDOW, on_create_plain_window },
@@ -59,7 +59,8 @@
     FOIL_RDR_NAME ":" PURC_VERSION_STRING "\n" \
     "HTML:5.3\n" \
     "workspace:0/tabbedWindow:-1/plainWindow:-1/widgetInTabbedWindow:8\n" \
-    "DOMElementSelectors:handle"
+    "DOMElementSelectors:handle\n" \
+    "batchOperations:64"
 
 enum {
     FOIL_TERM_MODE_LINE = 0,
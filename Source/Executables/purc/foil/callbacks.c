@@ -579,6 +579,22 @@ failed:
     return retv;
 }
 
+static void foil_begin_udom_batch(pcmcth_session *sess, pcmcth_udom *udom)
+{
+    int retv;
+    if ((udom = validate_udom(sess, udom, &retv))) {
+        foil_udom_begin_batch(udom);
+    }
+}
+
+static void foil_end_udom_batch(pcmcth_session *sess, pcmcth_udom *udom)
+{
+    int retv;
+    if ((udom = validate_udom(sess, udom, &retv))) {
+        foil_udom_end_batch(udom);
+    }
+}
+
 static purc_variant_t
 foil_call_method_in_session(pcmcth_session *sess,
             pcrdr_msg_target target, uint64_t target_value,
@@ -743,6 +759,8 @@ void foil_set_renderer_callbacks(pcmcth_renderer *rdr)
     rdr->cbs.register_crtn = foil_register_crtn;
     rdr->cbs.revoke_crtn = foil_revoke_crtn;
     rdr->cbs.update_udom = foil_update_udom;
+    rdr->cbs.begin_udom_batch = foil_begin_udom_batch;
+    rdr->cbs.end_udom_batch = foil_end_udom_batch;
     rdr->cbs.call_method_in_udom = foil_call_method_in_udom;
     rdr->cbs.call_method_in_session = foil_call_method_in_session;
     rdr->cbs.get_property_in_udom = foil_get_property_in_udom;
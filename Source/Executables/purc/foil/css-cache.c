@@ -0,0 +1,335 @@
+/*
+** @file css-cache.c
+** @date 2026/10/17
+** @brief The implementation of the cache of parsed style sheets.
+**
+** Copyright (C) 2026 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of purc, which is an HVML interpreter with
+** a command line interface (CLI).
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "css-cache.h"
+#include "util/list.h"
+
+#include <glib.h>
+#include <string.h>
+#include <assert.h>
+
+/* The pages of all workspaces are rendered by the renderer thread, so the
+   cache is shared by all uDOMs without locking. */
+
+struct css_cache_entry {
+    /* the node in the list of unused entries if `refc` is zero */
+    struct list_head ln;
+
+    css_stylesheet *sheet;
+    unsigned refc;
+    guint hash;
+
+    /* the parameters and the source of the style sheet */
+    css_language_level level;
+    bool allow_quirks;
+    bool inline_style;
+    char *charset;
+    char *url;
+    char *title;
+    css_url_resolution_fn resolve;
+
+    char *css;
+    size_t len;
+    size_t sz_memory;
+};
+
+static struct css_cache {
+    /* the entries keyed by their parameters and sources */
+    GHashTable *entries;
+    /* the entries keyed by their style sheets */
+    GHashTable *sheets;
+    /* the unused entries of the style sheets, and the ones of
+       the `style` attributes; the most recently used one first */
+    struct list_head unused[2];
+    size_t nr_unused[2];
+    foil_css_cache_stats stats;
+} css_cache;
+
+static guint
+hash_bytes(guint hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    /* FNV-1a */
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static guint
+hash_str(guint hash, const char *str)
+{
+    return str ? hash_bytes(hash, str, strlen(str) + 1) : hash;
+}
+
+static guint
+hash_entry(gconstpointer key)
+{
+    return ((const struct css_cache_entry *)key)->hash;
+}
+
+static inline bool
+equal_str(const char *a, const char *b)
+{
+    return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static gboolean
+equal_entries(gconstpointer a, gconstpointer b)
+{
+    const struct css_cache_entry *x = a;
+    const struct css_cache_entry *y = b;
+
+    return x->hash == y->hash && x->len == y->len &&
+        x->level == y->level && x->allow_quirks == y->allow_quirks &&
+        x->inline_style == y->inline_style && x->resolve == y->resolve &&
+        equal_str(x->charset, y->charset) && equal_str(x->url, y->url) &&
+        equal_str(x->title, y->title) && memcmp(x->css, y->css, x->len) == 0;
+}
+
+static void
+make_key(struct css_cache_entry *key, const css_stylesheet_params *params,
+        const char *css, size_t len)
+{
+    memset(key, 0, sizeof(*key));
+    key->level = params->level;
+    key->allow_quirks = params->allow_quirks;
+    key->inline_style = params->inline_style;
+    key->charset = (char *)params->charset;
+    key->url = (char *)params->url;
+    key->title = (char *)params->title;
+    key->resolve = params->resolve;
+    key->css = (char *)css;
+    key->len = len;
+
+    guint hash = 2166136261U;
+    hash = hash_bytes(hash, &key->level, sizeof(key->level));
+    hash = hash_bytes(hash, &key->allow_quirks, sizeof(key->allow_quirks));
+    hash = hash_bytes(hash, &key->inline_style, sizeof(key->inline_style));
+    hash = hash_str(hash, key->charset);
+    hash = hash_str(hash, key->url);
+    hash = hash_str(hash, key->title);
+    key->hash = hash_bytes(hash, css, len);
+}
+
+static void
+entry_delete(struct css_cache_entry *entry)
+{
+    assert(entry->refc == 0);
+
+    css_cache.stats.nr_sheets--;
+    css_cache.stats.sz_memory -= entry->sz_memory;
+
+    css_stylesheet_destroy(entry->sheet);
+    free(entry->charset);
+    free(entry->url);
+    free(entry->title);
+    free(entry->css);
+    free(entry);
+}
+
+static const size_t max_unused[2] = {
+    FOIL_CSS_CACHE_MAX_UNUSED,
+    FOIL_CSS_CACHE_MAX_UNUSED_INLINE,
+};
+
+static void
+remove_entry(struct css_cache_entry *entry)
+{
+    list_del(&entry->ln);
+    css_cache.nr_unused[entry->inline_style]--;
+    css_cache.stats.nr_unused--;
+
+    g_hash_table_remove(css_cache.sheets, entry->sheet);
+    g_hash_table_remove(css_cache.entries, entry);
+    entry_delete(entry);
+}
+
+int foil_css_cache_init(void)
+{
+    css_cache.entries = g_hash_table_new(hash_entry, equal_entries);
+    css_cache.sheets = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (int i = 0; i < 2; i++) {
+        INIT_LIST_HEAD(&css_cache.unused[i]);
+        css_cache.nr_unused[i] = 0;
+    }
+    memset(&css_cache.stats, 0, sizeof(css_cache.stats));
+
+    return (css_cache.entries && css_cache.sheets) ? 0 : -1;
+}
+
+void foil_css_cache_cleanup(void)
+{
+    struct css_cache_entry *entry, *tmp;
+
+    for (int i = 0; i < 2; i++) {
+        list_for_each_entry_safe(entry, tmp, &css_cache.unused[i], ln) {
+            remove_entry(entry);
+        }
+    }
+
+    if (css_cache.stats.nr_sheets > 0) {
+        LOG_WARN("%u style sheets are still in use\n",
+                (unsigned)css_cache.stats.nr_sheets);
+    }
+
+    LOG_DEBUG("CSS cache: %u hits, %u misses\n",
+            (unsigned)css_cache.stats.nr_hits,
+            (unsigned)css_cache.stats.nr_misses);
+
+    if (css_cache.entries) {
+        g_hash_table_destroy(css_cache.entries);
+        css_cache.entries = NULL;
+    }
+
+    if (css_cache.sheets) {
+        g_hash_table_destroy(css_cache.sheets);
+        css_cache.sheets = NULL;
+    }
+}
+
+static css_stylesheet *
+parse_stylesheet(const css_stylesheet_params *params,
+        const char *css, size_t len)
+{
+    css_stylesheet *sheet;
+    css_error err;
+
+    err = css_stylesheet_create(params, &sheet);
+    if (err != CSS_OK) {
+        LOG_ERROR("Failed to create style sheet: %d\n", err);
+        return NULL;
+    }
+
+    err = css_stylesheet_append_data(sheet, (const unsigned char *)css, len);
+    if (err != CSS_OK && err != CSS_NEEDDATA) {
+        LOG_ERROR("Failed to append data to style sheet: %d\n", err);
+        css_stylesheet_destroy(sheet);
+        return NULL;
+    }
+
+    css_stylesheet_data_done(sheet);
+    return sheet;
+}
+
+css_stylesheet *foil_css_cache_get(const css_stylesheet_params *params,
+        const char *css, size_t len)
+{
+    struct css_cache_entry key, *entry;
+
+    make_key(&key, params, css, len);
+    entry = g_hash_table_lookup(css_cache.entries, &key);
+    if (entry) {
+        if (entry->refc == 0) {
+            list_del_init(&entry->ln);
+            css_cache.nr_unused[entry->inline_style]--;
+            css_cache.stats.nr_unused--;
+        }
+
+        entry->refc++;
+        css_cache.stats.nr_hits++;
+        return entry->sheet;
+    }
+
+    css_stylesheet *sheet = parse_stylesheet(params, css, len);
+    if (sheet == NULL)
+        return NULL;
+
+    css_cache.stats.nr_misses++;
+    entry = malloc(sizeof(*entry));
+    if (entry == NULL)
+        goto failed;
+
+    *entry = key;
+    INIT_LIST_HEAD(&entry->ln);
+    entry->sheet = sheet;
+    entry->refc = 1;
+    entry->charset = key.charset ? strdup(key.charset) : NULL;
+    entry->url = key.url ? strdup(key.url) : NULL;
+    entry->title = key.title ? strdup(key.title) : NULL;
+    entry->css = malloc(len + 1);
+    if ((key.charset && entry->charset == NULL) ||
+            (key.url && entry->url == NULL) ||
+            (key.title && entry->title == NULL) || entry->css == NULL) {
+        free(entry->charset);
+        free(entry->url);
+        free(entry->title);
+        free(entry->css);
+        free(entry);
+        goto failed;
+    }
+
+    memcpy(entry->css, css, len);
+    entry->css[len] = 0;
+
+    size_t sz_sheet = 0;
+    css_stylesheet_size(sheet, &sz_sheet);
+    entry->sz_memory = sizeof(*entry) + sz_sheet + len + 1;
+
+    g_hash_table_insert(css_cache.entries, entry, entry);
+    g_hash_table_insert(css_cache.sheets, sheet, entry);
+    css_cache.stats.nr_sheets++;
+    css_cache.stats.sz_memory += entry->sz_memory;
+    return sheet;
+
+failed:
+    /* still usable, but not shared */
+    LOG_WARN("Failed to cache style sheet; memory exhausted\n");
+    return sheet;
+}
+
+void foil_css_cache_release(css_stylesheet *sheet)
+{
+    struct css_cache_entry *entry;
+
+    entry = g_hash_table_lookup(css_cache.sheets, sheet);
+    if (entry == NULL) {
+        css_stylesheet_destroy(sheet);
+        return;
+    }
+
+    assert(entry->refc > 0);
+    if (--entry->refc > 0)
+        return;
+
+    /* the least recently used one is evicted */
+    int i = entry->inline_style;
+    list_add(&entry->ln, &css_cache.unused[i]);
+    css_cache.nr_unused[i]++;
+    css_cache.stats.nr_unused++;
+    if (css_cache.nr_unused[i] > max_unused[i]) {
+        entry = list_last_entry(&css_cache.unused[i],
+                struct css_cache_entry, ln);
+        remove_entry(entry);
+    }
+}
+
+void foil_css_cache_get_stats(foil_css_cache_stats *stats)
+{
+    *stats = css_cache.stats;
+}
+
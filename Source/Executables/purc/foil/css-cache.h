@@ -0,0 +1,74 @@
+/*
+ * @file css-cache.h
+ * @date 2026/10/17
+ * @brief The header for the cache of parsed style sheets.
+ *
+ * Copyright (C) 2026 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of purc, which is an HVML interpreter with
+ * a command line interface (CLI).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef purc_foil_css_cache_h
+#define purc_foil_css_cache_h
+
+#include "foil.h"
+
+#include <csseng/csseng.h>
+
+/* the number of style sheets kept in the cache after the last user
+   released them */
+#define FOIL_CSS_CACHE_MAX_UNUSED           16
+
+/* the same for the style sheets of `style` attributes, which are many
+   and small */
+#define FOIL_CSS_CACHE_MAX_UNUSED_INLINE    256
+
+typedef struct foil_css_cache_stats {
+    /* the number of style sheets in the cache */
+    size_t nr_sheets;
+    /* the number of style sheets no one uses */
+    size_t nr_unused;
+    /* the number of lookups satisfied by the cache */
+    size_t nr_hits;
+    /* the number of style sheets parsed */
+    size_t nr_misses;
+    /* the memory held by the style sheets and their sources in bytes */
+    size_t sz_memory;
+} foil_css_cache_stats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int foil_css_cache_init(void);
+void foil_css_cache_cleanup(void);
+
+/* Returns a parsed style sheet for the CSS text and the parameters;
+   the style sheet is shared and must not be changed. Call
+   foil_css_cache_release() when it is no longer used. */
+css_stylesheet *foil_css_cache_get(const css_stylesheet_params *params,
+        const char *css, size_t len);
+void foil_css_cache_release(css_stylesheet *sheet);
+
+void foil_css_cache_get_stats(foil_css_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* purc_foil_css_cache_h */
+
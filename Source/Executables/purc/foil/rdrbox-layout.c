@@ -1955,6 +1955,49 @@ void foil_rdrbox_pre_layout(foil_layout_ctxt *ctxt, foil_rdrbox *box)
 
 }
 
+static void update_inherited_used_values(foil_rdrbox *box)
+{
+    foil_rdrbox *child = box->first;
+    while (child) {
+        if (child->is_pseudo && child->principal) {
+            inherit_used_values(child, child->principal);
+        }
+        else if (child->is_anonymous) {
+            foil_rdrbox *from = NULL;
+            if (child->type == FOIL_RDRBOX_TYPE_BLOCK) {
+                from = find_enclosing_container(child);
+            }
+            else if (child->type == FOIL_RDRBOX_TYPE_INLINE) {
+                from = child->parent;
+            }
+
+            if (from)
+                inherit_used_values(child, from);
+            update_inherited_used_values(child);
+        }
+
+        child = child->next;
+    }
+}
+
+/* Determines the used values of a box whose style changed without changing
+   its layout, unlike foil_rdrbox_pre_layout(), only the box and the
+   anonymous and pseudo boxes inheriting from it are updated. */
+void foil_rdrbox_update_used_values(foil_layout_ctxt *ctxt, foil_rdrbox *box)
+{
+    if (!box->is_pseudo && !box->is_anonymous && box->computed_style) {
+        dtmr_sizing_properties(ctxt, box);
+        dtmr_border_properties(ctxt, box);
+    }
+
+    if (box->type == FOIL_RDRBOX_TYPE_LIST_ITEM &&
+            box->list_item_data->marker_box) {
+        inherit_used_values(box->list_item_data->marker_box, box);
+    }
+
+    update_inherited_used_values(box);
+}
+
 void foil_rdrbox_resolve_width(foil_layout_ctxt *ctxt, foil_rdrbox *box)
 {
     assert(box->is_width_resolved == 0);
@@ -401,6 +401,12 @@ struct foil_rdrbox {
     uint32_t is_height_resolved:1;
     // Indicates that the computed z-index value is `auto`.
     uint32_t is_zidx_auto:1;
+    // Indicates that the used values of the box need to be determined again.
+    uint32_t is_style_dirty:1;
+    // Indicates that the subtree of the box needs to be laid out again.
+    uint32_t is_size_dirty:1;
+    // Indicates that some boxes in the subtree are dirty.
+    uint32_t has_dirty_desc:1;
 
     /* Used values of non-inherited properties */
     uint32_t type:4;
@@ -692,6 +698,7 @@ void foil_rdrbox_dump(const foil_rdrbox *box,
         purc_document_t doc, unsigned level);
 
 void foil_rdrbox_pre_layout(foil_layout_ctxt *ctxt, foil_rdrbox *box);
+void foil_rdrbox_update_used_values(foil_layout_ctxt *ctxt, foil_rdrbox *box);
 void foil_rdrbox_resolve_width(foil_layout_ctxt *ctxt, foil_rdrbox *box);
 void foil_rdrbox_resolve_height(foil_layout_ctxt *ctxt, foil_rdrbox *box);
 
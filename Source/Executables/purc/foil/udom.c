@@ -30,6 +30,7 @@
 #include "widget.h"
 #include "rdrbox.h"
 #include "rdrbox-internal.h"
+#include "css-cache.h"
 #include "util/sorted-array.h"
 #include "util/list.h"
 #include "unicode/unicode.h"
@@ -141,6 +142,11 @@ int foil_udom_module_init(pcmcth_renderer *rdr)
     if (foil_rdrbox_module_init(rdr))
         return -1;
 
+    if (foil_css_cache_init()) {
+        LOG_ERROR("Failed to initialize the style sheet cache\n");
+        return -1;
+    }
+
     css_stylesheet_params params;
     css_error err;
 
@@ -187,6 +193,7 @@ void foil_udom_module_cleanup(pcmcth_renderer *rdr)
     if (def_ua_sheet)
         css_stylesheet_destroy(def_ua_sheet);
 
+    foil_css_cache_cleanup();
     foil_rdrbox_module_cleanup(rdr);
 }
 
@@ -215,7 +222,7 @@ static void udom_cleanup(pcmcth_udom *udom)
     if (udom->base)
         pcutils_broken_down_url_delete(udom->base);
     if (udom->author_sheet)
-        css_stylesheet_destroy(udom->author_sheet);
+        foil_css_cache_release(udom->author_sheet);
     if (udom->select_ctx)
         css_select_ctx_destroy(udom->select_ctx);
     if (udom->root_stk_ctxt) {
@@ -358,7 +365,14 @@ pcmcth_udom *foil_udom_from_rdrbox(foil_rdrbox *box)
     return root->udom;
 }
 
-static void load_css(struct pcmcth_udom *udom, const char *href)
+/* the context to collect the author-defined style sheet in the head */
+struct head_walker_ctxt {
+    struct pcmcth_udom *udom;
+    GString *css;
+};
+
+static void load_css(struct pcmcth_udom *udom, GString *css_text,
+        const char *href)
 {
     char *css = NULL;
     size_t length;
@@ -403,13 +417,7 @@ static void load_css(struct pcmcth_udom *udom, const char *href)
     }
 
     if (css) {
-        css_error err;
-        err = css_stylesheet_append_data(udom->author_sheet,
-                (const unsigned char *)css, length);
-        if (err != CSS_OK && err != CSS_NEEDDATA) {
-            LOG_WARN("Failed to append css data from file: %d\n", err);
-        }
-
+        g_string_append_len(css_text, css, length);
         free(css);
     }
 }
@@ -435,7 +443,8 @@ head_walker(purc_document_t doc, pcdoc_element_t element, void *ctxt)
     size_t len;
     char *css_href = NULL;
 
-    struct pcmcth_udom *udom = (struct pcmcth_udom *)ctxt;
+    struct head_walker_ctxt *walker = (struct head_walker_ctxt *)ctxt;
+    struct pcmcth_udom *udom = walker->udom;
     pcdoc_element_get_tag_name(doc, element, &name, &len,
             NULL, NULL, NULL, NULL);
 
@@ -480,7 +489,7 @@ head_walker(purc_document_t doc, pcdoc_element_t element, void *ctxt)
         if (pcdoc_element_get_attribute(doc, element, ATTR_NAME_HREF,
                 &value, &len) == 0 && len > 0) {
             css_href = strndup(value, len);
-            load_css(udom, css_href);
+            load_css(udom, walker->css, css_href);
         }
     }
     else if (len == (sizeof(TAG_NAME_STYLE) - 1) &&
@@ -494,13 +503,7 @@ head_walker(purc_document_t doc, pcdoc_element_t element, void *ctxt)
 
                 if (pcdoc_text_content_get_text(doc, child.text_node,
                             &text, &len) == 0 && len > 0) {
-                    css_error err;
-                    err = css_stylesheet_append_data(udom->author_sheet,
-                            (const unsigned char *)text, len);
-                    if (err != CSS_OK && err != CSS_NEEDDATA) {
-                        LOG_ERROR("Failed to append css data: %d\n", err);
-                        return -1;
-                    }
+                    g_string_append_len(walker->css, text, len);
                 }
             }
 
@@ -572,22 +575,11 @@ select_element_style(const css_media *media, css_select_ctx *select_ctx,
         params.font_pw = NULL;
 #endif
 
-        err = css_stylesheet_create(&params, &inline_sheet);
-        if (err == CSS_OK) {
-            err = css_stylesheet_append_data(inline_sheet,
-                    (const unsigned char *)value, len);
-            if (err == CSS_OK || err == CSS_NEEDDATA) {
-                css_stylesheet_data_done(inline_sheet);
-            }
-            else {
-                LOG_WARN("Failed to append data to inline style sheet: %d\n",
-                        err);
-                css_stylesheet_destroy(inline_sheet);
-                inline_sheet = NULL;
-            }
-        }
-        else {
-            LOG_WARN("Failed to create inline style sheet: %d\n", err);
+        /* the same inline styles are usually used by many elements,
+           and are selected again on every restyle */
+        inline_sheet = foil_css_cache_get(&params, value, len);
+        if (inline_sheet == NULL) {
+            LOG_WARN("Failed to create inline style sheet\n");
         }
     }
 
@@ -656,13 +648,13 @@ select_element_style(const css_media *media, css_select_ctx *select_ctx,
     }
 
     if (inline_sheet) {
-        css_stylesheet_destroy(inline_sheet);
+        foil_css_cache_release(inline_sheet);
     }
     return result;
 
 failed:
     if (inline_sheet) {
-        css_stylesheet_destroy(inline_sheet);
+        foil_css_cache_release(inline_sheet);
     }
 
     if (result) {
@@ -1241,25 +1233,28 @@ foil_udom_load_edom(pcmcth_page *page, purc_variant_t edom, int *retv)
         params.title = "foo";
         params.resolve = resolve_url;
 
-        err = css_stylesheet_create(&params, &udom->author_sheet);
-        if (err != CSS_OK) {
-            *retv = PCRDR_SC_INSUFFICIENT_STORAGE;
-            LOG_ERROR("Failed to create default user agent sheet: %d\n", err);
-            goto failed;
-        }
-
+        /* the pages of an app usually share the same style sheets,
+           so the parsed ones are shared by all uDOMs */
+        struct head_walker_ctxt walker = { udom, g_string_new(NULL) };
         size_t n;
         pcdoc_travel_descendant_elements(edom_doc, head, head_walker,
-                udom, &n);
+                &walker, &n);
+
+        if (walker.css->len > 0) {
+            udom->author_sheet = foil_css_cache_get(&params,
+                    walker.css->str, walker.css->len);
+        }
+        g_string_free(walker.css, TRUE);
 
-        size_t sz;
-        css_stylesheet_size(udom->author_sheet, &sz);
+        size_t sz = 0;
+        if (udom->author_sheet)
+            css_stylesheet_size(udom->author_sheet, &sz);
         if (sz == 0) {
-            css_stylesheet_destroy(udom->author_sheet);
+            if (udom->author_sheet)
+                foil_css_cache_release(udom->author_sheet);
             udom->author_sheet = NULL;
         }
         else {
-            css_stylesheet_data_done(udom->author_sheet);
             err = css_select_ctx_append_sheet(udom->select_ctx,
                     udom->author_sheet, CSS_ORIGIN_AUTHOR, NULL);
             if (err != CSS_OK) {
@@ -1416,6 +1411,10 @@ static void reset_rdrbox_layout_info(pcmcth_udom *udom, foil_rdrbox *box)
     box->ml = box->mt = box->mr = box->mb = 0;
     box->pl = box->pt = box->pr = box->pb = 0;
     foil_rect_set(&box->ctnt_rect, 0, 0, 0, 0);
+    /* the used values are determined again by the pre-layout */
+    box->is_style_dirty = 0;
+    box->is_size_dirty = 0;
+    box->has_dirty_desc = 0;
 }
 
 #define COMP_AND_UPDATE_CRUX(prop)                                            \
@@ -1726,10 +1725,173 @@ static struct foil_rdrbox *get_rdrbox_container(pcmcth_udom *udom,
     return container;
 }
 
+static void fit_page_to_initial_cblock(pcmcth_udom *udom)
+{
+    int cols = udom->initial_cblock->width / FOIL_PX_GRID_CELL_W;
+    int rows = udom->initial_cblock->height / FOIL_PX_GRID_CELL_H;
+
+    if (rows > udom->page->rows || cols > udom->page->cols) {
+        foil_page_set_row_col(udom->page, cols, rows);
+    }
+}
+
+/* Whether the height of the box is the height of its children in flow. */
+static bool is_height_from_children(const foil_rdrbox *box)
+{
+    if (box->is_initial || (box->is_anonymous && box->is_block_level))
+        return true;
+
+    if (box->computed_style == NULL || box->is_replaced ||
+            !box->is_block_level || !box->is_in_normal_flow ||
+            (box->overflow_y != FOIL_RDRBOX_OVERFLOW_VISIBLE &&
+             box->overflow_y != FOIL_RDRBOX_OVERFLOW_VISIBLE_PROPAGATED) ||
+            box->prop_for_height != FOIL_RDRBOX_USE_HEIGHT ||
+            box->min_height > 0 || box->max_height > 0)
+        return false;
+
+    css_fixed length;
+    css_unit unit;
+    return css_computed_height(box->computed_style, &length, &unit) ==
+        CSS_HEIGHT_AUTO;
+}
+
+/* Whether the box is stacked in its parent from top to bottom, so that
+   a change of its height only moves the boxes following it. */
+static bool is_stacked_in_parent(const foil_rdrbox *box)
+{
+    const foil_rdrbox *parent = box->parent;
+
+    return parent && box->is_block_level && box->is_in_normal_flow &&
+        !box->floating && !box->is_abs_positioned &&
+        parent->is_block_container && parent->nr_inline_level_children == 0 &&
+        parent->nr_floating_children == 0 && parent->nr_abspos_children == 0;
+}
+
+/* Whether the boxes in the subtree are positioned relative to the subtree;
+   they can be moved without laying them out again. */
+static bool is_movable_deep(const foil_rdrbox *box)
+{
+    if (box->is_size_dirty || box->has_dirty_desc || box->is_abs_positioned ||
+            box->position == FOIL_RDRBOX_POSITION_FIXED)
+        return false;
+
+    for (const foil_rdrbox *child = box->first; child; child = child->next) {
+        if (!is_movable_deep(child))
+            return false;
+    }
+
+    return true;
+}
+
+/* Moves the boxes and the lines laid out in a box; this follows
+   layout_rdrtree(), which positions them. */
+static void move_laid_boxes(foil_rdrbox *box, int dx, int dy)
+{
+    if ((box->is_block_level || box->is_block_container) &&
+            box->nr_inline_level_children > 0) {
+        struct _inline_fmt_ctxt *fmt_ctxt = foil_rdrbox_inline_fmt_ctxt(box);
+        for (size_t i = 0; fmt_ctxt && i < fmt_ctxt->nr_lines; i++) {
+            struct _line_info *line = fmt_ctxt->lines + i;
+
+            foil_rect_offset(&line->rc, dx, dy);
+            for (size_t j = 0; j < line->nr_runs; j++) {
+                struct _inline_runbox *run = line->runs + j;
+
+                foil_rect_offset(&run->rc, dx, dy);
+                if (run->box->is_block_container || run->box->is_replaced)
+                    foil_rect_offset(&run->box->ctnt_rect, dx, dy);
+            }
+        }
+    }
+
+    if ((box->is_block_level && box->nr_inline_level_children > 0) ||
+            box->is_block_container) {
+        bool lay_blocks = !(box->is_block_level &&
+                box->nr_inline_level_children > 0);
+
+        for (foil_rdrbox *child = box->first; child; child = child->next) {
+            if (lay_blocks && child->is_block_level)
+                foil_rect_offset(&child->ctnt_rect, dx, dy);
+            move_laid_boxes(child, dx, dy);
+        }
+    }
+
+    if (box->type == FOIL_RDRBOX_TYPE_LIST_ITEM &&
+            box->list_item_data->marker_box) {
+        foil_rect_offset(&box->list_item_data->marker_box->ctnt_rect, dx, dy);
+    }
+}
+
+/* Absorbs the change of the height of a box which has been sized again by
+   moving the boxes following it and its ancestors, instead of laying out
+   the container again. Stops at the first ancestor whose size does not
+   change. Returns the ancestor, or NULL if the container has to be
+   laid out again. */
+static foil_rdrbox *absorb_height_change(foil_layout_ctxt *ctxt,
+        foil_rdrbox *rdrbox, const foil_rect *origin_rc)
+{
+    int dy = rdrbox->height - foil_rect_height(origin_rc);
+    foil_rdrbox *box, *top = NULL;
+
+    for (box = rdrbox; top == NULL; box = box->parent) {
+        if (!is_stacked_in_parent(box))
+            return NULL;
+
+        for (foil_rdrbox *next = box->next; next; next = next->next) {
+            if (!is_movable_deep(next))
+                return NULL;
+        }
+
+        if (!is_height_from_children(box->parent) || box->parent->is_initial)
+            top = box->parent;
+    }
+
+    foil_rect_set(&rdrbox->ctnt_rect, origin_rc->left, origin_rc->top,
+            origin_rc->left + rdrbox->width, origin_rc->top + rdrbox->height);
+    layout_rdrtree(ctxt, rdrbox);
+
+    for (box = rdrbox; box != top; box = box->parent) {
+        for (foil_rdrbox *next = box->next; next; next = next->next) {
+            /* as foil_rdrbox_lay_block_in_container() does */
+            if (next->is_block_level)
+                foil_rect_offset(&next->ctnt_rect, 0, dy);
+            move_laid_boxes(next, 0, dy);
+        }
+
+        if (box->parent != top || top->is_initial) {
+            box->parent->height += dy;
+            box->parent->ctnt_rect.bottom += dy;
+        }
+    }
+
+    return top;
+}
+
+/* Takes back the numbers of the children counted for the box by
+   foil_rdrbox_pre_layout(), which counts them again. */
+static void uncount_in_parent(foil_rdrbox *box)
+{
+    foil_rdrbox *parent = box->parent;
+
+    if (box->floating && parent->nr_floating_children > 0)
+        parent->nr_floating_children--;
+    if (box->is_abs_positioned && parent->nr_abspos_children > 0)
+        parent->nr_abspos_children--;
+
+    if (box->is_in_normal_flow) {
+        if (box->is_inline_level && parent->nr_inline_level_children > 0)
+            parent->nr_inline_level_children--;
+        else if (box->is_block_level && parent->nr_block_level_children > 0)
+            parent->nr_block_level_children--;
+    }
+}
+
 static struct foil_rdrbox *relayout_rdrtree(struct foil_layout_ctxt *ctxt,
         struct foil_rdrbox *rdrbox, foil_rect origin_rc)
 {
 again:
+    if (rdrbox->parent)
+        uncount_in_parent(rdrbox);
     reset_rdrbox_layout_deep(ctxt->udom, rdrbox);
     if (rdrbox == ctxt->udom->initial_cblock) {
         int width = ctxt->udom->vw;
@@ -1765,9 +1927,23 @@ again:
         int h = rdrbox->height;
 
         if (ow != w || oh != h) {
-            rdrbox = get_rdrbox_container(ctxt->udom, rdrbox);
-            origin_rc = rdrbox->ctnt_rect;
-            goto again;
+            foil_rdrbox *top = NULL;
+            if (ow == w)
+                top = absorb_height_change(ctxt, rdrbox, &origin_rc);
+
+            if (top == NULL) {
+                rdrbox = get_rdrbox_container(ctxt->udom, rdrbox);
+                origin_rc = rdrbox->ctnt_rect;
+                goto again;
+            }
+
+            if (top->is_initial) {
+                fit_page_to_initial_cblock(ctxt->udom);
+                top = top->first;
+            }
+
+            erase_bg(ctxt->udom, top, top->ctnt_rect);
+            return top;
         }
 
         foil_rect_set(&rdrbox->ctnt_rect, origin_rc.left, origin_rc.top,
@@ -1778,17 +1954,66 @@ again:
     erase_bg(ctxt->udom, rdrbox, origin_rc);
 
     if (rdrbox == ctxt->udom->initial_cblock) {
-        int cols = ctxt->udom->initial_cblock->width / FOIL_PX_GRID_CELL_W;
-        int rows = ctxt->udom->initial_cblock->height / FOIL_PX_GRID_CELL_H;
-
-        if (rows > ctxt->udom->page->rows || cols > ctxt->udom->page->cols) {
-            foil_page_set_row_col(ctxt->udom->page, cols, rows);
-        }
+        fit_page_to_initial_cblock(ctxt->udom);
         rdrbox = ctxt->udom->initial_cblock->first;
     }
     return rdrbox;
 }
 
+/* Marks the box dirty and its ancestors as having dirty descendants;
+   the marks are cleared when the boxes are laid out again. */
+static void mark_rdrbox_dirty(struct foil_rdrbox *rdrbox, bool size)
+{
+    if (size)
+        rdrbox->is_size_dirty = 1;
+    else
+        rdrbox->is_style_dirty = 1;
+
+    for (foil_rdrbox *box = rdrbox->parent; box && !box->has_dirty_desc;
+            box = box->parent) {
+        box->has_dirty_desc = 1;
+    }
+}
+
+/* Visits the dirty boxes only, from the last one to the first one in
+   document order: a box relaid absorbs its change of height by moving
+   the boxes following it, which are then never dirty. */
+static void relayout_dirty_boxes(foil_layout_ctxt *ctxt, foil_rdrbox *box)
+{
+    if (box->is_size_dirty) {
+        /* this clears the marks in the subtree */
+        foil_rdrbox *rdrbox = relayout_rdrtree(ctxt, box, box->ctnt_rect);
+        foil_udom_invalidate_rdrbox(ctxt->udom, rdrbox);
+        return;
+    }
+
+    if (box->is_style_dirty) {
+        box->is_style_dirty = 0;
+        foil_rdrbox_update_used_values(ctxt, box);
+        foil_udom_invalidate_rdrbox(ctxt->udom, box);
+    }
+
+    if (box->has_dirty_desc) {
+        /* a child may lay out this box again, but does not change
+           the children of it */
+        foil_rdrbox *child = box->last;
+        while (child) {
+            foil_rdrbox *prev = child->prev;
+            relayout_dirty_boxes(ctxt, child);
+            child = prev;
+        }
+        box->has_dirty_desc = 0;
+    }
+}
+
+static void relayout_dirty_rdrtree(pcmcth_udom *udom)
+{
+    if (udom->batch_depth > 0)
+        return;
+
+    foil_layout_ctxt layout_ctxt = { udom, udom->initial_cblock };
+    relayout_dirty_boxes(&layout_ctxt, udom->initial_cblock);
+}
 
 static int on_update_style(pcmcth_udom *udom, foil_rdrbox *rdrbox,
     pcdoc_element_t ref_elem, int op)
@@ -1796,10 +2021,8 @@ static int on_update_style(pcmcth_udom *udom, foil_rdrbox *rdrbox,
     (void)ref_elem;
     (void)op;
     int r = PCRDR_SC_NOT_IMPLEMENTED;
-    foil_rdrbox *render_box = rdrbox;
     pcdoc_element *ancestor = rdrbox->owner;
     css_select_results *result = NULL;
-    foil_layout_ctxt layout_ctxt = { udom, udom->initial_cblock };
 
     result = select_element_style(&udom->media,
             udom->select_ctx, udom, ancestor,
@@ -1837,17 +2060,14 @@ static int on_update_style(pcmcth_udom *udom, foil_rdrbox *rdrbox,
     result->styles[CSS_PSEUDO_ELEMENT_NONE] = NULL;
 
     if (!crux_changed) {
-        /* sizing, border property */
-        pre_layout_rdrtree(&layout_ctxt, rdrbox);
-        goto render;
+        /* sizing, border property; the layout does not change */
+        mark_rdrbox_dirty(rdrbox, false);
+    }
+    else {
+        mark_rdrbox_dirty(get_rdrbox_container(udom, rdrbox), true);
     }
 
-    render_box = get_rdrbox_container(udom, rdrbox);
-
-    render_box = relayout_rdrtree(&layout_ctxt, render_box, render_box->ctnt_rect);
-
-render:
-    foil_udom_invalidate_rdrbox(udom, render_box);
+    relayout_dirty_rdrtree(udom);
     r = PCRDR_SC_OK;
 
 done:
@@ -1866,14 +2086,11 @@ failed:
 
 static int on_rebuild_subtree(pcmcth_udom *udom, foil_rdrbox *rdrbox)
 {
-    foil_rect orc = rdrbox->ctnt_rect;
-
+    /* the content rectangle of the box is kept until it is laid out */
     rebuild_subtree(udom, rdrbox);
+    mark_rdrbox_dirty(rdrbox, true);
 
-    foil_layout_ctxt layout_ctxt = { udom, udom->initial_cblock };
-    rdrbox = relayout_rdrtree(&layout_ctxt, rdrbox, orc);
-
-    foil_udom_invalidate_rdrbox(udom, rdrbox);
+    relayout_dirty_rdrtree(udom);
     return PCRDR_SC_OK;
 }
 
@@ -2096,6 +2313,18 @@ int foil_udom_update_rdrbox(pcmcth_udom *udom, foil_rdrbox *rdrbox,
     return r;
 }
 
+void foil_udom_begin_batch(pcmcth_udom *udom)
+{
+    udom->batch_depth++;
+}
+
+void foil_udom_end_batch(pcmcth_udom *udom)
+{
+    assert(udom->batch_depth > 0);
+    udom->batch_depth--;
+    relayout_dirty_rdrtree(udom);
+}
+
 purc_variant_t foil_udom_call_method(pcmcth_udom *udom, foil_rdrbox *rdrbox,
         const char *method, purc_variant_t arg)
 {
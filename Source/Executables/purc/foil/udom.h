@@ -83,6 +83,9 @@ struct pcmcth_udom {
 
     /* the pointer to the stacking context created by the root element */
     struct foil_stacking_context *root_stk_ctxt;
+
+    /* the depth of nested batches of updates */
+    int batch_depth;
 };
 
 typedef struct foil_stacking_context {
@@ -132,6 +135,10 @@ uint8_t foil_udom_get_langcode(purc_document_t doc, pcdoc_element_t elem);
 int foil_udom_update_rdrbox(pcmcth_udom *udom, foil_rdrbox *rdrbox,
         int op, const char *property, purc_variant_t ref_info);
 
+/* defer the relayout caused by the updates until the batch ends */
+void foil_udom_begin_batch(pcmcth_udom *udom);
+void foil_udom_end_batch(pcmcth_udom *udom);
+
 purc_variant_t foil_udom_call_method(pcmcth_udom *udom, foil_rdrbox *rdrbox,
         const char *method, purc_variant_t arg);
 
@@ -182,6 +182,10 @@ typedef struct pcmcth_rdr_cbs {
             uint64_t element_handle, const char* property,
             purc_variant_t ref_info);
 
+    /* nullable; called around the operations of a `batch` request */
+    void (*begin_udom_batch)(pcmcth_session *, pcmcth_udom *);
+    void (*end_udom_batch)(pcmcth_session *, pcmcth_udom *);
+
     /* nullable */
     purc_variant_t (*call_method_in_session)(pcmcth_session *,
             pcrdr_msg_target target, uint64_t target_value,
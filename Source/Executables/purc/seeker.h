@@ -45,7 +45,8 @@
     SEEKER_RDR_NAME ":" PURC_VERSION_STRING "\n"                             \
     "HTML:5.3\n"                                                             \
     "workspace:-1/tabbedWindow:-1/widgetInTabbedWindow:-1/plainWindow:-1"    \
-    "DOMElementSelectors:handle"
+    "DOMElementSelectors:handle\n"                                           \
+    "batchOperations:64"
 
 #ifdef __cplusplus
 extern "C" {
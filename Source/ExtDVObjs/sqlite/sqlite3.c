@@ -25,6 +25,7 @@
 //#undef NDEBUG
 
 #include <sqlite3.h>
+#include <pthread.h>
 
 #include "config.h"
 #include "private/map.h"
@@ -32,6 +33,9 @@
 #include "private/instance.h"
 #include "private/atom-buckets.h"
 #include "private/debug.h"
+#include "private/list.h"
+#include "private/interpreter.h"
+#include "purc-runloop.h"
 #include "purc-variant.h"
 #include "purc-errors.h"
 
@@ -42,6 +46,19 @@
 
 #define SQLITE_DEFAULT_TIMEOUT      5
 
+/* the number of prepared statements kept by a connection */
+#define SQLITE_STMT_CACHE_SIZE      32
+
+/* the events fired on a cursor by $SQLiteCursor.query() */
+#define SQLITE_EVENT_NAME           "sqlite"
+#define SQLITE_SUB_EVENT_ROWS       "rows"
+#define SQLITE_SUB_EVENT_DONE       "done"
+#define SQLITE_SUB_EVENT_ERROR      "error"
+
+/* the default and maximal numbers of rows in a `sqlite:rows` event */
+#define SQLITE_DEF_CHUNK_ROWS       256
+#define SQLITE_MAX_CHUNK_ROWS       65536
+
 #define STR(x)                      #x
 #define STR2(x)                     STR(x)
 #define SQLITE_DVOBJ_VERCODE_STR    STR2(SQLITE_DVOBJ_VERCODE)
@@ -62,6 +79,7 @@
 #define SQLITE_KEY_ROWCOUNT         "rowcount"
 #define SQLITE_KEY_LASTROWID        "lastrowid"
 #define SQLITE_KEY_DESCRIPTION      "description"
+#define SQLITE_KEY_QUERY            "query"
 #define SQLITE_KEY_CONNECTION       "connection"
 #define SQLITE_KEY_HANDLE           "__handle_sqlite__"
 
@@ -84,13 +102,49 @@
 struct dvobj_sqlite_info {
     purc_variant_t          root;               // the root variant, i.e., $SQLITE itself
     struct pcvar_listener   *listener;          // the listener
+
+    struct list_head        conns;              // the connections
+    struct list_head        jobs;               // the query jobs in flight
+
+    /* The chunks dispatched by the workers but not arrived yet, in the
+     * dispatching order. Every dispatched chunk holds a reference to the
+     * info, so the info outlives $SQLITE until the runloop has called back
+     * for all of them. */
+    pthread_mutex_t         pending_lock;       // guards the fields below
+    struct list_head        pending;
+    unsigned                nr_refs;
+};
+
+struct dvobj_sqlite_connection;
+
+/* A prepared statement. It is cached by the connection which prepared it
+ * and keyed by its SQL text, unless `conn` is NULL: then the statement
+ * belongs to the cursor using it and is finalized when the cursor is done
+ * with it. */
+struct dvobj_sqlite_stmt {
+    struct list_head                ln;         // node in the LRU list
+    struct dvobj_sqlite_connection  *conn;
+    sqlite3_stmt                    *st;
+    bool                            is_dml;
+    bool                            in_use;
+    size_t                          nr_sql;
+    char                            sql[0];
 };
 
+struct dvobj_sqlite_worker;
+
 struct dvobj_sqlite_connection {
     purc_variant_t              root;               // the root variant, itself
     sqlite3                     *db;
     char                        *db_name;
     struct pcvar_listener       *listener;          // the listener
+
+    struct list_head            stmts;              // the most recently used first
+    size_t                      nr_stmts;
+
+    struct dvobj_sqlite_worker  *worker;            // runs query() off-thread
+    struct dvobj_sqlite_info    *info;              // NULL if $SQLITE is gone
+    struct list_head            ln;                 // node in info->conns
 };
 
 struct dvobj_sqlite_cursor {
@@ -103,7 +157,8 @@ struct dvobj_sqlite_cursor {
     purc_variant_t                  description;        // description attr
     struct dvobj_sqlite_connection  *conn;
     struct pcvar_listener           *listener;          // the listener
-    sqlite3_stmt                    *st;
+    struct dvobj_sqlite_stmt        *stmt;
+    sqlite3_stmt                    *st;                // stmt->st or NULL
 };
 
 static bool is_conn_closed(struct dvobj_sqlite_connection *conn)
@@ -197,6 +252,99 @@ lstrip_sql(const char *sql)
     return NULL;
 }
 
+static void stmt_destroy(struct dvobj_sqlite_stmt *stmt)
+{
+    sqlite3_finalize(stmt->st);
+    free(stmt);
+}
+
+/* Finalizes the idle cached statements of a connection being closed, and
+ * hands the ones still used by cursors over to those cursors. */
+static void conn_clear_stmts(struct dvobj_sqlite_connection *conn)
+{
+    struct list_head *p, *n;
+    list_for_each_safe(p, n, &conn->stmts) {
+        struct dvobj_sqlite_stmt *stmt;
+        stmt = list_entry(p, struct dvobj_sqlite_stmt, ln);
+        list_del(&stmt->ln);
+        stmt->conn = NULL;
+        if (!stmt->in_use) {
+            stmt_destroy(stmt);
+        }
+    }
+    conn->nr_stmts = 0;
+}
+
+static struct dvobj_sqlite_stmt *
+conn_find_stmt(struct dvobj_sqlite_connection *conn, const char *sql,
+        size_t nr_sql, bool *busy)
+{
+    struct dvobj_sqlite_stmt *stmt;
+    *busy = false;
+    list_for_each_entry(stmt, &conn->stmts, ln) {
+        if (stmt->nr_sql == nr_sql && memcmp(stmt->sql, sql, nr_sql) == 0) {
+            if (stmt->in_use) {
+                *busy = true;
+                return NULL;
+            }
+
+            list_move(&stmt->ln, &conn->stmts);
+            return stmt;
+        }
+    }
+
+    return NULL;
+}
+
+static void conn_cache_stmt(struct dvobj_sqlite_connection *conn,
+        struct dvobj_sqlite_stmt *stmt)
+{
+    if (conn->nr_stmts >= SQLITE_STMT_CACHE_SIZE) {
+        struct dvobj_sqlite_stmt *p, *victim = NULL;
+        list_for_each_entry_reverse(p, &conn->stmts, ln) {
+            if (!p->in_use) {
+                victim = p;
+                break;
+            }
+        }
+
+        /* all cached statements are in use by cursors */
+        if (victim == NULL) {
+            return;
+        }
+
+        list_del(&victim->ln);
+        conn->nr_stmts--;
+        stmt_destroy(victim);
+    }
+
+    stmt->conn = conn;
+    list_add(&stmt->ln, &conn->stmts);
+    conn->nr_stmts++;
+}
+
+/* Gives the statement of the cursor back to the cache, or finalizes it
+ * if it is not cached. */
+static void cursor_release_st(struct dvobj_sqlite_cursor *cursor)
+{
+    struct dvobj_sqlite_stmt *stmt = cursor->stmt;
+    if (stmt == NULL) {
+        return;
+    }
+
+    if (stmt->conn) {
+        sqlite3_reset(stmt->st);
+        sqlite3_clear_bindings(stmt->st);
+        stmt->in_use = false;
+    }
+    else {
+        stmt_destroy(stmt);
+    }
+
+    cursor->stmt = NULL;
+    cursor->st = NULL;
+}
+
 static inline int
 cursor_create_st(struct dvobj_sqlite_cursor *cursor, const char *sql)
 {
@@ -210,6 +358,16 @@ cursor_create_st(struct dvobj_sqlite_cursor *cursor, const char *sql)
         return -1;
     }
 
+    bool busy;
+    struct dvobj_sqlite_stmt *cached = conn_find_stmt(conn, sql, size, &busy);
+    if (cached) {
+        cached->in_use = true;
+        cursor->stmt = cached;
+        cursor->st = cached->st;
+        cursor->is_dml = cached->is_dml;
+        return 0;
+    }
+
     sqlite3_stmt *stmt = NULL;
     const char *tail;
     int rc;
@@ -236,6 +394,25 @@ cursor_create_st(struct dvobj_sqlite_cursor *cursor, const char *sql)
                   || (strncasecmp(p, "replace", 7) == 0);
     }
 
+    struct dvobj_sqlite_stmt *entry = malloc(sizeof(*entry) + size + 1);
+    if (entry == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto error;
+    }
+    entry->conn = NULL;
+    entry->st = stmt;
+    entry->is_dml = is_dml;
+    entry->in_use = true;
+    entry->nr_sql = size;
+    memcpy(entry->sql, sql, size + 1);
+
+    /* the same statement is being stepped by another cursor: use this
+     * one once and do not cache it */
+    if (!busy) {
+        conn_cache_stmt(conn, entry);
+    }
+
+    cursor->stmt = entry;
     cursor->st = stmt;
     cursor->is_dml = is_dml;
 
@@ -367,6 +544,37 @@ out:
     return rc;
 }
 
+static int cursor_build_description(struct dvobj_sqlite_cursor *cursor)
+{
+    int numcols = sqlite3_column_count(cursor->st);
+    if (cursor->description || numcols <= 0) {
+        return 0;
+    }
+
+    cursor->description = purc_variant_make_tuple(numcols, NULL);
+    if (!cursor->description) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    for (int i = 0; i < numcols; i++) {
+        const char *colname;
+        colname = sqlite3_column_name(cursor->st, i);
+        if (colname == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+        purc_variant_t val = purc_variant_make_string(colname, true);
+        if (!val) {
+            return -1;
+        }
+        purc_variant_tuple_set(cursor->description, i, val);
+        purc_variant_unref(val);
+    }
+
+    return 0;
+}
+
 static inline int
 cursor_exec_query(struct dvobj_sqlite_cursor *cursor, bool multiple,
         const char *sql, purc_variant_t param)
@@ -411,12 +619,8 @@ cursor_exec_query(struct dvobj_sqlite_cursor *cursor, bool multiple,
         cursor->description = PURC_VARIANT_INVALID;
     }
 
-    /* reset stmt : FIXME */
-    if (cursor->st) {
-        sqlite3_reset(cursor->st);
-        sqlite3_finalize(cursor->st);
-        cursor->st = NULL;
-    }
+    /* give the previous statement back */
+    cursor_release_st(cursor);
 
     rc = cursor_create_st(cursor, sql);
     if (rc != 0) {
@@ -458,27 +662,8 @@ cursor_exec_query(struct dvobj_sqlite_cursor *cursor, bool multiple,
             goto failed;
         }
 
-        int numcols = sqlite3_column_count(cursor->st);
-        if (cursor->description == PURC_VARIANT_INVALID && numcols > 0) {
-            cursor->description = purc_variant_make_tuple(numcols, NULL);
-            if (!cursor->description) {
-                purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                goto failed;
-            }
-            for (i = 0; i < numcols; i++) {
-                const char *colname;
-                colname = sqlite3_column_name(cursor->st, i);
-                if (colname == NULL) {
-                    purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-                    goto failed;
-                }
-                purc_variant_t val = purc_variant_make_string(colname, true);
-                if (!val) {
-                    goto failed;
-                }
-                purc_variant_tuple_set(cursor->description, i, val);
-                purc_variant_unref(val);
-            }
+        if (cursor_build_description(cursor)) {
+            goto failed;
         }
 
         if (rc == SQLITE_DONE) {
@@ -1259,15 +1444,9 @@ out:
 }
 
 static purc_variant_t sqlite_value_to_variant_with_type(sqlite3 *db,
-        sqlite3_stmt *st, int pos, const char *type_name)
+        sqlite3_stmt *st, int pos, struct affinity_type *dest_type)
 {
-    (void) db;
-    (void) st;
-    (void) pos;
-    (void) type_name;
-
     purc_variant_t val = PURC_VARIANT_INVALID;
-    struct affinity_type *dest_type = find_affinity_type(type_name);
 
     int col_type = sqlite3_column_type(st, pos);
     switch (col_type) {
@@ -1340,72 +1519,86 @@ fatal:
     return PURC_VARIANT_INVALID;
 }
 
+/* How the columns of a statement become the properties of a row object.
+ * The plan is resolved on the first row fetched by a call and shared by
+ * the rest of the rows fetched by the call. */
+struct fetch_row_plan {
+    int                     nr_cols;
+    purc_variant_t          *keys;
+    struct affinity_type    **types;
+    bool                    *convert;
+};
+
+static void release_row_plan(struct fetch_row_plan *plan)
+{
+    if (plan->keys) {
+        for (int i = 0; i < plan->nr_cols; i++) {
+            if (plan->keys[i])
+                purc_variant_unref(plan->keys[i]);
+        }
+        free(plan->keys);
+    }
+    memset(plan, 0, sizeof(*plan));
+}
+
 static purc_variant_t build_column_name(struct dvobj_sqlite_cursor *cursor,
         int pos, const char *name, purc_variant_t name_mapping)
 {
-    (void) cursor;
-    (void) pos;
-    (void) name;
-    (void) name_mapping;
-    purc_variant_t val = PURC_VARIANT_INVALID;
-    if (!name_mapping) {
-        val = purc_variant_make_string(name, true);
-        goto out;
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    if (name_mapping) {
+        v = purc_variant_object_get_by_ckey(name_mapping, name);
     }
 
-    purc_variant_t v = purc_variant_object_get_by_ckey(name_mapping, name);
     if (!v) {
-        val = purc_variant_make_string(name, true);
-        goto out;
+        /* reuse the name made for the description by execute() */
+        purc_variant_t desc = cursor->description;
+        size_t nr_desc;
+        if (desc && purc_variant_tuple_size(desc, &nr_desc) &&
+                (size_t)pos < nr_desc) {
+            return purc_variant_ref(purc_variant_tuple_get(desc, pos));
+        }
+        return purc_variant_make_string(name, true);
     }
 
     if (!purc_variant_is_string(v)){
         purc_set_error_with_info(PURC_ERROR_WRONG_DATA_TYPE,
                 "wrong data type for name_mapping '%s' type '%s'",
                 name, purc_variant_typename(purc_variant_get_type(v)));
-        goto out;
+        return PURC_VARIANT_INVALID;
     }
 
     size_t length;
     const char *str = purc_variant_get_string_const_ex(v, &length);
-    if (length > 0) {
-        val = purc_variant_ref(v);
-    }
-    else {
+    if (length == 0) {
         purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
                 "invalid value for  name_mapping '%s' value '%s'",
                 name, str);
-        goto out;
+        return PURC_VARIANT_INVALID;
     }
 
-out:
-    return val;
+    return purc_variant_ref(v);
 }
 
-static purc_variant_t build_column_value(struct dvobj_sqlite_cursor *cursor,
-        int pos, const char *name, purc_variant_t type_conversion)
+static int resolve_column_type(const char *name,
+        purc_variant_t type_conversion, struct affinity_type **type,
+        bool *convert)
 {
-    (void) cursor;
-    (void) pos;
-    (void) name;
-    (void) type_conversion;
-    purc_variant_t val = PURC_VARIANT_INVALID;
+    *type = NULL;
+    *convert = false;
     if (!type_conversion) {
-        val = sqlite_value_to_variant(cursor->conn->db, cursor->st, pos);
-        goto out;
+        return 0;
     }
 
     purc_variant_t v = purc_variant_object_get_by_ckey(type_conversion, name);
     if (!v) {
-        val = sqlite_value_to_variant(cursor->conn->db, cursor->st, pos);
-        goto out;
+        return 0;
     }
 
     if (!purc_variant_is_string(v)) {
         purc_set_error_with_info(PURC_ERROR_WRONG_DATA_TYPE,
                 "wrong data type for type conversion '%s' type '%s'",
                 name, purc_variant_typename(purc_variant_get_type(v)));
-        goto out;
+        return -1;
     }
 
     size_t nr_dest_type;
@@ -1414,60 +1607,104 @@ static purc_variant_t build_column_value(struct dvobj_sqlite_cursor *cursor,
         purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
                 "invalid value for  name_mapping '%s' value '%s'",
                 name, dest_type);
-        goto out;
+        return -1;
     }
 
-    val = sqlite_value_to_variant_with_type(cursor->conn->db, cursor->st, pos,
-            dest_type);
+    *type = find_affinity_type(dest_type);
+    *convert = true;
+    return 0;
+}
 
-out:
-    return val;
+static int build_row_plan(struct dvobj_sqlite_cursor *cursor, int nr_cols,
+        purc_variant_t name_mapping, purc_variant_t type_conversion,
+        struct fetch_row_plan *plan)
+{
+    release_row_plan(plan);
+
+    /* one block for the three arrays */
+    size_t sz = (sizeof(purc_variant_t) + sizeof(struct affinity_type *) +
+            sizeof(bool)) * nr_cols;
+    plan->keys = calloc(1, sz);
+    if (plan->keys == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+    plan->types = (struct affinity_type **)(plan->keys + nr_cols);
+    plan->convert = (bool *)(plan->types + nr_cols);
+    plan->nr_cols = nr_cols;
+
+    sqlite3_stmt *st = cursor->st;
+    for (int i = 0; i < nr_cols; i++) {
+        const char *col_name = sqlite3_column_name(st, i);
+        if (col_name == NULL) {
+            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            goto failed;
+        }
+
+        plan->keys[i] = build_column_name(cursor, i, col_name, name_mapping);
+        if (!plan->keys[i]) {
+            goto failed;
+        }
+
+        if (resolve_column_type(col_name, type_conversion, plan->types + i,
+                    plan->convert + i)) {
+            goto failed;
+        }
+    }
+
+    return 0;
+
+failed:
+    release_row_plan(plan);
+    return -1;
 }
 
 static purc_variant_t cursor_fetch_one_row_as_object(
         struct dvobj_sqlite_cursor *cursor, int nr_cols,
-        purc_variant_t name_mapping, purc_variant_t type_conversion)
+        purc_variant_t name_mapping, purc_variant_t type_conversion,
+        struct fetch_row_plan *plan)
 {
-    purc_variant_t key = PURC_VARIANT_INVALID;
     purc_variant_t val = PURC_VARIANT_INVALID;
-    purc_variant_t row = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+    purc_variant_t row = PURC_VARIANT_INVALID;
+
+    if (plan->keys == NULL || plan->nr_cols != nr_cols) {
+        if (build_row_plan(cursor, nr_cols, name_mapping, type_conversion,
+                    plan)) {
+            goto fatal;
+        }
+    }
+
+    row = purc_variant_make_object(0, PURC_VARIANT_INVALID,
             PURC_VARIANT_INVALID);
     if (!row) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         goto fatal;
     }
 
+    sqlite3 *db = cursor->conn->db;
     sqlite3_stmt *st = cursor->st;
     for (int i = 0; i < nr_cols; i++) {
-        const char *col_name = sqlite3_column_name(st, i);
-        if (col_name == NULL) {
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            goto fatal;
+        if (plan->convert[i]) {
+            val = sqlite_value_to_variant_with_type(db, st, i,
+                    plan->types[i]);
         }
-        key = build_column_name(cursor, i, col_name, name_mapping);
-        if (!key) {
-            goto fatal;
+        else {
+            val = sqlite_value_to_variant(db, st, i);
         }
-
-        val = build_column_value(cursor, i, col_name, type_conversion);
         if (!val) {
             goto fatal;
         }
 
-        if (!purc_variant_object_set(row, key, val)) {
+        if (!purc_variant_object_set(row, plan->keys[i], val)) {
             goto fatal;
         }
 
-        purc_variant_unref(key);
         purc_variant_unref(val);
     }
 
     return row;
 
 fatal:
-    if (key) {
-        purc_variant_unref(key);
-    }
     if (val) {
         purc_variant_unref(val);
     }
@@ -1479,7 +1716,7 @@ fatal:
 
 static purc_variant_t cursor_fetch_one_row(struct dvobj_sqlite_cursor *cursor,
         purc_variant_type result_type, purc_variant_t name_mapping,
-        purc_variant_t type_conversion)
+        purc_variant_t type_conversion, struct fetch_row_plan *plan)
 {
     purc_variant_t row = PURC_VARIANT_INVALID;
     int nr_cols = sqlite3_data_count(cursor->st);
@@ -1493,7 +1730,7 @@ static purc_variant_t cursor_fetch_one_row(struct dvobj_sqlite_cursor *cursor,
     }
     else {
         row = cursor_fetch_one_row_as_object(cursor, nr_cols,
-                name_mapping, type_conversion);
+                name_mapping, type_conversion, plan);
     }
 
 out:
@@ -1502,7 +1739,7 @@ out:
 
 static purc_variant_t cursor_iterator_next(struct dvobj_sqlite_cursor *cursor,
         purc_variant_type result_type, purc_variant_t name_mapping,
-        purc_variant_t type_conversion)
+        purc_variant_t type_conversion, struct fetch_row_plan *plan)
 {
     purc_variant_t row = PURC_VARIANT_INVALID;;
 
@@ -1520,7 +1757,7 @@ static purc_variant_t cursor_iterator_next(struct dvobj_sqlite_cursor *cursor,
     /* Prevent recursive use of cursors. */
     cursor->locked = 1;
     row = cursor_fetch_one_row(cursor, result_type, name_mapping,
-            type_conversion);
+            type_conversion, plan);
     cursor->locked = 0;
 
     if (!row || purc_variant_is_null(row)) {
@@ -1532,16 +1769,12 @@ static purc_variant_t cursor_iterator_next(struct dvobj_sqlite_cursor *cursor,
         if (cursor->is_dml) {
             cursor->rowcount = (long)sqlite3_changes(cursor->conn->db);
         }
-        sqlite3_reset(cursor->st);
-        sqlite3_finalize(cursor->st);
-        cursor->st = NULL;
+        cursor_release_st(cursor);
     }
     else if (rc != SQLITE_ROW) {
         purc_set_error_with_info(PURC_ERROR_EXTERNAL_FAILURE,
                 "sqlite error message is %s", sqlite3_errmsg(cursor->conn->db));
-        sqlite3_reset(cursor->st);
-        sqlite3_finalize(cursor->st);
-        cursor->st = NULL;
+        cursor_release_st(cursor);
         purc_variant_unref(row);
         row = PURC_VARIANT_INVALID;
     }
@@ -1598,10 +1831,7 @@ static bool on_sqlite_cursor_being_released(purc_variant_t src, pcvar_op_t op,
 
     if (op == PCVAR_OPERATION_RELEASING) {
         struct dvobj_sqlite_cursor *cursor = ctxt;
-        if (cursor->st) {
-            sqlite3_reset(cursor->st);
-            sqlite3_finalize(cursor->st);
-        }
+        cursor_release_st(cursor);
         destroy_cursor(cursor);
     }
 
@@ -1765,6 +1995,7 @@ static purc_variant_t cursor_fetchone_getter(purc_variant_t root,
     purc_variant_type result_type = PURC_VARIANT_TYPE_TUPLE;
     purc_variant_t name_mapping = PURC_VARIANT_INVALID;
     purc_variant_t type_conversion = PURC_VARIANT_INVALID;
+    struct fetch_row_plan plan = { 0 };
     purc_variant_t val;
 
     struct dvobj_sqlite_cursor *cursor = get_cursor_from_root(root);
@@ -1779,7 +2010,8 @@ static purc_variant_t cursor_fetchone_getter(purc_variant_t root,
     }
 
     val = cursor_iterator_next(cursor, result_type, name_mapping,
-            type_conversion);
+            type_conversion, &plan);
+    release_row_plan(&plan);
 
     return val;
 
@@ -1802,6 +2034,7 @@ static purc_variant_t cursor_fetchmany_getter(purc_variant_t root,
     purc_variant_type result_type = PURC_VARIANT_TYPE_TUPLE;
     purc_variant_t name_mapping = PURC_VARIANT_INVALID;
     purc_variant_t type_conversion = PURC_VARIANT_INVALID;
+    struct fetch_row_plan plan = { 0 };
     purc_variant_t val;
     uint64_t size = 0;
 
@@ -1842,7 +2075,7 @@ static purc_variant_t cursor_fetchmany_getter(purc_variant_t root,
     }
 
     val = cursor_iterator_next(cursor, result_type, name_mapping,
-            type_conversion);
+            type_conversion, &plan);
 
     if (!val || purc_variant_is_null(val)) {
         goto out;
@@ -1859,7 +2092,7 @@ static purc_variant_t cursor_fetchmany_getter(purc_variant_t root,
     size--;
     while (size != 0) {
         val = cursor_iterator_next(cursor, result_type, name_mapping,
-             type_conversion);
+             type_conversion, &plan);
         if (!val || purc_variant_is_null(val)) {
             break;
         }
@@ -1870,9 +2103,11 @@ static purc_variant_t cursor_fetchmany_getter(purc_variant_t root,
     val = arr_val;
 
 out:
+    release_row_plan(&plan);
     return val;
 
 failed:
+    release_row_plan(&plan);
     if (call_flags & PCVRT_CALL_FLAG_SILENTLY) {
         return purc_variant_make_undefined();
     }
@@ -1891,6 +2126,7 @@ static purc_variant_t cursor_fetchall_getter(purc_variant_t root,
     purc_variant_type result_type = PURC_VARIANT_TYPE_TUPLE;
     purc_variant_t name_mapping = PURC_VARIANT_INVALID;
     purc_variant_t type_conversion = PURC_VARIANT_INVALID;
+    struct fetch_row_plan plan = { 0 };
     purc_variant_t val;
 
     struct dvobj_sqlite_cursor *cursor = get_cursor_from_root(root);
@@ -1905,7 +2141,7 @@ static purc_variant_t cursor_fetchall_getter(purc_variant_t root,
     }
 
     val = cursor_iterator_next(cursor, result_type, name_mapping,
-            type_conversion);
+            type_conversion, &plan);
 
     if (!val || purc_variant_is_null(val)) {
         goto out;
@@ -1921,7 +2157,7 @@ static purc_variant_t cursor_fetchall_getter(purc_variant_t root,
 
     while (true) {
         val = cursor_iterator_next(cursor, result_type, name_mapping,
-             type_conversion);
+             type_conversion, &plan);
         if (!val || purc_variant_is_null(val)) {
             break;
         }
@@ -1931,9 +2167,11 @@ static purc_variant_t cursor_fetchall_getter(purc_variant_t root,
     val = arr_val;
 
 out:
+    release_row_plan(&plan);
     return val;
 
 failed:
+    release_row_plan(&plan);
     if (call_flags & PCVRT_CALL_FLAG_SILENTLY) {
         return purc_variant_make_undefined();
     }
@@ -1967,11 +2205,7 @@ static purc_variant_t cursor_close_getter(purc_variant_t root,
         goto out;
     }
 
-    if (cursor->st) {
-        sqlite3_reset(cursor->st);
-        sqlite3_finalize(cursor->st);
-        cursor->st = NULL;
-    }
+    cursor_release_st(cursor);
 
     cursor->closed = true;
     ret = true;
@@ -2023,6 +2257,647 @@ static purc_variant_t cursor_description_getter(purc_variant_t root,
     return purc_variant_make_null();;
 }
 
+/* $SQLiteCursor.query() runs a statement on the worker thread of the
+ * connection. The statement is prepared and bound on the interpreter
+ * thread (no variant is touched by the worker), the worker steps it and
+ * copies the rows into plain chunks, and the chunks are dispatched back to
+ * the runloop of the interpreter, which turns them into `sqlite:rows`,
+ * `sqlite:done` or `sqlite:error` events fired on the cursor. */
+struct sqlite_chunk;
+
+struct dvobj_sqlite_job {
+    struct list_head                ln;         // node in the worker queue
+    struct list_head                info_ln;    // node in info->jobs
+    struct dvobj_sqlite_info        *info;
+    struct dvobj_sqlite_cursor      *cursor;    // referenced until done
+    struct sqlite_chunk             *final;     // allocated on submitting
+    purc_runloop_t                  runloop;
+    purc_atom_t                     cid;
+    sqlite3_stmt                    *st;
+    size_t                          chunk_rows;
+};
+
+struct dvobj_sqlite_worker {
+    pthread_t                       thread;
+    pthread_mutex_t                 lock;
+    pthread_cond_t                  cond;
+    struct list_head                jobs;
+    sqlite3                         *db;
+    bool                            quit;
+};
+
+enum sqlite_chunk_kind {
+    SQLITE_CHUNK_ROWS,
+    SQLITE_CHUNK_DONE,
+    SQLITE_CHUNK_ERROR,
+};
+
+struct sqlite_cell {
+    int                             type;       // SQLITE_INTEGER, ...
+    union {
+        int64_t                     i;
+        double                      d;
+        struct {
+            void                    *bytes;
+            size_t                  len;
+        };
+    };
+};
+
+struct sqlite_chunk {
+    struct list_head                ln;         // node in info->pending
+    struct dvobj_sqlite_job         *job;
+    enum sqlite_chunk_kind          kind;
+    int                             nr_cols;
+    size_t                          nr_rows;
+    long                            rowcount;
+    int64_t                         lastrowid;
+    char                            *errmsg;
+    struct sqlite_cell              cells[0];
+};
+
+static void chunk_destroy(struct sqlite_chunk *chunk)
+{
+    size_t nr_cells = chunk->nr_rows * chunk->nr_cols;
+    for (size_t i = 0; i < nr_cells; i++) {
+        int type = chunk->cells[i].type;
+        if (type == SQLITE_TEXT || type == SQLITE_BLOB) {
+            free(chunk->cells[i].bytes);
+        }
+    }
+    free(chunk->errmsg);
+    free(chunk);
+}
+
+static purc_variant_t chunk_make_rows(struct sqlite_chunk *chunk)
+{
+    purc_variant_t rows = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    if (!rows) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct sqlite_cell *cell = chunk->cells;
+    for (size_t r = 0; r < chunk->nr_rows; r++) {
+        purc_variant_t row = purc_variant_make_tuple(chunk->nr_cols, NULL);
+        if (!row) {
+            goto failed;
+        }
+
+        for (int c = 0; c < chunk->nr_cols; c++, cell++) {
+            purc_variant_t val;
+            switch (cell->type) {
+            case SQLITE_INTEGER:
+                val = purc_variant_make_longint(cell->i);
+                break;
+            case SQLITE_FLOAT:
+                val = purc_variant_make_number(cell->d);
+                break;
+            case SQLITE_TEXT:
+                val = purc_variant_make_string_ex(cell->bytes, cell->len,
+                        false);
+                break;
+            case SQLITE_BLOB:
+                val = purc_variant_make_byte_sequence(cell->bytes, cell->len);
+                break;
+            default:
+                val = purc_variant_make_null();
+                break;
+            }
+
+            if (!val) {
+                purc_variant_unref(row);
+                goto failed;
+            }
+            purc_variant_tuple_set(row, c, val);
+            purc_variant_unref(val);
+        }
+
+        purc_variant_array_append(rows, row);
+        purc_variant_unref(row);
+    }
+
+    return rows;
+
+failed:
+    purc_variant_unref(rows);
+    return PURC_VARIANT_INVALID;
+}
+
+static void info_unref(struct dvobj_sqlite_info *info)
+{
+    pthread_mutex_lock(&info->pending_lock);
+    unsigned nr_refs = --info->nr_refs;
+    pthread_mutex_unlock(&info->pending_lock);
+
+    if (nr_refs == 0) {
+        assert(list_empty(&info->pending));
+        pthread_mutex_destroy(&info->pending_lock);
+        free(info);
+    }
+}
+
+static void job_destroy(struct dvobj_sqlite_job *job)
+{
+    struct dvobj_sqlite_cursor *cursor = job->cursor;
+
+    list_del(&job->info_ln);
+    if (job->final) {
+        chunk_destroy(job->final);
+    }
+
+    cursor_release_st(cursor);
+    cursor->locked = 0;
+    purc_variant_unref(cursor->root);
+    free(job);
+}
+
+/* Called on the runloop of the interpreter. The runloop calls us in the
+ * dispatching order, so the chunk arrived is the first pending one. */
+static void on_chunk_arrived(void *ctxt)
+{
+    struct dvobj_sqlite_info *info = ctxt;
+    struct sqlite_chunk *chunk = NULL;
+
+    pthread_mutex_lock(&info->pending_lock);
+    if (!list_empty(&info->pending)) {
+        chunk = list_first_entry(&info->pending, struct sqlite_chunk, ln);
+        list_del(&chunk->ln);
+    }
+    pthread_mutex_unlock(&info->pending_lock);
+    if (chunk == NULL) {
+        /* the jobs were cancelled */
+        info_unref(info);
+        return;
+    }
+
+    struct dvobj_sqlite_job *job = chunk->job;
+    struct dvobj_sqlite_cursor *cursor = job->cursor;
+    bool is_final = (chunk->kind != SQLITE_CHUNK_ROWS);
+
+    const char *sub = NULL;
+    purc_variant_t data = PURC_VARIANT_INVALID;
+    switch (chunk->kind) {
+    case SQLITE_CHUNK_ROWS:
+        sub = SQLITE_SUB_EVENT_ROWS;
+        data = chunk_make_rows(chunk);
+        break;
+
+    case SQLITE_CHUNK_DONE:
+        sub = SQLITE_SUB_EVENT_DONE;
+        if (cursor->is_dml) {
+            cursor->rowcount = chunk->rowcount;
+        }
+        cursor->lastrowid = chunk->lastrowid;
+        data = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+                PURC_VARIANT_INVALID);
+        if (data) {
+            purc_variant_t v = purc_variant_make_longint(cursor->rowcount);
+            purc_variant_object_set_by_static_ckey(data,
+                    SQLITE_KEY_ROWCOUNT, v);
+            purc_variant_unref(v);
+            v = purc_variant_make_longint(cursor->lastrowid);
+            purc_variant_object_set_by_static_ckey(data,
+                    SQLITE_KEY_LASTROWID, v);
+            purc_variant_unref(v);
+        }
+        break;
+
+    case SQLITE_CHUNK_ERROR:
+        sub = SQLITE_SUB_EVENT_ERROR;
+        data = purc_variant_make_string(chunk->errmsg ? chunk->errmsg :
+                "out of memory", false);
+        break;
+    }
+
+    if (job->cid && data) {
+        if (pcintr_coroutine_post_event(job->cid,
+                PCRDR_MSG_EVENT_REDUCE_OPT_KEEP, cursor->root,
+                SQLITE_EVENT_NAME, sub, data, PURC_VARIANT_INVALID)) {
+            /* the coroutine has gone */
+            purc_clr_error();
+        }
+    }
+    if (data) {
+        purc_variant_unref(data);
+    }
+
+    chunk_destroy(chunk);
+    if (is_final) {
+        job_destroy(job);
+    }
+    info_unref(info);
+}
+
+static struct sqlite_chunk *
+chunk_new(struct dvobj_sqlite_job *job, enum sqlite_chunk_kind kind,
+        int nr_cols, size_t nr_rows)
+{
+    struct sqlite_chunk *chunk = calloc(1, sizeof(*chunk) +
+            sizeof(struct sqlite_cell) * nr_cols * nr_rows);
+    if (chunk) {
+        chunk->job = job;
+        chunk->kind = kind;
+        chunk->nr_cols = nr_cols;
+    }
+    return chunk;
+}
+
+/* Called by the worker. */
+static void dispatch_chunk(struct dvobj_sqlite_job *job,
+        struct sqlite_chunk *chunk)
+{
+    struct dvobj_sqlite_info *info = job->info;
+
+    /* keep the order of the pending list the same as the runloop's */
+    pthread_mutex_lock(&info->pending_lock);
+    list_add_tail(&chunk->ln, &info->pending);
+    info->nr_refs++;
+    purc_runloop_dispatch(job->runloop, on_chunk_arrived, info);
+    pthread_mutex_unlock(&info->pending_lock);
+}
+
+/* The last chunk of a job must arrive, or the cursor stays locked, so it is
+ * allocated when the job is submitted. Without memory for the error message,
+ * the `sqlite:error` event reports `out of memory`. */
+static void post_final_chunk(struct dvobj_sqlite_job *job,
+        enum sqlite_chunk_kind kind, const char *errmsg, long rowcount,
+        int64_t lastrowid)
+{
+    struct sqlite_chunk *chunk = job->final;
+    job->final = NULL;
+
+    chunk->kind = kind;
+    chunk->rowcount = rowcount;
+    chunk->lastrowid = lastrowid;
+    if (errmsg) {
+        chunk->errmsg = strdup(errmsg);
+    }
+    dispatch_chunk(job, chunk);
+}
+
+static bool copy_cell(sqlite3_stmt *st, int col, struct sqlite_cell *cell)
+{
+    cell->type = sqlite3_column_type(st, col);
+    switch (cell->type) {
+    case SQLITE_INTEGER:
+        cell->i = sqlite3_column_int64(st, col);
+        break;
+
+    case SQLITE_FLOAT:
+        cell->d = sqlite3_column_double(st, col);
+        break;
+
+    case SQLITE_TEXT:
+    case SQLITE_BLOB: {
+        const void *bytes = (cell->type == SQLITE_TEXT) ?
+            (const void *)sqlite3_column_text(st, col) :
+            sqlite3_column_blob(st, col);
+        cell->len = sqlite3_column_bytes(st, col);
+        cell->bytes = malloc(cell->len + 1);
+        if (cell->bytes == NULL) {
+            cell->type = SQLITE_NULL;
+            return false;
+        }
+        if (cell->len) {
+            memcpy(cell->bytes, bytes, cell->len);
+        }
+        ((char *)cell->bytes)[cell->len] = 0;
+        break;
+    }
+
+    default:
+        cell->type = SQLITE_NULL;
+        break;
+    }
+
+    return true;
+}
+
+static void worker_run_job(struct dvobj_sqlite_worker *worker,
+        struct dvobj_sqlite_job *job)
+{
+    sqlite3 *db = worker->db;
+    sqlite3_stmt *st = job->st;
+    int nr_cols = sqlite3_column_count(st);
+    struct sqlite_chunk *chunk = NULL;
+    long rowcount = 0;
+    int rc;
+
+    while (true) {
+        /* keep the error message of this step from other threads */
+        sqlite3_mutex_enter(sqlite3_db_mutex(db));
+        rc = sqlite3_step(st);
+        if (rc != SQLITE_ROW) {
+            if (rc == SQLITE_DONE) {
+                rowcount = (long)sqlite3_changes(db);
+                int64_t lastrowid = sqlite3_last_insert_rowid(db);
+                sqlite3_mutex_leave(sqlite3_db_mutex(db));
+                if (chunk) {
+                    dispatch_chunk(job, chunk);
+                }
+                post_final_chunk(job, SQLITE_CHUNK_DONE, NULL, rowcount,
+                        lastrowid);
+            }
+            else {
+                char *errmsg = strdup(sqlite3_errmsg(db));
+                sqlite3_mutex_leave(sqlite3_db_mutex(db));
+                if (chunk) {
+                    chunk_destroy(chunk);
+                }
+                post_final_chunk(job, SQLITE_CHUNK_ERROR, errmsg, 0, 0);
+                free(errmsg);
+            }
+            return;
+        }
+
+        if (chunk == NULL) {
+            chunk = chunk_new(job, SQLITE_CHUNK_ROWS, nr_cols,
+                    job->chunk_rows);
+        }
+
+        bool ok = chunk != NULL;
+        if (ok) {
+            struct sqlite_cell *cells = chunk->cells +
+                chunk->nr_rows * nr_cols;
+            chunk->nr_rows++;
+            for (int i = 0; i < nr_cols && ok; i++) {
+                ok = copy_cell(st, i, cells + i);
+            }
+        }
+        sqlite3_mutex_leave(sqlite3_db_mutex(db));
+
+        if (!ok) {
+            if (chunk) {
+                chunk_destroy(chunk);
+            }
+            post_final_chunk(job, SQLITE_CHUNK_ERROR, NULL, 0, 0);
+            return;
+        }
+
+        if (chunk->nr_rows == job->chunk_rows) {
+            dispatch_chunk(job, chunk);
+            chunk = NULL;
+        }
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    struct dvobj_sqlite_worker *worker = arg;
+
+    pthread_mutex_lock(&worker->lock);
+    while (true) {
+        while (!worker->quit && list_empty(&worker->jobs)) {
+            pthread_cond_wait(&worker->cond, &worker->lock);
+        }
+
+        if (list_empty(&worker->jobs)) {
+            break;
+        }
+
+        struct dvobj_sqlite_job *job;
+        job = list_first_entry(&worker->jobs, struct dvobj_sqlite_job, ln);
+        list_del(&job->ln);
+
+        if (worker->quit) {
+            pthread_mutex_unlock(&worker->lock);
+            post_final_chunk(job, SQLITE_CHUNK_ERROR,
+                    "the connection is closed", 0, 0);
+        }
+        else {
+            pthread_mutex_unlock(&worker->lock);
+            worker_run_job(worker, job);
+        }
+        pthread_mutex_lock(&worker->lock);
+    }
+    pthread_mutex_unlock(&worker->lock);
+
+    return NULL;
+}
+
+static struct dvobj_sqlite_worker *
+conn_get_worker(struct dvobj_sqlite_connection *conn)
+{
+    if (conn->worker) {
+        return conn->worker;
+    }
+
+    struct dvobj_sqlite_worker *worker = calloc(1, sizeof(*worker));
+    if (worker == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&worker->jobs);
+    worker->db = conn->db;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+    if (pthread_create(&worker->thread, NULL, worker_main, worker)) {
+        pthread_cond_destroy(&worker->cond);
+        pthread_mutex_destroy(&worker->lock);
+        free(worker);
+        purc_set_error_with_info(PURC_ERROR_EXTERNAL_FAILURE,
+                "failed to create the worker thread");
+        return NULL;
+    }
+
+    conn->worker = worker;
+    return worker;
+}
+
+/* Interrupts the running query, fails the queued ones and waits for the
+ * worker to exit. The events of the jobs are still delivered later. */
+static void conn_stop_worker(struct dvobj_sqlite_connection *conn)
+{
+    struct dvobj_sqlite_worker *worker = conn->worker;
+    if (worker == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    worker->quit = true;
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    sqlite3_interrupt(conn->db);
+    pthread_join(worker->thread, NULL);
+
+    pthread_cond_destroy(&worker->cond);
+    pthread_mutex_destroy(&worker->lock);
+    free(worker);
+    conn->worker = NULL;
+}
+
+/* Called when $SQLITE is released: the events of the jobs in flight will
+ * never be observed, so stop the workers and free the undelivered chunks.
+ * The callbacks still queued by the runloop then find no pending chunk. */
+static void cancel_jobs(struct dvobj_sqlite_info *info)
+{
+    struct dvobj_sqlite_connection *conn, *next_conn;
+    struct dvobj_sqlite_job *job, *next_job;
+    struct sqlite_chunk *chunk, *next_chunk;
+
+    /* no chunk is dispatched once the workers quit */
+    list_for_each_entry_safe(conn, next_conn, &info->conns, ln) {
+        conn_stop_worker(conn);
+        list_del(&conn->ln);
+        conn->info = NULL;
+    }
+
+    pthread_mutex_lock(&info->pending_lock);
+    list_for_each_entry_safe(chunk, next_chunk, &info->pending, ln) {
+        list_del(&chunk->ln);
+        chunk_destroy(chunk);
+    }
+    pthread_mutex_unlock(&info->pending_lock);
+
+    list_for_each_entry_safe(job, next_job, &info->jobs, info_ln) {
+        job_destroy(job);
+    }
+}
+
+static int
+cursor_submit_query(struct dvobj_sqlite_cursor *cursor, const char *sql,
+        purc_variant_t params, size_t chunk_rows)
+{
+    int ret = -1;
+    struct dvobj_sqlite_job *job = NULL;
+
+    if (!check_cursor(cursor)) {
+        return -1;
+    }
+
+    if (cursor->conn->info == NULL) {
+        purc_set_error_with_info(PURC_ERROR_EXTERNAL_FAILURE,
+                "$SQLITE has been released");
+        return -1;
+    }
+
+    struct dvobj_sqlite_worker *worker = conn_get_worker(cursor->conn);
+    if (worker == NULL) {
+        return -1;
+    }
+
+    if (cursor->description) {
+        purc_variant_unref(cursor->description);
+        cursor->description = PURC_VARIANT_INVALID;
+    }
+    cursor_release_st(cursor);
+
+    if (cursor_create_st(cursor, sql)) {
+        goto failed;
+    }
+
+    purc_variant_t empty = PURC_VARIANT_INVALID;
+    if (params == PURC_VARIANT_INVALID) {
+        empty = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+        params = empty;
+    }
+    int rc = bind_parameters(cursor, params);
+    if (empty) {
+        purc_variant_unref(empty);
+    }
+    if (rc != SQLITE_OK || cursor_build_description(cursor)) {
+        goto failed;
+    }
+
+    job = calloc(1, sizeof(*job));
+    if (job == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    job->final = chunk_new(job, SQLITE_CHUNK_DONE, 0, 0);
+    if (job->final == NULL) {
+        free(job);
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        goto failed;
+    }
+
+    pcintr_coroutine_t co = pcintr_get_coroutine();
+    job->info = cursor->conn->info;
+    job->cursor = cursor;
+    job->runloop = purc_runloop_get_current();
+    job->cid = co ? co->cid : 0;
+    job->st = cursor->st;
+    job->chunk_rows = chunk_rows;
+
+    cursor->rowcount = cursor->is_dml ? 0L : -1L;
+    /* the cursor is busy until the `done` or `error` event */
+    cursor->locked = 1;
+    purc_variant_ref(cursor->root);
+    list_add_tail(&job->info_ln, &job->info->jobs);
+
+    pthread_mutex_lock(&worker->lock);
+    list_add_tail(&job->ln, &worker->jobs);
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+
+    ret = 0;
+
+failed:
+    if (ret) {
+        cursor_release_st(cursor);
+    }
+    return ret;
+}
+
+static purc_variant_t cursor_query_getter(purc_variant_t root,
+            size_t nr_args, purc_variant_t* argv, unsigned call_flags)
+{
+    (void) call_flags;
+    bool ret = false;
+    uint64_t chunk_rows = SQLITE_DEF_CHUNK_ROWS;
+    purc_variant_t params = PURC_VARIANT_INVALID;
+
+    struct dvobj_sqlite_cursor *cursor = get_cursor_from_root(root);
+    if (!check_cursor(cursor)) {
+        goto failed;
+    }
+
+    if (nr_args < 1) {
+        purc_set_error(PURC_ERROR_ARGUMENT_MISSED);
+        goto failed;
+    }
+
+    if (!purc_variant_is_string(argv[0])) {
+        purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        goto failed;
+    }
+
+    if (nr_args > 1 && !purc_variant_is_null(argv[1])) {
+        if (!purc_variant_is_array(argv[1])) {
+            purc_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+            goto failed;
+        }
+        params = argv[1];
+    }
+
+    if (nr_args > 2) {
+        if (!purc_variant_cast_to_ulongint(argv[2], &chunk_rows, false) ||
+                chunk_rows == 0 || chunk_rows > SQLITE_MAX_CHUNK_ROWS) {
+            purc_set_error_with_info(PURC_ERROR_INVALID_VALUE,
+                    "invalid param 'chunk_size'");
+            goto failed;
+        }
+    }
+
+    size_t nr_sql;
+    const char *sql = purc_variant_get_string_const_ex(argv[0], &nr_sql);
+    sql = pcutils_trim_spaces(sql, &nr_sql);
+    if (nr_sql == 0) {
+        purc_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    if (cursor_submit_query(cursor, sql, params, chunk_rows) == 0) {
+        ret = true;
+    }
+
+failed:
+    return purc_variant_make_boolean(ret);
+}
+
 static purc_variant_t
 create_cursor_variant(struct dvobj_sqlite_connection *sqlite_conn)
 {
@@ -2036,6 +2911,7 @@ create_cursor_variant(struct dvobj_sqlite_connection *sqlite_conn)
         { SQLITE_KEY_ROWCOUNT,          cursor_rowcount_getter,         NULL },
         { SQLITE_KEY_LASTROWID,         cursor_lastrowid_getter,        NULL },
         { SQLITE_KEY_DESCRIPTION,       cursor_description_getter,      NULL },
+        { SQLITE_KEY_QUERY,             cursor_query_getter,            NULL },
     };
 
     purc_variant_t cursor_val = purc_dvobj_make_from_methods(methods,
@@ -2099,7 +2975,6 @@ static struct dvobj_sqlite_connection *
 create_connection(struct dvobj_sqlite_info *sqlite_info, const char *db_name,
         size_t nr_db_name)
 {
-    (void) sqlite_info;
     int rc;
     sqlite3 *db = NULL;
     struct dvobj_sqlite_connection *connection = NULL;
@@ -2108,6 +2983,8 @@ create_connection(struct dvobj_sqlite_info *sqlite_info, const char *db_name,
         flags |= SQLITE_OPEN_URI;
     }
 
+    /* the connection may be shared with its worker thread */
+    flags |= SQLITE_OPEN_FULLMUTEX;
     rc = sqlite3_open_v2(db_name, &db, flags, NULL);
     if (rc != SQLITE_OK) {
         purc_set_error_with_info(PURC_ERROR_EXTERNAL_FAILURE,
@@ -2129,6 +3006,9 @@ create_connection(struct dvobj_sqlite_info *sqlite_info, const char *db_name,
     }
 
     connection->db = db;
+    connection->info = sqlite_info;
+    list_add_tail(&connection->ln, &sqlite_info->conns);
+    INIT_LIST_HEAD(&connection->stmts);
 
     return connection;
 
@@ -2148,7 +3028,12 @@ static bool on_sqlite_connection_being_released(purc_variant_t src, pcvar_op_t o
     if (op == PCVAR_OPERATION_RELEASING) {
         struct dvobj_sqlite_connection *connection = ctxt;
         purc_variant_revoke_listener(src, connection->listener);
+        if (connection->info) {
+            list_del(&connection->ln);
+        }
         if (connection->db) {
+            conn_stop_worker(connection);
+            conn_clear_stmts(connection);
             sqlite3_close_v2(connection->db);
         }
         free(connection);
@@ -2286,6 +3171,10 @@ static purc_variant_t conn_close_getter(purc_variant_t root,
         goto out;
     }
 
+    /* sqlite3_close_v2() defers the close until the statements still used
+     * by cursors are finalized */
+    conn_stop_worker(conn);
+    conn_clear_stmts(conn);
     int rc = sqlite3_close_v2(conn->db);
     if (rc == SQLITE_OK) {
         ret = true;
@@ -2598,7 +3487,8 @@ static bool on_sqlite_being_released(purc_variant_t src, pcvar_op_t op,
     if (op == PCVAR_OPERATION_RELEASING) {
         struct dvobj_sqlite_info *sqlite_info = ctxt;
         purc_variant_revoke_listener(src, sqlite_info->listener);
-        free(sqlite_info);
+        cancel_jobs(sqlite_info);
+        info_unref(sqlite_info);
     }
 
     return true;
@@ -2629,6 +3519,11 @@ static purc_variant_t create_sqlite(void)
     }
 
     sqlite_info->root = sqlite;
+    INIT_LIST_HEAD(&sqlite_info->conns);
+    INIT_LIST_HEAD(&sqlite_info->jobs);
+    INIT_LIST_HEAD(&sqlite_info->pending);
+    pthread_mutex_init(&sqlite_info->pending_lock, NULL);
+    sqlite_info->nr_refs = 1;
 
     /* $SQLITE.impl */
     if ((val = make_impl_object()) == PURC_VARIANT_INVALID) {
@@ -2664,7 +3559,7 @@ static purc_variant_t create_sqlite(void)
 
 failed_info:
     if (sqlite_info) {
-        free(sqlite_info);
+        info_unref(sqlite_info);
     }
 
 fatal:
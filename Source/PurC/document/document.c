@@ -83,6 +83,7 @@ pcdoc_document_new(purc_document_type_k type,
         doc->refc = 1;
         doc->ldc = 0;
         list_head_init(&doc->owner_list);
+        list_head_init(&doc->live_colls);
     }
 
     return doc;
@@ -109,6 +110,7 @@ purc_document_new(purc_document_type_k type)
         doc->refc = 1;
         doc->ldc = 0;
         list_head_init(&doc->owner_list);
+        list_head_init(&doc->live_colls);
     }
 
     return doc;
@@ -135,6 +137,7 @@ purc_document_load(purc_document_type_k type, const char *content, size_t len)
         doc->refc = 1;
         doc->ldc = 0;
         list_head_init(&doc->owner_list);
+        list_head_init(&doc->live_colls);
     }
 
     return doc;
@@ -153,6 +156,35 @@ purc_document_ref(purc_document_t doc)
     return doc;
 }
 
+static void release_query_caches(purc_document_t doc);
+
+/* the siblings around the nodes to be inserted */
+struct insertion_mark {
+    pcdoc_element_t parent;
+    pcdoc_node      prev;
+    pcdoc_node      next;
+};
+
+static void live_colls_before_insertion(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        struct insertion_mark *mark);
+static void live_colls_after_insertion(purc_document_t doc, unsigned age,
+        const struct insertion_mark *mark, bool ok);
+static void live_colls_before_removal(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, bool with_elem);
+static void live_colls_after_attr_change(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, const char *name);
+static void live_colls_commit(purc_document_t doc, unsigned age, bool ok);
+static void elem_index_before_attr_change(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, const char *name);
+
+/* whether the element index is to be patched for the change of `age` */
+static inline bool
+elem_index_valid(purc_document_t doc, unsigned age)
+{
+    return doc->elem_index && doc->index_age == age;
+}
+
 unsigned int
 purc_document_unref(purc_document_t doc)
 {
@@ -160,6 +192,7 @@ purc_document_unref(purc_document_t doc)
 
     unsigned int refc = doc->refc;
     if (refc == 0) {
+        release_query_caches(doc);
         doc->ops->destroy(doc);
     }
 
@@ -178,6 +211,7 @@ unsigned int
 purc_document_delete(purc_document_t doc)
 {
     unsigned int refc = doc->refc;
+    release_query_caches(doc);
     doc->ops->destroy(doc);
     return refc;
 }
@@ -193,22 +227,34 @@ pcdoc_element_new_element(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
         const char *tag, bool self_close)
 {
-    doc->age++;
-    return doc->ops->operate_element(doc, elem, op, tag, self_close);
+    unsigned age = doc->age++;
+    if (list_empty(&doc->live_colls) && !elem_index_valid(doc, age))
+        return doc->ops->operate_element(doc, elem, op, tag, self_close);
+
+    struct insertion_mark mark;
+    live_colls_before_insertion(doc, age, elem, op, &mark);
+    pcdoc_element_t new_elem;
+    new_elem = doc->ops->operate_element(doc, elem, op, tag, self_close);
+    live_colls_after_insertion(doc, age, &mark, new_elem != NULL);
+    return new_elem;
 }
 
 void
 pcdoc_element_clear(purc_document_t doc, pcdoc_element_t elem)
 {
-    doc->age++;
+    unsigned age = doc->age++;
+    live_colls_before_removal(doc, age, elem, false);
     doc->ops->operate_element(doc, elem, PCDOC_OP_CLEAR, NULL, 0);
+    live_colls_commit(doc, age, true);
 }
 
 void
 pcdoc_element_erase(purc_document_t doc, pcdoc_element_t elem)
 {
-    doc->age++;
+    unsigned age = doc->age++;
+    live_colls_before_removal(doc, age, elem, true);
     doc->ops->operate_element(doc, elem, PCDOC_OP_ERASE, NULL, 0);
+    live_colls_commit(doc, age, true);
 }
 
 pcdoc_text_node_t
@@ -216,8 +262,14 @@ pcdoc_element_new_text_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
         const char *text, size_t len)
 {
-    doc->age++;
-    return doc->ops->new_text_content(doc, elem, op, text, len);
+    unsigned age = doc->age++;
+    if (op == PCDOC_OP_DISPLACE)
+        live_colls_before_removal(doc, age, elem, false);
+
+    pcdoc_text_node_t text_node;
+    text_node = doc->ops->new_text_content(doc, elem, op, text, len);
+    live_colls_commit(doc, age, text_node != NULL);
+    return text_node;
 }
 
 pcdoc_data_node_t
@@ -225,10 +277,18 @@ pcdoc_element_set_data_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
         purc_variant_t data)
 {
-    doc->age++;
-    if (doc->ops->new_data_content)
-        return doc->ops->new_data_content(doc, elem, op, data);
+    unsigned age = doc->age++;
+    if (doc->ops->new_data_content) {
+        if (op == PCDOC_OP_DISPLACE)
+            live_colls_before_removal(doc, age, elem, false);
+
+        pcdoc_data_node_t data_node;
+        data_node = doc->ops->new_data_content(doc, elem, op, data);
+        live_colls_commit(doc, age, data_node != NULL);
+        return data_node;
+    }
 
+    live_colls_commit(doc, age, true);
     purc_set_error(PURC_ERROR_NOT_SUPPORTED);
     return NULL;
 }
@@ -238,8 +298,15 @@ pcdoc_element_new_content(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
         const char *content, size_t len)
 {
-    doc->age++;
-    return doc->ops->new_content(doc, elem, op, content, len);
+    unsigned age = doc->age++;
+    if (list_empty(&doc->live_colls) && !elem_index_valid(doc, age))
+        return doc->ops->new_content(doc, elem, op, content, len);
+
+    struct insertion_mark mark;
+    live_colls_before_insertion(doc, age, elem, op, &mark);
+    pcdoc_node node = doc->ops->new_content(doc, elem, op, content, len);
+    live_colls_after_insertion(doc, age, &mark, node.type != PCDOC_NODE_VOID);
+    return node;
 }
 
 int
@@ -259,12 +326,16 @@ pcdoc_element_set_attribute(purc_document_t doc,
         pcdoc_element_t elem, pcdoc_operation_k op,
         const char *name, const char *val, size_t len)
 {
-    doc->age++;
+    unsigned age = doc->age++;
+    int ret = 0;
     if (doc->ops->set_attribute) {
-        return doc->ops->set_attribute(doc, elem, op, name, val, len);
+        elem_index_before_attr_change(doc, age, elem, name);
+        ret = doc->ops->set_attribute(doc, elem, op, name, val, len);
+        live_colls_after_attr_change(doc, age, elem, name);
     }
 
-    return 0;
+    live_colls_commit(doc, age, true);
+    return ret;
 }
 
 int
@@ -715,6 +786,8 @@ selector_delete(pcdoc_selector_t selector)
         if (selector->id) {
             free(selector->id);
         }
+        free(selector->index_tag);
+        free(selector->index_class);
         free(selector);
     }
 }
@@ -737,6 +810,72 @@ pcdoc_selector_unref(pcdoc_selector_t selector)
     }
 }
 
+static inline bool
+is_css_name_char(char c)
+{
+    return purc_isalnum(c) || c == '-' || c == '_' || (unsigned char)c >= 0x80;
+}
+
+static char *
+strndup_lower(const char *str, size_t len)
+{
+    char *dup = strndup(str, len);
+    if (dup) {
+        for (size_t i = 0; i < len; i++)
+            dup[i] = purc_tolower(dup[i]);
+    }
+    return dup;
+}
+
+/* finds the index key of a compound selector like `p`, `.foo`, `p.foo.bar`,
+   or `p#foo`; other selectors are matched by walking the tree. */
+static void
+selector_find_index_key(pcdoc_selector_t ret, const char *selector)
+{
+    const char *p = selector;
+    const char *tag = NULL, *klass = NULL;
+    size_t tag_len = 0, class_len = 0;
+
+    while (purc_isspace(*p))
+        p++;
+
+    if (*p == '*') {
+        p++;
+    }
+    else if (is_css_name_char(*p)) {
+        tag = p;
+        while (is_css_name_char(*p))
+            p++;
+        tag_len = p - tag;
+    }
+
+    while (*p == '.' || *p == '#') {
+        char c = *p++;
+        const char *name = p;
+        while (is_css_name_char(*p))
+            p++;
+        if (p == name)
+            return;
+
+        if (c == '.' && klass == NULL) {
+            klass = name;
+            class_len = p - name;
+        }
+    }
+
+    while (purc_isspace(*p))
+        p++;
+    if (*p)
+        return;
+
+    /* the elements having a class are usually fewer than
+       the ones having a tag name */
+    if (klass)
+        ret->index_class = strndup_lower(klass, class_len);
+    else if (tag)
+        ret->index_tag = strndup_lower(tag, tag_len);
+}
+
 pcdoc_selector_t
 pcdoc_selector_new(const char *selector)
 {
@@ -759,6 +898,8 @@ pcdoc_selector_new(const char *selector)
         if (err != CSS_OK) {
             goto out_clear_ret;
         }
+
+        selector_find_index_key(ret, selector);
     }
 
 
@@ -780,6 +921,276 @@ pcdoc_selector_delete(pcdoc_selector_t selector)
     return 0;
 }
 
+#define NR_MAX_CACHED_SELECTORS     128
+
+static void
+free_cached_selector(void *val)
+{
+    pcdoc_selector_unref((pcdoc_selector_t)val);
+}
+
+pcdoc_selector_t
+pcdoc_document_get_selector(purc_document_t doc, const char *selector)
+{
+    pcutils_uomap_entry *entry;
+    pcdoc_selector_t ret;
+
+    if (!selector) {
+        return NULL;
+    }
+
+    if (doc->selectors == NULL) {
+        doc->selectors = pcutils_uomap_create(copy_key_string,
+                free_key_string, NULL, free_cached_selector,
+                NULL, comp_key_string, false, false);
+    }
+    else if ((entry = pcutils_uomap_find(doc->selectors, selector))) {
+        ret = (pcdoc_selector_t)pcutils_uomap_entry_val(entry);
+        return pcdoc_selector_ref(ret);
+    }
+
+    ret = pcdoc_selector_new(selector);
+    if (ret && doc->selectors) {
+        /* the selectors used by a document are usually a few dozens */
+        if (pcutils_uomap_get_size(doc->selectors) >= NR_MAX_CACHED_SELECTORS)
+            pcutils_uomap_clear(doc->selectors);
+
+        if (pcutils_uomap_insert(doc->selectors, selector, ret) == 0)
+            pcdoc_selector_ref(ret);
+    }
+
+    return ret;
+}
+
+struct pcdoc_elem_index {
+    pcdoc_element_t root;
+
+    /* the lower-cased names to the arrays of elements in document order */
+    pcutils_uomap  *tags;
+    pcutils_uomap  *classes;
+};
+
+static void
+free_indexed_elems(void *val)
+{
+    pcutils_arrlist_free((struct pcutils_arrlist *)val);
+}
+
+static void
+elem_index_delete(struct pcdoc_elem_index *index)
+{
+    if (index->tags)
+        pcutils_uomap_destroy(index->tags);
+    if (index->classes)
+        pcutils_uomap_destroy(index->classes);
+    free(index);
+}
+
+static void
+release_query_caches(purc_document_t doc)
+{
+    pcdoc_elem_coll_t coll, tmp;
+    list_for_each_entry_safe(coll, tmp, &doc->live_colls, live_ln) {
+        list_del_init(&coll->live_ln);
+    }
+
+    if (doc->selectors) {
+        pcutils_uomap_destroy(doc->selectors);
+        doc->selectors = NULL;
+    }
+
+    if (doc->elem_index) {
+        elem_index_delete(doc->elem_index);
+        doc->elem_index = NULL;
+    }
+}
+
+/* gets the array of the elements with the name in lower case */
+static struct pcutils_arrlist *
+get_index_elems(pcutils_uomap *map, const char *name, size_t len,
+        bool create)
+{
+    struct pcutils_arrlist *elems = NULL;
+    pcutils_uomap_entry *entry;
+    char buf[64];
+    char *key = buf;
+
+    if (len >= sizeof(buf) && (key = malloc(len + 1)) == NULL)
+        return NULL;
+
+    for (size_t i = 0; i < len; i++)
+        key[i] = purc_tolower(name[i]);
+    key[len] = 0;
+
+    if ((entry = pcutils_uomap_find(map, key))) {
+        elems = (struct pcutils_arrlist *)pcutils_uomap_entry_val(entry);
+    }
+    else if (create) {
+        elems = pcutils_arrlist_new_ex(NULL, 4);
+        if (elems && pcutils_uomap_insert(map, key, elems)) {
+            pcutils_arrlist_free(elems);
+            elems = NULL;
+        }
+    }
+
+    if (key != buf)
+        free(key);
+
+    return elems;
+}
+
+typedef int (*index_key_fn)(purc_document_t doc, pcutils_uomap *map,
+        const char *name, size_t len, pcdoc_element_t elem);
+
+/* calls `fn` for the tag name and every class name of the element */
+static int
+for_each_index_key(purc_document_t doc, struct pcdoc_elem_index *index,
+        pcdoc_element_t elem, bool with_tag, index_key_fn fn)
+{
+    const char *name;
+    size_t len;
+
+    if (with_tag && pcdoc_element_get_tag_name(doc, elem, &name, &len,
+                NULL, NULL, NULL, NULL) == 0 && name && len) {
+        if (fn(doc, index->tags, name, len, elem))
+            return -1;
+    }
+
+    const char *klass = pcdoc_element_class(doc, elem, &len);
+    size_t i = 0;
+    while (klass && i < len) {
+        while (i < len && strchr(CLASS_SEPARATOR, klass[i]))
+            i++;
+
+        size_t start = i;
+        while (i < len && !strchr(CLASS_SEPARATOR, klass[i]))
+            i++;
+
+        if (i > start && fn(doc, index->classes, klass + start, i - start,
+                    elem))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+index_elem(purc_document_t doc, pcutils_uomap *map, const char *name,
+        size_t len, pcdoc_element_t elem)
+{
+    UNUSED_PARAM(doc);
+
+    struct pcutils_arrlist *elems = get_index_elems(map, name, len, true);
+    if (elems == NULL)
+        return -1;
+
+    /* a class may be given more than once in the same element */
+    size_t n = pcutils_arrlist_length(elems);
+    if (n == 0 || pcutils_arrlist_get_idx(elems, n - 1) != elem)
+        return pcutils_arrlist_append(elems, elem);
+    return 0;
+}
+
+static int
+index_elem_cb(purc_document_t doc, pcdoc_element_t element, void *ctxt)
+{
+    struct pcdoc_elem_index *index = (struct pcdoc_elem_index *)ctxt;
+
+    if (for_each_index_key(doc, index, element, true, index_elem))
+        return PCDOC_TRAVEL_STOP;
+    return PCDOC_TRAVEL_GOON;
+}
+
+static int
+build_elem_index(purc_document_t doc)
+{
+    struct pcdoc_elem_index *index = calloc(1, sizeof(*index));
+    if (index == NULL)
+        return -1;
+
+    index->root = doc->ops->special_elem(doc, PCDOC_SPECIAL_ELEM_ROOT);
+    index->tags = pcutils_uomap_create(copy_key_string, free_key_string,
+            NULL, free_indexed_elems, NULL, comp_key_string, false, false);
+    index->classes = pcutils_uomap_create(copy_key_string, free_key_string,
+            NULL, free_indexed_elems, NULL, comp_key_string, false, false);
+    if (index->root == NULL || index->tags == NULL || index->classes == NULL ||
+            pcdoc_travel_descendant_elements(doc, index->root,
+                index_elem_cb, index, NULL)) {
+        elem_index_delete(index);
+        return -1;
+    }
+
+    if (doc->elem_index)
+        elem_index_delete(doc->elem_index);
+    doc->elem_index = index;
+    doc->index_age = doc->age;
+    return 0;
+}
+
+/*
+ * Gets the elements which may match the selector from the index, in
+ * document order. Returns false if the selector can not be resolved by
+ * the index; `*elems` is NULL if no element may match.
+ *
+ * The index is built when the tree is queried again without any change
+ * in between. It is then patched for the changes of the document along
+ * with the live collections, and built again only if patching failed.
+ */
+static bool
+get_indexed_elems(purc_document_t doc, pcdoc_selector_t selector,
+        struct pcutils_arrlist **elems)
+{
+    if (doc->ops->travel == NULL ||
+            (selector->index_tag == NULL && selector->index_class == NULL))
+        return false;
+
+    if (doc->elem_index == NULL || doc->index_age != doc->age) {
+        if (!doc->walked || doc->walk_age != doc->age) {
+            doc->walked = 1;
+            doc->walk_age = doc->age;
+            return false;
+        }
+
+        if (build_elem_index(doc))
+            return false;
+    }
+
+    pcutils_uomap *map;
+    const char *key;
+    if (selector->index_class) {
+        map = doc->elem_index->classes;
+        key = selector->index_class;
+    }
+    else {
+        map = doc->elem_index->tags;
+        key = selector->index_tag;
+    }
+
+    pcutils_uomap_entry *entry = pcutils_uomap_find(map, key);
+    *elems = entry ?
+        (struct pcutils_arrlist *)pcutils_uomap_entry_val(entry) : NULL;
+    return true;
+}
+
+/* whether the element is the ancestor or one of its descendants */
+static bool
+is_elem_in_subtree(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_element_t ancestor)
+{
+    if (doc->elem_index && ancestor == doc->elem_index->root)
+        return true;
+
+    while (elem) {
+        if (elem == ancestor)
+            return true;
+
+        pcdoc_node node = { PCDOC_NODE_ELEMENT, { .elem = elem } };
+        elem = doc->ops->get_parent(doc, node);
+    }
+
+    return false;
+}
+
 struct travel_elem_id {
     pcdoc_element_t elem;
     const char     *id;
@@ -874,6 +1285,30 @@ pcdoc_find_element_in_descendants(purc_document_t doc,
         goto out;
     }
 
+    struct pcutils_arrlist *elems;
+    if (get_indexed_elems(doc, selector, &elems)) {
+        size_t nr = elems ? pcutils_arrlist_length(elems) : 0;
+        ret = NULL;
+
+        doc->root4select = ancestor;
+        for (size_t i = 0; i < nr; i++) {
+            pcdoc_element_t elem = pcutils_arrlist_get_idx(elems, i);
+            bool match = false;
+
+            if (!is_elem_in_subtree(doc, elem, ancestor))
+                continue;
+
+            css_element_selector_match(selector->selector, elem,
+                    &purc_document_css_select_handler, doc, &match);
+            if (match) {
+                ret = elem;
+                break;
+            }
+        }
+        doc->root4select = NULL;
+        goto out;
+    }
+
     struct travel_find_elem data = {
         .selector = selector,
         .elem = NULL
@@ -901,6 +1336,7 @@ element_collection_new(purc_document_t doc, pcdoc_element_t ancestor,
     coll->refc = 1;
     coll->select_size = -1;
     coll->elems = pcutils_arrlist_new_ex(NULL, 4);
+    list_head_init(&coll->live_ln);
 
     return coll;
 }
@@ -920,6 +1356,7 @@ element_collection_unref(purc_document_t doc, pcdoc_elem_coll_t coll)
     UNUSED_PARAM(doc);
 
     if (coll->refc <= 1) {
+        list_del_init(&coll->live_ln);
         if (coll->selector) {
             pcdoc_selector_unref(coll->selector);
         }
@@ -956,6 +1393,513 @@ travel_select_elem_cb(purc_document_t doc, pcdoc_element_t element, void *ctxt)
     return PCDOC_TRAVEL_GOON;
 }
 
+/* the elements at most this deep are compared in document order */
+#define MAX_DEPTH_TO_COMPARE        256
+
+static size_t
+get_ancestors(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_element_t *ancestors)
+{
+    size_t n = 0;
+
+    while (elem) {
+        if (n == MAX_DEPTH_TO_COMPARE)
+            return 0;
+
+        ancestors[n++] = elem;
+        pcdoc_node node = { PCDOC_NODE_ELEMENT, { .elem = elem } };
+        elem = doc->ops->get_parent(doc, node);
+    }
+
+    return n;
+}
+
+/* compares the positions of two sibling elements by walking from one of
+   them in both directions; stops as soon as the other one is met. */
+static int
+compare_siblings(purc_document_t doc, pcdoc_element_t a, pcdoc_element_t b)
+{
+    pcdoc_node next = { PCDOC_NODE_ELEMENT, { .elem = a } };
+    pcdoc_node prev = next;
+
+    while (next.type != PCDOC_NODE_VOID || prev.type != PCDOC_NODE_VOID) {
+        if (next.type != PCDOC_NODE_VOID) {
+            next = doc->ops->next_sibling(doc, next);
+            if (next.type == PCDOC_NODE_ELEMENT && next.elem == b)
+                return -1;
+        }
+
+        if (prev.type != PCDOC_NODE_VOID) {
+            prev = doc->ops->prev_sibling(doc, prev);
+            if (prev.type == PCDOC_NODE_ELEMENT && prev.elem == b)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* sets `order` to a negative value if `a` precedes `b` in document order,
+   or a positive value if `a` follows `b`; returns -1 if failed. */
+static int
+compare_doc_order(purc_document_t doc, pcdoc_element_t a, pcdoc_element_t b,
+        int *order)
+{
+    pcdoc_element_t path_a[MAX_DEPTH_TO_COMPARE];
+    pcdoc_element_t path_b[MAX_DEPTH_TO_COMPARE];
+
+    size_t na = get_ancestors(doc, a, path_a);
+    size_t nb = get_ancestors(doc, b, path_b);
+    if (na == 0 || nb == 0 || path_a[na - 1] != path_b[nb - 1])
+        return -1;
+
+    while (na > 0 && nb > 0 && path_a[na - 1] == path_b[nb - 1]) {
+        na--;
+        nb--;
+    }
+
+    if (na == 0 || nb == 0) {
+        /* the ancestor precedes its descendants */
+        *order = (int)na - (int)nb;
+        return 0;
+    }
+
+    *order = compare_siblings(doc, path_a[na - 1], path_b[nb - 1]);
+    return *order ? 0 : -1;
+}
+
+/* finds the position of the first element not preceding `elem` */
+static int
+find_pos_in_order(purc_document_t doc, struct pcutils_arrlist *al,
+        pcdoc_element_t elem, size_t *pos)
+{
+    size_t len = pcutils_arrlist_length(al);
+    size_t lo = 0, hi = len;
+    int order;
+
+    /* appending is the most common case */
+    if (len > 0) {
+        if (compare_doc_order(doc, al->array[len - 1], elem, &order))
+            return -1;
+        if (order < 0)
+            lo = len;
+    }
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (compare_doc_order(doc, al->array[mid], elem, &order))
+            return -1;
+
+        if (order < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    *pos = lo;
+    return 0;
+}
+
+/* inserts the elements which are adjacent in document order */
+static int
+insert_elems_in_order(purc_document_t doc, struct pcutils_arrlist *al,
+        pcdoc_element_t *elems, size_t nr)
+{
+    size_t len = pcutils_arrlist_length(al);
+    size_t pos;
+
+    if (find_pos_in_order(doc, al, elems[0], &pos))
+        return -1;
+
+    for (size_t i = 0; i < nr; i++) {
+        if (pcutils_arrlist_append(al, NULL))
+            return -1;
+    }
+
+    memmove(al->array + pos + nr, al->array + pos,
+            (len - pos) * sizeof(al->array[0]));
+    memcpy(al->array + pos, elems, nr * sizeof(elems[0]));
+    return 0;
+}
+
+static int
+live_coll_insert_elems(pcdoc_elem_coll_t coll, pcdoc_element_t *elems,
+        size_t nr)
+{
+    int ret = insert_elems_in_order(coll->doc, coll->elems, elems, nr);
+    coll->nr_elems = pcutils_arrlist_length(coll->elems);
+    return ret;
+}
+
+static void
+elem_index_drop(purc_document_t doc)
+{
+    elem_index_delete(doc->elem_index);
+    doc->elem_index = NULL;
+}
+
+static int
+index_elem_in_order(purc_document_t doc, pcutils_uomap *map,
+        const char *name, size_t len, pcdoc_element_t elem)
+{
+    struct pcutils_arrlist *elems = get_index_elems(map, name, len, true);
+    size_t pos;
+
+    if (elems == NULL || find_pos_in_order(doc, elems, elem, &pos))
+        return -1;
+
+    /* a class may be given more than once in the same element */
+    if (pos < pcutils_arrlist_length(elems) && elems->array[pos] == elem)
+        return 0;
+    return insert_elems_in_order(doc, elems, &elem, 1);
+}
+
+static int
+unindex_elem(purc_document_t doc, pcutils_uomap *map,
+        const char *name, size_t len, pcdoc_element_t elem)
+{
+    struct pcutils_arrlist *elems = get_index_elems(map, name, len, false);
+    size_t pos;
+
+    if (elems == NULL)
+        return 0;
+
+    if (find_pos_in_order(doc, elems, elem, &pos))
+        return -1;
+
+    if (pos < pcutils_arrlist_length(elems) && elems->array[pos] == elem)
+        return pcutils_arrlist_del_idx(elems, pos, 1);
+    return 0;
+}
+
+struct patch_elem_index {
+    index_key_fn    fn;
+    pcdoc_element_t skip;
+};
+
+static int
+patch_elem_index_cb(purc_document_t doc, pcdoc_element_t element, void *ctxt)
+{
+    struct patch_elem_index *data = (struct patch_elem_index *)ctxt;
+
+    if (element != data->skip && for_each_index_key(doc, doc->elem_index,
+                element, true, data->fn))
+        return PCDOC_TRAVEL_STOP;
+    return PCDOC_TRAVEL_GOON;
+}
+
+/* removes the subtree from the index while it is still in the tree */
+static void
+elem_index_before_removal(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, bool with_elem)
+{
+    if (!elem_index_valid(doc, age))
+        return;
+
+    struct patch_elem_index data = { unindex_elem, with_elem ? NULL : elem };
+    if (pcdoc_travel_descendant_elements(doc, elem,
+                patch_elem_index_cb, &data, NULL))
+        elem_index_drop(doc);
+}
+
+static void
+elem_index_after_insertion(purc_document_t doc, unsigned age,
+        pcdoc_node first, pcdoc_node last)
+{
+    if (!elem_index_valid(doc, age))
+        return;
+
+    struct patch_elem_index data = { index_elem_in_order, NULL };
+    for (pcdoc_node node = first; node.type != PCDOC_NODE_VOID &&
+            node.data != last.data;
+            node = doc->ops->next_sibling(doc, node)) {
+        if (node.type == PCDOC_NODE_ELEMENT &&
+                pcdoc_travel_descendant_elements(doc, node.elem,
+                    patch_elem_index_cb, &data, NULL)) {
+            elem_index_drop(doc);
+            break;
+        }
+    }
+}
+
+/* the tag name never changes, so only the classes are indexed again */
+static void
+elem_index_before_attr_change(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, const char *name)
+{
+    if (!elem_index_valid(doc, age) || (name && strcasecmp(name, "class")))
+        return;
+
+    if (for_each_index_key(doc, doc->elem_index, elem, false, unindex_elem))
+        elem_index_drop(doc);
+}
+
+static void
+elem_index_after_attr_change(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, const char *name)
+{
+    if (!elem_index_valid(doc, age) || (name && strcasecmp(name, "class")))
+        return;
+
+    if (for_each_index_key(doc, doc->elem_index, elem, false,
+                index_elem_in_order))
+        elem_index_drop(doc);
+}
+
+static void
+live_coll_attach(pcdoc_elem_coll_t coll)
+{
+    purc_document_t doc = coll->doc;
+
+    /* only the elements changed are matched again, so the selector
+       must depend on nothing but the tag name, the classes, and the id */
+    if (coll->type != PCDOC_ELEM_COLL_TYPE_DOC_QUERY ||
+            coll->selector == NULL ||
+            (coll->selector->index_tag == NULL &&
+             coll->selector->index_class == NULL) ||
+            doc->ops->travel == NULL || doc->ops->get_parent == NULL ||
+            doc->ops->first_child == NULL || doc->ops->last_child == NULL ||
+            doc->ops->next_sibling == NULL || doc->ops->prev_sibling == NULL)
+        return;
+
+    if (list_empty(&coll->live_ln))
+        list_add_tail(&coll->live_ln, &doc->live_colls);
+}
+
+static inline void
+live_coll_detach(pcdoc_elem_coll_t coll)
+{
+    list_del_init(&coll->live_ln);
+}
+
+static inline bool
+live_coll_in_scope(purc_document_t doc, pcdoc_elem_coll_t coll,
+        pcdoc_element_t elem)
+{
+    return coll->ancestor == NULL ||
+        is_elem_in_subtree(doc, elem, coll->ancestor);
+}
+
+static bool
+live_coll_match(purc_document_t doc, pcdoc_elem_coll_t coll,
+        pcdoc_element_t elem)
+{
+    bool match = false;
+
+    doc->root4select = coll->ancestor ? coll->ancestor :
+        doc->ops->special_elem(doc, PCDOC_SPECIAL_ELEM_ROOT);
+    css_element_selector_match(coll->selector->selector, elem,
+            &purc_document_css_select_handler, doc, &match);
+    doc->root4select = NULL;
+    return match;
+}
+
+static void
+live_colls_before_insertion(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, pcdoc_operation_k op,
+        struct insertion_mark *mark)
+{
+    pcdoc_node node = { PCDOC_NODE_ELEMENT, { .elem = elem } };
+    pcdoc_node none = { PCDOC_NODE_VOID, { NULL } };
+
+    mark->parent = NULL;
+    mark->prev = none;
+    mark->next = none;
+
+    switch (op) {
+    case PCDOC_OP_APPEND:
+        mark->parent = elem;
+        mark->prev = doc->ops->last_child(doc, elem);
+        break;
+
+    case PCDOC_OP_PREPEND:
+        mark->parent = elem;
+        mark->next = doc->ops->first_child(doc, elem);
+        break;
+
+    case PCDOC_OP_INSERTBEFORE:
+        mark->parent = doc->ops->get_parent(doc, node);
+        mark->prev = doc->ops->prev_sibling(doc, node);
+        mark->next = node;
+        break;
+
+    case PCDOC_OP_INSERTAFTER:
+        mark->parent = doc->ops->get_parent(doc, node);
+        mark->prev = node;
+        mark->next = doc->ops->next_sibling(doc, node);
+        break;
+
+    case PCDOC_OP_DISPLACE:
+        live_colls_before_removal(doc, age, elem, false);
+        mark->parent = elem;
+        break;
+
+    default:
+        break;
+    }
+}
+
+struct match_new_elems {
+    pcdoc_elem_coll_t       coll;
+    struct pcutils_arrlist *found;
+};
+
+static int
+match_new_elem_cb(purc_document_t doc, pcdoc_element_t element, void *ctxt)
+{
+    struct match_new_elems *data = (struct match_new_elems *)ctxt;
+
+    if (live_coll_match(doc, data->coll, element) &&
+            pcutils_arrlist_append(data->found, element))
+        return PCDOC_TRAVEL_STOP;
+    return PCDOC_TRAVEL_GOON;
+}
+
+static void
+live_colls_after_insertion(purc_document_t doc, unsigned age,
+        const struct insertion_mark *mark, bool ok)
+{
+    if (!ok || mark->parent == NULL) {
+        live_colls_commit(doc, age, false);
+        return;
+    }
+
+    pcdoc_node first;
+    if (mark->prev.type != PCDOC_NODE_VOID)
+        first = doc->ops->next_sibling(doc, mark->prev);
+    else
+        first = doc->ops->first_child(doc, mark->parent);
+
+    elem_index_after_insertion(doc, age, first, mark->next);
+
+    struct match_new_elems data = { NULL, pcutils_arrlist_new(NULL) };
+    if (data.found == NULL) {
+        live_colls_commit(doc, age, false);
+        return;
+    }
+
+    pcdoc_elem_coll_t coll, tmp;
+    list_for_each_entry_safe(coll, tmp, &doc->live_colls, live_ln) {
+        if (coll->doc_age != age ||
+                !live_coll_in_scope(doc, coll, mark->parent))
+            continue;
+
+        data.coll = coll;
+        data.found->length = 0;
+        bool all = true;
+        for (pcdoc_node node = first; node.type != PCDOC_NODE_VOID &&
+                node.data != mark->next.data;
+                node = doc->ops->next_sibling(doc, node)) {
+            if (node.type == PCDOC_NODE_ELEMENT &&
+                    pcdoc_travel_descendant_elements(doc, node.elem,
+                        match_new_elem_cb, &data, NULL)) {
+                all = false;
+                break;
+            }
+        }
+
+        size_t nr = pcutils_arrlist_length(data.found);
+        if (!all || (nr > 0 && live_coll_insert_elems(coll,
+                        (pcdoc_element_t *)data.found->array, nr)))
+            live_coll_detach(coll);
+    }
+
+    pcutils_arrlist_free(data.found);
+    live_colls_commit(doc, age, true);
+}
+
+static void
+live_colls_before_removal(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, bool with_elem)
+{
+    elem_index_before_removal(doc, age, elem, with_elem);
+
+    pcdoc_elem_coll_t coll, tmp;
+    list_for_each_entry_safe(coll, tmp, &doc->live_colls, live_ln) {
+        if (coll->doc_age != age)
+            continue;
+
+        if (coll->ancestor && (with_elem || coll->ancestor != elem) &&
+                is_elem_in_subtree(doc, coll->ancestor, elem)) {
+            /* the scope itself is gone */
+            coll->elems->length = 0;
+            coll->nr_elems = 0;
+            live_coll_detach(coll);
+            continue;
+        }
+
+        if (!live_coll_in_scope(doc, coll, elem))
+            continue;
+
+        struct pcutils_arrlist *al = coll->elems;
+        size_t len = pcutils_arrlist_length(al), n = 0;
+        for (size_t i = 0; i < len; i++) {
+            pcdoc_element_t e = al->array[i];
+            if ((e == elem && !with_elem) ||
+                    !is_elem_in_subtree(doc, e, elem))
+                al->array[n++] = e;
+        }
+
+        al->length = n;
+        coll->nr_elems = n;
+    }
+}
+
+static void
+live_colls_after_attr_change(purc_document_t doc, unsigned age,
+        pcdoc_element_t elem, const char *name)
+{
+    elem_index_after_attr_change(doc, age, elem, name);
+
+    /* only the class and the id affect the selectors of live collections */
+    if (name && strcasecmp(name, "class") && strcasecmp(name, "id"))
+        return;
+
+    pcdoc_elem_coll_t coll, tmp;
+    list_for_each_entry_safe(coll, tmp, &doc->live_colls, live_ln) {
+        if (coll->doc_age != age || !live_coll_in_scope(doc, coll, elem))
+            continue;
+
+        struct pcutils_arrlist *al = coll->elems;
+        size_t len = pcutils_arrlist_length(al), i;
+        for (i = 0; i < len; i++) {
+            if (al->array[i] == elem)
+                break;
+        }
+
+        bool match = live_coll_match(doc, coll, elem);
+        if (match && i == len) {
+            if (live_coll_insert_elems(coll, &elem, 1))
+                live_coll_detach(coll);
+        }
+        else if (!match && i < len) {
+            pcutils_arrlist_del_idx(al, i, 1);
+            coll->nr_elems = pcutils_arrlist_length(al);
+        }
+    }
+}
+
+/* the live collections and the element index patched for the change are
+   up to date now; the others will be re-queried or built again. */
+static void
+live_colls_commit(purc_document_t doc, unsigned age, bool ok)
+{
+    if (elem_index_valid(doc, age)) {
+        if (ok)
+            doc->index_age = doc->age;
+        else
+            elem_index_drop(doc);
+    }
+
+    pcdoc_elem_coll_t coll, tmp;
+    list_for_each_entry_safe(coll, tmp, &doc->live_colls, live_ln) {
+        if (ok && coll->doc_age == age)
+            coll->doc_age = doc->age;
+        else
+            live_coll_detach(coll);
+    }
+}
+
 pcdoc_elem_coll_t
 pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
         pcdoc_element_t ancestor, pcdoc_selector_t selector)
@@ -985,10 +1929,26 @@ pcdoc_elem_coll_new_from_descendants(purc_document_t doc,
         goto out;
     }
 
+    struct pcutils_arrlist *elems;
+    if (get_indexed_elems(doc, selector, &elems)) {
+        size_t nr = elems ? pcutils_arrlist_length(elems) : 0;
+
+        doc->root4select = ancestor;
+        for (size_t i = 0; i < nr; i++) {
+            pcdoc_element_t elem = pcutils_arrlist_get_idx(elems, i);
+            if (is_elem_in_subtree(doc, elem, ancestor))
+                travel_select_elem_cb(doc, elem, coll);
+        }
+        doc->root4select = NULL;
+        live_coll_attach(coll);
+        goto out;
+    }
+
     doc->root4select = ancestor;
     pcdoc_travel_descendant_elements(doc, ancestor, travel_select_elem_cb,
             coll, NULL);
     doc->root4select = NULL;
+    live_coll_attach(coll);
 out:
     return coll;
 }
@@ -1167,6 +2127,7 @@ elem_coll_update_query(pcdoc_elem_coll_t elem_coll)
     elem_coll->nr_elems = new_coll->nr_elems;
     elem_coll->doc_age = elem_coll->doc->age;
     pcdoc_elem_coll_delete(new_coll->doc, new_coll);
+    live_coll_attach(elem_coll);
     ret = 0;
 
 out:
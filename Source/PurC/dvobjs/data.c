@@ -609,13 +609,18 @@ parse_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         goto failed;
     }
 
+    /* plain JSON does not need the eJSON parser and the evaluation */
+    purc_variant_t retv = pcvariant_make_from_strict_json(string, length);
+    if (retv != PURC_VARIANT_INVALID)
+        return retv;
+    purc_clr_error();
+
     struct purc_ejson_parsing_tree *ptree;
     ptree = purc_variant_ejson_parse_string(string, length);
     if (ptree == NULL) {
         goto failed;
     }
 
-    purc_variant_t retv;
     retv = purc_ejson_parsing_tree_evalute(ptree, NULL, NULL,
             (call_flags & PCVRT_CALL_FLAG_SILENTLY));
     purc_ejson_parsing_tree_destroy(ptree);
@@ -1936,9 +1941,14 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
         ssize_t sz = purc_variant_array_get_size(argv[0]);
 
         if (sz > 1) {
-            struct pcutils_array_list *al = variant_array_get_data(argv[0]);
-            struct pcutils_array_list_node *p;
-            array_list_for_each(al, p) {
+            // write to the members directly, make sure they are our own
+            if (pcvariant_array_unshare(argv[0]))
+                goto failed;
+
+            size_t nr;
+            purc_variant_t *members = array_members(argv[0], &nr);
+
+            for (size_t idx = 0; idx < nr; idx++) {
 
                 size_t new_idx;
                 if (sz < RAND_MAX) {
@@ -1949,8 +1959,11 @@ shuffle_getter(purc_variant_t root, size_t nr_args, purc_variant_t *argv,
                     new_idx = new_idx * sz / RAND_MAX;
                 }
 
-                if (new_idx != p->idx)
-                    pcutils_array_list_swap(al, p->idx, new_idx);
+                if (new_idx != idx) {
+                    purc_variant_t tmp = members[idx];
+                    members[idx] = members[new_idx];
+                    members[new_idx] = tmp;
+                }
             }
         }
     }
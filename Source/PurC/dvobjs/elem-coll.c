@@ -118,7 +118,8 @@ select_getter(void *entity, const char *property_name,
         goto out;
     }
 
-    selector = pcdoc_selector_new(purc_variant_get_string_const(argv[0]));
+    selector = pcdoc_document_get_selector(elem_coll->doc,
+            purc_variant_get_string_const(argv[0]));
     if (!selector) {
         goto out_clear_selector;
     }
@@ -920,7 +921,7 @@ pcdvobjs_find_element_in_doc(purc_document_t doc, const char *sel)
         goto out;
     }
 
-    selector = pcdoc_selector_new(sel);
+    selector = pcdoc_document_get_selector(doc, sel);
     if (!selector) {
         goto out_clear_selector;
     }
@@ -946,7 +947,7 @@ pcdvobjs_elem_coll_from_descendants(purc_document_t doc,
         goto out;
     }
 
-    selector = pcdoc_selector_new(sel);
+    selector = pcdoc_document_get_selector(doc, sel);
     if (!selector) {
         goto out_clear_selector;
     }
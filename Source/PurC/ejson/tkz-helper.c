@@ -40,6 +40,7 @@
 #endif
 
 #define NR_CONSUMED_LIST_LIMIT   128
+#define NR_READ_AHEAD_CHARS      1024
 #define MIN_BUFFER_CAPACITY      32
 
 #if HAVE(GLIB)
@@ -63,6 +64,11 @@ struct tkz_reader {
 
     int hee_line;
     int hee_column;
+
+    /* characters decoded from rws in blocks but not consumed yet */
+    size_t ra_pos;
+    size_t nr_ra;
+    uint32_t ra_chars[NR_READ_AHEAD_CHARS];
 };
 
 
@@ -122,20 +128,63 @@ struct tkz_reader *tkz_reader_new(int hee_line, int hee_column)
     return reader;
 }
 
+static size_t
+utf8_len_of_char(uint32_t uc)
+{
+    if (uc < 0x80 || uc == TKZ_INVALID_CHARACTER)
+        return 1;
+    else if (uc < 0x800)
+        return 2;
+    else if (uc < 0x10000)
+        return 3;
+    return 4;
+}
+
+/* Gives the characters read ahead but not consumed back to a seekable
+ * stream, so that the caller can go on reading it where the tokenizer
+ * stopped. This is best effort: malformed characters are counted as
+ * a single byte, and pipes cannot seek at all. */
+static void
+tkz_reader_drop_read_ahead(struct tkz_reader *reader)
+{
+    if (reader->rws && reader->ra_pos < reader->nr_ra) {
+        off_t back = 0;
+        for (size_t i = reader->ra_pos; i < reader->nr_ra; i++) {
+            back += utf8_len_of_char(reader->ra_chars[i]);
+        }
+        if (purc_rwstream_seek(reader->rws, -back, SEEK_CUR) < 0) {
+            purc_clr_error();
+        }
+    }
+    reader->ra_pos = 0;
+    reader->nr_ra = 0;
+}
+
 void tkz_reader_set_rwstream(struct tkz_reader *reader,
         purc_rwstream_t rws)
 {
+    if (reader->rws != rws) {
+        tkz_reader_drop_read_ahead(reader);
+    }
     reader->rws = rws;
 }
 
 static struct tkz_uc*
 tkz_reader_read_from_rwstream(struct tkz_reader *reader)
 {
-    char c[8] = {0};
-    uint32_t uc = 0;
-    int nr_c = purc_rwstream_read_utf8_char(reader->rws, c, &uc);
-    if (nr_c < 0) {
-        uc = TKZ_INVALID_CHARACTER;
+    uint32_t uc = TKZ_END_OF_FILE;
+    if (reader->ra_pos == reader->nr_ra) {
+        ssize_t nr = purc_rwstream_read_utf8_chars(reader->rws,
+                reader->ra_chars, NR_READ_AHEAD_CHARS);
+        reader->ra_pos = 0;
+        reader->nr_ra = nr > 0 ? nr : 0;
+        if (nr < 0) {
+            uc = TKZ_INVALID_CHARACTER;
+        }
+    }
+
+    if (reader->ra_pos < reader->nr_ra) {
+        uc = reader->ra_chars[reader->ra_pos++];
     }
     reader->column++;
     reader->consumed++;
@@ -251,6 +300,7 @@ int tkz_reader_hee_column(struct tkz_reader *reader)
 void tkz_reader_destroy(struct tkz_reader *reader)
 {
     if (reader) {
+        tkz_reader_drop_read_ahead(reader);
         struct list_head *p, *n;
         list_for_each_safe(p, n, &reader->reconsume_list) {
             struct tkz_uc *puc = list_entry(p, struct tkz_uc, list);
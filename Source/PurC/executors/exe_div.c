@@ -54,6 +54,9 @@ parse_rule(struct pcexec_exe_div_inst *exe_div_inst,
 {
     purc_exec_inst_t inst = &exe_div_inst->super;
 
+    if (!pcexecutor_inst_rule_changed(inst, rule))
+        return true;
+
     struct exe_div_param param = {0};
     int r = exe_div_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
@@ -70,6 +73,7 @@ parse_rule(struct pcexec_exe_div_inst *exe_div_inst,
     exe_div_param_reset(&exe_div_inst->param);
     exe_div_inst->param = param;
 
+    pcexecutor_inst_set_rule(inst, rule);
     return true;
 }
 
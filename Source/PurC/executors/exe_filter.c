@@ -197,21 +197,26 @@ parse_rule(struct pcexec_exe_filter_inst *exe_filter_inst,
 {
     purc_exec_inst_t inst = &exe_filter_inst->super;
 
-    struct exe_filter_param param = {0};
-    int r = exe_filter_parse(rule, strlen(rule), &param);
-    if (inst->err_msg) {
-        free(inst->err_msg);
-        inst->err_msg = NULL;
-    }
+    /* only the parsed rule is kept; the result set always reflects
+     * the current members of the input */
+    if (pcexecutor_inst_rule_changed(inst, rule)) {
+        struct exe_filter_param param = {0};
+        int r = exe_filter_parse(rule, strlen(rule), &param);
+        if (inst->err_msg) {
+            free(inst->err_msg);
+            inst->err_msg = NULL;
+        }
 
-    if (r) {
-        inst->err_msg = param.err_msg;
-        param.err_msg = NULL;
-        return false;
-    }
+        if (r) {
+            inst->err_msg = param.err_msg;
+            param.err_msg = NULL;
+            return false;
+        }
 
-    exe_filter_param_reset(&exe_filter_inst->param);
-    exe_filter_inst->param = param;
+        exe_filter_param_reset(&exe_filter_inst->param);
+        exe_filter_inst->param = param;
+        pcexecutor_inst_set_rule(inst, rule);
+    }
 
     return prepare_result_set(exe_filter_inst);
 }
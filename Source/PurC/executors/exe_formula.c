@@ -55,6 +55,9 @@ parse_rule(struct pcexec_exe_formula_inst *exe_formula_inst,
 {
     purc_exec_inst_t inst = &exe_formula_inst->super;
 
+    if (!pcexecutor_inst_rule_changed(inst, rule))
+        return true;
+
     struct exe_formula_param param = {0};
     int r = exe_formula_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
@@ -71,6 +74,7 @@ parse_rule(struct pcexec_exe_formula_inst *exe_formula_inst,
     exe_formula_param_reset(&exe_formula_inst->param);
     exe_formula_inst->param = param;
 
+    pcexecutor_inst_set_rule(inst, rule);
     return true;
 }
 
@@ -54,6 +54,9 @@ parse_rule(struct pcexec_exe_mul_inst *exe_mul_inst,
 {
     purc_exec_inst_t inst = &exe_mul_inst->super;
 
+    if (!pcexecutor_inst_rule_changed(inst, rule))
+        return true;
+
     struct exe_mul_param param = {0};
     int r = exe_mul_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
@@ -70,6 +73,7 @@ parse_rule(struct pcexec_exe_mul_inst *exe_mul_inst,
     exe_mul_param_reset(&exe_mul_inst->param);
     exe_mul_inst->param = param;
 
+    pcexecutor_inst_set_rule(inst, rule);
     return true;
 }
 
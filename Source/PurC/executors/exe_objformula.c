@@ -56,6 +56,9 @@ parse_rule(struct pcexec_exe_objformula_inst *exe_objformula_inst,
 {
     purc_exec_inst_t inst = &exe_objformula_inst->super;
 
+    if (!pcexecutor_inst_rule_changed(inst, rule))
+        return true;
+
     struct exe_objformula_param param = {0};
     int r = exe_objformula_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
@@ -75,6 +78,7 @@ parse_rule(struct pcexec_exe_objformula_inst *exe_objformula_inst,
     PC_ASSERT(param.rule.vncle);
     PC_ASSERT(exe_objformula_inst->param.rule.vncle);
 
+    pcexecutor_inst_set_rule(inst, rule);
     return true;
 }
 
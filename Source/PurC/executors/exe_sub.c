@@ -54,6 +54,9 @@ parse_rule(struct pcexec_exe_sub_inst *exe_sub_inst,
 {
     purc_exec_inst_t inst = &exe_sub_inst->super;
 
+    if (!pcexecutor_inst_rule_changed(inst, rule))
+        return true;
+
     struct exe_sub_param param = {0};
     int r = exe_sub_parse(rule, strlen(rule), &param);
     if (inst->err_msg) {
@@ -70,6 +73,7 @@ parse_rule(struct pcexec_exe_sub_inst *exe_sub_inst,
     exe_sub_param_reset(&exe_sub_inst->param);
     exe_sub_inst->param = param;
 
+    pcexecutor_inst_set_rule(inst, rule);
     return true;
 }
 
@@ -385,6 +385,29 @@ pcexecutor_inst_reset(struct purc_exec_inst *inst)
         free(inst->err_msg);
         inst->err_msg = NULL;
     }
+    if (inst->rule) {
+        free(inst->rule);
+        inst->rule = NULL;
+    }
+}
+
+bool
+pcexecutor_inst_rule_changed(struct purc_exec_inst *inst, const char *rule)
+{
+    return !inst->rule || strcmp(inst->rule, rule);
+}
+
+void
+pcexecutor_inst_set_rule(struct purc_exec_inst *inst, const char *rule)
+{
+    if (inst->rule) {
+        free(inst->rule);
+        inst->rule = NULL;
+    }
+
+    /* on OOM the rule is simply parsed again next time */
+    if (rule)
+        inst->rule = strdup(rule);
 }
 
 purc_atom_t
@@ -26,17 +26,180 @@
 
 #include "fetcher-internal.h"
 
+#include <wtf/HashMap.h>
+#include <wtf/ListHashSet.h>
+#include <wtf/Lock.h>
+#include <wtf/ThreadSafeRefCounted.h>
 #include <wtf/URL.h>
 #include <wtf/RunLoop.h>
+#include <wtf/text/StringHash.h>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
+#include <errno.h>
 #include <stdlib.h>
 
+/* The content of a local file, read into memory. The file is not mapped:
+ * another process may truncate it, and touching the pages gone would raise
+ * SIGBUS. The content is shared by the cache and by the asynchronous
+ * requests still delivering it, so an entry evicted from the cache stays
+ * valid until the last request is done with it. */
+class LocalFileContent : public ThreadSafeRefCounted<LocalFileContent> {
+public:
+    static RefPtr<LocalFileContent> load(const char *file);
+    ~LocalFileContent();
+
+    /* whether the file described by st is still the one we read */
+    bool isSameFile(const struct stat &st) const {
+        return st.st_dev == m_dev && st.st_ino == m_ino &&
+            st.st_mtime == m_mtime && (size_t)st.st_size == m_size;
+    }
+
+    const char *data() const { return (const char *)m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    LocalFileContent(const struct stat &st, void *data, size_t size)
+        : m_dev(st.st_dev), m_ino(st.st_ino), m_mtime(st.st_mtime),
+          m_size(size), m_data(data) { }
+
+    dev_t m_dev;
+    ino_t m_ino;
+    time_t m_mtime;
+    size_t m_size;
+    void *m_data;
+};
+
+RefPtr<LocalFileContent> LocalFileContent::load(const char *file)
+{
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return nullptr;
+    }
+
+    /* the file may shrink while being read; keep what was read, and the
+     * size differing from the one of the file makes the next fetch reload
+     * it */
+    char *data = NULL;
+    size_t size = 0;
+    if (st.st_size > 0) {
+        data = (char *)malloc(st.st_size);
+        if (data == NULL) {
+            close(fd);
+            return nullptr;
+        }
+
+        while (size < (size_t)st.st_size) {
+            ssize_t n = read(fd, data + size, st.st_size - size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n < 0) {
+                free(data);
+                close(fd);
+                return nullptr;
+            }
+            if (n == 0) {
+                break;
+            }
+            size += n;
+        }
+    }
+    close(fd);
+
+    return adoptRef(new LocalFileContent(st, data, size));
+}
+
+LocalFileContent::~LocalFileContent()
+{
+    free(m_data);
+}
+
+/* A LRU cache of the local files fetched recently, bounded by the cache
+ * quota of the fetcher. The local fetcher is shared by all instances, so
+ * the cache is protected by a lock. */
+class LocalFileCache {
+public:
+    LocalFileCache(size_t quota) : m_quota(quota), m_size(0) { }
+
+    RefPtr<LocalFileContent> fetch(const char *file);
+
+private:
+    void evict(size_t needed);
+
+    Lock m_lock;
+    HashMap<String, RefPtr<LocalFileContent>> m_contents;
+    ListHashSet<String> m_lru;      // the least recently used first
+    size_t m_quota;
+    size_t m_size;
+};
+
+RefPtr<LocalFileContent> LocalFileCache::fetch(const char *file)
+{
+    struct stat st;
+    if (stat(file, &st)) {
+        return nullptr;
+    }
+
+    String key = String::fromUTF8(file);
+    {
+        auto locker = holdLock(m_lock);
+        auto it = m_contents.find(key);
+        if (it != m_contents.end()) {
+            if (it->value->isSameFile(st)) {
+                m_lru.appendOrMoveToLast(key);
+                return it->value;
+            }
+
+            // the file changed on disk
+            m_size -= it->value->size();
+            m_contents.remove(it);
+            m_lru.remove(key);
+        }
+    }
+
+    RefPtr<LocalFileContent> content = LocalFileContent::load(file);
+    if (!content || content->size() > m_quota) {
+        return content;
+    }
+
+    auto locker = holdLock(m_lock);
+    if (m_contents.contains(key)) {
+        // loaded by another instance meanwhile
+        return content;
+    }
+
+    evict(content->size());
+    m_contents.add(key.isolatedCopy(), content);
+    m_lru.add(key.isolatedCopy());
+    m_size += content->size();
+    return content;
+}
+
+void LocalFileCache::evict(size_t needed)
+{
+    while (!m_lru.isEmpty() && m_size + needed > m_quota) {
+        String oldest = m_lru.takeFirst();
+        auto it = m_contents.find(oldest);
+        if (it != m_contents.end()) {
+            m_size -= it->value->size();
+            m_contents.remove(it);
+        }
+    }
+}
+
 struct pcfetcher_local {
     struct pcfetcher base;
+    LocalFileCache* cache;
 };
 
 struct mime_type {
@@ -94,6 +257,8 @@ struct pcfetcher* pcfetcher_local_init(size_t max_conns, size_t cache_quota)
     fetcher->cancel_async = pcfetcher_local_cancel_async;
     fetcher->check_response = pcfetcher_local_check_response;
 
+    local->cache = new LocalFileCache(cache_quota);
+
     return fetcher;
 }
 
@@ -104,12 +269,48 @@ int pcfetcher_local_term(struct pcfetcher* fetcher)
     }
 
     struct pcfetcher_local* local = (struct pcfetcher_local*)fetcher;
+    delete local->cache;
     free(local);
     return 0;
 }
 
-#define ASYNC_DELAY         0.05
-#define ASYNC_BUF_SIZE      4096
+String pcfetcher_build_uri(const char *base_url,  const char *url);
+
+static RefPtr<LocalFileContent> local_fetch(
+        struct pcfetcher_session *session,
+        struct pcfetcher* fetcher,
+        const char* url,
+        struct pcfetcher_resp_header *resp_header)
+{
+    String uri;
+    if (session->base_url) {
+        uri = pcfetcher_build_uri(session->base_url, url);
+    }
+    else {
+        uri.append(url);
+    }
+
+    RefPtr<LocalFileContent> content;
+    PurCWTF::URL wurl(URL(), uri);
+    if (wurl.isLocalFile()) {
+        const StringView path = wurl.path();
+        const CString& cpath = path.utf8();
+
+        const char* file = cpath.data();
+        content = ((struct pcfetcher_local*)fetcher)->cache->fetch(file);
+        if (content) {
+            resp_header->ret_code = 200;
+            resp_header->sz_resp = content->size();
+            resp_header->mime_type = strdup(get_mime(file));
+            return content;
+        }
+    }
+
+    resp_header->ret_code = 404;
+    resp_header->sz_resp = 0;
+    resp_header->mime_type = NULL;
+    return nullptr;
+}
 
 purc_variant_t pcfetcher_local_request_async(
         struct pcfetcher_session *session,
@@ -123,21 +324,21 @@ purc_variant_t pcfetcher_local_request_async(
         pcfetcher_progress_tracker tracker,
         void* tracker_ctxt)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(handler);
-    UNUSED_PARAM(ctxt);
 
     if (!fetcher || !url || !handler) {
         return PURC_VARIANT_INVALID;
     }
 
     struct pcfetcher_callback_info *info = pcfetcher_create_callback_info();
-    info->rws = pcfetcher_local_request_sync(session, fetcher, url, method,
-            params, timeout, &info->header);
+    if (!info) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    RefPtr<LocalFileContent> content = local_fetch(session, fetcher, url,
+            &info->header);
     info->handler = handler;
     info->session = session;
     info->ctxt = ctxt;
@@ -145,75 +346,45 @@ purc_variant_t pcfetcher_local_request_async(
     info->tracker_ctxt = tracker_ctxt;
     info->req_id = purc_variant_make_native(info, NULL);
 
-    if (!info->rws) {
-        info->header.ret_code = 404;
-    }
-
-    purc_rwstream_seek(info->rws, 0, SEEK_END);
-    size_t nr_bytes = purc_rwstream_tell(info->rws);
-    purc_rwstream_seek(info->rws, 0, SEEK_SET);
-
-    RunLoop *runloop = &RunLoop::current();
+    /* The content is delivered as a single chunk straight from the shared
+     * buffer; the handlers copy what they need. A missing file gets only
+     * the error, which carries the response header. */
+    RunLoop::current().dispatch([info, content = WTFMove(content)] {
+            if (info->cancelled) {
+                pcfetcher_destroy_callback_info(info);
+                return;
+            }
 
-    size_t nr_buf = ASYNC_BUF_SIZE;
-    double progress = 0.0;
-    double delay = 0.0;
-    size_t nr_send = 0;
-    ssize_t read_size = 0;
-
-    runloop->dispatchAfter(Seconds(ASYNC_DELAY), [info] {
-        info->handler(info->session, info->req_id, info->ctxt,
-                PCFETCHER_RESP_TYPE_HEADER,
-                (const char *)&info->header, 0);
-    });
-    while (true) {
-        char *buf = (char *)malloc(nr_buf + 1);
-        if ((read_size = purc_rwstream_read(info->rws, buf, nr_buf)) <= 0) {
-            free(buf);
-            break;
-        }
-        buf[read_size] = 0;
-        delay += ASYNC_DELAY;
-        nr_send += read_size;
-        progress = (double)nr_send / nr_bytes;
-
-        runloop->dispatchAfter(Seconds(delay), [content=buf, sz_content=read_size,
-                progress, info] {
-                if (info->cancelled) {
-                    return;
-                }
-                if (info->tracker) {
-                    info->tracker(info->session, info->req_id,
-                            info->tracker_ctxt, progress);
-                }
+            if (!content) {
+                info->handler(info->session, info->req_id, info->ctxt,
+                        PCFETCHER_RESP_TYPE_ERROR,
+                        (const char *)&info->header, 0);
+                pcfetcher_destroy_callback_info(info);
+                return;
+            }
+
+            info->handler(info->session, info->req_id, info->ctxt,
+                    PCFETCHER_RESP_TYPE_HEADER,
+                    (const char *)&info->header, 0);
+
+            if (info->tracker) {
+                info->tracker(info->session, info->req_id,
+                        info->tracker_ctxt, 1.0);
+            }
+            if (content->size() > 0) {
                 info->handler(info->session, info->req_id, info->ctxt,
                         PCFETCHER_RESP_TYPE_DATA,
-                        content, sz_content);
-                free(content);
-
-                if (progress == 1.0) {
-                    info->handler(info->session, info->req_id, info->ctxt,
-                            PCFETCHER_RESP_TYPE_FINISH,
-                            NULL, 0);
-                    pcfetcher_destroy_callback_info(info);
-                }
-        });
-
-
-    }
+                        content->data(), content->size());
+            }
+            info->handler(info->session, info->req_id, info->ctxt,
+                    PCFETCHER_RESP_TYPE_FINISH,
+                    NULL, 0);
+            pcfetcher_destroy_callback_info(info);
+    });
 
     return info->req_id;
 }
 
-off_t filesize(const char* filename)
-{
-    struct stat statbuf;
-    stat(filename,&statbuf);
-    return statbuf.st_size;
-}
-
-String pcfetcher_build_uri(const char *base_url,  const char *url);
-
 purc_rwstream_t pcfetcher_local_request_sync(
         struct pcfetcher_session *session,
         struct pcfetcher* fetcher,
@@ -223,47 +394,27 @@ purc_rwstream_t pcfetcher_local_request_sync(
         uint32_t timeout,
         struct pcfetcher_resp_header *resp_header)
 {
-    UNUSED_PARAM(fetcher);
-    UNUSED_PARAM(url);
     UNUSED_PARAM(method);
     UNUSED_PARAM(params);
     UNUSED_PARAM(timeout);
-    UNUSED_PARAM(resp_header);
 
-    if (!fetcher || !url) {
+    if (!fetcher || !url || !resp_header) {
         return NULL;
     }
 
-    String uri;
-    if (session->base_url) {
-        uri = pcfetcher_build_uri(session->base_url, url);
-    }
-    else {
-        uri.append(url);
-    }
-
-    PurCWTF::URL wurl(URL(), uri);
-    if (!wurl.isLocalFile()) {
-        resp_header->ret_code = 404;
-        resp_header->sz_resp = 0;
-        resp_header->mime_type = NULL;
+    RefPtr<LocalFileContent> content = local_fetch(session, fetcher, url,
+            resp_header);
+    if (!content) {
         return NULL;
     }
 
-    const StringView path = wurl.path();
-    const CString& cpath = path.utf8();
-
-    const char* file = cpath.data();
-
-    purc_rwstream_t rws = purc_rwstream_new_from_file(file, "r");
-    if (rws && resp_header) {
-        resp_header->ret_code = 200;
-        resp_header->sz_resp = filesize(file);
-        resp_header->mime_type = strdup(get_mime(file));
-        return rws;
+    /* the caller owns the stream, which may outlive the cache entry */
+    purc_rwstream_t rws = purc_rwstream_new_buffer(content->size(), 0);
+    if (rws) {
+        purc_rwstream_write(rws, content->data(), content->size());
+        purc_rwstream_seek(rws, 0, SEEK_SET);
     }
-
-    return NULL;
+    return rws;
 }
 
 void pcfetcher_local_cancel_async(struct pcfetcher* fetcher,
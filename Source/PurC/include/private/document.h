@@ -152,6 +152,8 @@ struct pcdoc_elem_content {
     pcutils_str_t      *data;
 };
 
+struct pcdoc_elem_index;
+
 struct purc_document {
     purc_document_type_k type;
     pcrdr_msg_data_type def_text_type;
@@ -160,6 +162,7 @@ struct purc_document {
     unsigned data_content:1;
     unsigned have_head:1;
     unsigned have_body:1;
+    unsigned walked:1;  /* a query walked the tree at `walk_age` */
 
     unsigned refc;
     unsigned age;
@@ -169,7 +172,19 @@ struct purc_document {
     /* owners of this document */
     struct list_head owner_list;
 
+    /* the element collections patched in place when the document changes */
+    struct list_head live_colls;
+
     pcdoc_element_t root4select;
+
+    /* the compiled selectors cached by their text */
+    pcutils_uomap *selectors;
+
+    /* the elements by tag name and class name; valid if `index_age`
+       equals `age`. */
+    struct pcdoc_elem_index *elem_index;
+    unsigned index_age;
+    unsigned walk_age;
     struct purc_document_ops *ops;
 
     void *impl;
@@ -203,6 +218,10 @@ struct pcdoc_elem_coll {
     pcdoc_elem_coll_t parent;
     /* the elements in the collection */
     struct pcutils_arrlist *elems;
+
+    /* the node in doc::live_colls; empty if the collection is re-queried
+       when the document changes */
+    struct list_head live_ln;
 };
 
 struct css_element_selector;
@@ -210,6 +229,11 @@ struct pcdoc_selector {
     struct css_element_selector *selector;
     char       *id;
     unsigned    refc;
+
+    /* the lower-cased tag name or class name to look up the elements
+       which may match a compound selector like `p.foo` in the index */
+    char       *index_tag;
+    char       *index_class;
 };
 
 
@@ -123,6 +123,8 @@ struct purc_exec_inst {
     char                       *err_msg;
 
     purc_variant_t              value;
+
+    char                       *rule;   // the rule parsed last
 };
 
 struct pcinst;
@@ -132,6 +134,13 @@ void pcexecutor_get_debug(int *debug_flex, int *debug_bison);
 
 void pcexecutor_inst_reset(struct purc_exec_inst *inst);
 
+/* Returns false if the rule is the one the instance parsed last, so that
+ * the parsed rule can be kept. */
+bool pcexecutor_inst_rule_changed(struct purc_exec_inst *inst,
+        const char *rule);
+
+void pcexecutor_inst_set_rule(struct purc_exec_inst *inst, const char *rule);
+
 
 int pcexecutor_register(pcexec_ops_t ops);
 
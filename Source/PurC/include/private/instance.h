@@ -45,6 +45,7 @@ typedef struct pcmodule pcmodule;
 typedef struct pcmodule *pcmodule_t;
 
 struct pcinst_msg_queue;
+struct pcinst_move_buffer;
 
 typedef int (*module_init_once_f)(void);
 typedef int (*module_init_instance_f)(struct pcinst *curr_inst,
@@ -110,6 +111,9 @@ struct pcinst {
     struct pcintr_heap     *intr_heap;
     purc_runloop_t          running_loop;
 
+    /* the move buffer of this instance; accessed by the owner only */
+    struct pcinst_move_buffer *move_buff;
+
     /* FIXME: enable the fields ONLY when NDEBUG is undefined */
     struct pcdebug_backtrace  *bt;
 
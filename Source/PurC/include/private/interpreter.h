@@ -123,6 +123,8 @@ struct pcintr_cancel {
     struct list_head             node;
 };
 
+struct pcintr_rdr_dom_batch;
+
 struct pcintr_heap {
     // owner instance
     struct pcinst      *owner;
@@ -136,17 +138,33 @@ struct pcintr_heap {
 
     size_t              nr_stopped_crtns;
 
+    /* coroutines which are ready to run */
+    struct list_head    ready_crtns;
+    /* coroutines which have pending messages or observer tasks */
+    struct list_head    event_crtns;
+    /* number of coroutines observing the idle event */
+    size_t              nr_idle_observers;
+
+    /* the renderer connection being watched and its fd monitor */
+    struct pcrdr_conn  *watched_conn;
+    uintptr_t           conn_monitor;
+
     pcutils_map        *name_chan_map;  // name to channel map.
     pcutils_map        *token_crtn_map; // token to crtn map.
 
     /* coroutines which were loaded to the renderer */
     struct sorted_array *loaded_crtn_handles;
 
+    /* DOM operations batched in the current time slice */
+    struct pcintr_rdr_dom_batch *dom_batch;
+
     purc_atom_t         move_buff;
     pcintr_timer_t     *event_timer;    // 10ms
 
     purc_cond_handler   cond_handler;
     unsigned int        keep_alive:1;
+    /* the scheduler is parked and waits for a wakeup */
+    unsigned int        parked:1;
     double              timestamp;
 };
 
@@ -331,6 +349,10 @@ struct pcintr_coroutine {
 
     struct rb_node              node;     /* heap::coroutines */
     struct list_head            ln;       /* heap::crtns, stopped_crtns */
+    struct list_head            ready_ln; /* heap::ready_crtns */
+    struct list_head            event_ln; /* heap::event_crtns */
+    unsigned int                in_ready_queue:1;
+    unsigned int                in_event_queue:1;
 
     struct list_head            doc_node;   /* doc::owner_list */
 
@@ -570,6 +592,13 @@ void pcintr_stop_coroutine(pcintr_coroutine_t crtn,
 /* resume the specific coroutine */
 void pcintr_resume_coroutine(pcintr_coroutine_t crtn) WTF_INTERNAL;
 
+/* put the coroutine into the ready queue of the scheduler */
+void pcintr_coroutine_queue_ready(pcintr_coroutine_t crtn) WTF_INTERNAL;
+/* put the coroutine into the event queue of the scheduler */
+void pcintr_coroutine_queue_event(pcintr_coroutine_t crtn) WTF_INTERNAL;
+/* remove the coroutine from the queues of the scheduler */
+void pcintr_coroutine_dequeue(pcintr_coroutine_t crtn) WTF_INTERNAL;
+
 void pcintr_check_after_execution(void);
 void pcintr_set_current_co_with_location(pcintr_coroutine_t co,
         const char *file, int line, const char *func);
@@ -44,6 +44,12 @@ struct pcinst_msg_hdr {
     struct list_head        ln;
 };
 
+struct pcinst_msg_queue;
+
+/* called after a message was put into the queue */
+typedef void (*pcinst_msg_queue_notify_fn)(struct pcinst_msg_queue *queue,
+        void *ctxt);
+
 struct pcinst_msg_queue {
     struct purc_rwlock  lock;
     struct list_head    req_msgs;
@@ -53,6 +59,15 @@ struct pcinst_msg_queue {
 
     uint64_t            state;
     size_t              nr_msgs;
+
+    /* the events in `event_msgs` hashed by target, target value,
+       event name, and element; allocated on the first event. */
+    struct list_head   *event_buckets;
+    size_t              nr_event_buckets;
+    size_t              nr_indexed_events;
+
+    pcinst_msg_queue_notify_fn  notify;
+    void                       *notify_ctxt;
 };
 
 /* Make sure the size of `struct list_head` is two times of sizeof(void *) */
@@ -72,6 +87,10 @@ pcinst_msg_queue_create(void);
 ssize_t
 pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue);
 
+void
+pcinst_msg_queue_set_notifier(struct pcinst_msg_queue *queue,
+        pcinst_msg_queue_notify_fn notify, void *ctxt);
+
 int
 pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg);
 
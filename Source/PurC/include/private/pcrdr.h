@@ -90,6 +90,14 @@ struct renderer_capabilities {
     /* the element selectors supported */
     unsigned    selectors;
 
+    /* the max number of DOM operations in one `batch` request;
+       0 for not supported (Since 0.9.22) */
+    int    batchOperations;
+
+    /* the newest version of the binary encoding of variants accepted
+       in `binary` data; 0 for not supported */
+    int    binaryData;
+
     /* the session handle */
     uint64_t    session_handle;
     /* the default workspace handle */
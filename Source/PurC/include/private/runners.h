@@ -28,6 +28,7 @@
 #include <stdbool.h>
 
 #include "purc-pcrdr.h"
+#include "purc-runloop.h"
 #include "private/utils.h"
 
 #define PCRUN_INSTMGR_APP_NAME      "cn.fmsoft.hvml.instmgr"
@@ -89,6 +90,20 @@ pcrun_instmgr_handle_message(void *ctxt) WTF_INTERNAL;
 void
 pcrun_notify_instmgr(const char* event, purc_atom_t inst_crtn_id) WTF_INTERNAL;
 
+/* Parks the idle callback (the scheduler) of the run loop until it is woken
+   up or the timeout (in milliseconds, negative for ever) expires. */
+void
+pcrun_park_idle_callback(purc_runloop_t runloop, long timeout_ms) WTF_INTERNAL;
+
+/* Wakes up the parked idle callback of the run loop; thread-safe. */
+void
+pcrun_wakeup_idle_callback(purc_runloop_t runloop) WTF_INTERNAL;
+
+/* Wakes up the idle callback of the run loop when the fd becomes readable.
+   Remove the monitor by calling purc_runloop_remove_fd_monitor(). */
+uintptr_t
+pcrun_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd) WTF_INTERNAL;
+
 PCA_EXTERN_C_END
 
 #endif /* not defined PURC_PRIVATE_RUNNERS_H */
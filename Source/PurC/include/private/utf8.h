@@ -36,6 +36,12 @@
 extern "C" {
 #endif  /* __cplusplus */
 
+/* Returns the length of the leading run of ASCII characters other than
+   the null byte in `str`, not longer than `len`. Uses the vector
+   instructions of the CPU if available. */
+size_t
+pcutils_ascii_span(const char *str, size_t len);
+
 #ifdef __cplusplus
 }
 #endif  /* __cplusplus */
@@ -50,10 +50,16 @@ PCA_EXTERN_C_BEGIN
 #ifndef NDEBUG
 // VW (NOTE): use 0 for easy finding memory leaks.
 #define MAX_RESERVED_VARIANTS   0
+#define MAX_RESERVED_NODES      0
 #else
 #define MAX_RESERVED_VARIANTS   32
+#define MAX_RESERVED_NODES      256     // for each size class
 #endif
 
+// the size classes (in 16 bytes) of the reserved nodes: 16, 32, ..., 128
+#define NODE_SIZE_CLASS_SHIFT   4
+#define NR_NODE_SIZE_CLASSES    8
+
 #define DEF_EMBEDDED_LEVELS     64
 #define MAX_EMBEDDED_LEVELS     1024
 
@@ -84,6 +90,12 @@ PCA_EXTERN_C_BEGIN
 #define PCVAR_LISTENER_PRE   (0x00)
 #define PCVAR_LISTENER_POST  (0x01)
 
+// the post listener only cares that the container changed; in a batch,
+// it is called once per operation instead of once per member.
+#define PCVAR_LISTENER_COALESCE         (0x02)
+// the marker of a batch in progress, never called.
+#define PCVAR_LISTENER_BATCH            (0x04)
+
 struct pcvar_listener {
     // the operation in which this listener is intersted.
     pcvar_op_t          op;
@@ -91,7 +103,7 @@ struct pcvar_listener {
     // the context for the listener
     void*               ctxt;
 
-    // flags of the listener; only one flag currently: PRE or POST.
+    // flags of the listener: PRE or POST, and the other flags above.
     unsigned int        flags;
 
     // the operation handler
@@ -211,6 +223,12 @@ struct pcvariant_heap {
 #else
     struct list_head    v_reserved;
 #endif
+
+    // the reserved blocks of container nodes, container data, and listeners
+    // for each size class; the first word of a block links to the next one.
+    void               *node_reserved[NR_NODE_SIZE_CLASSES];
+    size_t              nr_node_reserved[NR_NODE_SIZE_CLASSES];
+    size_t              max_node_reserved;
 };
 
 // internal interfaces for moving variant.
@@ -224,6 +242,12 @@ purc_variant *pcvariant_alloc(void) WTF_INTERNAL;
 purc_variant *pcvariant_alloc_0(void) WTF_INTERNAL;
 void pcvariant_free(purc_variant *v) WTF_INTERNAL;
 
+// allocate a zeroed block for a container node or other small structure,
+// recycling the blocks reserved by the heap of the current instance.
+void *pcvariant_node_alloc(size_t size) WTF_INTERNAL;
+// `size` must be the same as the one passed to pcvariant_node_alloc().
+void pcvariant_node_free(void *node, size_t size) WTF_INTERNAL;
+
 struct pcinst;
 struct tuple_node;
 
@@ -233,7 +257,7 @@ struct pcvar_rev_update_edge {
         // where to locate in parent
         struct set_node             *set_me;
         struct obj_node             *obj_me;
-        struct arr_node             *arr_me;
+        purc_variant_t               arr_me;    // the parent array itself
         struct tuple_node           *tuple_me;
     };
 };
@@ -244,8 +268,9 @@ typedef struct variant_set      *variant_set_t;
 struct set_node {
     struct rb_node                       rbnode;
     struct pcutils_array_list_node       alnode;
+    struct set_node *hash_next;     // next node in the same hash bucket
     purc_variant_t   val;  // actual variant-element
-    char             md5[33];
+    uint64_t         hash; // hash of the unique key(s)
 };
 
 struct variant_set {
@@ -256,6 +281,13 @@ struct variant_set {
     struct rb_root          elems;  // multiple-variant-elements stored in set
     struct pcutils_array_list al;    // struct set_node
 
+    // hash index of the members; not used by caseless sets, which are
+    // looked up through `elems`.
+    struct set_node       **buckets;
+    size_t                  nr_buckets;
+    // number of members not linked into `elems` yet
+    size_t                  nr_unordered;
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -268,12 +300,19 @@ struct obj_node {
     struct rb_node   node;
     purc_variant_t   key;
     purc_variant_t   val;
+    struct obj_node *hash_next; // next node in the same bucket
+    uint32_t         hash;      // hash of the key string
 };
 
 struct variant_obj {
     struct rb_root          kvs;  // struct obj_node*
     size_t                  size;
 
+    // hash index of the properties by key; small objects have no index
+    // and are looked up by scanning the cached hashes of the keys.
+    struct obj_node       **buckets;
+    size_t                  nr_buckets;
+
     // key: arr_node/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
@@ -282,17 +321,23 @@ struct variant_obj {
 // internal struct used by variant-arr
 typedef struct variant_arr      *variant_arr_t;
 
-struct arr_node {
-    struct pcutils_array_list_node       node;
-    purc_variant_t   val;
-};
-
 struct variant_arr {
-    struct pcutils_array_list     al;  // struct arr_node*
+    purc_variant_t                *members;
+    size_t                         nr_members;
+    size_t                         sz_members; // capacity of `members`
 
-    // key: arr_node/obj_node/set_node
+    // ring of the arrays sharing `members` (copy-on-write); NULL if owned
+    struct variant_arr            *cow_prev;
+    struct variant_arr            *cow_next;
+
+    // key: parent array/obj_node/set_node
     // val: parent
     pcutils_map                     *rev_update_chain;
+
+    // the number of slots holding each member; only when in a set
+    // key: member
+    // val: count (uintptr_t)
+    pcutils_map                     *slot_counts;
 };
 
 
@@ -314,9 +359,43 @@ struct variant_tuple {
 
 int pcvariant_array_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
+
+/* Gives the array a private copy of its members if they are shared with
+ * a clone; must be called before writing to `array_members()` directly. */
+int pcvariant_array_unshare(purc_variant_t value);
+
+static inline bool
+pcvariant_array_is_shared(purc_variant_t value)
+{
+    variant_arr_t data = (variant_arr_t)value->sz_ptr[1];
+    return data && data->cow_next;
+}
+
 int pcvariant_set_sort(purc_variant_t value, void *ud,
         int (*cmp)(purc_variant_t l, purc_variant_t r, void *ud));
 
+/* The sort key extracted from a member once before sorting. */
+struct pcvrnt_sort_key {
+    const char     *str;    // NULL for a number key or a missing value
+    char           *buf;    // the string owned by the key, if not NULL
+    double          num;
+};
+
+/* Fills `key` with the number or the string form of `v` (may be NULL). */
+int pcvariant_make_sort_key(purc_variant_t v, bool by_number,
+        struct pcvrnt_sort_key *key);
+
+typedef int (*pcvrnt_make_sort_keys_f)(purc_variant_t member,
+        struct pcvrnt_sort_key *keys, void *ud);
+typedef int (*pcvrnt_cmp_sort_keys_f)(const struct pcvrnt_sort_key *l,
+        const struct pcvrnt_sort_key *r, void *ud);
+
+/* Sorts the members of an array or a set stably: `make_keys` extracts
+ * `nr_keys` keys of every member once, then the members are ordered by
+ * comparing their keys with `cmp_keys`. */
+int pcvariant_sort_by_keys(purc_variant_t value, size_t nr_keys, void *ud,
+        pcvrnt_make_sort_keys_f make_keys, pcvrnt_cmp_sort_keys_f cmp_keys);
+
 int pcvariant_diff(purc_variant_t l, purc_variant_t r);
 int pcvariant_diff_ex(purc_variant_t l, purc_variant_t r,
         enum pcvrnt_compare_method opt);
@@ -371,6 +450,39 @@ char* pcvariant_to_string(purc_variant_t v);
 
 purc_variant_t pcvariant_make_object(size_t nr_kvs, ...);
 
+/* Makes a variant from strict JSON text without going through the eJSON
+ * parser. Returns PURC_VARIANT_INVALID if @json is not strict JSON or uses
+ * eJSON extensions; the caller then falls back to the eJSON parser. */
+purc_variant_t
+pcvariant_make_from_strict_json(const char *json, size_t sz) WTF_INTERNAL;
+
+/* The same as pcvariant_make_from_strict_json(), but reads the text from
+ * @stream through a window of fixed size. */
+purc_variant_t
+pcvariant_load_from_strict_json_stream(purc_rwstream_t stream) WTF_INTERNAL;
+
+/* The version of the binary encoding written by
+ * pcvariant_serialize_binary(); the loaders accept all versions up to it. */
+#define PCVRNT_BINARY_VERSION       1
+
+/* Writes @value to @out in the compact binary encoding. Returns the number
+ * of bytes written, or -1 on failure. */
+ssize_t
+pcvariant_serialize_binary(purc_variant_t value, purc_rwstream_t out);
+
+/* Loads a variant from the binary encoding in the buffer @buf of @sz bytes,
+ * and returns the number of bytes used in @consumed (nullable). If
+ * @static_strings is true, the strings and byte sequences refer to @buf
+ * instead of copies, so @buf must outlive the variant (e.g. a mapped file). */
+purc_variant_t
+pcvariant_load_from_binary(const void *buf, size_t sz, bool static_strings,
+        size_t *consumed);
+
+/* Loads a variant from the binary encoding in @in; only the bytes of the
+ * value are read from the stream. */
+purc_variant_t
+pcvariant_load_from_binary_stream(purc_rwstream_t in);
+
 WTF_ATTRIBUTE_PRINTF(1, 2)
 purc_variant_t pcvariant_make_with_printf(const char *fmt, ...);
 
@@ -397,6 +509,19 @@ void pcvariant_on_post_fired(
         purc_variant_t *argv    // the array of all relevant child variants.
         );
 
+/* Registers a post listener with PCVAR_LISTENER_COALESCE set. */
+struct pcvar_listener*
+pcvariant_register_coalescing_listener(purc_variant_t v,
+        pcvar_op_t op, pcvar_op_handler handler, void *ctxt);
+
+/* Starts or ends a batch of mutations on the container @v. In a batch,
+ * the coalescing listeners are not called per mutation; the outermost
+ * pcvariant_end_batch() calls them once for every operation fired in the
+ * batch, with the arguments of the last one. The other listeners are
+ * called as usual. Both are no-ops if nobody listens to @v. */
+void pcvariant_begin_batch(purc_variant_t v);
+void pcvariant_end_batch(purc_variant_t v);
+
 purc_variant_t pcvariant_set_find (purc_variant_t set, purc_variant_t value);
 
 static inline bool
@@ -417,6 +542,17 @@ pcvariant_array_clear(purc_variant_t array, bool silently);
 bool
 pcvariant_set_clear(purc_variant_t set, bool silently);
 
+static inline
+purc_variant_t *array_members(purc_variant_t array, size_t *sz)
+{
+    if (UNLIKELY(!(array && array->type == PVT(_ARRAY))))
+        return NULL;
+
+    variant_arr_t data = (variant_arr_t) array->sz_ptr[1];
+    *sz = data->nr_members;
+    return data->members;
+}
+
 static inline
 purc_variant_t *tuple_members(purc_variant_t tuple, size_t *sz)
 {
@@ -428,27 +564,22 @@ purc_variant_t *tuple_members(purc_variant_t tuple, size_t *sz)
     return data->members;
 }
 
-// md5 shall be at least 33 bytes long
-void pcvariant_md5_ex(char *md5, purc_variant_t val, const char *salt,
-    bool caseless, unsigned int serialize_flags) WTF_INTERNAL;
-
-PCA_INLINE void
-pcvariant_md5(char *md5, purc_variant_t val)
-{
-    const char *salt = NULL;
-    unsigned int serialize_flags = 0;
-    bool caseless = false;
-    pcvariant_md5_ex(md5, val, salt, caseless, serialize_flags);
-}
+// hash of the stringified text of val; values of which the texts are equal
+// have the same hash.
+uint64_t
+pcvariant_hash_text(purc_variant_t val) WTF_INTERNAL;
 
-// md5 shall be at least 33 bytes long
+// links the members added since last time into the ordered tree of the set
 void
-pcvariant_md5_by_set(char *md5, purc_variant_t val,
-        purc_variant_t set) WTF_INTERNAL;
+pcvariant_set_order_members(purc_variant_t set) WTF_INTERNAL;
 
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set);
+static inline void
+pcvariant_set_ensure_order(purc_variant_t set)
+{
+    variant_set_t data = (variant_set_t)set->sz_ptr[1];
+    if (data && data->nr_unordered)
+        pcvariant_set_order_members(set);
+}
 
 bool
 pcvariant_is_sorted_array(purc_variant_t v);
@@ -499,65 +630,63 @@ do {                                            \
 
 // purc_variant_t _arr;
 #define variant_array_get_data(_arr)        \
-    &(((variant_arr_t)_arr->sz_ptr[1])->al)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array(_arr, _p)                               \
-    array_list_for_each_entry(variant_array_get_data(_arr),              \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_safe(_arr, _p, _n)                      \
-    array_list_for_each_entry_safe(variant_array_get_data(_arr),         \
-            _p, _n, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p;
-#define foreach_in_variant_array_reverse(_arr, _p)                       \
-    array_list_for_each_entry_reverse(variant_array_get_data(_arr),      \
-            _p, node)
-
-// purc_variant_t _arr;
-// struct arr_node *_p, *_n;
-#define foreach_in_variant_array_reverse_safe(_arr, _p, _n)              \
-    array_list_for_each_entry_reverse_safe(variant_array_get_data(_arr), \
-            _p, _n, node)
+    ((variant_arr_t)_arr->sz_ptr[1])
 
+/*
+ * In the body of the following macros, `_p` points to the slot of the
+ * current member, i.e., `*_p == _val`.
+ *
+ * The members are re-read from the array on every iteration, so the body
+ * of a _safe version may remove the current member.
+ */
 #define foreach_value_in_variant_array(_arr, _val, _idx)              \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array(_arr, _p) {                          \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        purc_variant_t *_p;                                           \
+        for (size_t _i = 0; _i < _data->nr_members; _i++) {           \
+            _p = _data->members + _i;                                 \
+            _val = *_p;                                               \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_safe(_arr, _val, _idx)      \
     do {                                                           \
-        struct arr_node *_p, *_n;                                  \
-        foreach_in_variant_array_safe(_arr, _p, _n) {              \
-            _val = _p->val;                                        \
-            _idx = _p->node.idx;                                   \
+        variant_arr_t _data = variant_array_get_data(_arr);        \
+        purc_variant_t *_p;                                        \
+        for (size_t _i = 0, _n = _data->nr_members;                \
+                _i < _data->nr_members;                            \
+                _i += (_data->nr_members < _n) ? 0 : 1,            \
+                _n = _data->nr_members) {                          \
+            _p = _data->members + _i;                              \
+            _val = *_p;                                            \
+            _idx = _i;                                             \
      /* } */                                                       \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_reverse(_arr, _val, _idx)      \
     do {                                                              \
-        struct arr_node *_p;                                          \
-        foreach_in_variant_array_reverse(_arr, _p) {                  \
-            _val = _p->val;                                           \
-            _idx = _p->node.idx;                                      \
+        variant_arr_t _data = variant_array_get_data(_arr);           \
+        purc_variant_t *_p;                                           \
+        for (size_t _i = _data->nr_members; _i > 0; ) {               \
+            _p = _data->members + (--_i);                             \
+            _val = *_p;                                               \
+            _idx = _i;                                                \
      /* } */                                                          \
  /* } while (0) */
 
 #define foreach_value_in_variant_array_reverse_safe(_arr, _val, _idx)   \
     do {                                                                \
-        struct arr_node *_p, *_n;                                       \
-        foreach_in_variant_array_reverse_safe(_arr, _p, _n) {           \
-            _val = _p->val;                                             \
-            _idx = _p->node.idx;                                        \
+        variant_arr_t _data = variant_array_get_data(_arr);             \
+        purc_variant_t *_p;                                             \
+        for (size_t _i = _data->nr_members; _i > 0; ) {                 \
+            if (--_i >= _data->nr_members) {                            \
+                _i = _data->nr_members;                                 \
+                continue;                                               \
+            }                                                           \
+            _p = _data->members + _i;                                   \
+            _val = *_p;                                                 \
+            _idx = _i;                                                  \
      /* } */                                                            \
  /* } while (0) */
 
@@ -681,6 +810,7 @@ do {                                            \
     do {                                                                \
         variant_set_t _data;                                            \
         struct rb_node *_first;                                         \
+        pcvariant_set_ensure_order(_set);                               \
         _data = (variant_set_t)_set->sz_ptr[1];                         \
         _first = pcutils_rbtree_first(&_data->elems);                   \
         if (!_first)                                                    \
@@ -698,6 +828,7 @@ do {                                            \
     do {                                                                \
         variant_set_t _data;                                            \
         struct rb_node *_first;                                         \
+        pcvariant_set_ensure_order(_set);                               \
         _data = (variant_set_t)_set->sz_ptr[1];                         \
         _first = pcutils_rbtree_last(&_data->elems);                    \
         if (!_first)                                                    \
@@ -715,6 +846,7 @@ do {                                            \
     do {                                                                \
         variant_set_t _data;                                            \
         struct rb_node *_first;                                         \
+        pcvariant_set_ensure_order(_set);                               \
         _data = (variant_set_t)_set->sz_ptr[1];                         \
         _first = pcutils_rbtree_first(&_data->elems);                   \
         if (!_first)                                                    \
@@ -732,6 +864,7 @@ do {                                            \
     do {                                                                \
         variant_set_t _data;                                            \
         struct rb_node *_last;                                          \
+        pcvariant_set_ensure_order(_set);                               \
         _data = (variant_set_t)_set->sz_ptr[1];                         \
         _last = pcutils_rbtree_last(&_data->elems);                     \
         if (!_last)                                                     \
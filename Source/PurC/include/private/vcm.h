@@ -103,6 +103,8 @@ enum pcvcm_node_type {
 #define PCVCM_NODE_TYPE_NR \
     (PCVCM_NODE_TYPE_LAST - PCVCM_NODE_TYPE_FIRST + 1)
 
+struct pcvcm_eval_plan;
+
 struct pcvcm_node {
     struct pctree_node tree_node;
     enum pcvcm_node_type type;
@@ -111,6 +113,7 @@ struct pcvcm_node {
     int32_t   idx;
     int32_t   nr_nodes; /* nr_nodes of the tree */
     bool is_closed;
+    struct pcvcm_eval_plan *plan; /* cached evaluation plan of the tree */
     union {
         bool        b;
         double      d;
@@ -225,6 +228,15 @@ pcvcm_node_first_child(struct pcvcm_node *node)
     return NULL;
 }
 
+static inline struct pcvcm_node *
+pcvcm_node_next_child(struct pcvcm_node *node)
+{
+    if (node) {
+        return (struct pcvcm_node *)pctree_node_next(&node->tree_node);
+    }
+    return NULL;
+}
+
 static inline struct pcvcm_node *
 pcvcm_node_last_child(struct pcvcm_node *node)
 {
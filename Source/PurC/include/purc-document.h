@@ -1292,6 +1292,23 @@ pcdoc_selector_new(const char *selector);
 PCA_EXPORT int
 pcdoc_selector_delete(pcdoc_selector_t selector);
 
+/**
+ * pcdoc_document_get_selector:
+ *
+ * @doc: The pointer to a document.
+ * @selector: The selector string.
+ *
+ * Gets the compiled selector from the cache of the document, or compiles
+ * it and puts it in the cache if it has not been used for the document.
+ *
+ * Returns: the pointer to the selector which should be deleted by calling
+ *  pcdoc_selector_delete() after using it, or %NULL for a bad selector.
+ *
+ * Since: 0.9.22
+ */
+PCA_EXPORT pcdoc_selector_t
+pcdoc_document_get_selector(purc_document_t doc, const char *selector);
+
 
 /**
  * pcdoc_get_element_by_id_in_descendants:
@@ -161,9 +161,11 @@ typedef enum {
 #define PCRDR_OPERATION_GETPROPERTY         "getProperty"
     PCRDR_K_OPERATION_SETPROPERTY,
 #define PCRDR_OPERATION_SETPROPERTY         "setProperty"
+    PCRDR_K_OPERATION_BATCH,
+#define PCRDR_OPERATION_BATCH               "batch"
 
     /* XXX: change this when you append a new operation */
-    PCRDR_K_OPERATION_LAST = PCRDR_K_OPERATION_SETPROPERTY,
+    PCRDR_K_OPERATION_LAST = PCRDR_K_OPERATION_BATCH,
 } pcrdr_operation_k;
 
 #define PCRDR_NR_OPERATIONS \
@@ -256,6 +258,7 @@ typedef enum {
 #define PCRDR_MIN_PACKET_BUFF_SIZE      512
 #define PCRDR_DEF_PACKET_BUFF_SIZE      1024
 #define PCRDR_DEF_TIME_EXPECTED         5   /* 5 seconds */
+#define PCRDR_DEF_MAX_PENDING_REQUESTS  8   /* requests in flight */
 
 /* the maximal size of a payload in a frame (4KiB) */
 #define PCRDR_MAX_FRAME_PAYLOAD_SIZE    4096
@@ -515,6 +518,24 @@ pcrdr_conn_set_poll_timeout(pcrdr_conn *conn, int timeout_ms);
 PCA_EXPORT size_t
 pcrdr_conn_pending_requests_count(pcrdr_conn *conn);
 
+/**
+ * Set the max number of requests in flight.
+ *
+ * @param conn: the pointer to the renderer connection.
+ * @param max_pending: the max number of pending requests; zero for
+ *  the default value (\a PCRDR_DEF_MAX_PENDING_REQUESTS).
+ *
+ * When the number of pending requests reaches the limit,
+ * \a pcrdr_send_request() will read and dispatch the incoming messages
+ * until a slot is released before sending the new request.
+ *
+ * Returns the old limit.
+ *
+ * Since: 0.9.22
+ */
+PCA_EXPORT size_t
+pcrdr_conn_set_max_pending_requests(pcrdr_conn *conn, size_t max_pending);
+
 /**
  * Get the server host name of a connection.
  *
@@ -709,9 +730,13 @@ typedef enum {
     PCRDR_MSG_DATA_TYPE_XGML,
 #define PCRDR_MSG_DATA_TYPE_NAME_XML            "xml"
     PCRDR_MSG_DATA_TYPE_XML,
+    /* a variant in the compact binary encoding; only used on the wire,
+       the parsed messages carry the variant as `json` data. */
+#define PCRDR_MSG_DATA_TYPE_NAME_BINARY         "binary"
+    PCRDR_MSG_DATA_TYPE_BINARY,
 
     /* XXX: change this if you append a new enumerator */
-    PCRDR_MSG_DATA_TYPE_LAST = PCRDR_MSG_DATA_TYPE_XML,
+    PCRDR_MSG_DATA_TYPE_LAST = PCRDR_MSG_DATA_TYPE_BINARY,
 } pcrdr_msg_data_type;
 
 #define PCRDR_MSG_DATA_TYPE_NR     \
@@ -1102,6 +1127,22 @@ pcrdr_send_request(pcrdr_conn *conn, pcrdr_msg *request_msg,
 PCA_EXPORT int
 pcrdr_send_event(pcrdr_conn *conn, pcrdr_msg *event_msg);
 
+/**
+ * Wait for all pending requests to complete.
+ *
+ * @param conn: the pointer to the renderer connection.
+ *
+ * This function reads and dispatches the incoming messages until
+ * the response handlers of all pending requests have been called
+ * (with the result, or for timeout).
+ *
+ * Returns: -1 for error; zero means everything is ok.
+ *
+ * Since: 0.9.22
+ */
+PCA_EXPORT int
+pcrdr_wait_pending_requests(pcrdr_conn *conn);
+
 /**
  * Read and dispatch the message from the renderer connection.
  *
@@ -284,6 +284,36 @@ PCA_EXPORT int
 purc_rwstream_read_utf8_char (purc_rwstream_t rws,
         char* buf_utf8, uint32_t* buf_wc);
 
+/* The code point stored for a malformed character by
+ * purc_rwstream_read_utf8_chars(). */
+#define PCRWSTREAM_INVALID_CHAR     0xFFFFFFFF
+
+/**
+ * Reads characters (UTF-8) from purc_rwstream_t in blocks and converts them
+ * to Unicode code points.
+ *
+ * @param rws: purc_rwstream_t
+ * @param buf_wc: the buffer to convert characters into
+ * @param nr_wcs: the maximal number of characters to read
+ *
+ * The stream is never read beyond the last character stored in @buf_wc,
+ * so this function can be mixed with the other read functions. A character
+ * which purc_rwstream_read_utf8_char() would reject is stored as
+ * @PCRWSTREAM_INVALID_CHAR; a character truncated by the end of the stream
+ * is stored as @PCRWSTREAM_INVALID_CHAR and ends the read. The function
+ * returns early after a short read, so it does not block on a pipe which
+ * already gave some data.
+ *
+ * @return the number of characters stored in @buf_wc, 0 on the end of
+ *         the stream, or -1 on error with the error code set as
+ *         purc_rwstream_read() does.
+ *
+ * Since: 0.9.22
+ */
+PCA_EXPORT ssize_t
+purc_rwstream_read_utf8_chars (purc_rwstream_t rws,
+        uint32_t* buf_wc, size_t nr_wcs);
+
 
 /**
  * Write data to purc_rwstream_t
@@ -3254,6 +3254,11 @@ struct purc_variant_stat {
     size_t sz_total_mem;
     size_t nr_reserved;
     size_t nr_max_reserved;
+    /* the reserved blocks of container nodes; not counted in sz_total_mem */
+    size_t nr_reserved_nodes;
+    size_t sz_reserved_nodes;
+    /* the maximal number of reserved blocks for each size class */
+    size_t nr_max_reserved_nodes;
 };
 
 /**
@@ -39,6 +39,7 @@
 #include "private/utils.h"
 #include "private/ports.h"
 #include "private/debug.h"
+#include "private/runners.h"
 
 #include <stdatomic.h>
 #include <assert.h>
@@ -49,20 +50,35 @@
 
 #define NR_DEF_MAX_MSGS     4
 
+struct pcrdr_msg_hdr;
+
+/*
+ * Other instances push messages onto `inbox` without any lock; only the
+ * owner instance pops them, moving all of them at once to `msgs`.
+ */
 struct pcinst_move_buffer {
-    struct purc_rwlock  lock;
-    struct list_head    msgs;
+    _Atomic(struct pcrdr_msg_hdr *) inbox;  // LIFO, newest first
+    struct list_head    msgs;               // FIFO, owner only
+    size_t              nr_taken;           // the messages in `msgs`
 
     unsigned int        flags;
     size_t              max_nr_msgs;
-    size_t              nr_msgs;
+
+    /* the messages in both `inbox` and `msgs`, to limit the producers */
+    atomic_size_t       nr_msgs;
+
+    /* the run loop to wake up when a message is moved in */
+    purc_runloop_t      runloop;
 };
 
 /* the header of the struct pcrdr_msg */
 struct pcrdr_msg_hdr {
     atomic_uint             refcnt;
     purc_atom_t             origin;
-    struct list_head        ln;
+    union {
+        struct list_head        ln;     // in `msgs`
+        struct pcrdr_msg_hdr   *next;   // in `inbox`
+    };
 };
 
 /* Make sure the size of `struct list_head` is two times of sizeof(void *) */
@@ -198,35 +214,26 @@ purc_inst_create_move_buffer(unsigned int flags, size_t max_msgs)
         goto done;
     }
 
-    purc_rwlock_init(&mb->lock);
-    if (mb->lock.native_impl == NULL) {
-        errcode = PURC_ERROR_BAD_SYSTEM_CALL;
-        goto done;
-    }
-
     if (pcutils_sorted_array_add(mb_atom2buff_map,
                 (void *)(uintptr_t)atom, mb, NULL) < 0) {
         errcode = PURC_ERROR_OUT_OF_MEMORY;
         goto done;
     }
 
+    atomic_init(&mb->inbox, NULL);
+    atomic_init(&mb->nr_msgs, 0);
     mb->flags = flags;
-    mb->nr_msgs = 0;
     mb->max_nr_msgs = (max_msgs > 0) ? max_msgs : NR_DEF_MAX_MSGS;
+    mb->runloop = inst->running_loop;
     list_head_init(&mb->msgs);
+    mb->nr_taken = 0;
+    inst->move_buff = mb;
 
 done:
     purc_rwlock_writer_unlock(&mb_lock);
 
     if (errcode) {
-        if (mb) {
-            if (mb->lock.native_impl) {
-                purc_rwlock_clear(&mb->lock);
-            }
-
-            free(mb);
-        }
-
+        free(mb);
         purc_set_error(errcode);
         return 0;
     }
@@ -234,6 +241,22 @@ done:
     return atom;
 }
 
+/* moves the messages in the inbox to the tail of `msgs` in arrival order */
+static void
+take_inbox(struct pcinst_move_buffer *mb)
+{
+    struct pcrdr_msg_hdr *hdr, *next;
+    struct list_head *tail = mb->msgs.prev;
+
+    hdr = atomic_exchange_explicit(&mb->inbox, NULL, memory_order_acquire);
+    while (hdr) {
+        next = hdr->next;
+        list_add(&hdr->ln, tail);
+        mb->nr_taken++;
+        hdr = next;
+    }
+}
+
 static void
 pcinst_grind_message(pcrdr_msg *msg)
 {
@@ -281,8 +304,10 @@ purc_inst_destroy_move_buffer(void)
         goto done;
     }
 
+    /* no one can move a message in while we hold the writer lock */
+    take_inbox(mb);
+
     struct list_head *p, *n;
-    purc_rwlock_writer_lock(&mb->lock);
     pcvariant_use_move_heap();
     list_for_each_safe(p, n, &mb->msgs) {
 
@@ -291,16 +316,16 @@ purc_inst_destroy_move_buffer(void)
         hdr = list_entry(p, struct pcrdr_msg_hdr, ln);
 
         list_del(p);
-        mb->nr_msgs--;
+        mb->nr_taken--;
+        atomic_fetch_sub(&mb->nr_msgs, 1);
 
         pcinst_grind_message((pcrdr_msg *)hdr);
         nr++;
     }
     pcvariant_use_norm_heap();
-    purc_rwlock_writer_unlock(&mb->lock);
 
     pcutils_sorted_array_remove(mb_atom2buff_map, (void *)(uintptr_t)atom);
-    purc_rwlock_clear(&mb->lock);
+    inst->move_buff = NULL;
     free(mb);
 
 done:
@@ -338,6 +363,39 @@ do_take_message(struct pcinst* inst, pcrdr_msg *msg)
     }
 }
 
+static bool
+reserve_slot(struct pcinst_move_buffer *mb)
+{
+    size_t nr = atomic_fetch_add(&mb->nr_msgs, 1);
+    if (nr >= mb->max_nr_msgs) {
+        atomic_fetch_sub(&mb->nr_msgs, 1);
+        return false;
+    }
+
+    return true;
+}
+
+static void
+push_message(struct pcinst_move_buffer *mb, pcrdr_msg *msg)
+{
+    struct pcrdr_msg_hdr *hdr = (struct pcrdr_msg_hdr *)msg;
+    struct pcrdr_msg_hdr *head = atomic_load_explicit(&mb->inbox,
+            memory_order_relaxed);
+
+    do {
+        hdr->next = head;
+    } while (!atomic_compare_exchange_weak_explicit(&mb->inbox, &head, hdr,
+                memory_order_release, memory_order_relaxed));
+
+    /* The owner takes all messages in the inbox once it is woken up.
+       There is no wakeup fd per buffer: waking the idle callback up
+       readies a source of the owner's main context, and GLib signals
+       the context through its own wakeup fd when called from another
+       thread. */
+    if (head == NULL)
+        pcrun_wakeup_idle_callback(mb->runloop);
+}
+
 size_t
 purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
 {
@@ -364,19 +422,13 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
             goto done;
         }
 
-        if (mb->nr_msgs >= mb->max_nr_msgs) {
+        if (!reserve_slot(mb)) {
             errcode = PURC_ERROR_TOO_SMALL_BUFF;
             goto done;
         }
 
         do_move_message(inst, msg);
-
-        purc_rwlock_writer_lock(&mb->lock);
-        struct pcrdr_msg_hdr *hdr = (struct pcrdr_msg_hdr *)msg;
-        list_add_tail(&hdr->ln, &mb->msgs);
-        mb->nr_msgs++;
-        purc_rwlock_writer_unlock(&mb->lock);
-
+        push_message(mb, msg);
         nr++;
     }
     else {
@@ -385,7 +437,7 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
         for (size_t i = 0; i < count; i++) {
             pcutils_sorted_array_get(mb_atom2buff_map, i, (void **)&mb);
             if (mb->flags & PCINST_MOVE_BUFFER_BROADCAST &&
-                    mb->nr_msgs < mb->max_nr_msgs) {
+                    reserve_slot(mb)) {
 
                 pcrdr_msg *my_msg;
 
@@ -400,17 +452,14 @@ purc_inst_move_message(purc_atom_t inst_to, pcrdr_msg *msg)
                         pcrdr_release_message(my_msg);
                     }
                     else {
+                        atomic_fetch_sub(&mb->nr_msgs, 1);
                         PC_ERROR("failed to clone message to broadcast: %p\n",
                                 msg);
                         break;
                     }
                 }
 
-                purc_rwlock_writer_lock(&mb->lock);
-                struct pcrdr_msg_hdr *hdr = (struct pcrdr_msg_hdr *)my_msg;
-                list_add_tail(&hdr->ln, &mb->msgs);
-                mb->nr_msgs++;
-                purc_rwlock_writer_unlock(&mb->lock);
+                push_message(mb, my_msg);
                 nr++;
             }
         }
@@ -435,28 +484,15 @@ purc_inst_holding_messages_count(size_t *nr)
         return PURC_ERROR_NO_INSTANCE;
     }
 
-    int errcode = 0;
-    struct pcinst_move_buffer *mb;
-
-    purc_rwlock_reader_lock(&mb_lock);
-
-    if (!pcutils_sorted_array_find(mb_atom2buff_map,
-                (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb, NULL)) {
-        errcode = PURC_ERROR_NOT_EXISTS;
-        goto done;
-    }
-
-    /* no need to lock the buffer */
-    *nr = mb->nr_msgs;
-
-done:
-    purc_rwlock_reader_unlock(&mb_lock);
-
-    if (errcode) {
-        purc_set_error(errcode);
+    struct pcinst_move_buffer *mb = inst->move_buff;
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return PURC_ERROR_NOT_EXISTS;
     }
 
-    return errcode;
+    take_inbox(mb);
+    *nr = mb->nr_taken;
+    return 0;
 }
 
 const pcrdr_msg *
@@ -466,20 +502,16 @@ purc_inst_retrieve_message(size_t index)
     if (inst == NULL)
         return NULL;
 
-    int errcode = 0;
-    const pcrdr_msg *msg = NULL;
-    struct pcinst_move_buffer *mb;
-
-    purc_rwlock_reader_lock(&mb_lock);
-
-    if (!pcutils_sorted_array_find(mb_atom2buff_map,
-                (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb, NULL)) {
-        errcode = PURC_ERROR_NOT_EXISTS;
-        goto done;
+    struct pcinst_move_buffer *mb = inst->move_buff;
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return NULL;
     }
 
-    purc_rwlock_reader_lock(&mb->lock);
-    if (index < mb->nr_msgs) {
+    take_inbox(mb);
+
+    const pcrdr_msg *msg = NULL;
+    if (index < mb->nr_taken) {
         struct list_head *p;
         struct pcrdr_msg_hdr *hdr;
         size_t i = 0;
@@ -494,14 +526,6 @@ purc_inst_retrieve_message(size_t index)
             i++;
         }
     }
-    purc_rwlock_reader_unlock(&mb->lock);
-
-done:
-    purc_rwlock_reader_unlock(&mb_lock);
-
-    if (errcode) {
-        purc_set_error(errcode);
-    }
 
     return msg;
 }
@@ -515,20 +539,16 @@ purc_inst_take_away_message(size_t index)
         return NULL;
     }
 
-    int errcode = 0;
-    pcrdr_msg *msg = NULL;
-    struct pcinst_move_buffer *mb;
-
-    purc_rwlock_reader_lock(&mb_lock);
-
-    if (!pcutils_sorted_array_find(mb_atom2buff_map,
-                (void *)(uintptr_t)inst->endpoint_atom, (void **)&mb, NULL)) {
-        errcode = PURC_ERROR_NOT_EXISTS;
-        goto done;
+    struct pcinst_move_buffer *mb = inst->move_buff;
+    if (mb == NULL) {
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
+        return NULL;
     }
 
-    purc_rwlock_writer_lock(&mb->lock);
-    if (index < mb->nr_msgs) {
+    take_inbox(mb);
+
+    pcrdr_msg *msg = NULL;
+    if (index < mb->nr_taken) {
         struct list_head *p, *n;
         struct pcrdr_msg_hdr *hdr;
         size_t i = 0;
@@ -539,7 +559,8 @@ purc_inst_take_away_message(size_t index)
                 msg = (pcrdr_msg *)hdr;
                 list_del(p);
                 hdr->ln.next = hdr->ln.prev = NULL; /* mark as not linked */
-                mb->nr_msgs--;
+                mb->nr_taken--;
+                atomic_fetch_sub(&mb->nr_msgs, 1);
                 break;
             }
 
@@ -547,20 +568,12 @@ purc_inst_take_away_message(size_t index)
         }
     }
     else {
-        errcode = PURC_ERROR_NOT_EXISTS;
+        purc_set_error(PURC_ERROR_NOT_EXISTS);
     }
-    purc_rwlock_writer_unlock(&mb->lock);
 
     if (msg)
         do_take_message(inst, msg);
 
-done:
-    purc_rwlock_reader_unlock(&mb_lock);
-
-    if (errcode) {
-        purc_set_error(errcode);
-    }
-
     return msg;
 }
 
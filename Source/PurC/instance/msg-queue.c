@@ -26,6 +26,7 @@
 #include "config.h"
 
 #include "private/errors.h"
+#include "private/debug.h"
 #include "private/instance.h"
 #include "private/utils.h"
 #include "private/variant.h"
@@ -56,6 +57,11 @@ pcinst_msg_queue_create(void)
 
     queue->state = 0;
     queue->nr_msgs = 0;
+    queue->event_buckets = NULL;
+    queue->nr_event_buckets = 0;
+    queue->nr_indexed_events = 0;
+    queue->notify = NULL;
+    queue->notify_ctxt = NULL;
     list_head_init(&queue->req_msgs);
     list_head_init(&queue->res_msgs);
     list_head_init(&queue->event_msgs);
@@ -78,6 +84,192 @@ done:
     return queue;
 }
 
+bool
+is_event_match(pcrdr_msg *left, pcrdr_msg *right)
+{
+    if ((left->target == right->target) &&
+            (left->targetValue == right->targetValue) &&
+            (purc_variant_is_equal_to(left->eventName, right->eventName)) &&
+            (purc_variant_is_equal_to(left->elementValue, right->elementValue))
+            ) {
+        return true;
+    }
+    return false;
+}
+
+#define NR_MIN_EVENT_BUCKETS    16
+
+struct event_index_node {
+    struct list_head    ln;
+    uint64_t            hash;
+    pcrdr_msg          *msg;
+};
+
+/* Only the values of which the equal ones always have the same hash
+   contribute to the hash; see purc_variant_is_equal_to(). The containers
+   only contribute their types, because they may change while the events
+   referring to them are queued. */
+static uint64_t
+hash_event_variant(purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID)
+        return 0;
+
+    uint64_t hash = v->type + 1;
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_STRING:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+    case PURC_VARIANT_TYPE_EXCEPTION:
+    case PURC_VARIANT_TYPE_BSEQUENCE:
+    case PURC_VARIANT_TYPE_LONGINT:
+    case PURC_VARIANT_TYPE_ULONGINT:
+        hash = (hash ^ pcvariant_hash_text(v)) * 0x100000001B3ULL;
+        break;
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        hash = (hash ^ v->b) * 0x100000001B3ULL;
+        break;
+
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        hash = (hash ^ (uintptr_t)v->ptr_ptr[0]) * 0x100000001B3ULL;
+        hash = (hash ^ (uintptr_t)v->ptr_ptr[1]) * 0x100000001B3ULL;
+        break;
+
+    default:
+        // the numbers are compared with a tolerance
+        break;
+    }
+
+    return hash;
+}
+
+static uint64_t
+hash_event(const pcrdr_msg *msg)
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    hash = (hash ^ msg->target) * 0x100000001B3ULL;
+    hash = (hash ^ msg->targetValue) * 0x100000001B3ULL;
+    hash = (hash ^ hash_event_variant(msg->eventName)) * 0x100000001B3ULL;
+    hash = (hash ^ hash_event_variant(msg->elementValue)) * 0x100000001B3ULL;
+    return hash;
+}
+
+static int
+grow_event_buckets(struct pcinst_msg_queue *queue)
+{
+    size_t nr = queue->nr_event_buckets ?
+        queue->nr_event_buckets * 2 : NR_MIN_EVENT_BUCKETS;
+    struct list_head *buckets = malloc(sizeof(*buckets) * nr);
+    if (buckets == NULL)
+        return -1;
+
+    for (size_t i = 0; i < nr; i++)
+        list_head_init(buckets + i);
+
+    /* keep the order of the nodes in each old bucket; the events matching
+       each other are always in the same bucket. */
+    for (size_t i = 0; i < queue->nr_event_buckets; i++) {
+        struct event_index_node *node, *next;
+        list_for_each_entry_safe(node, next, queue->event_buckets + i, ln) {
+            list_add_tail(&node->ln, buckets + (node->hash & (nr - 1)));
+        }
+    }
+
+    free(queue->event_buckets);
+    queue->event_buckets = buckets;
+    queue->nr_event_buckets = nr;
+    return 0;
+}
+
+/*
+ * The nodes matching each other in a bucket are in the same order as
+ * the events in `event_msgs`, so the first one found is the earliest one.
+ */
+static void
+index_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, uint64_t hash,
+        bool tail)
+{
+    if (queue->nr_indexed_events >= queue->nr_event_buckets * 2 &&
+            grow_event_buckets(queue))
+        goto failed;
+
+    struct event_index_node *node = malloc(sizeof(*node));
+    if (node == NULL)
+        goto failed;
+
+    node->hash = hash;
+    node->msg = msg;
+
+    struct list_head *bucket;
+    bucket = queue->event_buckets + (hash & (queue->nr_event_buckets - 1));
+    if (tail)
+        list_add_tail(&node->ln, bucket);
+    else
+        list_add(&node->ln, bucket);
+    queue->nr_indexed_events++;
+    return;
+
+failed:
+    /* the event can not be reduced, but it is still delivered */
+    PC_WARN("Failed to index an event message: %p\n", msg);
+}
+
+static pcrdr_msg *
+find_indexed_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg,
+        uint64_t hash)
+{
+    if (queue->nr_indexed_events == 0)
+        return NULL;
+
+    struct list_head *bucket;
+    struct event_index_node *node;
+    bucket = queue->event_buckets + (hash & (queue->nr_event_buckets - 1));
+    list_for_each_entry(node, bucket, ln) {
+        if (node->hash == hash && is_event_match(node->msg, msg))
+            return node->msg;
+    }
+
+    return NULL;
+}
+
+static void
+unindex_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
+{
+    if (queue->nr_indexed_events == 0)
+        return;
+
+    /* the hash of a queued event does not change; see hash_event_variant() */
+    uint64_t hash = hash_event(msg);
+    struct list_head *bucket;
+    struct event_index_node *node;
+    bucket = queue->event_buckets + (hash & (queue->nr_event_buckets - 1));
+    list_for_each_entry(node, bucket, ln) {
+        if (node->msg == msg) {
+            list_del(&node->ln);
+            free(node);
+            queue->nr_indexed_events--;
+            break;
+        }
+    }
+}
+
+static void
+clear_event_index(struct pcinst_msg_queue *queue)
+{
+    for (size_t i = 0; i < queue->nr_event_buckets; i++) {
+        struct event_index_node *node, *next;
+        list_for_each_entry_safe(node, next, queue->event_buckets + i, ln) {
+            free(node);
+        }
+    }
+
+    free(queue->event_buckets);
+    queue->event_buckets = NULL;
+    queue->nr_event_buckets = 0;
+    queue->nr_indexed_events = 0;
+}
+
 static ssize_t
 grind_msg_list(struct list_head *msgs)
 {
@@ -104,6 +296,7 @@ pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue)
     nr += grind_msg_list(&queue->event_msgs);
     nr += grind_msg_list(&queue->void_msgs);
     queue->nr_msgs -= nr;
+    clear_event_index(queue);
 
     purc_rwlock_writer_unlock(&queue->lock);
 
@@ -113,17 +306,12 @@ pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue)
     return nr;
 }
 
-bool
-is_event_match(pcrdr_msg *left, pcrdr_msg *right)
+void
+pcinst_msg_queue_set_notifier(struct pcinst_msg_queue *queue,
+        pcinst_msg_queue_notify_fn notify, void *ctxt)
 {
-    if ((left->target == right->target) &&
-            (left->targetValue == right->targetValue) &&
-            (purc_variant_is_equal_to(left->eventName, right->eventName)) &&
-            (purc_variant_is_equal_to(left->elementValue, right->elementValue))
-            ) {
-        return true;
-    }
-    return false;
+    queue->notify = notify;
+    queue->notify_ctxt = ctxt;
 }
 
 static uint64_t
@@ -134,45 +322,48 @@ get_timestamp_us(void)
     return (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
 }
 
-int
-reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
+static void
+add_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, uint64_t hash,
+        bool tail)
 {
-    struct pcinst_msg_hdr *hdr;
-    struct list_head *p, *n;
-    list_for_each_safe(p, n, &queue->event_msgs) {
-        hdr = list_entry(p, struct pcinst_msg_hdr, ln);
-        pcrdr_msg *orig = (pcrdr_msg*) hdr;
-        if (is_event_match(orig, msg)) {
-            if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE) {
-                pcrdr_release_message(msg);
-                return 0;
-            }
-            // OVERLAY : data
-            if (orig->data) {
-                purc_variant_unref(orig->data);
-                orig->data = PURC_VARIANT_INVALID;
-            }
-            if (msg->data) {
-                orig->data = msg->data;
-                purc_variant_ref(orig->data);
-            }
-            pcrdr_release_message(msg);
-            return 0;
-        }
-    }
-
-    hdr = (struct pcinst_msg_hdr *)msg;
-    /* keep timestamp */
-    msg->resultValue = get_timestamp_us();
+    struct pcinst_msg_hdr *hdr = (struct pcinst_msg_hdr *)msg;
     if (tail) {
         list_add_tail(&hdr->ln, &queue->event_msgs);
     }
     else {
         list_add(&hdr->ln, &queue->event_msgs);
     }
+    index_event(queue, msg, hash, tail);
     queue->state |= MSG_QS_EVENT;
     queue->nr_msgs++;
+}
+
+int
+reduce_event(struct pcinst_msg_queue *queue, pcrdr_msg *msg, bool tail)
+{
+    uint64_t hash = hash_event(msg);
+    pcrdr_msg *orig = find_indexed_event(queue, msg, hash);
+    if (orig) {
+        if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE) {
+            pcrdr_release_message(msg);
+            return 0;
+        }
+        // OVERLAY : data
+        if (orig->data) {
+            purc_variant_unref(orig->data);
+            orig->data = PURC_VARIANT_INVALID;
+        }
+        if (msg->data) {
+            orig->data = msg->data;
+            purc_variant_ref(orig->data);
+        }
+        pcrdr_release_message(msg);
+        return 0;
+    }
 
+    /* keep timestamp */
+    msg->resultValue = get_timestamp_us();
+    add_event(queue, msg, hash, tail);
     return 0;
 }
 
@@ -207,9 +398,7 @@ pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
         if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
             /* keep timestamp */
             msg->resultValue = get_timestamp_us();
-            list_add_tail(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
+            add_event(queue, msg, hash_event(msg), true);
         }
         else {
             reduce_event(queue, msg, true);
@@ -224,6 +413,10 @@ pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     }
 
     purc_rwlock_writer_unlock(&queue->lock);
+
+    if (queue->notify) {
+        queue->notify(queue, queue->notify_ctxt);
+    }
     return 0;
 }
 
@@ -256,9 +449,7 @@ pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     case PCRDR_MSG_TYPE_EVENT:
         queue->state |= MSG_QS_EVENT;
         if (msg->reduceOpt == PCRDR_MSG_EVENT_REDUCE_OPT_KEEP) {
-            list_add(&hdr->ln, &queue->event_msgs);
-            queue->state |= MSG_QS_EVENT;
-            queue->nr_msgs++;
+            add_event(queue, msg, hash_event(msg), false);
         }
         else {
             reduce_event(queue, msg, false);
@@ -273,6 +464,10 @@ pcinst_msg_queue_prepend(struct pcinst_msg_queue *queue, pcrdr_msg *msg)
     }
 
     purc_rwlock_writer_unlock(&queue->lock);
+
+    if (queue->notify) {
+        queue->notify(queue, queue->notify_ctxt);
+    }
     return 0;
 }
 
@@ -286,6 +481,9 @@ get_msg(struct pcinst_msg_queue *queue, struct list_head *msgs)
             struct pcinst_msg_hdr, ln);
     pcrdr_msg *msg = (pcrdr_msg *)hdr;
     list_del(&hdr->ln);
+    if (msgs == &queue->event_msgs) {
+        unindex_event(queue, msg);
+    }
     queue->nr_msgs--;
     if (list_empty(msgs)) {
         queue->state &= ~MSG_QS_RES;
@@ -350,6 +548,7 @@ pcinst_msg_queue_get_event_by_element(struct pcinst_msg_queue *queue,
                 purc_variant_is_equal_to(m->eventName, event_name)) {
             msg = m;
             list_del(&hdr->ln);
+            unindex_event(queue, msg);
             break;
         }
     }
@@ -139,15 +139,15 @@ regist_variant_listener(pcintr_stack_t stack, purc_variant_t observed,
         const char *type, struct pcvar_listener** listener)
 {
     if (strcmp(type, MSG_TYPE_GROW) == 0) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_coalescing_listener(observed,
                 PCVAR_OPERATION_GROW, base_variant_msg_listener, stack);
     }
     else if (strcmp(type, MSG_TYPE_SHRINK) == 0) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_coalescing_listener(observed,
                 PCVAR_OPERATION_SHRINK, base_variant_msg_listener, stack);
     }
     else if (strcmp(type, MSG_TYPE_CHANGE) == 0) {
-        *listener = purc_variant_register_post_listener(observed,
+        *listener = pcvariant_register_coalescing_listener(observed,
                 PCVAR_OPERATION_CHANGE, base_variant_msg_listener, stack);
     }
     else {
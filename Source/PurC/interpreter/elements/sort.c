@@ -310,79 +310,44 @@ comp_string(const char *l, const char *r, bool ascendingly, bool casesensitively
     return ascendingly ? ret : -ret;
 }
 
-static char *
-variant_to_string(purc_variant_t v)
-{
-    if (!v) {
-        return NULL;
-    }
-
-    char *buf = NULL;
-    int total = purc_variant_stringify_alloc(&buf, v);
-    if (total < 0) {
-        return NULL;
-    }
-    return buf;
-}
-
-static int
-comp_raw(purc_variant_t l, purc_variant_t r, bool by_number,
-        bool ascendingly, bool casesensitively)
-{
-    if (by_number) {
-        double dl = l ? purc_variant_numerify(l) : 0.0f;
-        double dr = r ? purc_variant_numerify(r) : 0.0f;
-        return comp_number(dl, dr, ascendingly);
-    }
-
-    char *buf_l = variant_to_string(l);
-    char *buf_r = variant_to_string(r);
-    int ret = comp_string(buf_l, buf_r, ascendingly, casesensitively);
-
-    if (buf_l) {
-        free(buf_l);
-    }
-    if (buf_r) {
-        free(buf_r);
-    }
-
-    return ret;
-}
-
 static int
-comp_by_key(purc_variant_t l, purc_variant_t r, const char *key, bool by_number,
-        bool ascendingly, bool casesensitively)
+make_sort_keys(purc_variant_t member, struct pcvrnt_sort_key *keys, void *ud)
 {
-    purc_variant_t lv = PURC_VARIANT_INVALID;
-    purc_variant_t rv = PURC_VARIANT_INVALID;
-    if (purc_variant_is_object(l)) {
-        lv = purc_variant_object_get_by_ckey(l, key);
-        purc_clr_error();
-    }
+    struct ctxt_for_sort *ctxt = ud;
+    size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
+    for (size_t i = 0; i < nr_keys; i++) {
+        struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
+        purc_variant_t v = PURC_VARIANT_INVALID;
+        if (key->key == NULL) {
+            v = member;
+        }
+        else if (purc_variant_is_object(member)) {
+            v = purc_variant_object_get_by_ckey(member, key->key);
+            purc_clr_error();
+        }
 
-    if (purc_variant_is_object(r)) {
-        rv = purc_variant_object_get_by_ckey(r, key);
-        purc_clr_error();
+        if (pcvariant_make_sort_key(v, key->by_number, keys + i)) {
+            return -1;
+        }
     }
-
-    return comp_raw(lv, rv, by_number, ascendingly, casesensitively);
+    return 0;
 }
 
 static int
-sort_cmp(purc_variant_t l, purc_variant_t r, void *data)
+cmp_sort_keys(const struct pcvrnt_sort_key *l,
+        const struct pcvrnt_sort_key *r, void *ud)
 {
-    struct ctxt_for_sort *ctxt = data;
+    struct ctxt_for_sort *ctxt = ud;
     size_t nr_keys = pcutils_arrlist_length(ctxt->keys);
     for (size_t i = 0; i < nr_keys; i++) {
         struct sort_key *key = pcutils_arrlist_get_idx(ctxt->keys, i);
         int ret = 0;
-        if (key->key == NULL) {
-            ret = comp_raw(l, r, key->by_number, ctxt->ascendingly,
-                    ctxt->casesensitively);
+        if (key->by_number) {
+            ret = comp_number(l[i].num, r[i].num, ctxt->ascendingly);
         }
         else {
-            ret = comp_by_key(l, r, key->key, key->by_number,
-                    ctxt->ascendingly, ctxt->casesensitively);
+            ret = comp_string(l[i].str, r[i].str, ctxt->ascendingly,
+                    ctxt->casesensitively);
         }
         if (ret != 0) {
             return ret;
@@ -457,7 +422,8 @@ sort_array(struct ctxt_for_sort *ctxt, purc_variant_t array,
             }
         }
     }
-    pcvariant_array_sort(array, ctxt, sort_cmp);
+    pcvariant_sort_by_keys(array, pcutils_arrlist_length(ctxt->keys), ctxt,
+            make_sort_keys, cmp_sort_keys);
 }
 
 
@@ -510,7 +476,8 @@ sort_set(struct ctxt_for_sort *ctxt, purc_variant_t set, purc_variant_t against)
             }
         }
     }
-    pcvariant_set_sort(set, ctxt, sort_cmp);
+    pcvariant_sort_by_keys(set, pcutils_arrlist_length(ctxt->keys), ctxt,
+            make_sort_keys, cmp_sort_keys);
 }
 
 static int
@@ -241,6 +241,13 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response(struct pcrdr_conn *conn,
         const char *element, const char *property,
         pcrdr_msg_data_type data_type, purc_variant_t data, size_t data_len);
 
+/* send a request without waiting for the response (pipelined) */
+bool pcintr_rdr_send_request_async(struct pcrdr_conn *conn,
+        pcrdr_msg_target target, uint64_t target_value, const char *operation,
+        const char *request_id, pcrdr_msg_element_type element_type,
+        const char *element, const char *property,
+        pcrdr_msg_data_type data_type, purc_variant_t data, size_t data_len);
+
 uint64_t pcintr_rdr_start_session(struct pcrdr_conn *conn, const char *protocol,
         uint64_t protocol_version, const char *host_name, const char *app_name,
         const char *runner_name);
@@ -377,6 +384,19 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         const char *property, pcrdr_msg_data_type data_type,
         const char *data, size_t len);
 
+/* send the DOM operations batched in the current time slice */
+void
+pcintr_rdr_flush_dom_batch(struct pcinst *inst);
+
+/* call this before removing the descendants of an eDOM element, and the
+   element itself if `with_elem` is true */
+void
+pcintr_rdr_prepare_for_removal(struct pcinst *inst, purc_document_t doc,
+        pcdoc_element_t elem, bool with_elem);
+
+void
+pcintr_rdr_release_dom_batch(struct pcintr_heap *heap);
+
 purc_variant_t
 pcintr_rdr_call_method(pcintr_stack_t stack, const char *request_id,
         const char *css_selector, const char *method, purc_variant_t arg);
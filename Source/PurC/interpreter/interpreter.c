@@ -354,6 +354,15 @@ coroutine_release(pcintr_coroutine_t co)
         struct pcintr_heap *heap = pcintr_get_heap();
         PC_ASSERT(heap && co->owner == heap);
 
+        pcintr_coroutine_dequeue(co);
+        if (co->stack.observe_idle) {
+            co->stack.observe_idle = 0;
+            heap->nr_idle_observers--;
+        }
+
+        /* the batched operations may refer to the document */
+        pcintr_rdr_flush_dom_batch(heap->owner);
+
         stack_release(&co->stack);
         pcvdom_document_unref(co->vdom);
 
@@ -503,6 +512,12 @@ static void _cleanup_instance(struct pcinst* inst)
         coroutine_destroy(pco);
     }
 
+    if (heap->conn_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop, heap->conn_monitor);
+        heap->conn_monitor = 0;
+        heap->watched_conn = NULL;
+    }
+
     if (heap->move_buff) {
         size_t n = purc_inst_destroy_move_buffer();
         PC_DEBUG("Instance is quiting, %u messages discarded\n", (unsigned)n);
@@ -529,6 +544,8 @@ static void _cleanup_instance(struct pcinst* inst)
         heap->loaded_crtn_handles = NULL;
     }
 
+    pcintr_rdr_release_dom_batch(heap);
+
     free(heap);
     inst->intr_heap = NULL;
 }
@@ -563,6 +580,8 @@ static int _init_instance(struct pcinst* inst,
     if (!heap)
         return PURC_ERROR_OUT_OF_MEMORY;
 
+    /* the move buffer wakes up the scheduler of this runloop */
+    inst->running_loop = purc_runloop_get_current();
     heap->move_buff = purc_inst_create_move_buffer(
             PCINST_MOVE_BUFFER_BROADCAST, PCINTR_MOVE_BUFFER_SIZE);
     if (!heap->move_buff) {
@@ -575,7 +594,6 @@ static int _init_instance(struct pcinst* inst,
         return purc_get_last_error();
     }
 
-    inst->running_loop = purc_runloop_get_current();
     inst->intr_heap = heap;
     heap->owner     = inst;
 
@@ -583,6 +601,8 @@ static int _init_instance(struct pcinst* inst,
 
     list_head_init(&heap->crtns);
     list_head_init(&heap->stopped_crtns);
+    list_head_init(&heap->ready_crtns);
+    list_head_init(&heap->event_crtns);
     pcutils_avl_init(&heap->wait_timeout_crtns_avl, wait_timeout_comp , true, NULL);
 
     heap->name_chan_map =
@@ -1761,6 +1781,13 @@ static int set_coroutine_id(pcintr_coroutine_t coroutine)
     return 0;
 }
 
+static void
+on_coroutine_msg_arrived(struct pcinst_msg_queue *queue, void *ctxt)
+{
+    UNUSED_PARAM(queue);
+    pcintr_coroutine_queue_event((pcintr_coroutine_t)ctxt);
+}
+
 static pcintr_coroutine_t
 coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
         pcrdr_page_type_k page_type, void *user_data)
@@ -1842,6 +1869,9 @@ coroutine_create(purc_vdom_t vdom, pcintr_coroutine_t parent,
     co->stopped_timeout = -1;
     co->avl.key = co;
     co->sending_document_by_url = 1;    // 0.9.18
+
+    pcinst_msg_queue_set_notifier(co->mq, on_coroutine_msg_arrived, co);
+    pcintr_coroutine_queue_ready(co);
     return co;
 
 fail_clr_fetcher_session:
@@ -3392,6 +3422,31 @@ pcintr_coroutine_set_state_with_location(pcintr_coroutine_t co,
     UNUSED_PARAM(line);
     UNUSED_PARAM(func);
     co->state = state;
+
+    if (co->owner == NULL) {
+        return;
+    }
+
+    if (state == CO_STATE_READY) {
+        pcintr_coroutine_queue_ready(co);
+    }
+    else if (state != CO_STATE_RUNNING) {
+        /* give pending messages and tasks a chance in the new state */
+        pcintr_coroutine_queue_event(co);
+    }
+}
+
+static void
+prepare_for_removal(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_operation_k op)
+{
+    if (op == PCDOC_OP_DISPLACE || op == PCDOC_OP_UPDATE ||
+            op == PCDOC_OP_CLEAR) {
+        pcintr_rdr_prepare_for_removal(pcinst_current(), doc, elem, false);
+    }
+    else if (op == PCDOC_OP_ERASE) {
+        pcintr_rdr_prepare_for_removal(pcinst_current(), doc, elem, true);
+    }
 }
 
 int
@@ -3439,6 +3494,7 @@ pcintr_util_new_element(purc_document_t doc, pcdoc_element_t elem,
     pcdoc_element_t new_elem;
 
     insert_cached_text_node(doc, sync_to_rdr);
+    prepare_for_removal(doc, elem, op);
 
     new_elem = pcdoc_element_new_element(doc, elem, op, tag, self_close);
     if (new_elem && sync_to_rdr) {
@@ -3490,6 +3546,7 @@ pcintr_util_clear_element(purc_document_t doc, pcdoc_element_t elem,
         bool sync_to_rdr)
 {
     insert_cached_text_node(doc, sync_to_rdr);
+    prepare_for_removal(doc, elem, PCDOC_OP_CLEAR);
     pcdoc_element_clear(doc, elem);
     if (sync_to_rdr) {
         // TODO check stage and send message to rdr
@@ -3501,6 +3558,7 @@ pcintr_util_erase_element(purc_document_t doc, pcdoc_element_t elem,
         bool sync_to_rdr)
 {
     insert_cached_text_node(doc, sync_to_rdr);
+    prepare_for_removal(doc, elem, PCDOC_OP_ERASE);
     pcdoc_element_erase(doc, elem);
     if (sync_to_rdr) {
         // TODO check stage and send message to rdr
@@ -3529,6 +3587,8 @@ pcintr_util_new_text_content(purc_document_t doc, pcdoc_element_t elem,
             insert_cached_text_node(doc, sync_to_rdr);
         }
 
+        prepare_for_removal(doc, elem, op);
+
         pcdoc_text_node_t text_node;
         text_node = pcdoc_element_new_text_content(doc, elem, op,
                 txt, len);
@@ -3562,6 +3622,7 @@ pcintr_util_new_content(purc_document_t doc,
 {
     pcdoc_node node;
     insert_cached_text_node(doc, sync_to_rdr);
+    prepare_for_removal(doc, elem, op);
 
     node = pcdoc_element_new_content(doc, elem, op, content, len);
 
@@ -3624,6 +3685,7 @@ pcintr_util_set_data_content(purc_document_t doc,
     UNUSED_PARAM(sync_to_rdr);
     UNUSED_PARAM(no_return);
     insert_cached_text_node(doc, sync_to_rdr);
+    prepare_for_removal(doc, elem, op);
     // TODO: sync to rdr
     return pcdoc_element_set_data_content(doc, elem, op, data);
 }
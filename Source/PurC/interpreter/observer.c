@@ -272,7 +272,10 @@ pcintr_register_observer(pcintr_stack_t  stack,
     // observe idle
     if (pcintr_is_crtn_observed(observed) &&
             (strcmp(type,  MSG_TYPE_IDLE) == 0) && sub_type == NULL) {
-        stack->observe_idle = 1;
+        if (!stack->observe_idle) {
+            stack->observe_idle = 1;
+            stack->co->owner->nr_idle_observers++;
+        }
     }
 
     return observer;
@@ -325,8 +328,10 @@ pcintr_revoke_observer(struct pcintr_observer* observer)
 
     // observe idle
     if (pcintr_is_crtn_observed(observer->observed)) {
-        if (strcmp(observer->type, MSG_TYPE_IDLE) == 0) {
+        if (strcmp(observer->type, MSG_TYPE_IDLE) == 0 &&
+                stack->observe_idle) {
             stack->observe_idle = 0;
+            stack->co->owner->nr_idle_observers--;
         }
     }
 
@@ -66,6 +66,7 @@ static struct pcintr_rdr_data_type {
     { PCRDR_MSG_DATA_TYPE_NAME_MATHML, PCRDR_MSG_DATA_TYPE_MATHML },
     { PCRDR_MSG_DATA_TYPE_NAME_XGML, PCRDR_MSG_DATA_TYPE_XGML },
     { PCRDR_MSG_DATA_TYPE_NAME_XML, PCRDR_MSG_DATA_TYPE_XML },
+    { PCRDR_MSG_DATA_TYPE_NAME_BINARY, PCRDR_MSG_DATA_TYPE_BINARY },
 };
 
 /* Make sure the size of doc_types matches the number of document types */
@@ -123,6 +124,8 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response_ex(struct pcrdr_conn *conn,
         pcrdr_msg_data_type data_type, purc_variant_t data, size_t data_len,
         int seconds_expected)
 {
+    pcintr_rdr_flush_dom_batch(pcinst_current());
+
     pcrdr_msg *response_msg = NULL;
     pcrdr_msg *msg = pcrdr_make_request_message(
             target,                             /* target */
@@ -181,6 +184,65 @@ pcrdr_msg *pcintr_rdr_send_request_and_wait_response(struct pcrdr_conn *conn,
         element, property, data_type, data, data_len, PCRDR_TIME_DEF_EXPECTED);
 }
 
+static int
+async_response_handler(pcrdr_conn *conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    UNUSED_PARAM(conn);
+    UNUSED_PARAM(context);
+
+    if (state != PCRDR_RESPONSE_RESULT) {
+        PC_WARN("no response for the request %s: %d\n", request_id, state);
+    }
+    else if (response_msg->retCode != PCRDR_SC_OK) {
+        PC_WARN("the request %s was refused by the renderer: %d\n",
+                request_id, response_msg->retCode);
+    }
+
+    return 0;
+}
+
+bool pcintr_rdr_send_request_async(struct pcrdr_conn *conn,
+        pcrdr_msg_target target, uint64_t target_value, const char *operation,
+        const char *request_id, pcrdr_msg_element_type element_type,
+        const char *element, const char *property,
+        pcrdr_msg_data_type data_type, purc_variant_t data, size_t data_len)
+{
+    pcintr_rdr_flush_dom_batch(pcinst_current());
+
+    pcrdr_msg *msg = pcrdr_make_request_message(
+            target,                             /* target */
+            target_value,                       /* target_value */
+            operation,                          /* operation */
+            request_id,                         /* request_id */
+            NULL,                               /* source_uri */
+            element_type,                       /* element_type */
+            element,                            /* element */
+            property,                           /* property */
+            PCRDR_MSG_DATA_TYPE_VOID,           /* data_type */
+            NULL,                               /* data */
+            0                                   /* data_len */
+            );
+    if (msg == NULL) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return false;
+    }
+
+    msg->dataType = data_type;
+    if (data) {
+        msg->data = purc_variant_ref(data);
+    }
+    if (data_len > 0) {
+        msg->textLen = data_len;
+    }
+
+    /* the response will be checked by the handler later */
+    int ret = pcrdr_send_request(conn, msg, PCRDR_TIME_DEF_EXPECTED,
+            NULL, async_response_handler);
+    pcrdr_release_message(msg);
+    return ret == 0;
+}
+
 
 uint64_t pcintr_rdr_create_workspace(struct pcrdr_conn *conn,
         uint64_t session, const char *name, purc_variant_t data)
@@ -1437,6 +1499,7 @@ static const char *rdr_ops[] = {
     PCRDR_OPERATION_CALLMETHOD,                // "callMethod"
     PCRDR_OPERATION_GETPROPERTY,               // "getProperty"
     PCRDR_OPERATION_SETPROPERTY,               // "setProperty"
+    PCRDR_OPERATION_BATCH,                     // "batch"
 };
 
 /* make sure the number of operations matches the enumulators */
@@ -1634,6 +1697,466 @@ out:
     return ret;
 }
 
+/* The DOM mutations recorded in one time slice of the scheduler; they are
+   sent to the renderer in a single `batch` request when the slice ends,
+   or before any other request to keep the order of messages. */
+#define DOM_BATCH_MAX_OPS           64
+
+struct dom_op {
+    int                     op;
+    pcdoc_element_t         element;
+    pcdoc_element_t         ref_elem;
+    char                   *property;
+    pcrdr_msg_data_type     data_type;
+    purc_variant_t          data;
+};
+
+struct pcintr_rdr_dom_batch {
+    purc_document_t         doc;
+    uint64_t                target_dom;
+    size_t                  nr_ops;
+    struct dom_op           ops[DOM_BATCH_MAX_OPS];
+};
+
+static void
+dom_op_release(struct dom_op *op)
+{
+    free(op->property);
+    op->property = NULL;
+    PURC_VARIANT_SAFE_CLEAR(op->data);
+}
+
+static bool
+is_replacing_op(int op)
+{
+    return op == PCRDR_K_OPERATION_DISPLACE ||
+        op == PCRDR_K_OPERATION_UPDATE ||
+        op == PCRDR_K_OPERATION_ERASE ||
+        op == PCRDR_K_OPERATION_CLEAR;
+}
+
+/*
+ * Drops the pending operations made redundant by `new_op`:
+ *
+ *  - an attribute which is updated or erased again;
+ *  - the text content of an element which is replaced, cleared or erased;
+ *  - the content of such an element, but only if no operation on another
+ *    element followed it, because that operation may refer to an element
+ *    created by the content.
+ *
+ * `insertBefore` and `insertAfter` change the parent of the element, so they
+ * are always kept.
+ */
+static void
+coalesce_dom_ops(struct pcintr_rdr_dom_batch *batch,
+        const struct dom_op *new_op)
+{
+    if (new_op->property == NULL || !is_replacing_op(new_op->op))
+        return;
+
+    bool is_attr = strncmp(new_op->property, "attr.", 5) == 0;
+    if (!is_attr && strcmp(new_op->property, "textContent") &&
+            strcmp(new_op->property, "content"))
+        return;
+
+    bool dropped = false;
+    bool foreign = false;
+    for (size_t i = batch->nr_ops; i > 0; i--) {
+        struct dom_op *op = batch->ops + i - 1;
+        if (op->element != new_op->element || op->property == NULL) {
+            foreign = true;
+            continue;
+        }
+
+        bool drop = false;
+        if (is_attr) {
+            drop = strcmp(op->property, new_op->property) == 0;
+        }
+        else if (op->op == PCRDR_K_OPERATION_INSERTBEFORE ||
+                op->op == PCRDR_K_OPERATION_INSERTAFTER) {
+            drop = false;
+        }
+        else if (strcmp(op->property, "textContent") == 0) {
+            drop = true;
+        }
+        else if (strcmp(op->property, "content") == 0) {
+            drop = !foreign;
+        }
+
+        if (drop) {
+            dom_op_release(op);
+            op->op = -1;
+            dropped = true;
+        }
+    }
+
+    if (dropped) {
+        size_t n = 0;
+        for (size_t i = 0; i < batch->nr_ops; i++) {
+            if (batch->ops[i].op >= 0) {
+                batch->ops[n++] = batch->ops[i];
+            }
+        }
+        batch->nr_ops = n;
+    }
+}
+
+static size_t
+max_batched_ops(struct pcinst *inst)
+{
+    /* the operations are still coalesced if the renderer does not support
+       the `batch` request; they are sent one by one in this case. */
+    if (inst->rdr_caps && inst->rdr_caps->batchOperations > 0 &&
+            inst->rdr_caps->batchOperations < DOM_BATCH_MAX_OPS) {
+        return inst->rdr_caps->batchOperations;
+    }
+
+    return DOM_BATCH_MAX_OPS;
+}
+
+static bool
+batch_dom_op(pcintr_stack_t stack, int op,
+        pcdoc_element_t element, pcdoc_element_t ref_elem,
+        const char *property, pcrdr_msg_data_type data_type,
+        const char *data, size_t len)
+{
+    if (!stack) {
+        return false;
+    }
+
+    pcintr_coroutine_t co = stack->co;
+    if (co->target_page_handle == 0 || co->target_dom_handle == 0 ||
+            co->stack.doc->ldc == 0) {
+        /* null page or suppressed */
+        return false;
+    }
+
+    struct pcinst *inst = pcinst_current();
+    struct pcintr_heap *heap = inst->intr_heap;
+    if (inst->conn_to_rdr == NULL || heap == NULL) {
+        return false;
+    }
+
+    struct pcintr_rdr_dom_batch *batch = heap->dom_batch;
+    if (batch && batch->nr_ops > 0 &&
+            (batch->doc != co->stack.doc ||
+             batch->target_dom != co->target_dom_handle ||
+             batch->nr_ops >= max_batched_ops(inst))) {
+        pcintr_rdr_flush_dom_batch(inst);
+        batch = heap->dom_batch;
+    }
+
+    if (batch == NULL) {
+        batch = calloc(1, sizeof(*batch));
+        if (batch == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+        heap->dom_batch = batch;
+    }
+
+    struct dom_op new_op = { op, element, ref_elem, NULL, data_type,
+        PURC_VARIANT_INVALID };
+    if (property) {
+        if (op == PCRDR_K_OPERATION_DISPLACE) {
+            // VW: use 'update' operation when displace property
+            new_op.op = PCRDR_K_OPERATION_UPDATE;
+        }
+
+        new_op.property = strdup(property);
+        if (new_op.property == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+    }
+
+    /* the renderer behind a move buffer only needs the reference element */
+    if (pcrdr_conn_type(inst->conn_to_rdr) != CT_MOVE_BUFFER) {
+        if (data_type == PCRDR_MSG_DATA_TYPE_JSON) {
+            new_op.data = purc_variant_make_from_json_string(data, len);
+        }
+        else {  /* VW: for other data types */
+            new_op.data = purc_variant_make_string_ex(data, len, false);
+        }
+
+        if (new_op.data == PURC_VARIANT_INVALID) {
+            free(new_op.property);
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+    }
+
+    coalesce_dom_ops(batch, &new_op);
+    batch->doc = co->stack.doc;
+    batch->target_dom = co->target_dom_handle;
+    batch->ops[batch->nr_ops++] = new_op;
+    return true;
+}
+
+static purc_variant_t
+dom_op_data(struct pcrdr_conn *conn, const struct dom_op *op,
+        pcrdr_msg_data_type *data_type)
+{
+    if (pcrdr_conn_type(conn) == CT_MOVE_BUFFER) {
+        *data_type = PCRDR_MSG_DATA_TYPE_JSON;
+        if (op->ref_elem) {
+            return purc_variant_make_native(op->ref_elem, NULL);
+        }
+        return PURC_VARIANT_INVALID;
+    }
+
+    *data_type = op->data_type;
+    return op->data ? purc_variant_ref(op->data) : PURC_VARIANT_INVALID;
+}
+
+static const char *
+data_type_name(pcrdr_msg_data_type type)
+{
+    for (size_t i = 0; i < PCA_TABLESIZE(pcintr_rdr_data_types); i++) {
+        if (pcintr_rdr_data_types[i].type == type) {
+            return pcintr_rdr_data_types[i].type_name;
+        }
+    }
+
+    return PCRDR_MSG_DATA_TYPE_NAME_VOID;
+}
+
+static bool
+object_set_variant(purc_variant_t object, const char *key, purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID) {
+        return false;
+    }
+
+    bool ret = purc_variant_object_set_by_static_ckey(object, key, v);
+    purc_variant_unref(v);
+    return ret;
+}
+
+static purc_variant_t
+make_dom_op_object(struct pcrdr_conn *conn, const struct dom_op *op)
+{
+    char elem[LEN_BUFF_LONGLONGINT];
+    snprintf(elem, sizeof(elem), "%llx",
+            (unsigned long long int)(uint64_t)(uintptr_t)op->element);
+
+    purc_variant_t object = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    if (object == PURC_VARIANT_INVALID) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    pcrdr_msg_data_type data_type;
+    purc_variant_t data = dom_op_data(conn, op, &data_type);
+
+    if (!object_set_variant(object, "operation",
+                purc_variant_make_string_static(rdr_ops[op->op], false)) ||
+            !object_set_variant(object, "element",
+                purc_variant_make_string(elem, false)) ||
+            (op->property && !object_set_variant(object, "property",
+                purc_variant_make_string(op->property, false))) ||
+            !object_set_variant(object, "dataType",
+                purc_variant_make_string_static(data_type_name(data_type),
+                    false)) ||
+            (data && !object_set_variant(object, "data", data))) {
+        purc_variant_unref(object);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return object;
+}
+
+static bool
+check_dom_response(pcrdr_msg *response_msg)
+{
+    if (response_msg == NULL) {
+        return false;
+    }
+
+    int ret_code = response_msg->retCode;
+    pcrdr_release_message(response_msg);
+    if (ret_code != PCRDR_SC_OK) {
+        PC_WARN("the DOM operations were refused by the renderer: %d\n",
+                ret_code);
+        return false;
+    }
+
+    return true;
+}
+
+static void
+send_dom_ops(struct pcrdr_conn *conn, uint64_t target_dom,
+        const char *operation, pcrdr_msg_element_type element_type,
+        const char *element, const char *property,
+        pcrdr_msg_data_type data_type, purc_variant_t data)
+{
+    if (pcrdr_conn_type(conn) == CT_MOVE_BUFFER) {
+        /* the renderer shares the eDOM: wait until it is done with it */
+        check_dom_response(pcintr_rdr_send_request_and_wait_response(conn,
+                    PCRDR_MSG_TARGET_DOM, target_dom, operation, NULL,
+                    element_type, element, property, data_type, data, 0));
+    }
+    else {
+        pcintr_rdr_send_request_async(conn, PCRDR_MSG_TARGET_DOM,
+                target_dom, operation, NULL, element_type, element, property,
+                data_type, data, 0);
+    }
+}
+
+static void
+send_dom_batch(struct pcrdr_conn *conn, struct pcintr_rdr_dom_batch *batch)
+{
+    purc_variant_t ops = purc_variant_make_array_0();
+    if (ops == PURC_VARIANT_INVALID) {
+        return;
+    }
+
+    for (size_t i = 0; i < batch->nr_ops; i++) {
+        purc_variant_t op = make_dom_op_object(conn, batch->ops + i);
+        if (op == PURC_VARIANT_INVALID ||
+                !purc_variant_array_append(ops, op)) {
+            PURC_VARIANT_SAFE_CLEAR(op);
+            goto failed;
+        }
+        purc_variant_unref(op);
+    }
+
+    send_dom_ops(conn, batch->target_dom, PCRDR_OPERATION_BATCH,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_JSON, ops);
+
+failed:
+    purc_variant_unref(ops);
+}
+
+static void
+send_dom_op(struct pcrdr_conn *conn, uint64_t target_dom,
+        const struct dom_op *op)
+{
+    char elem[LEN_BUFF_LONGLONGINT];
+    snprintf(elem, sizeof(elem), "%llx",
+            (unsigned long long int)(uint64_t)(uintptr_t)op->element);
+
+    pcrdr_msg_data_type data_type;
+    purc_variant_t data = dom_op_data(conn, op, &data_type);
+
+    send_dom_ops(conn, target_dom, rdr_ops[op->op],
+            PCRDR_MSG_ELEMENT_TYPE_HANDLE, elem, op->property,
+            data_type, data);
+
+    if (data) {
+        purc_variant_unref(data);
+    }
+}
+
+void
+pcintr_rdr_flush_dom_batch(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst ? inst->intr_heap : NULL;
+    struct pcintr_rdr_dom_batch *batch = heap ? heap->dom_batch : NULL;
+    if (batch == NULL || batch->nr_ops == 0) {
+        return;
+    }
+
+    /* detach the batch, for every request flushes the batch at first */
+    heap->dom_batch = NULL;
+
+    struct pcrdr_conn *conn = inst->conn_to_rdr;
+    if (conn) {
+        int last_err = purc_get_last_error();
+
+        if (batch->nr_ops > 1 && inst->rdr_caps &&
+                inst->rdr_caps->batchOperations > 0) {
+            send_dom_batch(conn, batch);
+        }
+        else {
+            for (size_t i = 0; i < batch->nr_ops; i++) {
+                send_dom_op(conn, batch->target_dom, batch->ops + i);
+            }
+        }
+
+        purc_set_error(last_err);
+    }
+
+    for (size_t i = 0; i < batch->nr_ops; i++) {
+        dom_op_release(batch->ops + i);
+    }
+    batch->nr_ops = 0;
+
+    if (heap->dom_batch == NULL) {
+        heap->dom_batch = batch;
+    }
+    else {
+        free(batch);
+    }
+}
+
+/* whether the element is to be removed with the subtree of `root` */
+static bool
+is_elem_removed(purc_document_t doc, pcdoc_element_t elem,
+        pcdoc_element_t root, bool with_root)
+{
+    if (elem == root)
+        return with_root;
+
+    while (elem) {
+        pcdoc_node node = { PCDOC_NODE_ELEMENT, { .elem = elem } };
+        elem = pcdoc_node_get_parent(doc, node);
+        if (elem == root)
+            return true;
+    }
+
+    return false;
+}
+
+void
+pcintr_rdr_prepare_for_removal(struct pcinst *inst, purc_document_t doc,
+        pcdoc_element_t elem, bool with_elem)
+{
+    struct pcintr_heap *heap = inst ? inst->intr_heap : NULL;
+    struct pcintr_rdr_dom_batch *batch = heap ? heap->dom_batch : NULL;
+    if (batch == NULL || batch->nr_ops == 0 || inst->conn_to_rdr == NULL) {
+        return;
+    }
+
+    /* The renderer behind a move buffer shares the eDOM: send the batched
+       operations before any element goes away. */
+    if (pcrdr_conn_type(inst->conn_to_rdr) == CT_MOVE_BUFFER) {
+        pcintr_rdr_flush_dom_batch(inst);
+        return;
+    }
+
+    /* Otherwise the operations only refer to the elements by their
+       addresses, which may be taken by new elements once the removed ones
+       are freed: send the operations on the elements to be removed now. */
+    if (batch->doc != doc) {
+        return;
+    }
+
+    for (size_t i = 0; i < batch->nr_ops; i++) {
+        struct dom_op *op = batch->ops + i;
+        if (is_elem_removed(doc, op->element, elem, with_elem) ||
+                (op->ref_elem &&
+                 is_elem_removed(doc, op->ref_elem, elem, with_elem))) {
+            pcintr_rdr_flush_dom_batch(inst);
+            break;
+        }
+    }
+}
+
+void
+pcintr_rdr_release_dom_batch(struct pcintr_heap *heap)
+{
+    struct pcintr_rdr_dom_batch *batch = heap->dom_batch;
+    if (batch) {
+        for (size_t i = 0; i < batch->nr_ops; i++) {
+            dom_op_release(batch->ops + i);
+        }
+        free(batch);
+        heap->dom_batch = NULL;
+    }
+}
+
 bool
 pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         int op, const char *request_id,
@@ -1649,6 +2172,15 @@ pcintr_rdr_send_dom_req_simple_raw(pcintr_stack_t stack,
         data = " ";
         len = 1;
     }
+
+    /* Nobody needs the result of a plain DOM mutation: record it in the
+       batch of the current time slice. */
+    if (request_id == NULL ||
+            strcmp(request_id, PCINTR_RDR_NORETURN_REQUEST_ID) == 0) {
+        return batch_dom_op(stack, op, element, ref_elem, property,
+                data_type, data, len);
+    }
+
     pcrdr_msg *response_msg = pcintr_rdr_send_dom_req_raw(stack, op,
             request_id, PCRDR_MSG_ELEMENT_TYPE_HANDLE, NULL,
             element, ref_elem, property, data_type, data, len);
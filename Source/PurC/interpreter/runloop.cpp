@@ -187,6 +187,43 @@ void purc_runloop_set_timeout(purc_runloop_t runloop,
     ((RunLoop*)runloop)->setTimeout(G_SOURCE_FUNC(callback), ctxt, interval);
 }
 
+void pcrun_park_idle_callback(purc_runloop_t runloop, long timeout_ms)
+{
+    if (!runloop) {
+        runloop = purc_runloop_get_current();
+    }
+
+    PurCWTF::Seconds timeout = PurCWTF::Seconds::infinity();
+    if (timeout_ms >= 0) {
+        timeout = PurCWTF::Seconds::fromMilliseconds(timeout_ms);
+    }
+    ((RunLoop*)runloop)->parkIdleCallback(timeout);
+}
+
+void pcrun_wakeup_idle_callback(purc_runloop_t runloop)
+{
+    if (runloop) {
+        ((RunLoop*)runloop)->wakeUpIdleCallback();
+    }
+}
+
+uintptr_t pcrun_add_wakeup_fd_monitor(purc_runloop_t runloop, int fd)
+{
+    if (!runloop) {
+        runloop = purc_runloop_get_current();
+    }
+
+    RunLoop *runLoop = (RunLoop*)runloop;
+    return runLoop->addFdMonitor(fd,
+            (GIOCondition)(G_IO_IN | G_IO_PRI | G_IO_ERR | G_IO_HUP),
+            [runLoop] (gint fd, GIOCondition condition) -> gboolean {
+            UNUSED_PARAM(fd);
+            UNUSED_PARAM(condition);
+            runLoop->wakeUpIdleCallback();
+            return true;
+        });
+}
+
 extern "C" purc_atom_t
 pcrun_create_inst_thread(const char *app_name, const char *runner_name,
         purc_cond_handler cond_handler,
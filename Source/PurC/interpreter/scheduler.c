@@ -35,13 +35,14 @@
 #include "private/variant.h"
 #include "private/ports.h"
 #include "private/msg-queue.h"
+#include "private/runners.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 #include <sys/time.h>
 
-#define SCHEDULE_SLEEP          10 * 1000       // usec
+#define SCHEDULE_PARK_MAX       1000            // ms
 #define IDLE_EVENT_TIMEOUT      100             // ms
 #define TIME_SLIECE             0.005           // s
 
@@ -68,6 +69,10 @@ static void
 broadcast_idle_event(struct pcinst *inst)
 {
     struct pcintr_heap *heap = inst->intr_heap;
+    if (heap->nr_idle_observers == 0) {
+        return;
+    }
+
     struct list_head *crtns = &heap->crtns;
     pcintr_coroutine_t p, q;
     list_for_each_entry_safe(p, q, crtns, ln) {
@@ -98,6 +103,33 @@ broadcast_idle_event(struct pcinst *inst)
     }
 }
 
+static void
+unwatch_rdr_conn(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    if (heap->conn_monitor) {
+        purc_runloop_remove_fd_monitor(inst->running_loop, heap->conn_monitor);
+        heap->conn_monitor = 0;
+    }
+    heap->watched_conn = NULL;
+}
+
+static void
+watch_rdr_conn(struct pcinst *inst, struct pcrdr_conn *conn)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+    if (heap->watched_conn == conn) {
+        return;
+    }
+
+    unwatch_rdr_conn(inst);
+    if (conn && pcrdr_conn_fd(conn) >= 0) {
+        heap->conn_monitor = pcrun_add_wakeup_fd_monitor(inst->running_loop,
+                pcrdr_conn_fd(conn));
+    }
+    heap->watched_conn = conn;
+}
+
 static void
 handle_rdr_conn_lost(struct pcinst *inst)
 {
@@ -143,6 +175,7 @@ handle_rdr_conn_lost(struct pcinst *inst)
 
     // FIXME:
     // pcrdr_disconnect(inst->conn_to_rdr);
+    unwatch_rdr_conn(inst);
     pcrdr_free_connection(inst->conn_to_rdr);
     inst->conn_to_rdr = NULL;
 }
@@ -518,9 +551,8 @@ execute_one_step(struct pcinst *inst)
     bool busy = false;
     struct pcintr_heap *heap = inst->intr_heap;
 
-    pcintr_coroutine_t p, q, cor_tmp;
+    pcintr_coroutine_t cor_tmp;
     pcintr_coroutine_t co;
-    struct list_head *crtns;
 
     pcintr_coroutine_t cos[heap->nr_stopped_crtns];
     size_t pos = 0;
@@ -540,14 +572,19 @@ execute_one_step(struct pcinst *inst)
         pcintr_resume_coroutine(co);
     }
 
-    crtns = &heap->crtns;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
+    /* coroutines which become ready again go to the next round */
+    struct list_head ready;
+    list_head_init(&ready);
+    list_splice_init(&heap->ready_crtns, &ready);
+
+    while (!list_empty(&ready)) {
+        co = list_first_entry(&ready, struct pcintr_coroutine, ready_ln);
+        list_del(&co->ready_ln);
+        co->in_ready_queue = 0;
         if (co->state != CO_STATE_READY) {
             continue;
         }
 
-#if 1
         struct timespec begin;
         clock_gettime(CLOCK_MONOTONIC, &begin);
         struct pcintr_stack_frame *frame;
@@ -563,19 +600,17 @@ execute_one_step(struct pcinst *inst)
                 break;
             }
         }
-#else
-            execute_one_step_for_ready_co(inst, co);
-#endif
         busy = true;
     }
 
     return busy;
 }
 
-
-void
+// return whether a message was dispatched
+static bool
 check_and_dispatch_event_from_conn(struct pcinst *inst)
 {
+    bool dispatched = false;
     struct pcrdr_conn *conn =  purc_get_conn_to_renderer();
 
     if (conn) {
@@ -587,14 +622,24 @@ check_and_dispatch_event_from_conn(struct pcinst *inst)
         int last_err = purc_get_last_error();
         purc_clr_error();
 
-        pcrdr_wait_and_dispatch_message(conn, 0);
+        /* the extra source takes one message from the move buffer */
+        size_t nr_holding = 0;
+        purc_inst_holding_messages_count(&nr_holding);
+        purc_clr_error();
+
+        if (pcrdr_wait_and_dispatch_message(conn, 0) == 0 || nr_holding) {
+            dispatched = true;
+        }
 
         int err = purc_get_last_error();
         if (err == PCRDR_ERROR_IO || err == PCRDR_ERROR_PEER_CLOSED) {
             handle_rdr_conn_lost(inst);
+            dispatched = true;
         }
         purc_set_error(last_err);
     }
+
+    return dispatched;
 }
 
 static int
@@ -714,61 +759,133 @@ out:
     return busy;
 }
 
+// handle one message and one task of the coroutine in the event queue
+// return -1 if the coroutine exited, 1 if it made progress, otherwise 0
+static int
+dispatch_coroutine_event(pcintr_coroutine_t co, bool *busy)
+{
+    size_t nr_msgs = pcinst_msg_queue_count(co->mq);
+    struct list_head *first_task = co->tasks.next;
+
+    *busy = handle_coroutine_event(co);
+
+    if (co->stack.exited && co->stack.last_msg_read) {
+        pcintr_run_exiting_co(co);
+        *busy = true;
+        return -1;
+    }
+
+    /* an observed but unhandled message is put back to the queue */
+    if (*busy || co->state == CO_STATE_READY ||
+            pcinst_msg_queue_count(co->mq) < nr_msgs ||
+            co->tasks.next != first_task) {
+        return 1;
+    }
+
+    return 0;
+}
+
 static bool
 dispatch_event(struct pcinst *inst)
 {
-    UNUSED_PARAM(inst);
-
     struct timespec begin;
     bool is_busy = false;
+    struct pcintr_heap *heap = inst->intr_heap;
 
-#if 1
 again:
     is_busy = false;
     clock_gettime(CLOCK_MONOTONIC, &begin);
-#endif
-    check_and_dispatch_event_from_conn(inst);
+    if (check_and_dispatch_event_from_conn(inst)) {
+        is_busy = true;
+    }
 
-    bool co_is_busy = false;
-    struct pcintr_heap *heap = inst->intr_heap;
-    struct list_head *crtns = &heap->crtns;
-    pcintr_coroutine_t p, q;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
-        co_is_busy = handle_coroutine_event(co);
+    /* coroutines woken up during the dispatching go to the next round */
+    struct list_head pending;
+    list_head_init(&pending);
+    list_splice_init(&heap->event_crtns, &pending);
 
-        if (co->stack.exited && co->stack.last_msg_read) {
-            pcintr_run_exiting_co(co);
-        }
+    while (!list_empty(&pending)) {
+        pcintr_coroutine_t co;
+        co = list_first_entry(&pending, struct pcintr_coroutine, event_ln);
+        list_del_init(&co->event_ln);
 
+        /* keep in_event_queue set to suppress the notifications
+           caused by the handling of the coroutine itself */
+        bool co_is_busy = false;
+        int progress = dispatch_coroutine_event(co, &co_is_busy);
         if (co_is_busy) {
             is_busy = true;
         }
-    }
 
-    crtns = &heap->stopped_crtns;
-    list_for_each_entry_safe(p, q, crtns, ln) {
-        pcintr_coroutine_t co = p;
-        co_is_busy = handle_coroutine_event(co);
-
-        if (co->stack.exited && co->stack.last_msg_read) {
-            pcintr_run_exiting_co(co);
+        if (progress < 0) {
+            /* the coroutine was destroyed */
+            continue;
         }
 
-        if (co_is_busy) {
-            is_busy = true;
+        co->in_event_queue = 0;
+        if (progress && (pcinst_msg_queue_count(co->mq) > 0 ||
+                    !list_empty(&co->tasks))) {
+            pcintr_coroutine_queue_event(co);
         }
     }
 
-#if 1
     double diff = purc_get_elapsed_seconds(&begin, NULL);
     if (diff < TIME_SLIECE && is_busy) {
         goto again;
     }
-#endif
     return is_busy;
 }
 
+// park the scheduler until there is something to do
+static void
+park_scheduler(struct pcinst *inst)
+{
+    struct pcintr_heap *heap = inst->intr_heap;
+
+    if (!list_empty(&heap->ready_crtns) || !list_empty(&heap->event_crtns)) {
+        return;
+    }
+
+    size_t nr_holding = 0;
+    purc_inst_holding_messages_count(&nr_holding);
+    purc_clr_error();
+    if (nr_holding) {
+        return;
+    }
+
+    struct pcrdr_conn *conn = purc_get_conn_to_renderer();
+    watch_rdr_conn(inst, conn);
+
+    /* parked for ever if there is no renderer and no deadline */
+    long timeout = conn ? SCHEDULE_PARK_MAX : -1;
+
+    if (heap->nr_idle_observers) {
+        double left = heap->timestamp + IDLE_EVENT_TIMEOUT -
+            pcintr_get_current_time();
+        if (left < 0) {
+            left = 0;
+        }
+        if (timeout < 0 || left < timeout) {
+            timeout = (long)left + 1;
+        }
+    }
+
+    if (!list_empty(&heap->wait_timeout_crtns_avl.list_head)) {
+        pcintr_coroutine_t co;
+        co = avl_first_element(&heap->wait_timeout_crtns_avl, co, avl);
+        long left = co->stopped_timeout - pcintr_monotonic_time_ms();
+        if (left < 0) {
+            left = 0;
+        }
+        if (timeout < 0 || left < timeout) {
+            timeout = left;
+        }
+    }
+
+    heap->parked = 1;
+    pcrun_park_idle_callback(inst->running_loop, timeout);
+}
+
 void
 pcintr_schedule(void *ctxt)
 {
@@ -776,17 +893,22 @@ pcintr_schedule(void *ctxt)
     bool event_is_busy;
     struct pcinst *inst = (struct pcinst *)ctxt;
     if (!inst) {
-        goto out_sleep;
+        goto out_park;
     }
 
     struct pcintr_heap *heap = inst->intr_heap;
     if (!heap) {
-        goto out_sleep;
+        goto out_park;
     }
 
+    heap->parked = 0;
+
 again:
 
     if (inst->conn_to_rdr_origin) {
+        if (heap->watched_conn == inst->conn_to_rdr_origin) {
+            unwatch_rdr_conn(inst);
+        }
         pcrdr_disconnect(inst->conn_to_rdr_origin);
         inst->conn_to_rdr_origin = NULL;
     }
@@ -798,6 +920,9 @@ again:
     // 2. dispatch event for observing / stopped coroutines
     event_is_busy = dispatch_event(inst);
 
+    // send the DOM operations batched in this time slice to the renderer
+    pcintr_rdr_flush_dom_batch(inst);
+
     // 3. its busy, goto next scheduler without sleep
     if (step_is_busy || event_is_busy) {
         pcintr_update_timestamp(inst);
@@ -811,10 +936,12 @@ again:
         pcintr_update_timestamp(inst);
     }
 
-out_sleep:
-    pcutils_usleep(SCHEDULE_SLEEP);
-
+    // 6. wait for messages, timeouts or coroutines becoming ready
+    park_scheduler(inst);
     return;
+
+out_park:
+    pcrun_park_idle_callback(NULL, SCHEDULE_PARK_MAX);
 }
 
 int pcintr_yield(
@@ -1058,3 +1185,44 @@ void pcintr_resume_coroutine(pcintr_coroutine_t crtn)
     crtn->stopped_timeout = -1;
 }
 
+static void
+wake_up_scheduler(pcintr_heap_t heap)
+{
+    if (heap->parked) {
+        heap->parked = 0;
+        pcrun_wakeup_idle_callback(heap->owner->running_loop);
+    }
+}
+
+void pcintr_coroutine_queue_ready(pcintr_coroutine_t crtn)
+{
+    pcintr_heap_t heap = crtn->owner;
+    if (!crtn->in_ready_queue) {
+        crtn->in_ready_queue = 1;
+        list_add_tail(&crtn->ready_ln, &heap->ready_crtns);
+    }
+    wake_up_scheduler(heap);
+}
+
+void pcintr_coroutine_queue_event(pcintr_coroutine_t crtn)
+{
+    pcintr_heap_t heap = crtn->owner;
+    if (!crtn->in_event_queue) {
+        crtn->in_event_queue = 1;
+        list_add_tail(&crtn->event_ln, &heap->event_crtns);
+    }
+    wake_up_scheduler(heap);
+}
+
+void pcintr_coroutine_dequeue(pcintr_coroutine_t crtn)
+{
+    if (crtn->in_ready_queue) {
+        list_del(&crtn->ready_ln);
+        crtn->in_ready_queue = 0;
+    }
+
+    if (crtn->in_event_queue) {
+        list_del(&crtn->event_ln);
+        crtn->in_event_queue = 0;
+    }
+}
@@ -158,13 +158,72 @@ int pcrdr_conn_set_poll_timeout(pcrdr_conn* conn, int timeout_ms)
 
 size_t pcrdr_conn_pending_requests_count(pcrdr_conn* conn)
 {
-    size_t n = 0;
-    struct pending_request *pr;
-    list_for_each_entry(pr, &conn->pending_requests, list) {
-        n++;
+    return conn->nr_pending_requests;
+}
+
+size_t pcrdr_conn_set_max_pending_requests(pcrdr_conn* conn,
+        size_t max_pending)
+{
+    size_t old = conn->max_pending_requests;
+    conn->max_pending_requests = max_pending;
+    return old;
+}
+
+static int
+add_pending_request(pcrdr_conn* conn, struct pending_request *pr, bool first)
+{
+    if (conn->pending_map == NULL) {
+        conn->pending_map = pcutils_uomap_create(NULL, NULL, NULL, NULL,
+                NULL, NULL, false, false);
+        if (conn->pending_map == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return -1;
+        }
+    }
+
+    /* the key is owned by the request identifier of the pending request */
+    if (pcutils_uomap_replace_or_insert(conn->pending_map,
+                purc_variant_get_string_const(pr->request_id), pr, NULL)) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    if (first)
+        list_add(&pr->list, &conn->pending_requests);
+    else
+        list_add_tail(&pr->list, &conn->pending_requests);
+    conn->nr_pending_requests++;
+    return 0;
+}
+
+static struct pending_request *
+find_pending_request(pcrdr_conn* conn, const char *request_id)
+{
+    if (conn->pending_map == NULL)
+        return NULL;
+
+    pcutils_uomap_entry *entry;
+    entry = pcutils_uomap_find(conn->pending_map, request_id);
+    if (entry == NULL)
+        return NULL;
+
+    return (struct pending_request *)pcutils_uomap_entry_val(entry);
+}
+
+static void
+remove_pending_request(pcrdr_conn* conn, struct pending_request *pr)
+{
+    const char *request_id = purc_variant_get_string_const(pr->request_id);
+
+    if (conn->pending_map &&
+            find_pending_request(conn, request_id) == pr) {
+        pcutils_uomap_erase(conn->pending_map, request_id);
     }
 
-    return n;
+    list_del(&pr->list);
+    conn->nr_pending_requests--;
+    purc_variant_unref(pr->request_id);
+    free(pr);
 }
 
 int pcrdr_free_connection(pcrdr_conn* conn)
@@ -186,9 +245,11 @@ int pcrdr_free_connection(pcrdr_conn* conn)
                     purc_variant_get_string_const(pr->request_id),
                     PCRDR_RESPONSE_CANCELLED, pr->context, NULL);
         }
-        list_del(&pr->list);
-        purc_variant_unref(pr->request_id);
-        free(pr);
+        remove_pending_request(conn, pr);
+    }
+
+    if (conn->pending_map) {
+        pcutils_uomap_destroy(conn->pending_map);
     }
 
     free(conn);
@@ -259,7 +320,57 @@ pcrdr_set_handler_for_response_from_extra_source(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add_tail(&pr->list, &conn->pending_requests);
+
+    if (add_pending_request(conn, pr, false)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int dispatch_message(pcrdr_conn *conn, pcrdr_msg *msg);
+static int check_timeout_requests(pcrdr_conn *conn);
+
+/* read and dispatch messages once; returns -1 on error */
+static int
+pump_messages(pcrdr_conn* conn)
+{
+    int retval;
+    pcrdr_msg *msg;
+
+    if (conn->source_fn) {
+        msg = conn->source_fn(conn, conn->source_ctxt);
+        if (msg) {
+            dispatch_message(conn, msg);
+        }
+    }
+
+    retval = conn->wait_message(conn, conn->timeout_ms);
+    if (retval < 0) {
+        purc_set_error(PCRDR_ERROR_BAD_SYSTEM_CALL);
+        return -1;
+    }
+    else if (retval > 0) {
+        msg = conn->read_message(conn);
+        if (msg == NULL) {
+            return -1;
+        }
+
+        dispatch_message(conn, msg);
+    }
+
+    check_timeout_requests(conn);
+    return 0;
+}
+
+int pcrdr_wait_pending_requests(pcrdr_conn* conn)
+{
+    while (conn->nr_pending_requests > 0) {
+        if (pump_messages(conn))
+            return -1;
+    }
 
     return 0;
 }
@@ -275,6 +386,14 @@ int pcrdr_send_request(pcrdr_conn* conn, pcrdr_msg *request_msg,
         return -1;
     }
 
+    /* keep the number of requests in flight within the window */
+    size_t max_pending = conn->max_pending_requests ?
+        conn->max_pending_requests : PCRDR_DEF_MAX_PENDING_REQUESTS;
+    while (conn->nr_pending_requests >= max_pending) {
+        if (pump_messages(conn))
+            return -1;
+    }
+
     conn->stats.nr_requests_sent++;
     if (conn->send_message(conn, request_msg) < 0) {
         return -1;
@@ -302,55 +421,40 @@ pcrdr_send_event(pcrdr_conn *conn, pcrdr_msg *event_msg)
     return 0;
 }
 
-static inline int
-variant_strcmp(purc_variant_t a, purc_variant_t b)
-{
-    if (a == b)
-        return 0;
-
-    return strcmp(
-            purc_variant_get_string_const(a),
-            purc_variant_get_string_const(b));
-}
-
 static int
 handle_response_message(pcrdr_conn* conn, const pcrdr_msg *msg)
 {
     int retval = -1;
+    const char *request_id = purc_variant_get_string_const(msg->requestId);
 
-    if (!list_empty(&conn->pending_requests)) {
-        struct pending_request *pr;
-        pr = list_first_entry(&conn->pending_requests,
-                struct pending_request, list);
-
-        if (variant_strcmp(msg->requestId, pr->request_id) == 0) {
-            const char *request_id =
-                purc_variant_get_string_const(msg->requestId);
-            if (pr->response_handler && pr->response_handler(conn,
-                        request_id,
-                        PCRDR_RESPONSE_RESULT, pr->context, msg) < 0) {
-                purc_log_warn("response handler for %s returned failure\n",
-                        request_id);
-            }
-
-            retval = 0;
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
-        }
-        else if (strcmp("-",
-                    purc_variant_get_string_const(msg->requestId))== 0) {
-            /* FIXME: */
-            purc_log_warn("ignore noreturn request\n");
-            retval = 0;
-        }
-        else {
-            purc_log_error("response not matched the first pending request\n");
-            purc_set_error(PCRDR_ERROR_UNEXPECTED);
+    /* responses may arrive in any order */
+    struct pending_request *pr = find_pending_request(conn, request_id);
+    if (pr) {
+        /* remove it first: the handler may send new requests */
+        list_del(&pr->list);
+        list_head_init(&pr->list);
+        pcutils_uomap_erase(conn->pending_map, request_id);
+
+        if (pr->response_handler && pr->response_handler(conn,
+                    request_id,
+                    PCRDR_RESPONSE_RESULT, pr->context, msg) < 0) {
+            purc_log_warn("response handler for %s returned failure\n",
+                    request_id);
         }
+
+        retval = 0;
+        conn->nr_pending_requests--;
+        purc_variant_unref(pr->request_id);
+        free(pr);
+    }
+    else if (strcmp(PCRDR_REQUESTID_NORETURN, request_id) == 0) {
+        /* FIXME: */
+        purc_log_warn("ignore noreturn request\n");
+        retval = 0;
     }
     else {
-        purc_log_error("no pending request?\n");
+        purc_log_error("no pending request for the response: %s\n",
+                request_id);
         purc_set_error(PCRDR_ERROR_UNEXPECTED);
     }
 
@@ -371,9 +475,7 @@ check_timeout_requests(pcrdr_conn *conn)
                         PCRDR_RESPONSE_TIMEOUT, pr->context, NULL);
             }
 
-            list_del(&pr->list);
-            purc_variant_unref(pr->request_id);
-            free(pr);
+            remove_pending_request(conn, pr);
         }
     }
 
@@ -553,7 +655,11 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
         pr->time_expected = purc_get_monotoic_time() + 3600;
     else
         pr->time_expected = purc_get_monotoic_time() + seconds_expected;
-    list_add(&pr->list, &conn->pending_requests);
+    if (add_pending_request(conn, pr, true)) {
+        purc_variant_unref(pr->request_id);
+        free(pr);
+        return -1;
+    }
 
     while (*response_msg == NULL) {
         pcrdr_msg *msg;
@@ -603,9 +709,7 @@ pcrdr_wait_response_for_specific_request(pcrdr_conn* conn,
     }
 
     if (*response_msg == NULL) {
-        list_del(&pr->list);
-        purc_variant_unref(pr->request_id);
-        free(pr);
+        remove_pending_request(conn, pr);
     }
     else if (*response_msg == MSG_POINTER_INVALID) {
         *response_msg = NULL;   /* reset response messge to NULL */
@@ -31,6 +31,7 @@
 
 #include "purc-pcrdr.h"
 #include "private/list.h"
+#include "private/map.h"
 
 #include "purc.h"
 
@@ -87,8 +88,16 @@ struct pcrdr_conn {
     pcrdr_request_handler request_handler;
     pcrdr_event_handler event_handler;
 
-    /* the pending requests queue */
+    /* the pending requests queue, in the order of sending */
     struct list_head pending_requests;
+    /* requestId -> struct pending_request, created on demand */
+    pcutils_uomap *pending_map;
+    size_t nr_pending_requests;
+    /* the max number of requests in flight; 0 for the default */
+    size_t max_pending_requests;
+
+    /* the peer reads variants in the binary encoding (`binary` data) */
+    bool binary_data;
 
     /* operations */
     int (*wait_message) (pcrdr_conn* conn, int timeout_ms);
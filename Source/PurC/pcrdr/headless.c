@@ -58,7 +58,8 @@
     "workspace:" __STRING(8)                                \
     "/tabbedWindow:" __STRING(8)                            \
     "/widgetInTabbedWindow:" __STRING(32)                   \
-    "/plainWindow:" __STRING(256)
+    "/plainWindow:" __STRING(256) "\n"                       \
+    "batchOperations:" __STRING(64)
 
 struct tabbedwin_info {
     // the group identifier of the tabbedwin
@@ -139,30 +140,29 @@ struct pcrdr_prot_data {
     struct session_info *session;
 };
 
-static struct result_info *result_of_first_request(pcrdr_conn* conn)
+/* returns the result of the earliest pending request which has got one */
+static struct result_info *result_of_pending_request(pcrdr_conn* conn,
+        const char **request_id)
 {
-    if (list_empty(&conn->pending_requests)) {
-        return NULL;
-    }
-
     struct pending_request *pr;
-    pr = list_first_entry(&conn->pending_requests,
-            struct pending_request, list);
-
-    const char *request_id;
-    request_id = purc_variant_get_string_const(pr->request_id);
+    list_for_each_entry(pr, &conn->pending_requests, list) {
+        const char *id = purc_variant_get_string_const(pr->request_id);
 
-    struct result_info **data;
-    data = pcutils_kvlist_get(&conn->prot_data->results, request_id);
-    if (data == NULL)
-        return NULL;
+        struct result_info **data;
+        data = pcutils_kvlist_get(&conn->prot_data->results, id);
+        if (data) {
+            if (request_id)
+                *request_id = id;
+            return *data;
+        }
+    }
 
-    return *data;
+    return NULL;
 }
 
 static int my_wait_message(pcrdr_conn* conn, int timeout_ms)
 {
-    if (result_of_first_request(conn) == NULL) {
+    if (result_of_pending_request(conn, NULL) == NULL) {
         if (timeout_ms > 1000) {
             pcutils_sleep(timeout_ms / 1000);
         }
@@ -210,19 +210,13 @@ static pcrdr_msg *my_read_message(pcrdr_conn* conn)
     pcrdr_msg* msg = NULL;
     struct result_info *result;
 
-    if ((result = result_of_first_request(conn)) == NULL) {
-        purc_log_warn("There is not any result for the first request.\n");
+    const char *request_id;
+    if ((result = result_of_pending_request(conn, &request_id)) == NULL) {
+        purc_log_warn("There is not any result for the pending requests.\n");
         purc_set_error(PCRDR_ERROR_UNEXPECTED);
         return NULL;
     }
 
-    struct pending_request *pr;
-    pr = list_first_entry(&conn->pending_requests,
-            struct pending_request, list);
-
-    const char *request_id;
-    request_id = purc_variant_get_string_const(pr->request_id);
-
     msg = pcrdr_make_response_message(
             request_id, NULL,
             result->retCode, (uint64_t)(uintptr_t)result->resultValue,
@@ -1662,6 +1656,46 @@ found:
     result->resultValue = msg->targetValue;
 }
 
+static void on_batch(struct pcrdr_prot_data *prot_data,
+        const pcrdr_msg *msg, unsigned int op_id, struct result_info *result)
+{
+    on_operate_dom(prot_data, msg, op_id, result);
+    if (result->retCode != PCRDR_SC_OK) {
+        return;
+    }
+
+    size_t nr_ops;
+    if (msg->dataType != PCRDR_MSG_DATA_TYPE_JSON || msg->data == NULL ||
+            !purc_variant_array_size(msg->data, &nr_ops) || nr_ops == 0) {
+        result->retCode = PCRDR_SC_BAD_REQUEST;
+        return;
+    }
+
+    /* every operation in the batch must be a DOM mutation */
+    for (size_t i = 0; i < nr_ops; i++) {
+        purc_variant_t op = purc_variant_array_get(msg->data, i);
+        purc_variant_t v;
+        const char *operation = NULL;
+        const char *element = NULL;
+
+        if ((v = purc_variant_object_get_by_ckey(op, "operation")))
+            operation = purc_variant_get_string_const(v);
+        if ((v = purc_variant_object_get_by_ckey(op, "element")))
+            element = purc_variant_get_string_const(v);
+        purc_clr_error();
+
+        unsigned int id;
+        if (operation == NULL || element == NULL ||
+                pcrdr_operation_from_atom(
+                    pcrdr_check_operation(operation), &id) == NULL ||
+                id < PCRDR_K_OPERATION_APPEND ||
+                id > PCRDR_K_OPERATION_CLEAR) {
+            result->retCode = PCRDR_SC_BAD_REQUEST;
+            return;
+        }
+    }
+}
+
 static void on_call_method(struct pcrdr_prot_data *prot_data,
         const pcrdr_msg *msg, unsigned int op_id, struct result_info *result)
 {
@@ -1786,6 +1820,7 @@ static request_handler handlers[] = {
     on_call_method,
     on_get_property,
     on_set_property,
+    on_batch,
 };
 
 /* make sure the number of operation handlers matches the enumulators */
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "private/pcrdr.h"
 #include "private/instance.h"
+#include "private/variant.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -112,6 +113,17 @@ pcrdr_msg *pcrdr_make_request_message(
             goto failed;
         }
     }
+    else if (data_type == PCRDR_MSG_DATA_TYPE_BINARY) {
+        assert(data);
+        msg->data = pcvariant_load_from_binary(data, data_len, false, NULL);
+
+        if (msg->data == NULL) {
+            goto failed;
+        }
+
+        /* the same as pcrdr_parse_packet() does for the binary data */
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    }
     else {  /* for other text types */
         assert(data);
         msg->data = purc_variant_make_string_ex(data, data_len, true);
@@ -161,6 +173,17 @@ pcrdr_msg *pcrdr_make_response_message(
             goto failed;
         }
     }
+    else if (data_type == PCRDR_MSG_DATA_TYPE_BINARY) {
+        assert(data);
+        msg->data = pcvariant_load_from_binary(data, data_len, false, NULL);
+
+        if (msg->data == NULL) {
+            goto failed;
+        }
+
+        /* the same as pcrdr_parse_packet() does for the binary data */
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    }
     else {  /* for other text types */
         assert(data);
         msg->data = purc_variant_make_string_ex(data, data_len, true);
@@ -235,6 +258,17 @@ pcrdr_msg *pcrdr_make_event_message(
             goto failed;
         }
     }
+    else if (data_type == PCRDR_MSG_DATA_TYPE_BINARY) {
+        assert(data);
+        msg->data = pcvariant_load_from_binary(data, data_len, false, NULL);
+
+        if (msg->data == NULL) {
+            goto failed;
+        }
+
+        /* the same as pcrdr_parse_packet() does for the binary data */
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    }
     else { /* for other text types */
         assert(data);
         msg->data = purc_variant_make_string_ex(data, data_len, true);
@@ -605,6 +639,7 @@ static const char *data_type_names[] = {
     "mathml",
     "xgml",
     "xml",
+    "binary",
 };
 
 /* make sure number of data_type_names matches the enums */
@@ -711,8 +746,6 @@ int pcrdr_parse_packet(char *packet, size_t sz_packet, pcrdr_msg **msg_out)
     char *saveptr1;
     char *data;
 
-    UNUSED_PARAM(sz_packet);
-
     if ((msg = pcinst_get_message()) == NULL) {
         purc_set_error(PCRDR_ERROR_NOMEM);
         return -1;
@@ -769,6 +802,20 @@ int pcrdr_parse_packet(char *packet, size_t sz_packet, pcrdr_msg **msg_out)
             goto failed;
         }
     }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_BINARY) {
+        if (data == NULL || data + msg->__data_len > packet + sz_packet) {
+            goto failed;
+        }
+
+        msg->data = pcvariant_load_from_binary(data, msg->__data_len,
+                false, NULL);
+        if (msg->data == NULL) {
+            goto failed;
+        }
+
+        /* the receivers handle the variant like the one parsed from JSON */
+        msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    }
     else {  /* for other text types */
         // FIXME: check __data_len ???
         assert(data != NULL /* && msg->__data_len > 0 */);
@@ -823,6 +870,22 @@ serialize_message_data(const pcrdr_msg *msg, pcrdr_cb_write fn, void *ctxt)
         text = text_alloc;
         purc_rwstream_destroy(buffer);
     }
+    else if (msg->dataType == PCRDR_MSG_DATA_TYPE_BINARY) {
+        purc_rwstream_t buffer = NULL;
+        buffer = purc_rwstream_new_buffer(PCRDR_MIN_PACKET_BUFF_SIZE,
+                PCRDR_MAX_INMEM_PAYLOAD_SIZE);
+
+        if (pcvariant_serialize_binary(msg->data, buffer) < 0) {
+            errcode = purc_get_last_error();
+            purc_rwstream_destroy(buffer);
+            goto done;
+        }
+
+        text_alloc = purc_rwstream_get_mem_buffer_ex(buffer, &text_len,
+                NULL, true);
+        text = text_alloc;
+        purc_rwstream_destroy(buffer);
+    }
     else {  /* for other text types */
         text = purc_variant_get_string_const_ex(msg->data, &text_len);
         assert(msg->data != NULL);
@@ -1290,6 +1353,12 @@ pcrdr_parse_renderer_capabilities(const char *data)
             else if (strcasecmp(cap, "displayDensity") == 0) {  // Since 160
                 rdr_caps->display_density = strdup(value);
             }
+            else if (strcasecmp(cap, "batchOperations") == 0) { // Since 0.9.22
+                rdr_caps->batchOperations = (int)strtol(value, NULL, 10);
+            }
+            else if (strcasecmp(cap, "binaryData") == 0) {
+                rdr_caps->binaryData = (int)strtol(value, NULL, 10);
+            }
             else {
                 PC_WARN("Unknown renderer capability: %s\n", cap);
                 break;
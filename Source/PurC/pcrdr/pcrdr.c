@@ -32,6 +32,7 @@
 #include "private/debug.h"
 #include "private/utils.h"
 #include "private/pcrdr.h"
+#include "private/variant.h"
 #include "private/runners.h"
 
 #include "connect.h"
@@ -90,6 +91,7 @@ static struct pcrdr_opatom {
     { PCRDR_OPERATION_CALLMETHOD,           0 }, // "callMethod"
     { PCRDR_OPERATION_GETPROPERTY,          0 }, // "getProperty"
     { PCRDR_OPERATION_SETPROPERTY,          0 }, // "setProperty"
+    { PCRDR_OPERATION_BATCH,                0 }, // "batch"
 };
 
 /* make sure the number of operations matches the enumulators */
@@ -190,7 +192,7 @@ static int set_session_args(struct pcinst *inst,
         struct renderer_capabilities *rdr_caps)
 {
     (void) rdr_caps;
-    purc_variant_t vs[22] = { NULL };
+    purc_variant_t vs[24] = { NULL };
     purc_variant_t tmp;
     int n = 0;
 
@@ -210,6 +212,9 @@ static int set_session_args(struct pcinst *inst,
     vs[n++] = purc_variant_make_boolean(inst->allow_switching_rdr);
     vs[n++] = purc_variant_make_string_static("allowScalingByDensity", false);
     vs[n++] = purc_variant_make_boolean(inst->allow_scaling_by_density);
+    /* the version of the binary encoding of variants we read */
+    vs[n++] = purc_variant_make_string_static("binaryData", false);
+    vs[n++] = purc_variant_make_ulongint(PCVRNT_BINARY_VERSION);
 
     vs[n++] = purc_variant_make_string_static("appLabel", false);
     tmp = purc_get_app_label(rdr_caps->locale);
@@ -358,6 +363,9 @@ static int connect_to_renderer(struct pcinst *inst,
         if (inst->rdr_caps == NULL) {
             goto failed;
         }
+
+        inst->conn_to_rdr->binary_data =
+            (inst->rdr_caps->binaryData >= PCVRNT_BINARY_VERSION);
     }
     pcrdr_release_message(msg);
 
@@ -620,6 +628,9 @@ int pcrdr_switch_renderer(struct pcinst *inst, const char *comm,
         if (n_rdr_caps == NULL) {
             goto failed;
         }
+
+        n_conn_to_rdr->binary_data =
+            (n_rdr_caps->binaryData >= PCVRNT_BINARY_VERSION);
     }
     pcrdr_release_message(msg);
 
@@ -490,23 +490,34 @@ done:
     return msg;
 }
 
+static int send_packet (pcrdr_conn* conn, bool binary,
+        const char* text, size_t len);
+
 static int my_send_message (pcrdr_conn* conn, pcrdr_msg *msg)
 {
     int retv = -1;
     purc_rwstream_t buffer = NULL;
 
+    /* send JSON data in the binary encoding if the peer accepts it */
+    pcrdr_msg_data_type data_type = msg->dataType;
+    if (conn->binary_data && data_type == PCRDR_MSG_DATA_TYPE_JSON)
+        msg->dataType = PCRDR_MSG_DATA_TYPE_BINARY;
+
     buffer = purc_rwstream_new_buffer (PCRDR_MIN_PACKET_BUFF_SIZE,
             PCRDR_MAX_INMEM_PAYLOAD_SIZE);
 
-    if (pcrdr_serialize_message (msg,
-                (pcrdr_cb_write)purc_rwstream_write, buffer) < 0) {
+    int ret = pcrdr_serialize_message (msg,
+                (pcrdr_cb_write)purc_rwstream_write, buffer);
+    bool binary = (msg->dataType == PCRDR_MSG_DATA_TYPE_BINARY);
+    msg->dataType = data_type;
+    if (ret < 0) {
         goto done;
     }
 
     size_t packet_len;
     const char * packet = purc_rwstream_get_mem_buffer (buffer, &packet_len);
 
-    if (pcrdr_socket_send_text_packet (conn, packet, packet_len) < 0) {
+    if (send_packet (conn, binary, packet, packet_len) < 0) {
         goto done;
     }
 
@@ -1488,7 +1499,9 @@ done:
     return 0;
 }
 
-int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+/* sends a text packet, or a binary one if `binary` is true */
+static int send_packet (pcrdr_conn* conn, bool binary,
+        const char* text, size_t len)
 {
     int retv = 0;
 
@@ -1500,7 +1513,7 @@ int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
 
             do {
                 if (left == len) {
-                    header.op = US_OPCODE_TEXT;
+                    header.op = binary ? US_OPCODE_BIN : US_OPCODE_TEXT;
                     header.fragmented = len;
                     header.sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
                     left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
@@ -1526,7 +1539,7 @@ int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
             } while (left > 0 && retv == 0);
         }
         else {
-            header.op = US_OPCODE_TEXT;
+            header.op = binary ? US_OPCODE_BIN : US_OPCODE_TEXT;
             header.fragmented = 0;
             header.sz_payload = len;
             if (conn_write (conn->fd, &header, sizeof (USFrameHeader)) == 0)
@@ -1547,7 +1560,7 @@ int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
             do {
                 if (left == len) {
                     fin = 0;
-                    opcode = WS_OPCODE_TEXT;
+                    opcode = binary ? WS_OPCODE_BIN : WS_OPCODE_TEXT;
                     sz_payload = PCRDR_MAX_FRAME_PAYLOAD_SIZE;
                     left -= PCRDR_MAX_FRAME_PAYLOAD_SIZE;
                 }
@@ -1570,7 +1583,8 @@ int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
             } while (left > 0 && retv == 0);
         }
         else {
-            retv = ws_send_data_frame(conn->fd, 1, WS_OPCODE_TEXT, text, len);
+            retv = ws_send_data_frame(conn->fd, 1,
+                    binary ? WS_OPCODE_BIN : WS_OPCODE_TEXT, text, len);
         }
     }
     else
@@ -1579,6 +1593,11 @@ int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t le
     return retv;
 }
 
+int pcrdr_socket_send_text_packet (pcrdr_conn* conn, const char* text, size_t len)
+{
+    return send_packet(conn, false, text, len);
+}
+
 #define SCHEMA_UNIX_SOCKET  "unix://"
 
 pcrdr_msg *pcrdr_socket_connect(const char* renderer_uri,
@@ -28,6 +28,7 @@
 #include "purc-utils.h"
 #include "private/errors.h"
 #include "private/instance.h"
+#include "private/utf8.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -557,6 +558,118 @@ int purc_rwstream_read_utf8_char (purc_rwstream_t rws, char* buf_utf8,
     return ch_len;
 }
 
+/* Decodes one character at the head of buf[0..*len], reading the missing
+ * continuation bytes from the stream if the character is cut by the end of
+ * the block. Mirrors the checks of purc_rwstream_read_utf8_char(); returns
+ * the number of bytes consumed, or -1 on reaching the end of the stream in
+ * the middle of a character. */
+static int
+decode_utf8_char_in_block(purc_rwstream_t rws, unsigned char *buf,
+        size_t len, uint32_t *wc)
+{
+    int n = 1;
+    int ch_len;
+    uint8_t c = buf[0];
+
+    if (c > 0xFD) {
+        *wc = PCRWSTREAM_INVALID_CHAR;
+        return 1;
+    }
+
+    if (c & 0x80) {
+        while (c & (0x80 >> n))
+            n++;
+
+        if (n < 2) {
+            *wc = PCRWSTREAM_INVALID_CHAR;
+            return 1;
+        }
+        ch_len = n;
+    }
+    else {
+        *wc = c;
+        return 1;
+    }
+
+    for (int i = 1; i < ch_len; i++) {
+        if ((size_t)i >= len) {
+            /* the block never holds more than the caller asked for, so the
+             * trailing partial character is completed byte by byte */
+            if (purc_rwstream_read(rws, buf + i, 1) != 1) {
+                *wc = PCRWSTREAM_INVALID_CHAR;
+                return -1;
+            }
+        }
+
+        if ((buf[i] & 0xC0) != 0x80) {
+            *wc = PCRWSTREAM_INVALID_CHAR;
+            return i + 1;
+        }
+    }
+
+    size_t nr_chars;
+    if (ch_len > 3 || !pcutils_string_check_utf8_len((const char *)buf,
+                ch_len, &nr_chars, NULL)) {
+        *wc = PCRWSTREAM_INVALID_CHAR;
+    }
+    else {
+        *wc = utf8_to_uint32_t(buf, ch_len);
+    }
+    return ch_len;
+}
+
+#define SZ_UTF8_BLOCK       1024
+
+ssize_t purc_rwstream_read_utf8_chars (purc_rwstream_t rws,
+        uint32_t* buf_wc, size_t nr_wcs)
+{
+    if (rws == NULL || buf_wc == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    /* 5 spare bytes for completing a character cut by the end of a block */
+    unsigned char block[SZ_UTF8_BLOCK + 8];
+    size_t nr_decoded = 0;
+
+    while (nr_decoded < nr_wcs) {
+        /* every character takes at least one byte: asking for no more bytes
+         * than the characters still wanted never consumes data beyond the
+         * last decoded character */
+        size_t want = nr_wcs - nr_decoded;
+        if (want > SZ_UTF8_BLOCK)
+            want = SZ_UTF8_BLOCK;
+
+        ssize_t nr_read = purc_rwstream_read(rws, block, want);
+        if (nr_read <= 0) {
+            if (nr_decoded == 0)
+                return nr_read;
+            break;
+        }
+
+        /* the leading ASCII characters of the block need no decoding */
+        size_t pos = pcutils_ascii_span((const char *)block, nr_read);
+        for (size_t i = 0; i < pos; i++)
+            buf_wc[nr_decoded + i] = block[i];
+        nr_decoded += pos;
+
+        while (pos < (size_t)nr_read) {
+            int used = decode_utf8_char_in_block(rws, block + pos,
+                    nr_read - pos, buf_wc + nr_decoded);
+            nr_decoded++;
+            if (used < 0)
+                return nr_decoded;
+            pos += used;
+        }
+
+        /* do not block on a pipe when a short read already gave us data */
+        if ((size_t)nr_read < want)
+            break;
+    }
+
+    return nr_decoded;
+}
+
 ssize_t purc_rwstream_write (purc_rwstream_t rws, const void* buf, size_t count)
 {
     if (rws == NULL) {
@@ -44,89 +44,194 @@ do {                                                        \
     goto error;                                             \
 } while (0)
 
-/* see IETF RFC 3629 Section 4 */
+#if CPU(X86_64) && COMPILER(GCC_COMPATIBLE)
+#define USE_AVX2_DISPATCH   1
+#include <immintrin.h>
+#include <pthread.h>
+#elif CPU(X86_SSE2)
+#include <emmintrin.h>
+#elif CPU(ARM64)
+#include <arm_neon.h>
+#endif
 
-static const char *
-fast_validate(const char *str, size_t *nr_chars)
+/* do not bother the vector code for short runs */
+#define MIN_LEN_ASCII_SPAN  16
+#define MAX_GAP_ASCII_SPAN  1024
+
+/*
+ * The functions below return the exact length of the leading run of ASCII
+ * characters other than the null byte in `str`, not longer than `len`.
+ */
+static size_t
+ascii_span_word(const char *str, size_t len)
 {
-    size_t n = 0;
-    const char *p;
+    const uint64_t ones = UINT64_C(0x0101010101010101);
+    const uint64_t highs = UINT64_C(0x8080808080808080);
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t w;
+        memcpy(&w, str + i, sizeof(w));
+        /* a byte with the high bit set, or a null byte */
+        if ((w | ((w - ones) & ~w)) & highs)
+            break;
+    }
 
-    for (p = str; *p; p++) {
-        if (*(uint8_t *)p < 128) {
-            n++;
-        }
-        else {
-            const char *last;
+    /* find the byte stopping the run in the last word or the tail */
+    while (i < len && (uint8_t)(str[i] - 1) < 0x7f)
+        i++;
 
-            last = p;
-            if (*(uint8_t *)p < 0xe0) /* 110xxxxx */
-            {
-                if (UNLIKELY (*(uint8_t *)p < 0xc2))
-                    goto error;
-            }
-            else {
-                if (*(uint8_t *)p < 0xf0) /* 1110xxxx */
-                {
-                    switch (*(uint8_t *)p++ & 0x0f) {
-                    case 0:
-                        VALIDATE_BYTE(0xe0, 0xa0); /* 0xa0 ... 0xbf */
-                        break;
-                    case 0x0d:
-                        VALIDATE_BYTE(0xe0, 0x80); /* 0x80 ... 0x9f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                }
-                else if (*(uint8_t *)p < 0xf5) /* 11110xxx excluding out-of-range */
-                {
-                    switch (*(uint8_t *)p++ & 0x07) {
-                    case 0:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                        if (UNLIKELY((*(uint8_t *)p & 0x30) == 0))
-                            goto error;
-                        break;
-                    case 4:
-                        VALIDATE_BYTE(0xf0, 0x80); /* 0x80 ... 0x8f */
-                        break;
-                    default:
-                        VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                    }
-                    p++;
-                    VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
-                }
-                else
-                    goto error;
-            }
+    return i;
+}
 
-            p++;
-            VALIDATE_BYTE(0xc0, 0x80); /* 10xxxxxx */
+#if CPU(X86_SSE2)
+static inline unsigned
+ctz32(uint32_t mask)
+{
+#if COMPILER(GCC_COMPATIBLE)
+    return __builtin_ctz(mask);
+#else
+    unsigned n = 0;
+    while ((mask & 1) == 0) {
+        mask >>= 1;
+        n++;
+    }
+    return n;
+#endif
+}
 
-            n++;
-            continue;
-error:
-            if (nr_chars)
-                *nr_chars = n;
-            return last;
-        }
+static size_t
+ascii_span_sse2(const char *str, size_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(str + i));
+        uint32_t mask = (uint32_t)(_mm_movemask_epi8(v) |
+                _mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+        if (mask)
+            return i + ctz32(mask);
     }
 
-    if (nr_chars)
-        *nr_chars = n;
-    return p;
+    return i + ascii_span_word(str + i, len - i);
+}
+#endif
+
+#if USE(AVX2_DISPATCH)
+__attribute__((target("avx2")))
+static size_t
+ascii_span_avx2(const char *str, size_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(str + i));
+        uint32_t mask = (uint32_t)(_mm256_movemask_epi8(v) |
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+        if (mask)
+            return i + ctz32(mask);
+    }
+
+    return i + ascii_span_sse2(str + i, len - i);
+}
+#endif
+
+#if CPU(ARM64)
+static size_t
+ascii_span_neon(const char *str, size_t len)
+{
+    const uint8x16_t highs = vdupq_n_u8(0x80);
+    const uint8x16_t zero = vdupq_n_u8(0);
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(str + i));
+        uint8x16_t bad = vorrq_u8(vcgeq_u8(v, highs), vceqq_u8(v, zero));
+        if (vmaxvq_u8(bad))
+            break;
+    }
+
+    return i + ascii_span_word(str + i, len - i);
+}
+#endif
+
+typedef size_t (*ascii_span_fn)(const char *str, size_t len);
+
+#if USE(AVX2_DISPATCH)
+static ascii_span_fn ascii_span_impl;
+static pthread_once_t ascii_span_once = PTHREAD_ONCE_INIT;
+
+static void
+resolve_ascii_span(void)
+{
+    if (__builtin_cpu_supports("avx2"))
+        ascii_span_impl = ascii_span_avx2;
+    else
+        ascii_span_impl = ascii_span_sse2;
+}
+#endif
+
+static inline ascii_span_fn
+get_ascii_span(void)
+{
+#if USE(AVX2_DISPATCH)
+    pthread_once(&ascii_span_once, resolve_ascii_span);
+    return ascii_span_impl;
+#elif CPU(X86_SSE2)
+    return ascii_span_sse2;
+#elif CPU(ARM64)
+    return ascii_span_neon;
+#else
+    return ascii_span_word;
+#endif
+}
+
+size_t
+pcutils_ascii_span(const char *str, size_t len)
+{
+    return get_ascii_span()(str, len);
 }
 
+/* see IETF RFC 3629 Section 4 */
+
 static const char *
 fast_validate_len(const char *str, ssize_t max_len, size_t *nr_chars)
 {
     size_t n = 0;
     const char *p;
+    ascii_span_fn ascii_span = get_ascii_span();
+    const char *end = str + max_len;
+    /* the vector code is not used again before `next_span` after it
+       stopped; the distance grows while the runs found are short. */
+    const char *next_span = (max_len >= MIN_LEN_ASCII_SPAN) ? str : end;
+    size_t span_gap = MIN_LEN_ASCII_SPAN;
 
     assert(max_len >= 0);
 
     for (p = str; ((p - str) < max_len) && *p; p++) {
         if (*(uint8_t *)p < 128) {
+            if (UNLIKELY(p >= next_span)) {
+                /* not zero: `*p` is an ASCII character but the null */
+                size_t span = ascii_span(p, end - p);
+                if (span < MIN_LEN_ASCII_SPAN) {
+                    if (span_gap < MAX_GAP_ASCII_SPAN)
+                        span_gap <<= 1;
+                }
+                else {
+                    span_gap = MIN_LEN_ASCII_SPAN;
+                }
+
+                n += span;
+                p += span;
+                if ((size_t)(end - p) >= span_gap + MIN_LEN_ASCII_SPAN)
+                    next_span = p + span_gap;
+                else
+                    next_span = end;
+                p--;
+                continue;
+            }
             n++;
         }
         else {
@@ -224,7 +329,8 @@ bool pcutils_string_check_utf8(const char *str, ssize_t max_len,
     if (max_len >= 0)
         return pcutils_string_check_utf8_len(str, max_len, nr_chars, end);
 
-    p = fast_validate(str, nr_chars);
+    /* strlen() is vectorized by libc, let the bounded validator go fast */
+    p = fast_validate_len(str, strlen(str), nr_chars);
 
     if (end)
         *end = p;
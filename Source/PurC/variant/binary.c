@@ -0,0 +1,952 @@
+/*
+ * @file binary.c
+ * @date 2026/10/17
+ * @brief The compact binary encoding of variants.
+ *
+ * Copyright (C) 2026 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The layout of an encoded variant:
+ *
+ *  header      := 'P' 'C' 'V' 'B' <version:u8>
+ *  value       := <tag:u8> <payload>
+ *
+ * The payload by tag:
+ *
+ *  UNDEFINED, NULL, FALSE, TRUE:   empty
+ *  EXCEPTION, ATOMSTRING, STRING:  str
+ *  NUMBER:         <double:le64>
+ *  LONGINT:        <zigzag:varint>
+ *  ULONGINT:       <varint>
+ *  LONGDOUBLE:     <double:le64> <size:u8> <native bytes of long double>
+ *  BSEQUENCE:      <length:varint> <bytes>
+ *  OBJECT:         <count:varint> (str value)*
+ *  ARRAY, TUPLE:   <count:varint> value*
+ *  SET:            <flags:u8> [str] <count:varint> value*
+ *
+ *  str         := <length:varint> <bytes in UTF-8> '\0'
+ *
+ * Varints are unsigned LEB128. The strings keep their terminating null
+ * byte, so that a buffer which outlives the loaded variants (e.g. a mapped
+ * cache file) can back the strings without copying them. The decoder
+ * uses the double if the size of long double does not match its own.
+ * Dynamic and native values are written as null, like the JSON serializer
+ * does by default.
+ */
+
+#include "config.h"
+
+#include "purc-variant.h"
+#include "purc-rwstream.h"
+#include "private/variant.h"
+#include "private/atom-buckets.h"
+#include "private/errors.h"
+#include "private/debug.h"
+#include "variant-internals.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BINARY_MAGIC            "PCVB"
+#define LEN_BINARY_MAGIC        4
+#define BINARY_MAX_DEPTH        512
+#define SZ_WRITE_BUFF           4096
+#define MAX_LEN_VARINT          10
+
+enum {
+    TAG_UNDEFINED = 0,
+    TAG_NULL,
+    TAG_FALSE,
+    TAG_TRUE,
+    TAG_EXCEPTION,
+    TAG_NUMBER,
+    TAG_LONGINT,
+    TAG_ULONGINT,
+    TAG_LONGDOUBLE,
+    TAG_ATOMSTRING,
+    TAG_STRING,
+    TAG_BSEQUENCE,
+    TAG_OBJECT,
+    TAG_ARRAY,
+    TAG_SET,
+    TAG_TUPLE,
+};
+
+#define SET_FLAG_CASELESS       0x01
+#define SET_FLAG_UNIQUE_KEY     0x02
+
+struct writer {
+    purc_rwstream_t     rws;
+    size_t              nr_written;
+    size_t              len;
+    uint8_t             buf[SZ_WRITE_BUFF];
+};
+
+static int
+writer_flush(struct writer *w)
+{
+    if (w->len == 0)
+        return 0;
+
+    if (purc_rwstream_write(w->rws, w->buf, w->len) != (ssize_t)w->len) {
+        pcinst_set_error(PURC_ERROR_OUTPUT);
+        return -1;
+    }
+
+    w->nr_written += w->len;
+    w->len = 0;
+    return 0;
+}
+
+static int
+write_bytes(struct writer *w, const void *bytes, size_t n)
+{
+    if (w->len + n <= sizeof(w->buf)) {
+        memcpy(w->buf + w->len, bytes, n);
+        w->len += n;
+        return 0;
+    }
+
+    if (writer_flush(w))
+        return -1;
+
+    if (n <= sizeof(w->buf)) {
+        memcpy(w->buf, bytes, n);
+        w->len = n;
+        return 0;
+    }
+
+    // large payloads go to the stream directly
+    if (purc_rwstream_write(w->rws, bytes, n) != (ssize_t)n) {
+        pcinst_set_error(PURC_ERROR_OUTPUT);
+        return -1;
+    }
+
+    w->nr_written += n;
+    return 0;
+}
+
+static inline int
+write_u8(struct writer *w, uint8_t u)
+{
+    return write_bytes(w, &u, 1);
+}
+
+static int
+write_varint(struct writer *w, uint64_t u)
+{
+    uint8_t buf[MAX_LEN_VARINT];
+    size_t n = 0;
+
+    while (u >= 0x80) {
+        buf[n++] = (uint8_t)(u | 0x80);
+        u >>= 7;
+    }
+    buf[n++] = (uint8_t)u;
+
+    return write_bytes(w, buf, n);
+}
+
+static int
+write_double(struct writer *w, double d)
+{
+    uint64_t u;
+    uint8_t buf[8];
+
+    memcpy(&u, &d, sizeof(u));
+    for (int i = 0; i < 8; i++) {
+        buf[i] = (uint8_t)u;
+        u >>= 8;
+    }
+
+    return write_bytes(w, buf, sizeof(buf));
+}
+
+static int
+write_str(struct writer *w, const char *str, size_t len)
+{
+    if (write_varint(w, len) || write_bytes(w, str, len))
+        return -1;
+
+    return write_u8(w, 0);
+}
+
+static int
+write_value(struct writer *w, purc_variant_t v, int depth);
+
+static int
+write_members(struct writer *w, purc_variant_t *members, size_t nr,
+        int depth)
+{
+    if (write_varint(w, nr))
+        return -1;
+
+    for (size_t i = 0; i < nr; i++) {
+        if (write_value(w, members[i], depth))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int
+write_object(struct writer *w, purc_variant_t obj, int depth)
+{
+    if (write_varint(w, purc_variant_object_get_size(obj)))
+        return -1;
+
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(obj, k, v) {
+        size_t len;
+        const char *key = purc_variant_get_string_const_ex(k, &len);
+        if (write_str(w, key, len) || write_value(w, v, depth))
+            return -1;
+    } end_foreach;
+
+    return 0;
+}
+
+static int
+write_set(struct writer *w, purc_variant_t set, int depth)
+{
+    variant_set_t data = pcvar_set_get_data(set);
+    uint8_t flags = 0;
+
+    if (data->caseless)
+        flags |= SET_FLAG_CASELESS;
+    if (data->unique_key)
+        flags |= SET_FLAG_UNIQUE_KEY;
+
+    if (write_u8(w, flags))
+        return -1;
+
+    /* `unique_key` was split in place into `keynames`; write the names
+     * joined by spaces so that the reader gets all of them back. */
+    if (data->unique_key) {
+        size_t len = data->nr_keynames - 1;
+        for (size_t i = 0; i < data->nr_keynames; i++)
+            len += strlen(data->keynames[i]);
+
+        if (write_varint(w, len))
+            return -1;
+
+        for (size_t i = 0; i < data->nr_keynames; i++) {
+            if (i && write_bytes(w, " ", 1))
+                return -1;
+            if (write_bytes(w, data->keynames[i], strlen(data->keynames[i])))
+                return -1;
+        }
+
+        if (write_u8(w, 0))
+            return -1;
+    }
+
+    if (write_varint(w, purc_variant_set_get_size(set)))
+        return -1;
+
+    purc_variant_t v;
+    foreach_value_in_variant_set(set, v) {
+        if (write_value(w, v, depth))
+            return -1;
+    } end_foreach;
+
+    return 0;
+}
+
+static int
+write_value(struct writer *w, purc_variant_t v, int depth)
+{
+    if (++depth > BINARY_MAX_DEPTH) {
+        pcinst_set_error(PURC_ERROR_TOO_LARGE_ENTITY);
+        return -1;
+    }
+
+    const char *str;
+    size_t len;
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_UNDEFINED:
+        return write_u8(w, TAG_UNDEFINED);
+
+    case PURC_VARIANT_TYPE_NULL:
+    case PURC_VARIANT_TYPE_DYNAMIC:
+    case PURC_VARIANT_TYPE_NATIVE:
+        return write_u8(w, TAG_NULL);
+
+    case PURC_VARIANT_TYPE_BOOLEAN:
+        return write_u8(w, v->b ? TAG_TRUE : TAG_FALSE);
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        str = purc_variant_get_exception_string_const(v);
+        if (write_u8(w, TAG_EXCEPTION))
+            return -1;
+        return write_str(w, str, strlen(str));
+
+    case PURC_VARIANT_TYPE_NUMBER:
+        if (write_u8(w, TAG_NUMBER))
+            return -1;
+        return write_double(w, v->d);
+
+    case PURC_VARIANT_TYPE_LONGINT:
+        if (write_u8(w, TAG_LONGINT))
+            return -1;
+        // zigzag: small negative numbers take few bytes too
+        return write_varint(w,
+                ((uint64_t)v->i64 << 1) ^ (uint64_t)(v->i64 >> 63));
+
+    case PURC_VARIANT_TYPE_ULONGINT:
+        if (write_u8(w, TAG_ULONGINT))
+            return -1;
+        return write_varint(w, v->u64);
+
+    case PURC_VARIANT_TYPE_LONGDOUBLE:
+        if (write_u8(w, TAG_LONGDOUBLE) || write_double(w, (double)v->ld) ||
+                write_u8(w, (uint8_t)sizeof(long double)))
+            return -1;
+        return write_bytes(w, &v->ld, sizeof(long double));
+
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        str = purc_variant_get_atom_string_const(v);
+        if (write_u8(w, TAG_ATOMSTRING))
+            return -1;
+        return write_str(w, str, strlen(str));
+
+    case PURC_VARIANT_TYPE_STRING:
+        str = purc_variant_get_string_const_ex(v, &len);
+        if (write_u8(w, TAG_STRING))
+            return -1;
+        return write_str(w, str, len);
+
+    case PURC_VARIANT_TYPE_BSEQUENCE:
+        {
+            const unsigned char *bytes;
+            bytes = purc_variant_get_bytes_const(v, &len);
+            if (write_u8(w, TAG_BSEQUENCE) || write_varint(w, len))
+                return -1;
+            return write_bytes(w, bytes, len);
+        }
+
+    case PURC_VARIANT_TYPE_OBJECT:
+        if (write_u8(w, TAG_OBJECT))
+            return -1;
+        return write_object(w, v, depth);
+
+    case PURC_VARIANT_TYPE_ARRAY:
+        {
+            purc_variant_t *members = array_members(v, &len);
+            if (write_u8(w, TAG_ARRAY))
+                return -1;
+            return write_members(w, members, len, depth);
+        }
+
+    case PURC_VARIANT_TYPE_SET:
+        if (write_u8(w, TAG_SET))
+            return -1;
+        return write_set(w, v, depth);
+
+    case PURC_VARIANT_TYPE_TUPLE:
+        {
+            purc_variant_t *members = tuple_members(v, &len);
+            if (write_u8(w, TAG_TUPLE))
+                return -1;
+            return write_members(w, members, len, depth);
+        }
+
+    default:
+        PC_ASSERT(0);
+        break;
+    }
+
+    pcinst_set_error(PURC_ERROR_NOT_SUPPORTED);
+    return -1;
+}
+
+ssize_t
+pcvariant_serialize_binary(purc_variant_t value, purc_rwstream_t out)
+{
+    if (value == PURC_VARIANT_INVALID || out == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return -1;
+    }
+
+    struct writer *w = (struct writer *)malloc(sizeof(*w));
+    if (w == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    w->rws = out;
+    w->nr_written = 0;
+    w->len = 0;
+
+    ssize_t ret = -1;
+    if (write_bytes(w, BINARY_MAGIC, LEN_BINARY_MAGIC) == 0 &&
+            write_u8(w, PCVRNT_BINARY_VERSION) == 0 &&
+            write_value(w, value, 0) == 0 &&
+            writer_flush(w) == 0)
+        ret = (ssize_t)w->nr_written;
+
+    free(w);
+    return ret;
+}
+
+/* Reads either from a buffer in memory or from a stream; the stream is
+ * read exactly up to the end of the value, so that several values can be
+ * stored back to back. */
+struct reader {
+    const uint8_t      *p;
+    const uint8_t      *end;
+    purc_rwstream_t     rws;
+
+    // make the strings and byte sequences refer to the buffer
+    bool                static_strings;
+};
+
+static int
+read_bytes(struct reader *r, void *buf, size_t n)
+{
+    if (r->rws) {
+        if (purc_rwstream_read(r->rws, buf, n) != (ssize_t)n)
+            goto incomplete;
+        return 0;
+    }
+
+    if ((size_t)(r->end - r->p) < n)
+        goto incomplete;
+
+    memcpy(buf, r->p, n);
+    r->p += n;
+    return 0;
+
+incomplete:
+    pcinst_set_error(PURC_ERROR_INCOMPLETE_OBJECT);
+    return -1;
+}
+
+static inline int
+read_u8(struct reader *r, uint8_t *u)
+{
+    if (r->rws == NULL && r->p < r->end) {
+        *u = *r->p++;
+        return 0;
+    }
+
+    return read_bytes(r, u, 1);
+}
+
+static int
+read_varint(struct reader *r, uint64_t *u)
+{
+    uint64_t v = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+        uint8_t b;
+        if (read_u8(r, &b))
+            return -1;
+
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            *u = v;
+            return 0;
+        }
+    }
+
+    pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+    return -1;
+}
+
+static int
+read_double(struct reader *r, double *d)
+{
+    uint8_t buf[8];
+    if (read_bytes(r, buf, sizeof(buf)))
+        return -1;
+
+    uint64_t u = 0;
+    for (int i = 7; i >= 0; i--)
+        u = (u << 8) | buf[i];
+
+    memcpy(d, &u, sizeof(*d));
+    return 0;
+}
+
+/* checks a length against the bytes left in a buffer, so that a bad length
+ * fails before any allocation */
+static int
+check_length(struct reader *r, uint64_t len)
+{
+    if (len >= SIZE_MAX ||
+            (r->rws == NULL && len > (uint64_t)(r->end - r->p))) {
+        pcinst_set_error(PURC_ERROR_INCOMPLETE_OBJECT);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* reads a str; the returned buffer is either in the input buffer, or
+ * allocated if `*buf` is set, and it is always null-terminated. A str
+ * with an embedded null character is rejected, since it would be
+ * truncated by the string constructors. */
+static const char *
+read_str(struct reader *r, size_t *len, char **buf)
+{
+    uint64_t n;
+    *buf = NULL;
+    if (read_varint(r, &n) || check_length(r, n) || check_length(r, n + 1))
+        return NULL;
+
+    if (r->rws == NULL) {
+        const char *str = (const char *)r->p;
+        if (str[n] != '\0' || memchr(str, '\0', n)) {
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+            return NULL;
+        }
+
+        r->p += n + 1;
+        *len = (size_t)n;
+        return str;
+    }
+
+    *buf = (char *)malloc(n + 1);
+    if (*buf == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
+    }
+
+    if (read_bytes(r, *buf, n + 1))
+        goto failed;
+
+    if ((*buf)[n] != '\0' || memchr(*buf, '\0', n)) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        goto failed;
+    }
+
+    *len = (size_t)n;
+    return *buf;
+
+failed:
+    free(*buf);
+    *buf = NULL;
+    return NULL;
+}
+
+static purc_variant_t
+read_string(struct reader *r)
+{
+    size_t len;
+    char *buf;
+    const char *str = read_str(r, &len, &buf);
+    if (str == NULL)
+        return PURC_VARIANT_INVALID;
+
+    if (buf)
+        return purc_variant_make_string_reuse_buff(buf, len + 1, true);
+
+    if (r->static_strings)
+        return purc_variant_make_string_static(str, true);
+
+    return purc_variant_make_string_ex(str, len, true);
+}
+
+static purc_variant_t
+read_bsequence(struct reader *r)
+{
+    uint64_t n;
+    if (read_varint(r, &n) || check_length(r, n))
+        return PURC_VARIANT_INVALID;
+
+    if (n == 0)
+        return purc_variant_make_byte_sequence_empty();
+
+    if (r->rws == NULL) {
+        const uint8_t *bytes = r->p;
+        r->p += n;
+        if (r->static_strings)
+            return purc_variant_make_byte_sequence_static(bytes, n);
+        return purc_variant_make_byte_sequence(bytes, n);
+    }
+
+    void *buf = malloc(n);
+    if (buf == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (read_bytes(r, buf, n)) {
+        free(buf);
+        return PURC_VARIANT_INVALID;
+    }
+
+    purc_variant_t v = purc_variant_make_byte_sequence_reuse_buff(buf, n, n);
+    if (v == PURC_VARIANT_INVALID)
+        free(buf);
+    return v;
+}
+
+static purc_variant_t
+read_named(struct reader *r, uint8_t tag)
+{
+    size_t len;
+    char *buf;
+    const char *str = read_str(r, &len, &buf);
+    if (str == NULL)
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t v = PURC_VARIANT_INVALID;
+    if (tag == TAG_ATOMSTRING) {
+        v = purc_variant_make_atom_string(str, true);
+    }
+    else {
+        purc_atom_t atom;
+        atom = purc_atom_try_string_ex(ATOM_BUCKET_EXCEPT, str);
+        if (atom)
+            v = purc_variant_make_exception(atom);
+        else
+            pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+    }
+
+    free(buf);
+    return v;
+}
+
+static purc_variant_t
+read_longdouble(struct reader *r)
+{
+    double d;
+    uint8_t size;
+    if (read_double(r, &d) || read_u8(r, &size) || check_length(r, size))
+        return PURC_VARIANT_INVALID;
+
+    uint8_t raw[256];
+    if (read_bytes(r, raw, size))
+        return PURC_VARIANT_INVALID;
+
+    long double ld;
+    if (size == sizeof(ld))
+        memcpy(&ld, raw, sizeof(ld));
+    else
+        ld = d;
+
+    return purc_variant_make_longdouble(ld);
+}
+
+static purc_variant_t
+read_value(struct reader *r, int depth);
+
+/* every member takes one byte at least */
+static int
+read_count(struct reader *r, size_t *count)
+{
+    uint64_t n;
+    if (read_varint(r, &n) || check_length(r, n))
+        return -1;
+
+    *count = (size_t)n;
+    return 0;
+}
+
+static purc_variant_t
+read_array(struct reader *r, int depth)
+{
+    size_t nr;
+    if (read_count(r, &nr))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t arr = pcvar_make_arr();
+    if (arr == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = read_value(r, depth);
+        if (v == PURC_VARIANT_INVALID)
+            goto failed;
+
+        int ret = pcvar_arr_append(arr, v);
+        purc_variant_unref(v);
+        if (ret)
+            goto failed;
+    }
+
+    return arr;
+
+failed:
+    purc_variant_unref(arr);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+read_tuple(struct reader *r, int depth)
+{
+    size_t nr;
+    if (read_count(r, &nr))
+        return PURC_VARIANT_INVALID;
+
+    // the count read from a stream is not trusted to allocate up front
+    purc_variant_t *members = NULL;
+    purc_variant_t tuple = PURC_VARIANT_INVALID;
+    size_t sz = 0, i;
+    for (i = 0; i < nr; i++) {
+        if (i == sz) {
+            sz = sz ? sz * 2 : 8;
+            purc_variant_t *tmp = realloc(members, sz * sizeof(*members));
+            if (tmp == NULL) {
+                pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+                goto done;
+            }
+            members = tmp;
+        }
+
+        members[i] = read_value(r, depth);
+        if (members[i] == PURC_VARIANT_INVALID)
+            goto done;
+    }
+
+    tuple = purc_variant_make_tuple(nr, members);
+
+done:
+    for (size_t n = 0; n < i; n++)
+        purc_variant_unref(members[n]);
+    free(members);
+    return tuple;
+}
+
+static purc_variant_t
+read_object(struct reader *r, int depth)
+{
+    size_t nr;
+    if (read_count(r, &nr))
+        return PURC_VARIANT_INVALID;
+
+    purc_variant_t obj = pcvar_make_obj();
+    if (obj == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t k = read_string(r);
+        if (k == PURC_VARIANT_INVALID)
+            goto failed;
+
+        purc_variant_t v = read_value(r, depth);
+        if (v == PURC_VARIANT_INVALID) {
+            purc_variant_unref(k);
+            goto failed;
+        }
+
+        int ret = pcvar_obj_set(obj, k, v);
+        purc_variant_unref(k);
+        purc_variant_unref(v);
+        if (ret)
+            goto failed;
+    }
+
+    return obj;
+
+failed:
+    purc_variant_unref(obj);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+read_set(struct reader *r, int depth)
+{
+    uint8_t flags;
+    if (read_u8(r, &flags))
+        return PURC_VARIANT_INVALID;
+
+    const char *unique_key = NULL;
+    char *buf = NULL;
+    if (flags & SET_FLAG_UNIQUE_KEY) {
+        size_t len;
+        unique_key = read_str(r, &len, &buf);
+        if (unique_key == NULL)
+            return PURC_VARIANT_INVALID;
+    }
+
+    purc_variant_t set = PURC_VARIANT_INVALID;
+    size_t nr;
+    if (read_count(r, &nr))
+        goto failed;
+
+    set = purc_variant_make_set_by_ckey_ex(0, unique_key,
+            (flags & SET_FLAG_CASELESS) ? true : false, PURC_VARIANT_INVALID);
+    if (set == PURC_VARIANT_INVALID)
+        goto failed;
+
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t v = read_value(r, depth);
+        if (v == PURC_VARIANT_INVALID)
+            goto failed;
+
+        ssize_t ret = purc_variant_set_add(set, v, PCVRNT_CR_METHOD_OVERWRITE);
+        purc_variant_unref(v);
+        if (ret < 0)
+            goto failed;
+    }
+
+    free(buf);
+    return set;
+
+failed:
+    free(buf);
+    PURC_VARIANT_SAFE_CLEAR(set);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+read_value(struct reader *r, int depth)
+{
+    if (++depth > BINARY_MAX_DEPTH) {
+        pcinst_set_error(PURC_ERROR_TOO_LARGE_ENTITY);
+        return PURC_VARIANT_INVALID;
+    }
+
+    uint8_t tag;
+    if (read_u8(r, &tag))
+        return PURC_VARIANT_INVALID;
+
+    switch (tag) {
+    case TAG_UNDEFINED:
+        return purc_variant_make_undefined();
+
+    case TAG_NULL:
+        return purc_variant_make_null();
+
+    case TAG_FALSE:
+    case TAG_TRUE:
+        return purc_variant_make_boolean(tag == TAG_TRUE);
+
+    case TAG_EXCEPTION:
+    case TAG_ATOMSTRING:
+        return read_named(r, tag);
+
+    case TAG_NUMBER:
+        {
+            double d;
+            if (read_double(r, &d))
+                return PURC_VARIANT_INVALID;
+            return purc_variant_make_number(d);
+        }
+
+    case TAG_LONGINT:
+        {
+            uint64_t u;
+            if (read_varint(r, &u))
+                return PURC_VARIANT_INVALID;
+            return purc_variant_make_longint((int64_t)(u >> 1) ^ -(int64_t)(u & 1));
+        }
+
+    case TAG_ULONGINT:
+        {
+            uint64_t u;
+            if (read_varint(r, &u))
+                return PURC_VARIANT_INVALID;
+            return purc_variant_make_ulongint(u);
+        }
+
+    case TAG_LONGDOUBLE:
+        return read_longdouble(r);
+
+    case TAG_STRING:
+        return read_string(r);
+
+    case TAG_BSEQUENCE:
+        return read_bsequence(r);
+
+    case TAG_OBJECT:
+        return read_object(r, depth);
+
+    case TAG_ARRAY:
+        return read_array(r, depth);
+
+    case TAG_SET:
+        return read_set(r, depth);
+
+    case TAG_TUPLE:
+        return read_tuple(r, depth);
+
+    default:
+        break;
+    }
+
+    pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+read_binary(struct reader *r)
+{
+    uint8_t header[LEN_BINARY_MAGIC + 1];
+    if (read_bytes(r, header, sizeof(header)))
+        return PURC_VARIANT_INVALID;
+
+    if (memcmp(header, BINARY_MAGIC, LEN_BINARY_MAGIC)) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    if (header[LEN_BINARY_MAGIC] == 0 ||
+            header[LEN_BINARY_MAGIC] > PCVRNT_BINARY_VERSION) {
+        pcinst_set_error(PURC_ERROR_MISMATCHED_VERSION);
+        return PURC_VARIANT_INVALID;
+    }
+
+    return read_value(r, 0);
+}
+
+purc_variant_t
+pcvariant_load_from_binary(const void *buf, size_t sz, bool static_strings,
+        size_t *consumed)
+{
+    if (buf == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct reader r = {
+        .p              = (const uint8_t *)buf,
+        .end            = (const uint8_t *)buf + sz,
+        .rws            = NULL,
+        .static_strings = static_strings,
+    };
+
+    purc_variant_t v = read_binary(&r);
+    if (v != PURC_VARIANT_INVALID && consumed)
+        *consumed = r.p - (const uint8_t *)buf;
+
+    return v;
+}
+
+purc_variant_t
+pcvariant_load_from_binary_stream(purc_rwstream_t in)
+{
+    if (in == NULL) {
+        pcinst_set_error(PURC_ERROR_INVALID_VALUE);
+        return PURC_VARIANT_INVALID;
+    }
+
+    struct reader r = {
+        .p              = NULL,
+        .end            = NULL,
+        .rws            = in,
+        .static_strings = false,
+    };
+
+    return read_binary(&r);
+}
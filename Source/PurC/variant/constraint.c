@@ -543,6 +543,10 @@ wind_up(struct reverse_checker *checker)
 void
 pcvar_adjust_set_by_descendant(purc_variant_t val)
 {
+    // nothing to adjust, and no maps to build, if no set holds `val`
+    if (!pcvar_container_belongs_to_set(val))
+        return;
+
     copy_key_fn copy_key = ref;
     free_key_fn free_key = unref;
     copy_val_fn copy_val = ref;
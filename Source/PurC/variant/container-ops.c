@@ -196,13 +196,17 @@ pcvariant_object_clear(purc_variant_t object, bool silently)
     purc_variant_t key;
     purc_variant_t value;
     UNUSED_VARIABLE(value);
+    pcvariant_begin_batch(object);
     foreach_in_variant_object_safe_x(object, key, value)
         if (!purc_variant_object_remove(object, key, silently)) {
-            goto end;
+            goto done;
         }
     end_foreach;
     ret = true;
 
+done:
+    pcvariant_end_batch(object);
+
 end:
     return ret;
 }
@@ -224,14 +228,18 @@ pcvariant_array_clear(purc_variant_t array, bool silently)
     purc_variant_t val;
     size_t curr;
     UNUSED_VARIABLE(val);
+    pcvariant_begin_batch(array);
     foreach_value_in_variant_array_safe(array, val, curr)
         if (!purc_variant_array_remove(array, curr)) {
-            goto end;
+            goto done;
         }
         --curr;
     end_foreach;
     ret = true;
 
+done:
+    pcvariant_end_batch(array);
+
 end:
     return ret;
 }
@@ -251,13 +259,17 @@ pcvariant_set_clear(purc_variant_t set, bool silently)
     }
 
     purc_variant_t v;
+    pcvariant_begin_batch(set);
     foreach_value_in_variant_set_safe(set, v)
         if (-1 == purc_variant_set_remove(set, v, PCVRNT_NR_METHOD_IGNORE)) {
-            goto end;
+            goto done;
         }
     end_foreach;
     ret = true;
 
+done:
+    pcvariant_end_batch(set);
+
 end:
     return ret;
 }
@@ -630,6 +642,7 @@ pcvariant_container_displace(purc_variant_t dst,
     }
 
     enum purc_variant_type type = purc_variant_get_type(dst);
+    pcvariant_begin_batch(dst);
     switch (type) {
         case PURC_VARIANT_TYPE_OBJECT:
             ret = object_displace(dst, src, silently);
@@ -647,6 +660,7 @@ pcvariant_container_displace(purc_variant_t dst,
             SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
             break;
     }
+    pcvariant_end_batch(dst);
 
 end:
     return ret;
@@ -669,6 +683,7 @@ pcvariant_container_remove(purc_variant_t dst,
     }
 
     enum purc_variant_type type = purc_variant_get_type(dst);
+    pcvariant_begin_batch(dst);
     switch (type) {
         case PURC_VARIANT_TYPE_OBJECT:
             ret = object_remove(dst, src, silently);
@@ -686,6 +701,7 @@ pcvariant_container_remove(purc_variant_t dst,
             SET_SILENT_ERROR(PURC_ERROR_WRONG_DATA_TYPE);
             break;
     }
+    pcvariant_end_batch(dst);
 
 end:
     return ret;
@@ -712,10 +728,9 @@ pcvariant_array_append_another(purc_variant_t array,
         goto end;
     }
 
-    if(!array_foreach(another, append_array_member, array, silently)) {
-        goto end;
-    }
-    ret = true;
+    pcvariant_begin_batch(array);
+    ret = array_foreach(another, append_array_member, array, silently);
+    pcvariant_end_batch(array);
 
 end:
     return ret;
@@ -742,10 +757,10 @@ pcvariant_array_prepend_another(purc_variant_t array,
         goto end;
     }
 
-    if(!array_reverse_foreach(another, prepend_array_member, array, silently)) {
-        goto end;
-    }
-    ret = true;
+    pcvariant_begin_batch(array);
+    ret = array_reverse_foreach(another, prepend_array_member, array,
+            silently);
+    pcvariant_end_batch(array);
 
 end:
     return ret;
@@ -776,8 +791,10 @@ pcvariant_array_insert_another_before(purc_variant_t array, int idx,
     struct complex_ctxt c_ctxt;
     c_ctxt.ctxt = (uintptr_t) array;
     c_ctxt.extra = idx;
+    pcvariant_begin_batch(array);
     ret = array_reverse_foreach(another, insert_before_array_member, &c_ctxt,
             silently);
+    pcvariant_end_batch(array);
 end:
     return ret;
 }
@@ -807,8 +824,10 @@ pcvariant_array_insert_another_after(purc_variant_t array, int idx,
     struct complex_ctxt c_ctxt;
     c_ctxt.ctxt = (uintptr_t) array;
     c_ctxt.extra = idx;
+    pcvariant_begin_batch(array);
     ret = array_reverse_foreach(another, insert_after_array_member, &c_ctxt,
             silently);
+    pcvariant_end_batch(array);
 
 end:
     return ret;
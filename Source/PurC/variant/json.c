@@ -0,0 +1,568 @@
+/*
+ * @file json.c
+ * @date 2026/10/17
+ * @brief The fast path to make variants from strict JSON text.
+ *
+ * Copyright (C) 2021 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "purc-variant.h"
+#include "purc-utils.h"
+#include "private/variant.h"
+#include "private/ejson.h"
+#include "private/errors.h"
+#include "private/debug.h"
+
+#include "variant-internals.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/*
+ * This parser only accepts strict JSON (RFC 8259) and builds the variants
+ * directly. It gives up silently on anything else, including the eJSON
+ * extensions (`$` in strings, number suffixes, single quotes, comments,
+ * ...) and the errors, and the caller falls back to the eJSON parser which
+ * handles the extensions and reports the errors.
+ *
+ * The text is either in memory, or read from a stream through a window of
+ * fixed size; the strings longer than the window go to the scratch buffer.
+ */
+
+#define MAX_NUMBER_LEN          64
+#define SZ_STREAM_WINDOW        4096
+
+struct json_reader {
+    const char *p;
+    const char *end;
+    unsigned    depth;
+
+    /* the scratch buffer for strings containing escapes */
+    char       *buf;
+    size_t      sz_buf;
+
+    /* the stream and the window over it; NULL for the text in memory */
+    purc_rwstream_t stream;
+    char       *window;
+    size_t      sz_window;
+};
+
+static purc_variant_t
+parse_value(struct json_reader *reader);
+
+/*
+ * Moves the bytes left to the start of the window and reads more from the
+ * stream. Returns whether there are at least @n bytes to read now.
+ */
+static bool
+fill_window(struct json_reader *reader, size_t n)
+{
+    size_t left = reader->end - reader->p;
+    if (left >= n || reader->stream == NULL)
+        return left >= n;
+
+    memmove(reader->window, reader->p, left);
+    while (left < reader->sz_window) {
+        ssize_t nr_read = purc_rwstream_read(reader->stream,
+                reader->window + left, reader->sz_window - left);
+        if (nr_read <= 0) {
+            /* no more to read */
+            reader->stream = NULL;
+            break;
+        }
+        left += nr_read;
+    }
+
+    reader->p = reader->window;
+    reader->end = reader->window + left;
+    return left >= n;
+}
+
+static inline void
+skip_ws(struct json_reader *reader)
+{
+    do {
+        const char *p = reader->p;
+        while (p < reader->end &&
+                (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t'))
+            p++;
+        reader->p = p;
+    } while (reader->p == reader->end && fill_window(reader, 1));
+}
+
+#define ONES                    0x0101010101010101ULL
+#define HIGHS                   0x8080808080808080ULL
+#define HAS_ZERO(x)             (((x) - ONES) & ~(x) & HIGHS)
+#define HAS_BYTE(x, c)          HAS_ZERO((x) ^ (ONES * (uint8_t)(c)))
+#define HAS_LESS(x, n)          (((x) - ONES * (n)) & ~(x) & HIGHS)
+
+/*
+ * Returns the first byte from @p which ends the plain run of a string:
+ * a quote, a backslash, a dollar or a control character. Eight bytes are
+ * tested at once.
+ */
+static const char *
+scan_string_run(const char *p, const char *end)
+{
+    while (end - p >= 8) {
+        uint64_t w;
+        memcpy(&w, p, sizeof(w));
+        if (HAS_BYTE(w, '"') | HAS_BYTE(w, '\\') | HAS_BYTE(w, '$') |
+                HAS_LESS(w, 0x20))
+            break;
+        p += 8;
+    }
+
+    while (p < end) {
+        unsigned char c = (unsigned char)*p;
+        if (c == '"' || c == '\\' || c == '$' || c < 0x20)
+            break;
+        p++;
+    }
+
+    return p;
+}
+
+static bool
+buf_append(struct json_reader *reader, size_t *len,
+        const char *bytes, size_t n)
+{
+    if (*len + n + 1 > reader->sz_buf) {
+        size_t sz = reader->sz_buf ? reader->sz_buf : 64;
+        while (sz < *len + n + 1)
+            sz *= 2;
+
+        char *buf = realloc(reader->buf, sz);
+        if (buf == NULL) {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            return false;
+        }
+        reader->buf = buf;
+        reader->sz_buf = sz;
+    }
+
+    memcpy(reader->buf + *len, bytes, n);
+    *len += n;
+    return true;
+}
+
+static int
+hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static bool
+append_escape(struct json_reader *reader, size_t *len)
+{
+    const char *p = reader->p;      /* after the backslash */
+    char c;
+
+    if (p >= reader->end)
+        return false;
+
+    switch (*p) {
+    case '"':
+    case '\\':
+    case '/':
+        c = *p;
+        break;
+    case 'b':
+        c = '\b';
+        break;
+    case 'f':
+        c = '\f';
+        break;
+    case 'n':
+        c = '\n';
+        break;
+    case 'r':
+        c = '\r';
+        break;
+    case 't':
+        c = '\t';
+        break;
+
+    case 'u': {
+        if (reader->end - p < 5)
+            return false;
+
+        uint32_t uc = 0;
+        for (int i = 1; i <= 4; i++) {
+            int v = hex_value(p[i]);
+            if (v < 0)
+                return false;
+            uc = (uc << 4) | v;
+        }
+
+        /* the eJSON parser rejects surrogates and a null character would
+           truncate the string; leave both to it */
+        if (uc == 0 || (uc & 0xFFFFF800) == 0xD800)
+            return false;
+
+        char utf8[4];
+        size_t n;
+        if (uc < 0x80) {
+            utf8[0] = (char)uc;
+            n = 1;
+        }
+        else if (uc < 0x800) {
+            utf8[0] = (char)(0xC0 | (uc >> 6));
+            utf8[1] = (char)(0x80 | (uc & 0x3F));
+            n = 2;
+        }
+        else {
+            utf8[0] = (char)(0xE0 | (uc >> 12));
+            utf8[1] = (char)(0x80 | ((uc >> 6) & 0x3F));
+            utf8[2] = (char)(0x80 | (uc & 0x3F));
+            n = 3;
+        }
+
+        reader->p = p + 5;
+        return buf_append(reader, len, utf8, n);
+    }
+
+    default:
+        return false;
+    }
+
+    reader->p = p + 1;
+    return buf_append(reader, len, &c, 1);
+}
+
+static purc_variant_t
+parse_string(struct json_reader *reader)
+{
+    const char *run = ++reader->p;      /* skip the opening quote */
+    const char *p = scan_string_run(run, reader->end);
+    size_t len = 0;
+    bool copied = false;
+
+    while (p >= reader->end || *p == '\\') {
+        /* the run is copied before the window moves */
+        if (!buf_append(reader, &len, run, p - run))
+            return PURC_VARIANT_INVALID;
+        copied = true;
+
+        if (p >= reader->end) {
+            reader->p = p;
+            if (!fill_window(reader, 1))
+                return PURC_VARIANT_INVALID;
+        }
+        else {
+            /* the longest escape is \uXXXX */
+            reader->p = p + 1;
+            fill_window(reader, 5);
+            if (!append_escape(reader, &len))
+                return PURC_VARIANT_INVALID;
+        }
+
+        run = reader->p;
+        p = scan_string_run(run, reader->end);
+    }
+
+    if (*p != '"')
+        return PURC_VARIANT_INVALID;
+
+    reader->p = p + 1;
+
+    if (!copied) {
+        if (!pcutils_string_check_utf8_len(run, p - run, NULL, NULL))
+            return PURC_VARIANT_INVALID;
+        return purc_variant_make_string_ex(run, p - run, false);
+    }
+
+    if (!buf_append(reader, &len, run, p - run))
+        return PURC_VARIANT_INVALID;
+
+    if (!pcutils_string_check_utf8_len(reader->buf, len, NULL, NULL))
+        return PURC_VARIANT_INVALID;
+
+    return purc_variant_make_string_ex(reader->buf, len, false);
+}
+
+static inline bool
+is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static purc_variant_t
+parse_number(struct json_reader *reader)
+{
+    /* a number longer than this is not taken anyway */
+    fill_window(reader, MAX_NUMBER_LEN);
+
+    const char *start = reader->p;
+    const char *p = start;
+    const char *end = reader->end;
+
+    if (p < end && *p == '-')
+        p++;
+
+    if (p >= end || !is_digit(*p))
+        return PURC_VARIANT_INVALID;
+
+    if (*p == '0')
+        p++;
+    else {
+        while (p < end && is_digit(*p))
+            p++;
+    }
+
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !is_digit(*p))
+            return PURC_VARIANT_INVALID;
+        while (p < end && is_digit(*p))
+            p++;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        if (p < end && (*p == '+' || *p == '-'))
+            p++;
+        if (p >= end || !is_digit(*p))
+            return PURC_VARIANT_INVALID;
+        while (p < end && is_digit(*p))
+            p++;
+    }
+
+    /* number suffixes (L, UL, FL) and hexadecimals are eJSON */
+    size_t len = p - start;
+    if (len >= MAX_NUMBER_LEN || (p < end && (*p == 'L' || *p == 'U' ||
+                    *p == 'F' || *p == 'x')))
+        return PURC_VARIANT_INVALID;
+
+    char number[MAX_NUMBER_LEN];
+    memcpy(number, start, len);
+    number[len] = '\0';
+
+    reader->p = p;
+    return purc_variant_make_number(strtod(number, NULL));
+}
+
+static bool
+expect_literal(struct json_reader *reader, const char *literal, size_t len)
+{
+    if (!fill_window(reader, len) || memcmp(reader->p, literal, len))
+        return false;
+
+    reader->p += len;
+    return true;
+}
+
+static purc_variant_t
+parse_array(struct json_reader *reader)
+{
+    purc_variant_t array = purc_variant_make_array_0();
+    if (array == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    reader->p++;
+    skip_ws(reader);
+    if (reader->p < reader->end && *reader->p == ']') {
+        reader->p++;
+        return array;
+    }
+
+    while (true) {
+        purc_variant_t v = parse_value(reader);
+        if (v == PURC_VARIANT_INVALID)
+            goto failed;
+
+        bool ok = purc_variant_array_append(array, v);
+        purc_variant_unref(v);
+        if (!ok)
+            goto failed;
+
+        skip_ws(reader);
+        if (reader->p >= reader->end)
+            goto failed;
+
+        char c = *reader->p++;
+        if (c == ']')
+            break;
+        if (c != ',')
+            goto failed;
+    }
+
+    return array;
+
+failed:
+    purc_variant_unref(array);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+parse_object(struct json_reader *reader)
+{
+    purc_variant_t object = purc_variant_make_object_0();
+    if (object == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    reader->p++;
+    skip_ws(reader);
+    if (reader->p < reader->end && *reader->p == '}') {
+        reader->p++;
+        return object;
+    }
+
+    while (true) {
+        skip_ws(reader);
+        if (reader->p >= reader->end || *reader->p != '"')
+            goto failed;
+
+        purc_variant_t k = parse_string(reader);
+        if (k == PURC_VARIANT_INVALID)
+            goto failed;
+
+        skip_ws(reader);
+        if (reader->p >= reader->end || *reader->p != ':') {
+            purc_variant_unref(k);
+            goto failed;
+        }
+        reader->p++;
+
+        purc_variant_t v = parse_value(reader);
+        if (v == PURC_VARIANT_INVALID) {
+            purc_variant_unref(k);
+            goto failed;
+        }
+
+        bool ok = purc_variant_object_set(object, k, v);
+        purc_variant_unref(k);
+        purc_variant_unref(v);
+        if (!ok)
+            goto failed;
+
+        skip_ws(reader);
+        if (reader->p >= reader->end)
+            goto failed;
+
+        char c = *reader->p++;
+        if (c == '}')
+            break;
+        if (c != ',')
+            goto failed;
+    }
+
+    return object;
+
+failed:
+    purc_variant_unref(object);
+    return PURC_VARIANT_INVALID;
+}
+
+static purc_variant_t
+parse_value(struct json_reader *reader)
+{
+    purc_variant_t v = PURC_VARIANT_INVALID;
+
+    skip_ws(reader);
+    if (reader->p >= reader->end)
+        return PURC_VARIANT_INVALID;
+
+    switch (*reader->p) {
+    case '{':
+    case '[':
+        /* keep the depth limit of the eJSON parser */
+        if (++reader->depth > PCEJSON_DEFAULT_DEPTH)
+            return PURC_VARIANT_INVALID;
+        if (*reader->p == '{')
+            v = parse_object(reader);
+        else
+            v = parse_array(reader);
+        reader->depth--;
+        break;
+
+    case '"':
+        v = parse_string(reader);
+        break;
+
+    case 't':
+        if (expect_literal(reader, "true", 4))
+            v = purc_variant_make_boolean(true);
+        break;
+
+    case 'f':
+        if (expect_literal(reader, "false", 5))
+            v = purc_variant_make_boolean(false);
+        break;
+
+    case 'n':
+        if (expect_literal(reader, "null", 4))
+            v = purc_variant_make_null();
+        break;
+
+    default:
+        v = parse_number(reader);
+        break;
+    }
+
+    return v;
+}
+
+/* parses the whole text; only a terminating null character may follow the
+   value besides the white spaces */
+static purc_variant_t
+parse_text(struct json_reader *reader)
+{
+    purc_variant_t v = parse_value(reader);
+    if (v != PURC_VARIANT_INVALID) {
+        skip_ws(reader);
+        if (reader->p < reader->end && *reader->p == '\0') {
+            reader->p++;
+            fill_window(reader, 1);
+        }
+
+        if (reader->p < reader->end) {
+            purc_variant_unref(v);
+            v = PURC_VARIANT_INVALID;
+        }
+    }
+
+    free(reader->buf);
+    return v;
+}
+
+purc_variant_t
+pcvariant_make_from_strict_json(const char *json, size_t sz)
+{
+    struct json_reader reader = { json, json + sz, 0, NULL, 0,
+        NULL, NULL, 0 };
+
+    return parse_text(&reader);
+}
+
+purc_variant_t
+pcvariant_load_from_strict_json_stream(purc_rwstream_t stream)
+{
+    char window[SZ_STREAM_WINDOW];
+    struct json_reader reader = { window, window, 0, NULL, 0,
+        stream, window, sizeof(window) };
+
+    return parse_text(&reader);
+}
@@ -229,6 +229,17 @@ move_or_clone_immutable(struct pcinst *inst, purc_variant_t v)
     return retv;
 }
 
+/* Whether the container can be handed off to the move heap as is: nobody
+ * else refers to it, and it does not share its storage with a clone. */
+static inline bool
+owned_exclusively(purc_variant_t v)
+{
+    if (v->refc != 1)
+        return false;
+
+    return v->type != PURC_VARIANT_TYPE_ARRAY || !pcvariant_array_is_shared(v);
+}
+
 struct travel_context {
     struct pcinst *inst;
     struct pcutils_arrlist *vrts_to_unref;
@@ -446,21 +457,21 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
         UNUSED_PARAM(idx);
         switch (v->type) {
         case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_array(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_object(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_set(ctxt, v);
             }
@@ -471,7 +482,7 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
             break;
         }
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
+        if (IS_CONTAINER(v->type) && !owned_exclusively(v)) {
             retv = purc_variant_container_clone_recursively(v);
             if (retv == PURC_VARIANT_INVALID) {
                 purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -480,7 +491,7 @@ move_or_clone_mutable_descendants_in_array(struct travel_context *ctxt,
 
             move_keys_in_cloned_container(ctxt, retv);
 
-            _p->val = retv;
+            *_p = retv;
             pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
 
@@ -502,21 +513,21 @@ move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
 
         switch (v->type) {
         case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_array(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_object(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_set(ctxt, v);
             }
@@ -534,7 +545,7 @@ move_or_clone_mutable_descendants_in_object(struct travel_context *ctxt,
                 pcutils_arrlist_append(ctxt->vrts_to_unref, k);
             }
 
-            if (v->refc > 1) {
+            if (!owned_exclusively(v)) {
                 retv = purc_variant_container_clone_recursively(v);
                 if (retv == PURC_VARIANT_INVALID) {
                     purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -570,21 +581,21 @@ move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
 
         switch (v->type) {
         case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_array(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_object(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_set(ctxt, v);
             }
@@ -595,7 +606,7 @@ move_or_clone_mutable_descendants_in_set(struct travel_context *ctxt,
             break;
         }
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
+        if (IS_CONTAINER(v->type) && !owned_exclusively(v)) {
             retv = purc_variant_container_clone_recursively(v);
             if (retv == PURC_VARIANT_INVALID) {
                 purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -629,21 +640,21 @@ move_or_clone_mutable_descendants_in_tuple(struct travel_context *ctxt,
 
         switch (v->type) {
         case PURC_VARIANT_TYPE_ARRAY:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_array(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_OBJECT:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_object(ctxt, v);
             }
             break;
 
         case PURC_VARIANT_TYPE_SET:
-            if (v->refc == 1) {
+            if (owned_exclusively(v)) {
                 move_variant_in(ctxt->inst, v);
                 move_or_clone_mutable_descendants_in_set(ctxt, v);
             }
@@ -654,7 +665,7 @@ move_or_clone_mutable_descendants_in_tuple(struct travel_context *ctxt,
             break;
         }
 
-        if (IS_CONTAINER(v->type) && v->refc > 1) {
+        if (IS_CONTAINER(v->type) && !owned_exclusively(v)) {
             retv = purc_variant_container_clone_recursively(v);
             if (retv == PURC_VARIANT_INVALID) {
                 purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
@@ -663,6 +674,7 @@ move_or_clone_mutable_descendants_in_tuple(struct travel_context *ctxt,
 
             move_keys_in_cloned_container(ctxt, retv);
 
+            members[idx] = retv;
             pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
 
@@ -745,7 +757,7 @@ move_or_clone_immutable_descendants_in_array(struct travel_context *ctxt,
         }
 
         if (retv != v) {
-            _p->val = retv;
+            *_p = retv;
             if (!(v->flags & PCVRNT_FLAG_NOFREE))
                 pcutils_arrlist_append(ctxt->vrts_to_unref, v);
         }
@@ -946,7 +958,7 @@ purc_variant_t pcvariant_move_heap_in(purc_variant_t v)
     pcvariant_use_move_heap();
 
     if (IS_CONTAINER(v->type)) {
-        if (v->refc == 1) {
+        if (owned_exclusively(v)) {
             retv = v;
             move_variant_in(inst, v);
             move_or_clone_mutable_descendants(&ctxt, v);
@@ -1046,7 +1058,7 @@ static purc_variant_t move_array_descendants_out(purc_variant_t arr)
             break;
         }
 
-        _p->val = retv;
+        *_p = retv;
 
     } end_foreach;
 
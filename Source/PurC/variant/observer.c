@@ -37,7 +37,8 @@ register_listener(purc_variant_t v, unsigned int flags,
     listeners = &v->listeners;
 
     struct pcvar_listener *listener;
-    listener = (struct pcvar_listener*)calloc(1, sizeof(*listener));
+    listener = (struct pcvar_listener*)pcvariant_node_alloc(
+            sizeof(*listener));
     if (!listener) {
         pcinst_set_error(PCVRNT_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -101,6 +102,18 @@ purc_variant_register_post_listener(purc_variant_t v,
     return register_listener(v, PCVAR_LISTENER_POST, op, handler, ctxt);
 }
 
+struct pcvar_listener*
+pcvariant_register_coalescing_listener(purc_variant_t v,
+        pcvar_op_t op, pcvar_op_handler handler, void *ctxt)
+{
+    struct pcvar_listener *listener;
+    listener = purc_variant_register_post_listener(v, op, handler, ctxt);
+    if (listener)
+        listener->flags |= PCVAR_LISTENER_COALESCE;
+
+    return listener;
+}
+
 bool
 purc_variant_revoke_listener(purc_variant_t v,
         struct pcvar_listener *listener)
@@ -126,7 +139,7 @@ purc_variant_revoke_listener(purc_variant_t v,
             continue;
 
         list_del(p);
-        free(curr);
+        pcvariant_node_free(curr, sizeof(*curr));
         return true;
     }
 
@@ -164,6 +177,143 @@ bool pcvariant_on_pre_fired(
     return true;
 }
 
+#define MAX_BATCH_ARGS      4
+#define NR_BATCH_OPS        3   // GROW, SHRINK, and CHANGE
+
+/* The state of a batch lives in a marker listener interested in nothing,
+ * so the loops firing the operations skip it. The marker is a PRE
+ * listener: it is kept among the pre listeners at the head of the list. */
+struct pcvar_batch {
+    struct pcvar_listener   marker;
+
+    unsigned int            depth;
+    pcvar_op_t              pending;
+
+    // the arguments of the last operation fired in the batch, by type
+    size_t                  nr_args[NR_BATCH_OPS];
+    purc_variant_t          argv[NR_BATCH_OPS][MAX_BATCH_ARGS];
+};
+
+static struct pcvar_batch *
+find_batch(purc_variant_t v)
+{
+    struct pcvar_listener *p;
+    list_for_each_entry(p, &v->listeners, list_node) {
+        if ((p->flags & PCVAR_LISTENER_PRE_OR_POST) != PCVAR_LISTENER_PRE)
+            break;
+
+        if (p->flags & PCVAR_LISTENER_BATCH)
+            return container_of(p, struct pcvar_batch, marker);
+    }
+
+    return NULL;
+}
+
+static int
+batch_op_index(pcvar_op_t op)
+{
+    switch (op) {
+    case PCVAR_OPERATION_GROW:
+        return 0;
+    case PCVAR_OPERATION_SHRINK:
+        return 1;
+    case PCVAR_OPERATION_CHANGE:
+        return 2;
+    default:
+        return -1;
+    }
+}
+
+static bool
+batch_record(struct pcvar_batch *batch, pcvar_op_t op,
+        size_t nr_args, purc_variant_t *argv)
+{
+    int i = batch_op_index(op);
+    if (i < 0 || nr_args > MAX_BATCH_ARGS)
+        return false;
+
+    for (size_t j = 0; j < batch->nr_args[i]; j++)
+        PURC_VARIANT_SAFE_CLEAR(batch->argv[i][j]);
+
+    for (size_t j = 0; j < nr_args; j++) {
+        batch->argv[i][j] = argv[j];
+        if (argv[j] != PURC_VARIANT_INVALID)
+            purc_variant_ref(argv[j]);
+    }
+
+    batch->nr_args[i] = nr_args;
+    batch->pending |= op;
+    return true;
+}
+
+void
+pcvariant_begin_batch(purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID || !IS_CONTAINER(v->type) ||
+            !pcvar_is_observed(v))
+        return;
+
+    struct pcvar_batch *batch = find_batch(v);
+    if (batch == NULL) {
+        batch = (struct pcvar_batch *)calloc(1, sizeof(*batch));
+        if (batch == NULL) {
+            // not fatal: the listeners will be called per mutation
+            return;
+        }
+
+        batch->marker.flags = PCVAR_LISTENER_PRE | PCVAR_LISTENER_BATCH;
+        list_add(&batch->marker.list_node, &v->listeners);
+    }
+
+    batch->depth++;
+}
+
+void
+pcvariant_end_batch(purc_variant_t v)
+{
+    if (v == PURC_VARIANT_INVALID || !IS_CONTAINER(v->type) ||
+            !pcvar_is_observed(v))
+        return;
+
+    struct pcvar_batch *batch = find_batch(v);
+    if (batch == NULL || --batch->depth > 0)
+        return;
+
+    list_del(&batch->marker.list_node);
+
+    static const pcvar_op_t ops[NR_BATCH_OPS] = {
+        PCVAR_OPERATION_GROW,
+        PCVAR_OPERATION_SHRINK,
+        PCVAR_OPERATION_CHANGE,
+    };
+
+    for (int i = 0; i < NR_BATCH_OPS; i++) {
+        if ((batch->pending & ops[i]) == 0)
+            continue;
+
+        struct pcvar_listener *p, *n;
+        list_for_each_entry_reverse_safe(p, n, &v->listeners, list_node) {
+            if ((p->op & ops[i]) == 0)
+                continue;
+
+            if ((p->flags & PCVAR_LISTENER_PRE_OR_POST) == PCVAR_LISTENER_PRE)
+                break;
+
+            if ((p->flags & PCVAR_LISTENER_COALESCE) == 0)
+                continue;
+
+            bool ok = p->handler(v, ops[i], p->ctxt,
+                    batch->nr_args[i], batch->argv[i]);
+            PC_ASSERT(ok);
+        }
+
+        for (size_t j = 0; j < batch->nr_args[i]; j++)
+            PURC_VARIANT_SAFE_CLEAR(batch->argv[i][j]);
+    }
+
+    free(batch);
+}
+
 void pcvariant_on_post_fired(
         purc_variant_t source,  // the source variant.
         pcvar_op_t op,          // the operation identifier.
@@ -177,6 +327,11 @@ void pcvariant_on_post_fired(
     struct list_head *listeners;
     listeners = &source->listeners;
 
+    // the coalescing listeners are deferred to the end of the batch
+    struct pcvar_batch *batch = find_batch(source);
+    if (batch && !batch_record(batch, op, nr_args, argv))
+        batch = NULL;
+
     struct pcvar_listener *p, *n;
     list_for_each_entry_reverse_safe(p, n, listeners, list_node) {
         struct pcvar_listener *curr = p;
@@ -187,6 +342,9 @@ void pcvariant_on_post_fired(
         if ((curr->flags & PCVAR_LISTENER_PRE_OR_POST) == PCVAR_LISTENER_PRE)
             break;
 
+        if (batch && (curr->flags & PCVAR_LISTENER_COALESCE))
+            continue;
+
         bool ok = curr->handler(source, op, curr->ctxt, nr_args, argv);
         PC_ASSERT(ok);
     }
@@ -0,0 +1,296 @@
+/*
+ * @file sort-keys.c
+ * @date 2026/10/17
+ * @brief The implementation of sorting containers by precomputed keys.
+ *
+ * Copyright (C) 2026 FMSoft <https://www.fmsoft.cn>
+ *
+ * This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define _GNU_SOURCE
+
+#include "config.h"
+
+#include "private/variant.h"
+#include "private/errors.h"
+#include "private/utils.h"
+#include "variant-internals.h"
+#include "purc-utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+int
+pcvariant_make_sort_key(purc_variant_t v, bool by_number,
+        struct pcvrnt_sort_key *key)
+{
+    memset(key, 0, sizeof(*key));
+    if (v == PURC_VARIANT_INVALID)
+        return 0;
+
+    if (by_number) {
+        key->num = purc_variant_numerify(v);
+        return 0;
+    }
+
+    switch (v->type) {
+    case PURC_VARIANT_TYPE_STRING:
+        key->str = purc_variant_get_string_const(v);
+        break;
+
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+        key->str = purc_variant_get_atom_string_const(v);
+        break;
+
+    case PURC_VARIANT_TYPE_EXCEPTION:
+        key->str = purc_variant_get_exception_string_const(v);
+        break;
+
+    default:
+        if (purc_variant_stringify_alloc(&key->buf, v) < 0) {
+            key->buf = NULL;
+            return -1;
+        }
+        key->str = key->buf;
+        break;
+    }
+
+    return 0;
+}
+
+struct sort_item {
+    void                       *member;    // purc_variant_t or set_node
+    size_t                      idx;
+    struct pcvrnt_sort_key     *keys;
+};
+
+struct sort_user_data {
+    pcvrnt_cmp_sort_keys_f      cmp_keys;
+    void                       *ud;
+};
+
+#if OS(HURD) || OS(LINUX)
+static int cmp_items(const void *l, const void *r, void *ud)
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
+static int cmp_items(void *ud, const void *l, const void *r)
+#else
+#error Unsupported operating system.
+#endif
+{
+    const struct sort_item *il = (const struct sort_item *)l;
+    const struct sort_item *ir = (const struct sort_item *)r;
+    struct sort_user_data *d = (struct sort_user_data *)ud;
+
+    int ret = d->cmp_keys(il->keys, ir->keys, d->ud);
+    if (ret == 0) {
+        // keep the original order of the equal members
+        ret = (il->idx > ir->idx) - (il->idx < ir->idx);
+    }
+
+    return ret;
+}
+
+int
+pcvariant_sort_by_keys(purc_variant_t value, size_t nr_keys, void *ud,
+        pcvrnt_make_sort_keys_f make_keys, pcvrnt_cmp_sort_keys_f cmp_keys)
+{
+    PC_ASSERT(make_keys && cmp_keys);
+
+    purc_variant_t *members = NULL;
+    struct pcutils_array_list *al = NULL;
+    size_t nr;
+
+    if (purc_variant_is_array(value)) {
+        if (pcvariant_array_unshare(value))
+            return -1;
+        members = array_members(value, &nr);
+    }
+    else if (purc_variant_is_set(value)) {
+        variant_set_t data = pcvar_set_get_data(value);
+        al = &data->al;
+        nr = pcutils_array_list_length(al);
+    }
+    else {
+        pcinst_set_error(PURC_ERROR_WRONG_DATA_TYPE);
+        return -1;
+    }
+
+    if (nr < 2 || nr_keys == 0)
+        return 0;
+
+    struct sort_item *items;
+    struct pcvrnt_sort_key *keys;
+    items = (struct sort_item *)malloc(nr * sizeof(*items));
+    keys = (struct pcvrnt_sort_key *)calloc(nr * nr_keys, sizeof(*keys));
+    if (items == NULL || keys == NULL) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        free(items);
+        free(keys);
+        return -1;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < nr; i++) {
+        purc_variant_t member;
+        if (members) {
+            items[i].member = members[i];
+            member = members[i];
+        }
+        else {
+            struct set_node *node;
+            node = container_of(al->nodes[i], struct set_node, alnode);
+            items[i].member = node;
+            member = node->val;
+        }
+
+        items[i].idx = i;
+        items[i].keys = keys + i * nr_keys;
+        if (make_keys(member, items[i].keys, ud)) {
+            ret = -1;
+            break;
+        }
+    }
+
+    if (ret == 0) {
+        struct sort_user_data d = {
+            .cmp_keys = cmp_keys,
+            .ud       = ud,
+        };
+
+#if OS(HURD) || OS(LINUX)
+        qsort_r(items, nr, sizeof(*items), cmp_items, &d);
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
+        qsort_r(items, nr, sizeof(*items), &d, cmp_items);
+#elif OS(WINDOWS)
+        qsort_s(items, nr, sizeof(*items), cmp_items, &d);
+#endif
+
+        for (size_t i = 0; i < nr; i++) {
+            if (members) {
+                members[i] = (purc_variant_t)items[i].member;
+            }
+            else {
+                struct set_node *node = (struct set_node *)items[i].member;
+                al->nodes[i] = &node->alnode;
+                al->nodes[i]->idx = i;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < nr * nr_keys; i++)
+        free(keys[i].buf);
+    free(keys);
+    free(items);
+
+    return ret;
+}
+
+struct flags_user_data {
+    pcvrnt_compare_method_k     method;
+    bool                        desc;
+};
+
+static int
+make_flags_key(purc_variant_t member, struct pcvrnt_sort_key *keys, void *ud)
+{
+    struct flags_user_data *d = (struct flags_user_data *)ud;
+    return pcvariant_make_sort_key(member,
+            d->method == PCVRNT_COMPARE_METHOD_NUMBER, keys);
+}
+
+static int
+cmp_flags_keys(const struct pcvrnt_sort_key *l,
+        const struct pcvrnt_sort_key *r, void *ud)
+{
+    struct flags_user_data *d = (struct flags_user_data *)ud;
+    int ret;
+
+    if (d->method == PCVRNT_COMPARE_METHOD_NUMBER) {
+        if (pcutils_equal_doubles(l->num, r->num))
+            ret = 0;
+        else
+            ret = l->num < r->num ? -1 : 1;
+    }
+    else {
+        const char *ls = l->str ? l->str : "";
+        const char *rs = r->str ? r->str : "";
+        if (d->method == PCVRNT_COMPARE_METHOD_CASELESS)
+            ret = pcutils_strcasecmp(ls, rs);
+        else
+            ret = strcmp(ls, rs);
+    }
+
+    return d->desc ? -ret : ret;
+}
+
+static bool
+is_number(purc_variant_t v)
+{
+    return v->type == PURC_VARIANT_TYPE_NUMBER ||
+        v->type == PURC_VARIANT_TYPE_LONGINT ||
+        v->type == PURC_VARIANT_TYPE_ULONGINT ||
+        v->type == PURC_VARIANT_TYPE_LONGDOUBLE;
+}
+
+/* `auto` compares by the type of the left operand, which is the same for
+ * every pair only if all members are numbers, or none of them is. */
+static int
+resolve_auto_method(purc_variant_t value, pcvrnt_compare_method_k *method)
+{
+    size_t nr_numbers = 0, nr = 0;
+    purc_variant_t v;
+
+    if (purc_variant_is_array(value)) {
+        size_t idx;
+        foreach_value_in_variant_array(value, v, idx) {
+            (void)idx;
+            nr++;
+            if (is_number(v))
+                nr_numbers++;
+        } end_foreach;
+    }
+    else {
+        foreach_value_in_variant_set(value, v) {
+            nr++;
+            if (is_number(v))
+                nr_numbers++;
+        } end_foreach;
+    }
+
+    if (nr_numbers == nr)
+        *method = PCVRNT_COMPARE_METHOD_NUMBER;
+    else if (nr_numbers == 0)
+        *method = PCVRNT_COMPARE_METHOD_CASE;
+    else
+        return -1;
+
+    return 0;
+}
+
+int
+pcvar_sort_by_flags(purc_variant_t value, uintptr_t sort_flags)
+{
+    struct flags_user_data d;
+
+    d.method = (pcvrnt_compare_method_k)(sort_flags & PCVRNT_CMPOPT_MASK);
+    d.desc = (sort_flags & PCVRNT_SORT_DESC) ? true : false;
+    if (d.method == PCVRNT_COMPARE_METHOD_AUTO &&
+            resolve_auto_method(value, &d.method))
+        return -1;
+
+    return pcvariant_sort_by_keys(value, 1, &d, make_flags_key, cmp_flags_keys);
+}
@@ -25,6 +25,7 @@
 #define _GNU_SOURCE
 
 #include "config.h"
+#include "private/instance.h"
 #include "private/variant.h"
 #include "private/errors.h"
 #include "variant-internals.h"
@@ -36,18 +37,87 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define ARR_MIN_CAPACITY        4
+
 static size_t
 variant_arr_length(variant_arr_t data)
 {
-    struct pcutils_array_list *al = &data->al;
-    return pcutils_array_list_length(al);
+    return data->nr_members;
+}
+
+/* makes sure there is room for `sz` members at least */
+static int
+variant_arr_reserve(variant_arr_t data, size_t sz)
+{
+    if (sz <= data->sz_members)
+        return 0;
+
+    size_t new_sz = data->sz_members ? data->sz_members : ARR_MIN_CAPACITY;
+    while (new_sz < sz)
+        new_sz *= 2;
+
+    purc_variant_t *members;
+    members = (purc_variant_t*)realloc(data->members,
+            new_sz * sizeof(*members));
+    if (!members) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    data->members = members;
+    data->sz_members = new_sz;
+    return 0;
+}
+
+/* leaves the ring of the arrays sharing the same members */
+static void
+variant_arr_cow_unlink(variant_arr_t data)
+{
+    variant_arr_t prev = data->cow_prev;
+    variant_arr_t next = data->cow_next;
+
+    if (prev == next) {
+        next->cow_prev = NULL;
+        next->cow_next = NULL;
+    }
+    else {
+        prev->cow_next = next;
+        next->cow_prev = prev;
+    }
+
+    data->cow_prev = NULL;
+    data->cow_next = NULL;
+}
+
+/* the shared members are referenced once by the whole ring; an array
+ * takes its own copy (and its own references) before the first write. */
+static int
+variant_arr_unshare(variant_arr_t data)
+{
+    if (!data->cow_next)
+        return 0;
+
+    purc_variant_t *members;
+    members = (purc_variant_t*)malloc(data->sz_members * sizeof(*members));
+    if (!members) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
+
+    memcpy(members, data->members, data->nr_members * sizeof(*members));
+    for (size_t i = 0; i < data->nr_members; i++)
+        purc_variant_ref(members[i]);
+
+    variant_arr_cow_unlink(data);
+    data->members = members;
+    return 0;
 }
 
 static inline bool
 grow(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return true;
 
     purc_variant_t vals[] = { pos, value };
@@ -60,7 +130,7 @@ static inline bool
 shrink(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return true;
 
     purc_variant_t vals[] = { pos, value };
@@ -74,7 +144,7 @@ change(purc_variant_t arr, purc_variant_t pos,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return true;
 
     purc_variant_t vals[] = { pos, o, n };
@@ -87,7 +157,7 @@ static inline void
 grown(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, value };
@@ -100,7 +170,7 @@ static inline void
 shrunk(purc_variant_t arr, purc_variant_t pos, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, value };
@@ -114,7 +184,7 @@ changed(purc_variant_t arr, purc_variant_t pos,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, o, n };
@@ -129,97 +199,143 @@ pcvar_arr_get_data(purc_variant_t arr)
     return (variant_arr_t)arr->sz_ptr[1];
 }
 
-static void
-break_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+static int
+comp_slot_key(const void *key1, const void *key2)
 {
-    struct pcvar_rev_update_edge edge = {
-        .parent        = arr,
-        .arr_me        = node,
-    };
+    return (key1 > key2) - (key1 < key2);
+}
+
+/* counts one more slot holding `val`; returns the new count or 0 on error */
+static size_t
+add_slot(variant_arr_t data, purc_variant_t val)
+{
+    if (!data->slot_counts) {
+        data->slot_counts = pcutils_map_create(NULL, NULL, NULL, NULL,
+                comp_slot_key, false);
+        if (!data->slot_counts)
+            return 0;
+    }
+
+    pcutils_map_entry *entry;
+    entry = pcutils_map_find(data->slot_counts, val);
+    if (entry) {
+        entry->val = (void *)((uintptr_t)entry->val + 1);
+        return (uintptr_t)entry->val;
+    }
+
+    if (pcutils_map_insert(data->slot_counts, val, (void *)(uintptr_t)1))
+        return 0;
 
-    pcvar_break_edge_to_parent(node->val, &edge);
-    pcvar_break_rue_downward(node->val);
+    return 1;
 }
 
-static void
-arr_node_release(purc_variant_t arr, struct arr_node *node)
+/* counts one less slot holding `val`; returns the remaining count */
+static size_t
+del_slot(variant_arr_t data, purc_variant_t val)
 {
-    if (!node)
-        return;
+    if (!data->slot_counts)
+        return 0;
 
-    break_rev_update_chain(arr, node);
+    pcutils_map_entry *entry;
+    entry = pcutils_map_find(data->slot_counts, val);
+    if (!entry)
+        return 0;
 
-    if (node->node.idx != (size_t)-1) {
-        variant_arr_t data = pcvar_arr_get_data(arr);
-        PC_ASSERT(data);
+    uintptr_t nr = (uintptr_t)entry->val - 1;
+    if (nr == 0)
+        pcutils_map_erase(data->slot_counts, val);
+    else
+        entry->val = (void *)nr;
 
-        struct pcutils_array_list *al = &data->al;
-        PC_ASSERT(al);
+    return nr;
+}
 
-        struct pcutils_array_list_node *p;
-        int r = pcutils_array_list_remove(al, node->node.idx, &p);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == p);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+static void
+clear_slots(variant_arr_t data)
+{
+    if (data->slot_counts) {
+        pcutils_map_destroy(data->slot_counts);
+        data->slot_counts = NULL;
     }
-
-    PURC_VARIANT_SAFE_CLEAR(node->val);
 }
 
+/* breaks the edge of `val` which is leaving a slot of `arr` */
 static void
-arr_node_destroy(purc_variant_t arr, struct arr_node *node)
+break_rev_update_chain(purc_variant_t arr, purc_variant_t val)
 {
-    if (!node)
+    if (!pcvar_container_belongs_to_set(arr))
+        return;
+
+    // keep the edge while the value is still held by another slot
+    if (del_slot(pcvar_arr_get_data(arr), val) > 0)
         return;
 
-    arr_node_release(arr, node);
-    free(node);
+    struct pcvar_rev_update_edge edge = {
+        .parent        = arr,
+        .arr_me        = arr,
+    };
+
+    pcvar_break_edge_to_parent(val, &edge);
+    pcvar_break_rue_downward(val);
 }
 
-static purc_variant_t
-variant_arr_make_pos(variant_arr_t data, size_t idx)
+/* The position is only passed to the listeners; it is not made (and
+ * nothing will be fired) if the array is not observed. */
+static int
+variant_arr_make_pos(purc_variant_t arr, size_t idx, bool check,
+        purc_variant_t *pos)
 {
-    size_t len = variant_arr_length(data);
+    *pos = PURC_VARIANT_INVALID;
+    if (!check || !pcvar_is_observed(arr))
+        return 0;
+
+    size_t len = variant_arr_length(pcvar_arr_get_data(arr));
     if (idx > len)
         idx = len;
 
-    return purc_variant_make_longint(idx);
+    *pos = purc_variant_make_longint(idx);
+    return (*pos == PURC_VARIANT_INVALID) ? -1 : 0;
 }
 
-static struct arr_node*
-arr_node_create(purc_variant_t val)
+/* takes the member at `idx` out of the vector, the caller owns the ref */
+static purc_variant_t
+variant_arr_take(variant_arr_t data, size_t idx)
 {
-    struct arr_node *node;
-    node = (struct arr_node*)calloc(1, sizeof(*node));
-    if (!node) {
-        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-        return NULL;
-    }
-
-    node->node.idx = (size_t)-1;
+    PC_ASSERT(idx < data->nr_members);
 
-    node->val = val;
-    purc_variant_ref(val);
+    purc_variant_t val = data->members[idx];
+    memmove(data->members + idx, data->members + idx + 1,
+            (data->nr_members - idx - 1) * sizeof(*data->members));
+    data->nr_members--;
 
-    return node;
+    return val;
 }
 
+/* the caller breaks the chain of `val` again if this fails */
 static int
-build_rev_update_chain(purc_variant_t arr, struct arr_node *node)
+build_rev_update_chain(purc_variant_t arr, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
 
+    size_t nr = add_slot(pcvar_arr_get_data(arr), val);
+    if (nr == 0)
+        return -1;
+
+    // the edge was built for another slot holding the value
+    if (nr > 1)
+        return 0;
+
     int r;
 
     struct pcvar_rev_update_edge edge = {
         .parent        = arr,
-        .arr_me        = node,
+        .arr_me        = arr,
     };
 
-    r = pcvar_build_edge_to_parent(node->val, &edge);
+    r = pcvar_build_edge_to_parent(val, &edge);
     if (r == 0) {
-        r = pcvar_build_rue_downward(node->val);
+        r = pcvar_build_rue_downward(val);
     }
 
     return r ? -1 : 0;
@@ -280,19 +396,14 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx > nr)
         idx = nr;
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, idx, check, &pos))
         return -1;
 
-    struct arr_node *node = NULL;
-
     do {
         if (check) {
             if (!grow(arr, pos, val, check))
@@ -302,35 +413,32 @@ variant_arr_insert_before(purc_variant_t arr, size_t idx, purc_variant_t val,
                 break;
         }
 
-        node = arr_node_create(val);
-        if (!node)
+        if (variant_arr_unshare(data) || variant_arr_reserve(data, nr + 1))
             break;
 
-        int r;
-        PC_ASSERT(node->node.idx == (size_t)-1);
-        r = pcutils_array_list_insert_before(al, idx, &node->node);
-        if (r) {
-            PC_ASSERT(node->node.idx == (size_t)-1);
-            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            break;
-        }
-        PC_ASSERT(node->node.idx != (size_t)-1);
+        memmove(data->members + idx + 1, data->members + idx,
+                (nr - idx) * sizeof(*data->members));
+        data->members[idx] = purc_variant_ref(val);
+        data->nr_members++;
 
         if (check) {
-            if (build_rev_update_chain(arr, node))
+            if (build_rev_update_chain(arr, val)) {
+                break_rev_update_chain(arr, val);
+                variant_arr_take(data, idx);
+                purc_variant_unref(val);
                 break;
+            }
 
             pcvar_adjust_set_by_descendant(arr);
             grown(arr, pos, val, check);
         }
 
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    arr_node_destroy(arr, node);
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
@@ -342,9 +450,7 @@ refresh_extra(purc_variant_t arr)
     variant_arr_t data = pcvar_arr_get_data(arr);
     if (data) {
         extra += sizeof(*data);
-        struct pcutils_array_list *al = &data->al;
-        extra += al->sz * sizeof(*al->nodes);
-        extra += al->nr * sizeof(struct arr_node);
+        extra += data->sz_members * sizeof(*data->members);
     }
     pcvariant_stat_set_extra_size(arr, extra);
 }
@@ -354,8 +460,7 @@ variant_arr_append(purc_variant_t arr, purc_variant_t val,
         bool check)
 {
     variant_arr_t data = pcvar_arr_get_data(arr);
-    struct pcutils_array_list *al = &data->al;
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     int r = variant_arr_insert_before(arr, nr, val, check);
     refresh_extra(arr);
     return r ? -1 : 0;
@@ -371,19 +476,14 @@ variant_arr_prepend(purc_variant_t arr, purc_variant_t val,
 static purc_variant_t
 variant_arr_get(variant_arr_t data, size_t idx)
 {
-    struct pcutils_array_list *al = &data->al;
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    if (p == NULL)
+    if (idx >= data->nr_members)
         return PURC_VARIANT_INVALID;
 
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    return node->val;
+    return data->members[idx];
 }
 
 static int
-check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
+check_change(purc_variant_t arr, size_t idx, purc_variant_t val)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -398,10 +498,10 @@ check_change(purc_variant_t arr, struct arr_node *node, purc_variant_t val)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 found = true;
             }
-            r = pcvar_arr_append(_new, i == node->node.idx ? val : v);
+            r = pcvar_arr_append(_new, i == idx ? val : v);
             if (r)
                 break;
         } end_foreach;
@@ -431,54 +531,43 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         purc_set_error(PURC_ERROR_OVERFLOW);
         return -1;
     }
 
-    struct pcutils_array_list_node *p;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
-
-    struct arr_node *old_node;
-    old_node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(old_node->val != PURC_VARIANT_INVALID);
-    if (old_node->val == val) {
+    purc_variant_t old = data->members[idx];
+    PC_ASSERT(old != PURC_VARIANT_INVALID);
+    if (old == val) {
         // NOTE: keep refc intact
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    if (variant_arr_unshare(data))
         return -1;
 
-    do {
-        purc_variant_t old = old_node->val;
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, idx, check, &pos))
+        return -1;
 
+    do {
         if (check) {
             if (!change(arr, pos, old, val, check))
                 break;
 
-            if (check_change(arr, old_node, val))
+            if (check_change(arr, idx, val))
                 break;
 
-            old_node->val = val;
-
-            if (build_rev_update_chain(arr, old_node)) {
-                break_rev_update_chain(arr, old_node);
-                old_node->val = old;
+            if (build_rev_update_chain(arr, val)) {
+                break_rev_update_chain(arr, val);
                 break;
             }
 
-            old_node->val = old;
-            break_rev_update_chain(arr, old_node);
+            break_rev_update_chain(arr, old);
         }
 
-        old_node->val = purc_variant_ref(val);
+        data->members[idx] = purc_variant_ref(val);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
@@ -487,18 +576,18 @@ variant_arr_set(purc_variant_t arr, size_t idx, purc_variant_t val,
         }
 
         purc_variant_unref(old);
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
 
 static int
-check_shrink(purc_variant_t arr, struct arr_node *node)
+check_shrink(purc_variant_t arr, size_t idx)
 {
     if (!pcvar_container_belongs_to_set(arr))
         return 0;
@@ -513,7 +602,7 @@ check_shrink(purc_variant_t arr, struct arr_node *node)
         size_t i;
         purc_variant_t v;
         foreach_value_in_variant_array(arr, v, i) {
-            if (i == node->node.idx) {
+            if (i == idx) {
                 PC_ASSERT(!found);
                 found = true;
                 continue;
@@ -548,57 +637,47 @@ variant_arr_remove(purc_variant_t arr, size_t idx,
     variant_arr_t data = pcvar_arr_get_data(arr);
     PC_ASSERT(data);
 
-    struct pcutils_array_list *al = &data->al;
-    PC_ASSERT(al);
-
-    size_t nr = pcutils_array_list_length(al);
+    size_t nr = variant_arr_length(data);
     if (idx >= nr) {
         // FIXME: failure or success???
         return 0;
     }
 
-    purc_variant_t pos = variant_arr_make_pos(data, idx);
-    if (pos == PURC_VARIANT_INVALID)
+    if (variant_arr_unshare(data))
         return -1;
 
-    struct pcutils_array_list_node *p, *n;
-    p = pcutils_array_list_get(al, idx);
-    PC_ASSERT(p);
+    purc_variant_t pos;
+    if (variant_arr_make_pos(arr, idx, check, &pos))
+        return -1;
 
-    struct arr_node *node;
-    node = (struct arr_node*)container_of(p, struct arr_node, node);
-    PC_ASSERT(node->val);
+    purc_variant_t val = data->members[idx];
+    PC_ASSERT(val);
 
     do {
         if (check) {
-            if (!shrink(arr, pos, node->val, check))
+            if (!shrink(arr, pos, val, check))
                 break;
 
-            if (check_shrink(arr, node))
+            if (check_shrink(arr, idx))
                 break;
-
-            break_rev_update_chain(arr, node);
         }
 
-        PC_ASSERT(node->node.idx != (size_t)-1);
-        int r = pcutils_array_list_remove(al, idx, &n);
-        PC_ASSERT(r == 0);
-        PC_ASSERT(&node->node == n);
-        PC_ASSERT(node->node.idx == (size_t)-1);
+        break_rev_update_chain(arr, val);
+        variant_arr_take(data, idx);
 
         if (check) {
             pcvar_adjust_set_by_descendant(arr);
 
-            shrunk(arr, pos, node->val, check);
+            shrunk(arr, pos, val, check);
         }
 
-        arr_node_destroy(arr, node);
-        purc_variant_unref(pos);
+        purc_variant_unref(val);
+        PURC_VARIANT_SAFE_CLEAR(pos);
 
         return 0;
     } while (0);
 
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
 
     return -1;
 }
@@ -610,20 +689,28 @@ array_release (purc_variant_t arr)
     if (!data)
         return;
 
-    struct pcutils_array_list *al = &data->al;
-    struct arr_node *p, *n;
-    array_list_for_each_entry_reverse_safe(al, p, n, node) {
-        arr_node_destroy(arr, p);
-    };
+    if (pcvar_container_belongs_to_set(arr))
+        pcvar_array_break_rue_downward(arr);
+
+    if (data->cow_next) {
+        // the members are still in use by the other arrays of the ring
+        variant_arr_cow_unlink(data);
+    }
+    else {
+        while (data->nr_members > 0) {
+            purc_variant_unref(data->members[--data->nr_members]);
+        }
 
-    pcutils_array_list_reset(al);
+        free(data->members);
+    }
 
     if (data->rev_update_chain) {
         pcvar_destroy_rev_update_chain(data->rev_update_chain);
         data->rev_update_chain = NULL;
     }
+    clear_slots(data);
 
-    free(data);
+    pcvariant_node_free(data, sizeof(*data));
     arr->sz_ptr[1] = (uintptr_t)NULL;
 
     pcvariant_stat_set_extra_size(arr, 0);
@@ -642,28 +729,18 @@ make_array(size_t sz)
         var->flags         = PCVRNT_FLAG_EXTRA_SIZE;
         var->refc          = 1;
 
-        size_t initial_size = ARRAY_LIST_DEFAULT_SIZE;
-        if (sz>initial_size)
-            initial_size = sz;
-
-        variant_arr_t data = (variant_arr_t)calloc(1, sizeof(*data));
+        variant_arr_t data;
+        data = (variant_arr_t)pcvariant_node_alloc(sizeof(*data));
         if (!data) {
             pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
             break;
         }
 
-        struct pcutils_array_list *al;
-        al = &data->al;
-        pcutils_array_list_init(al);
-        if (pcutils_array_list_expand(al, initial_size)) {
-            pcutils_array_list_reset(al);
-            free(data);
-            pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
-            break;
-        }
-
         var->sz_ptr[1]     = (uintptr_t)data;
 
+        if (sz > 0 && variant_arr_reserve(data, sz))
+            break;
+
         refresh_extra(var);
 
         return var;
@@ -871,16 +948,19 @@ struct arr_user_data {
     void *ud;
 };
 
-static int
-sort_cmp(struct pcutils_array_list_node *l, struct pcutils_array_list_node *r,
-        void *ud)
+#if OS(HURD) || OS(LINUX)
+static int sort_cmp(const void *l, const void *r, void *ud)
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD) || OS(WINDOWS)
+static int sort_cmp(void *ud, const void *l, const void *r)
+#else
+#error Unsupported operating system.
+#endif
 {
-    struct arr_node *l_n, *r_n;
-    l_n = container_of(l, struct arr_node, node);
-    r_n = container_of(r, struct arr_node, node);
+    purc_variant_t lv = *(const purc_variant_t*)l;
+    purc_variant_t rv = *(const purc_variant_t*)r;
 
     struct arr_user_data *d = (struct arr_user_data*)ud;
-    return d->cmp(l_n->val, r_n->val, d->ud);
+    return d->cmp(lv, rv, d->ud);
 }
 
 static int vrtcmp(purc_variant_t l, purc_variant_t r, void *ud)
@@ -903,6 +983,9 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
     if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
         return -1;
 
+    if (cmp == NULL && pcvar_sort_by_flags(arr, (uintptr_t)ud) == 0)
+        return 0;
+
     variant_arr_t data = pcvar_arr_get_data(arr);
 
     struct arr_user_data d = {
@@ -914,16 +997,93 @@ int pcvariant_array_sort(purc_variant_t arr, void *ud,
         d.cmp = vrtcmp;
     }
 
-    pcutils_array_list_sort(&data->al, &d, sort_cmp);
+    if (variant_arr_unshare(data))
+        return -1;
+
+    purc_variant_t *members = data->members;
+    size_t nr = data->nr_members;
+
+#if OS(HURD) || OS(LINUX)
+    qsort_r(members, nr, sizeof(*members), sort_cmp, &d);
+#elif OS(DARWIN) || OS(FREEBSD) || OS(NETBSD) || OS(OPENBSD)
+    qsort_r(members, nr, sizeof(*members), &d, sort_cmp);
+#elif OS(WINDOWS)
+    qsort_s(members, nr, sizeof(*members), sort_cmp, &d);
+#endif
 
     return 0;
 }
 
+int
+pcvariant_array_unshare(purc_variant_t arr)
+{
+    if (!arr || arr->type != PURC_VARIANT_TYPE_ARRAY)
+        return -1;
+
+    return variant_arr_unshare(pcvar_arr_get_data(arr));
+}
+
+/* Whether a clone can share the members with `arr`: the members must be
+ * immutable if a deep copy is asked, and the clone must stay in the heap of
+ * the current instance, because the reference counts are not atomic. */
+static bool
+can_share_members(purc_variant_t arr, bool recursively)
+{
+    struct pcinst *inst = pcinst_current();
+    if (!inst || inst->variant_heap != inst->org_vrt_heap)
+        return false;
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    if (data->nr_members == 0)
+        return false;
+
+    if (recursively) {
+        for (size_t i = 0; i < data->nr_members; i++) {
+            if (IS_CONTAINER(data->members[i]->type))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static purc_variant_t
+array_clone_shared(purc_variant_t arr)
+{
+    purc_variant_t var = make_array(0);
+    if (var == PURC_VARIANT_INVALID)
+        return PURC_VARIANT_INVALID;
+
+    variant_arr_t data = pcvar_arr_get_data(arr);
+    variant_arr_t cloned = pcvar_arr_get_data(var);
+
+    cloned->members = data->members;
+    cloned->nr_members = data->nr_members;
+    cloned->sz_members = data->sz_members;
+
+    if (data->cow_next == NULL) {
+        data->cow_next = data->cow_prev = cloned;
+        cloned->cow_next = cloned->cow_prev = data;
+    }
+    else {
+        cloned->cow_prev = data;
+        cloned->cow_next = data->cow_next;
+        data->cow_next->cow_prev = cloned;
+        data->cow_next = cloned;
+    }
+
+    refresh_extra(var);
+    return var;
+}
+
 purc_variant_t
 pcvariant_array_clone(purc_variant_t arr, bool recursively)
 {
+    if (can_share_members(arr, recursively))
+        return array_clone_shared(arr);
+
     purc_variant_t var;
-    var = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    var = make_array(variant_arr_length(pcvar_arr_get_data(arr)));
     if (var == PURC_VARIANT_INVALID)
         return PURC_VARIANT_INVALID;
 
@@ -961,18 +1121,27 @@ pcvar_array_break_rue_downward(purc_variant_t arr)
     PC_ASSERT(purc_variant_is_array(arr));
 
     variant_arr_t data = pcvar_arr_get_data(arr);
-    if (!data)
+    if (!data || !data->slot_counts)
         return;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
-        struct pcvar_rev_update_edge edge = {
-            .parent         = arr,
-            .arr_me         = p,
-        };
-        pcvar_break_edge_to_parent(p->val, &edge);
-        pcvar_break_rue_downward(p->val);
+    struct pcvar_rev_update_edge edge = {
+        .parent         = arr,
+        .arr_me         = arr,
+    };
+
+    // once for each distinct member
+    pcutils_map_entry *entry;
+    struct pcutils_map_iterator it;
+    it = pcutils_map_it_begin_first(data->slot_counts);
+    while ((entry = pcutils_map_it_value(&it))) {
+        purc_variant_t v = (purc_variant_t)entry->key;
+        pcvar_break_edge_to_parent(v, &edge);
+        pcvar_break_rue_downward(v);
+        pcutils_map_it_next(&it);
     }
+    pcutils_map_it_end(&it);
+
+    clear_slots(data);
 }
 
 void
@@ -999,16 +1168,25 @@ pcvar_array_build_rue_downward(purc_variant_t arr)
     if (!data)
         return 0;
 
-    struct arr_node *p;
-    foreach_in_variant_array(arr, p) {
-        struct pcvar_rev_update_edge edge = {
-            .parent         = arr,
-            .arr_me         = p,
-        };
-        int r = pcvar_build_edge_to_parent(p->val, &edge);
+    struct pcvar_rev_update_edge edge = {
+        .parent         = arr,
+        .arr_me         = arr,
+    };
+
+    // count the slots again, so that building twice changes nothing
+    clear_slots(data);
+    for (size_t i = 0; i < data->nr_members; i++) {
+        purc_variant_t v = data->members[i];
+        size_t nr = add_slot(data, v);
+        if (nr == 0)
+            return -1;
+        if (nr > 1)
+            continue;
+
+        int r = pcvar_build_edge_to_parent(v, &edge);
         if (r)
             return -1;
-        r = pcvar_build_rue_downward(p->val);
+        r = pcvar_build_rue_downward(v);
         if (r)
             return -1;
     }
@@ -1043,67 +1221,26 @@ pcvar_array_build_edge_to_parent(purc_variant_t arr,
     return r ? -1 : 0;
 }
 
-static struct pcutils_array_list_node*
-next_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
-{
-    if (!node)
-        return NULL;
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx + 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
-}
-
-static struct pcutils_array_list_node*
-prev_node(struct pcutils_array_list *al, struct pcutils_array_list_node *node)
+static void
+it_refresh(struct arr_iterator *it, size_t idx)
 {
-    if (!node)
-        return NULL;
-    if (node->idx == 0)
-        return NULL;
-
-    size_t count = pcutils_array_list_length(al);
-    size_t idx = node->idx - 1;
-    if (idx >= count)
-        return NULL;
-
-    return pcutils_array_list_get(al, idx);
+    variant_arr_t data = pcvar_arr_get_data(it->arr);
+    size_t sz = data->nr_members;
+    purc_variant_t *members = data->members;
+
+    it->idx = idx;
+    it->curr = members[idx];
+    it->prev = idx > 0 ? members[idx - 1] : PURC_VARIANT_INVALID;
+    it->next = idx + 1 < sz ? members[idx + 1] : PURC_VARIANT_INVALID;
 }
 
 static void
-it_refresh(struct arr_iterator *it,
-        struct pcutils_array_list *al,
-        struct pcutils_array_list_node *curr)
+it_reset(struct arr_iterator *it)
 {
-    struct pcutils_array_list_node *next  = NULL;
-    struct pcutils_array_list_node *prev  = NULL;
-    if (curr) {
-        next  = next_node(al, curr);
-        prev  = prev_node(al, curr);
-    }
-
-    if (curr) {
-        it->curr = container_of(curr, struct arr_node, node);
-    }
-    else {
-        it->curr = NULL;
-    }
-
-    if (next) {
-        it->next = container_of(next, struct arr_node, node);
-    }
-    else {
-        it->next = NULL;
-    }
-
-    if (prev) {
-        it->prev = container_of(prev, struct arr_node, node);
-    }
-    else {
-        it->prev = NULL;
-    }
+    it->idx  = (size_t)-1;
+    it->curr = PURC_VARIANT_INVALID;
+    it->next = PURC_VARIANT_INVALID;
+    it->prev = PURC_VARIANT_INVALID;
 }
 
 struct arr_iterator
@@ -1112,6 +1249,7 @@ pcvar_arr_it_first(purc_variant_t arr)
     struct arr_iterator it = {
         .arr         = arr,
     };
+    it_reset(&it);
     if (arr == PURC_VARIANT_INVALID)
         return it;
 
@@ -1120,12 +1258,7 @@ pcvar_arr_it_first(purc_variant_t arr)
     if (count == 0)
         return it;
 
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *first;
-    first = pcutils_array_list_get_first(al);
-
-    it_refresh(&it, al, first);
+    it_refresh(&it, 0);
 
     return it;
 }
@@ -1136,6 +1269,7 @@ pcvar_arr_it_last(purc_variant_t arr)
     struct arr_iterator it = {
         .arr         = arr,
     };
+    it_reset(&it);
     if (arr == PURC_VARIANT_INVALID)
         return it;
 
@@ -1144,12 +1278,7 @@ pcvar_arr_it_last(purc_variant_t arr)
     if (count == 0)
         return it;
 
-    struct pcutils_array_list *al = &data->al;
-
-    struct pcutils_array_list_node *last;
-    last = pcutils_array_list_get_last(al);
-
-    it_refresh(&it, al, last);
+    it_refresh(&it, count - 1);
 
     return it;
 }
@@ -1157,45 +1286,28 @@ pcvar_arr_it_last(purc_variant_t arr)
 void
 pcvar_arr_it_next(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
     if (it->next) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *next;
-        next = &it->next->node;
-
-        it_refresh(it, al, next);
+        it_refresh(it, it->idx + 1);
     }
     else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
+        it_reset(it);
     }
 }
 
 void
 pcvar_arr_it_prev(struct arr_iterator *it)
 {
-    if (it->curr == NULL)
+    if (it->curr == PURC_VARIANT_INVALID)
         return;
 
     if (it->prev) {
-        variant_arr_t data = pcvar_arr_get_data(it->arr);
-        struct pcutils_array_list *al = &data->al;
-
-        struct pcutils_array_list_node *prev;
-        prev = &it->prev->node;
-
-        it_refresh(it, al, prev);
+        it_refresh(it, it->idx - 1);
     }
     else {
-        it->curr = NULL;
-        it->next = NULL;
-        it->prev = NULL;
+        it_reset(it);
     }
 }
 
-
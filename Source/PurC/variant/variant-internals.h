@@ -101,6 +101,14 @@ pcvar_reverse_check(purc_variant_t old, purc_variant_t _new) WTF_INTERNAL;
 bool
 pcvar_container_belongs_to_set(purc_variant_t val) WTF_INTERNAL;
 
+/* whether any listener (or a batch) is attached to the container; the
+ * mutations skip building the notification arguments if not */
+static inline bool
+pcvar_is_observed(purc_variant_t val)
+{
+    return !list_empty(&val->listeners);
+}
+
 purc_variant_t
 pcvariant_container_clone(purc_variant_t cntr, bool recursively) WTF_INTERNAL;
 
@@ -191,10 +199,11 @@ pcvar_obj_it_prev(struct obj_iterator *it);
 
 struct arr_iterator {
     purc_variant_t                arr;
+    size_t                        idx;
 
-    struct arr_node              *curr;
-    struct arr_node              *next;
-    struct arr_node              *prev;
+    purc_variant_t                curr;
+    purc_variant_t                next;
+    purc_variant_t                prev;
 };
 
 struct arr_iterator
@@ -281,6 +290,11 @@ pcvar_rev_update_chain_post_handler(
 purc_variant_t
 pcvar_set_clone_struct(purc_variant_t set);
 
+// sorts with the default comparison given by PCVRNT_SORT_XXX and
+// PCVRNT_COMPARE_METHOD_XXX; -1 if the keys can not be precomputed.
+int
+pcvar_sort_by_flags(purc_variant_t ctnr, uintptr_t sort_flags);
+
 // constraint-releated
 purc_variant_t
 pcvar_make_arr(void);
@@ -26,6 +26,7 @@
 #include "config.h"
 #include "private/variant.h"
 #include "private/errors.h"
+#include "private/hashtable.h"
 #include "purc-errors.h"
 #include "variant-internals.h"
 
@@ -36,13 +37,18 @@
 #include <string.h>
 
 #define OBJ_EXTRA_SIZE(data) (sizeof(*data) + \
-        (data->size) * sizeof(struct obj_node))
+        (data->size) * sizeof(struct obj_node) + \
+        (data->nr_buckets) * sizeof(struct obj_node *))
+
+/* objects with more properties than this get a hash index */
+#define OBJ_LINEAR_MAX          8
+#define OBJ_MIN_BUCKETS         16
 
 static inline bool
 grow(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return true;
 
     purc_variant_t vals[] = { key, val };
@@ -55,7 +61,7 @@ static inline bool
 shrink(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return true;
 
     purc_variant_t vals[] = { key, val };
@@ -70,7 +76,7 @@ change(purc_variant_t obj,
         purc_variant_t kn, purc_variant_t vn,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return true;
 
     purc_variant_t vals[] = { ko, vo, kn, vn };
@@ -83,7 +89,7 @@ static inline void
 grown(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return;
 
     purc_variant_t vals[] = { key, val };
@@ -96,7 +102,7 @@ static inline void
 shrunk(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return;
 
     purc_variant_t vals[] = { key, val };
@@ -111,7 +117,7 @@ changed(purc_variant_t obj,
         purc_variant_t kn, purc_variant_t vn,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(obj))
         return;
 
     purc_variant_t vals[] = { ko, vo, kn, vn };
@@ -127,6 +133,99 @@ pcvar_obj_get_data(purc_variant_t obj)
     return data;
 }
 
+static inline uint32_t
+key_hash(const char *sk)
+{
+    return pchash_fnv1a_str_hash(sk);
+}
+
+static struct obj_node*
+find_node(variant_obj_t data, const char *sk, uint32_t hash)
+{
+    struct obj_node *node;
+
+    if (data->buckets) {
+        node = data->buckets[hash & (data->nr_buckets - 1)];
+        for (; node; node = node->hash_next) {
+            if (node->hash == hash &&
+                    strcmp(sk, purc_variant_get_string_const(node->key)) == 0)
+                return node;
+        }
+
+        return NULL;
+    }
+
+    struct rb_node *p = pcutils_rbtree_first(&data->kvs);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        node = container_of(p, struct obj_node, node);
+        if (node->hash == hash &&
+                strcmp(sk, purc_variant_get_string_const(node->key)) == 0)
+            return node;
+    }
+
+    return NULL;
+}
+
+static void
+link_hash(variant_obj_t data, struct obj_node *node)
+{
+    if (!data->buckets)
+        return;
+
+    struct obj_node **bucket;
+    bucket = &data->buckets[node->hash & (data->nr_buckets - 1)];
+    node->hash_next = *bucket;
+    *bucket = node;
+}
+
+static void
+unlink_hash(variant_obj_t data, struct obj_node *node)
+{
+    if (!data->buckets)
+        return;
+
+    struct obj_node **pp;
+    pp = &data->buckets[node->hash & (data->nr_buckets - 1)];
+    for (; *pp; pp = &(*pp)->hash_next) {
+        if (*pp == node) {
+            *pp = node->hash_next;
+            break;
+        }
+    }
+    node->hash_next = NULL;
+}
+
+/*
+ * Builds or enlarges the hash index when the object grows out of the
+ * current one. Failing to allocate the buckets is not an error: the object
+ * keeps working with the old index or without one.
+ */
+static void
+refresh_hash(variant_obj_t data)
+{
+    if (data->size <= OBJ_LINEAR_MAX || data->size <= data->nr_buckets)
+        return;
+
+    size_t nr_buckets = data->nr_buckets ? data->nr_buckets : OBJ_MIN_BUCKETS;
+    while (nr_buckets < data->size)
+        nr_buckets *= 2;
+
+    struct obj_node **buckets;
+    buckets = (struct obj_node **)calloc(nr_buckets, sizeof(*buckets));
+    if (!buckets)
+        return;
+
+    free(data->buckets);
+    data->buckets = buckets;
+    data->nr_buckets = nr_buckets;
+
+    struct rb_node *p = pcutils_rbtree_first(&data->kvs);
+    for (; p; p = pcutils_rbtree_next(p)) {
+        struct obj_node *node = container_of(p, struct obj_node, node);
+        link_hash(data, node);
+    }
+}
+
 static purc_variant_t v_object_new_with_capacity(void)
 {
     purc_variant_t var = pcvariant_get(PVT(_OBJECT));
@@ -139,7 +238,7 @@ static purc_variant_t v_object_new_with_capacity(void)
     var->flags         = PCVRNT_FLAG_EXTRA_SIZE;
 
     variant_obj_t data;
-    data = (variant_obj_t)calloc(1, sizeof(*data));
+    data = (variant_obj_t)pcvariant_node_alloc(sizeof(*data));
 
     if (!data) {
         pcvariant_put(var);
@@ -184,6 +283,7 @@ obj_node_release(purc_variant_t obj, struct obj_node *node)
     struct rb_root *root = &data->kvs;
     if (&node->node == root->rb_node || node->node.rb_parent) {
         --data->size;
+        unlink_hash(data, node);
         pcutils_rbtree_erase(&node->node, root);
         node->node.rb_parent = NULL;
     }
@@ -200,7 +300,7 @@ obj_node_destroy(purc_variant_t obj, struct obj_node *node)
 
     obj_node_release(obj, node);
 
-    free(node);
+    pcvariant_node_free(node, sizeof(*node));
 }
 
 static struct obj_node*
@@ -212,7 +312,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
     }
 
     struct obj_node *node;
-    node = (struct obj_node*)calloc(1, sizeof(*node));
+    node = (struct obj_node*)pcvariant_node_alloc(sizeof(*node));
     if (!node) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
@@ -220,6 +320,7 @@ obj_node_create(purc_variant_t k, purc_variant_t v)
 
     node->key = purc_variant_ref(k);
     node->val = purc_variant_ref(v);
+    node->hash = key_hash(purc_variant_get_string_const(k));
 
     return node;
 }
@@ -296,28 +397,9 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
 {
     variant_obj_t data = pcvar_obj_get_data(obj);
     struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
 
-    if (!entry) {
+    struct obj_node *node = find_node(data, key, key_hash(key));
+    if (!node) {
         if (silently)
             return 0;
 
@@ -325,8 +407,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         return -1;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
+    struct rb_node *entry = &node->node;
     purc_variant_t k = node->key;
     purc_variant_t v = node->val;
 
@@ -342,6 +423,7 @@ v_object_remove(purc_variant_t obj, const char *key, bool silently,
         }
 
         --data->size;
+        unlink_hash(data, node);
         PC_ASSERT(entry == root->rb_node || entry->rb_parent);
         pcutils_rbtree_erase(entry, root);
         entry->rb_parent = NULL;
@@ -466,30 +548,27 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
     variant_obj_t data = pcvar_obj_get_data(obj);
     PC_ASSERT(data);
 
-    struct rb_root *root = &data->kvs;
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sko = purc_variant_get_string_const(node->key);
-        int ret = strcmp(sk, sko);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
+    struct obj_node *node = find_node(data, sk, key_hash(sk));
+    if (!node) { //new the entry
+        struct rb_root *root = &data->kvs;
+        struct rb_node **pnode = &root->rb_node;
+        struct rb_node *parent = NULL;
+        while (*pnode) {
+            struct obj_node *on;
+            on = container_of(*pnode, struct obj_node, node);
+            const char *sko = purc_variant_get_string_const(on->key);
+            int ret = strcmp(sk, sko);
+            PC_ASSERT(ret);
+
+            parent = *pnode;
+
+            if (ret < 0)
+                pnode = &parent->rb_left;
+            else
+                pnode = &parent->rb_right;
         }
-    }
 
-    if (!entry) { //new the entry
-        struct obj_node *node = obj_node_create(key, val);
+        node = obj_node_create(key, val);
         if (!node)
             return -1;
 
@@ -502,12 +581,14 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
                     break;
             }
 
-            entry = &node->node;
+            struct rb_node *entry = &node->node;
 
             pcutils_rbtree_link_node(entry, parent, pnode);
             pcutils_rbtree_insert_color(entry, root);
 
             ++data->size;
+            link_hash(data, node);
+            refresh_hash(data);
 
             if (check) {
                 if (build_rev_update_chain(obj, node))
@@ -532,8 +613,6 @@ v_object_set(purc_variant_t obj, purc_variant_t key, purc_variant_t val,
         return -1;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     if (node->val == val) {
         // NOTE: keep refc intact
         return 0;
@@ -750,6 +829,10 @@ void pcvariant_object_release (purc_variant_t value)
 
     variant_obj_t data = pcvar_obj_get_data(value);
 
+    free(data->buckets);
+    data->buckets = NULL;
+    data->nr_buckets = 0;
+
     struct rb_root *root = &data->kvs;
 
     struct rb_node *p, *n;
@@ -765,7 +848,7 @@ void pcvariant_object_release (purc_variant_t value)
         data->rev_update_chain = NULL;
     }
 
-    free(data);
+    pcvariant_node_free(data, sizeof(*data));
 
     value->sz_ptr[1] = (uintptr_t)NULL; // say no to double free
 
@@ -802,38 +885,14 @@ purc_variant_object_get_by_ckey(purc_variant_t obj, const char* key)
         PURC_VARIANT_INVALID);
 
     variant_obj_t data = pcvar_obj_get_data(obj);
-    struct rb_root *root = &data->kvs;
-
-    struct rb_node **pnode = &root->rb_node;
-    struct rb_node *parent = NULL;
-    struct rb_node *entry = NULL;
-    while (*pnode) {
-        struct obj_node *node;
-        node = container_of(*pnode, struct obj_node, node);
-        const char *sk = purc_variant_get_string_const(node->key);
 
-        int ret = strcmp(key, sk);
-
-        parent = *pnode;
-
-        if (ret < 0)
-            pnode = &parent->rb_left;
-        else if (ret > 0)
-            pnode = &parent->rb_right;
-        else{
-            entry = *pnode;
-            break;
-        }
-    }
-
-    if (!entry) {
+    struct obj_node *node = find_node(data, key, key_hash(key));
+    if (!node) {
         pcinst_set_error(PCVRNT_ERROR_NO_SUCH_KEY);
 
         return PURC_VARIANT_INVALID;
     }
 
-    struct obj_node *node;
-    node = container_of(entry, struct obj_node, node);
     return node->val;
 }
 
@@ -41,7 +41,7 @@ static bool
 grow(purc_variant_t set, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return true;
 
     purc_variant_t vals[] = { value };
@@ -54,7 +54,7 @@ static bool
 shrink(purc_variant_t set, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return true;
 
     purc_variant_t vals[] = { value };
@@ -68,7 +68,7 @@ change(purc_variant_t set,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return true;
 
     purc_variant_t vals[] = { o, n };
@@ -81,7 +81,7 @@ static void
 grown(purc_variant_t set, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return;
 
     purc_variant_t vals[] = { value };
@@ -94,7 +94,7 @@ static void
 shrunk(purc_variant_t set, purc_variant_t value,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return;
 
     purc_variant_t vals[] = { value };
@@ -108,7 +108,7 @@ changed(purc_variant_t set,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || !pcvar_is_observed(set))
         return;
 
     purc_variant_t vals[] = { o, n };
@@ -138,6 +138,7 @@ variant_set_get_extra_size(variant_set_t data)
 
     extra += sz_record * count;
     extra += sizeof(struct set_node*)*(data->al.nr);
+    extra += sizeof(struct set_node*)*(data->nr_buckets);
 
     return extra;
 }
@@ -279,7 +280,8 @@ pcv_set_new(void)
     set->type          = PVT(_SET);
     set->flags         = PCVRNT_FLAG_EXTRA_SIZE;
 
-    variant_set_t data  = (variant_set_t)calloc(1, sizeof(*data));
+    variant_set_t data;
+    data = (variant_set_t)pcvariant_node_alloc(sizeof(*data));
     pcv_set_set_data(set, data);
 
     if (!data) {
@@ -353,12 +355,6 @@ elem_node_revoke_constraints(purc_variant_t set, struct set_node *node)
     break_rev_update_chain(set, node);
 }
 
-struct element_rb_node {
-    struct rb_node     **pnode;
-    struct rb_node      *parent;
-    struct rb_node      *entry;
-};
-
 static int
 _compare_generic(purc_variant_t _new, purc_variant_t _old, bool caseless)
 {
@@ -434,31 +430,62 @@ _compare(purc_variant_t _new, purc_variant_t _old,
     return _compare_by_unique_keys(_new, _old, data);
 }
 
-static void
-find_element_rb_node(struct element_rb_node *node,
-        purc_variant_t set, purc_variant_t kvs)
+#define SET_MIN_BUCKETS     16
+
+/* Where a member equal to the given value is or will be. Caseless sets keep
+ * the members ordered in `elems` and search the tree; other sets search the
+ * hash index by the hash of the unique key(s) and order the members lazily,
+ * because the ordered tree is only needed for traversing in order. */
+struct element_pos {
+    struct rb_node     **pnode;
+    struct rb_node      *parent;
+    uint64_t             hash;
+};
+
+static uint64_t
+hash_by_set(variant_set_t data, purc_variant_t val)
+{
+    if (data->unique_key == NULL)
+        return pcvariant_hash_text(val);
+
+    uint64_t hash = 0;
+    for (size_t i=0; i<data->nr_keynames; ++i) {
+        purc_variant_t v = _get_by_key(val, data->keynames[i]);
+        hash = (hash ^ pcvariant_hash_text(v)) * 0x100000001B3ULL;
+        purc_variant_unref(v);
+    }
+
+    return hash;
+}
+
+static struct set_node*
+locate_element(purc_variant_t set, purc_variant_t kvs,
+        struct element_pos *pos)
 {
     variant_set_t data = pcvar_set_get_data(set);
-    struct rb_root *root = &data->elems;
-    struct rb_node **pnode = &root->rb_node;
+
+    if (!data->caseless) {
+        pos->hash = hash_by_set(data, kvs);
+        if (data->nr_buckets == 0)
+            return NULL;
+
+        struct set_node *node;
+        node = data->buckets[pos->hash & (data->nr_buckets - 1)];
+        for (; node; node = node->hash_next) {
+            if (node->hash == pos->hash && _compare(kvs, node->val, data) == 0)
+                return node;
+        }
+        return NULL;
+    }
+
+    struct rb_node **pnode = &data->elems.rb_node;
     struct rb_node *parent = NULL;
     struct rb_node *entry = NULL;
-    char md5[33];
-    pcvariant_md5_by_set(md5, kvs, set);
 
     while (*pnode) {
         struct set_node *on;
         on = container_of(*pnode, struct set_node, rbnode);
-        int diff;
-        if (0) {
-            diff = variant_set_compare_by_set_keys(set, kvs, on->val);
-        }
-        else if (0) {
-            diff = pcvariant_diff_by_set(md5, kvs, on->md5, on->val, set);
-        }
-        else {
-            diff = _compare(kvs, on->val, data);
-        }
+        int diff = _compare(kvs, on->val, data);
 
         parent = *pnode;
 
@@ -474,21 +501,131 @@ find_element_rb_node(struct element_rb_node *node,
         }
     }
 
-    node->pnode  = pnode;
-    node->parent = parent;
-    node->entry  = entry;
+    pos->pnode  = pnode;
+    pos->parent = parent;
+
+    return entry ? container_of(entry, struct set_node, rbnode) : NULL;
 }
 
 static struct set_node*
 find_element(purc_variant_t set, purc_variant_t kvs)
 {
-    struct element_rb_node node;
-    find_element_rb_node(&node, set, kvs);
+    struct element_pos pos;
+    return locate_element(set, kvs, &pos);
+}
 
-    if (!node.entry)
-        return NULL;
+/* makes room in the hash index for one more member */
+static int
+reserve_bucket(variant_set_t data)
+{
+    size_t count = pcutils_array_list_length(&data->al);
+    if (count < data->nr_buckets)
+        return 0;
+
+    size_t nr_buckets = data->nr_buckets ?
+        data->nr_buckets * 2 : SET_MIN_BUCKETS;
+    struct set_node **buckets;
+    buckets = (struct set_node **)calloc(nr_buckets, sizeof(*buckets));
+    if (!buckets) {
+        pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return -1;
+    }
 
-    return container_of(node.entry, struct set_node, rbnode);
+    for (size_t i = 0; i < data->nr_buckets; i++) {
+        struct set_node *node = data->buckets[i];
+        while (node) {
+            struct set_node *next = node->hash_next;
+            struct set_node **bucket = buckets + (node->hash & (nr_buckets - 1));
+            node->hash_next = *bucket;
+            *bucket = node;
+            node = next;
+        }
+    }
+
+    free(data->buckets);
+    data->buckets = buckets;
+    data->nr_buckets = nr_buckets;
+    return 0;
+}
+
+static void
+link_elem_node(variant_set_t data, struct set_node *node,
+        struct element_pos *pos)
+{
+    if (data->caseless) {
+        pcutils_rbtree_link_node(&node->rbnode, pos->parent, pos->pnode);
+        pcutils_rbtree_insert_color(&node->rbnode, &data->elems);
+        return;
+    }
+
+    PC_ASSERT(data->nr_buckets > 0);
+    struct set_node **bucket;
+    bucket = data->buckets + (pos->hash & (data->nr_buckets - 1));
+    node->hash = pos->hash;
+    node->hash_next = *bucket;
+    *bucket = node;
+
+    // linked into `elems` when the members are traversed in order
+    RB_CLEAR_NODE(&node->rbnode);
+    data->nr_unordered++;
+}
+
+static void
+unlink_elem_node(variant_set_t data, struct set_node *node)
+{
+    if (RB_EMPTY_NODE(&node->rbnode)) {
+        PC_ASSERT(data->nr_unordered > 0);
+        data->nr_unordered--;
+    }
+    else {
+        pcutils_rbtree_erase(&node->rbnode, &data->elems);
+        RB_CLEAR_NODE(&node->rbnode);
+    }
+
+    if (data->caseless)
+        return;
+
+    struct set_node **p;
+    p = data->buckets + (node->hash & (data->nr_buckets - 1));
+    for (; *p; p = &(*p)->hash_next) {
+        if (*p == node) {
+            *p = node->hash_next;
+            break;
+        }
+    }
+    node->hash_next = NULL;
+}
+
+void
+pcvariant_set_order_members(purc_variant_t set)
+{
+    variant_set_t data = pcvar_set_get_data(set);
+    if (!data || data->nr_unordered == 0)
+        return;
+
+    struct pcutils_array_list_node *p;
+    array_list_for_each(&data->al, p) {
+        struct set_node *node = container_of(p, struct set_node, alnode);
+        if (!RB_EMPTY_NODE(&node->rbnode))
+            continue;
+
+        struct rb_node **pnode = &data->elems.rb_node;
+        struct rb_node *parent = NULL;
+        while (*pnode) {
+            struct set_node *on;
+            on = container_of(*pnode, struct set_node, rbnode);
+            parent = *pnode;
+            if (_compare(node->val, on->val, data) < 0)
+                pnode = &parent->rb_left;
+            else
+                pnode = &parent->rb_right;
+        }
+
+        pcutils_rbtree_link_node(&node->rbnode, parent, pnode);
+        pcutils_rbtree_insert_color(&node->rbnode, &data->elems);
+    }
+
+    data->nr_unordered = 0;
 }
 
 static int
@@ -573,7 +710,7 @@ elem_node_remove(purc_variant_t set, struct set_node *node)
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
-    pcutils_rbtree_erase(&node->rbnode, &data->elems);
+    unlink_elem_node(data, node);
 
     int r;
     struct pcutils_array_list_node *old;
@@ -603,7 +740,7 @@ elem_node_destroy(purc_variant_t set, struct set_node *node)
         return;
 
     elem_node_release(set, node);
-    free(node);
+    pcvariant_node_free(node, sizeof(*node));
 }
 
 static int
@@ -658,6 +795,10 @@ variant_set_release(purc_variant_t set, variant_set_t data)
         data->rev_update_chain = NULL;
     }
 
+    free(data->buckets);
+    data->buckets = NULL;
+    data->nr_buckets = 0;
+
     free(data->keynames);
     data->keynames = NULL;
     data->nr_keynames = 0;
@@ -709,14 +850,14 @@ variant_set_create_elem_node(purc_variant_t set, purc_variant_t val)
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
-    struct set_node *_new = (struct set_node*)calloc(1, sizeof(*_new));
+    struct set_node *_new;
+    _new = (struct set_node*)pcvariant_node_alloc(sizeof(*_new));
     if (!_new) {
         pcinst_set_error(PURC_ERROR_OUT_OF_MEMORY);
         return NULL;
     }
 
-    pcvariant_md5_by_set(_new->md5, val, set);
-
+    RB_CLEAR_NODE(&_new->rbnode);
     _new->alnode.idx = (size_t)-1;
     _new->val = val;
     purc_variant_ref(val);
@@ -840,8 +981,7 @@ check_grow(purc_variant_t set, purc_variant_t val)
 
 static int
 insert(purc_variant_t set, variant_set_t data,
-        purc_variant_t val,
-        struct rb_node *parent, struct rb_node **pnode,
+        purc_variant_t val, struct element_pos *pos,
         bool check)
 {
     struct set_node *node = NULL;
@@ -855,6 +995,9 @@ insert(purc_variant_t set, variant_set_t data,
                 break;
         }
 
+        if (!data->caseless && reserve_bucket(data))
+            break;
+
         node = variant_set_create_elem_node(set, val);
         if (!node)
             break;
@@ -868,10 +1011,7 @@ insert(purc_variant_t set, variant_set_t data,
         size_t count = pcutils_array_list_length(&data->al);
         node->alnode.idx = count - 1;
 
-        struct rb_node *entry = &node->rbnode;
-
-        pcutils_rbtree_link_node(entry, parent, pnode);
-        pcutils_rbtree_insert_color(entry, &data->elems);
+        link_elem_node(data, node, pos);
 
         if (check) {
             if (!elem_node_setup_constraints(set, node))
@@ -896,16 +1036,14 @@ pcvar_set_add(purc_variant_t set, purc_variant_t val)
     variant_set_t data = pcvar_set_get_data(set);
     PC_ASSERT(data);
 
-    struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, val);
-
-    if (rbn.entry) {
+    struct element_pos pos;
+    if (locate_element(set, val, &pos)) {
         purc_set_error(PURC_ERROR_DUPLICATED);
         return -1;
     }
 
     bool check = false;
-    return insert(set, data, val, rbn.parent, rbn.pnode, check);
+    return insert(set, data, val, &pos, check);
 }
 
 static int
@@ -961,18 +1099,15 @@ insert_or_replace(purc_variant_t set,
         variant_set_t data, purc_variant_t val, pcvrnt_cr_method_k cr_method,
         bool check)
 {
-    struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, val);
+    struct element_pos pos;
+    struct set_node *curr = locate_element(set, val, &pos);
 
-    if (!rbn.entry) {
-        int r = insert(set, data, val, rbn.parent, rbn.pnode, check);
+    if (!curr) {
+        int r = insert(set, data, val, &pos, check);
 
         return (r == 0) ? 1 : 0;
     }
 
-    struct set_node *curr;
-    curr = container_of(rbn.entry, struct set_node, rbnode);
-
     if (curr->val == val) {
         return 0;
     }
@@ -1399,6 +1534,8 @@ iterator_refresh(struct pcvrnt_set_iterator *it)
         it->prev = NULL;
         return;
     }
+    pcvariant_set_ensure_order(it->set);
+
     struct rb_node *first, *last;
     first = pcutils_rbtree_first(&data->elems);
     last  = pcutils_rbtree_last(&data->elems);
@@ -1437,6 +1574,8 @@ pcvrnt_set_iterator_create_begin(purc_variant_t set)
     }
     it->set = set;
 
+    pcvariant_set_ensure_order(set);
+
     struct rb_node *p;
     p = pcutils_rbtree_first(&data->elems);
     PC_ASSERT(p);
@@ -1470,6 +1609,8 @@ pcvrnt_set_iterator_create_end(purc_variant_t set)
     }
     it->set = set;
 
+    pcvariant_set_ensure_order(set);
+
     struct rb_node *p;
     p = pcutils_rbtree_last(&data->elems);
     PC_ASSERT(p);
@@ -1541,7 +1682,7 @@ pcvariant_set_release(purc_variant_t value)
     PC_ASSERT(data);
 
     variant_set_release(value, data);
-    free(data);
+    pcvariant_node_free(data, sizeof(*data));
     pcv_set_set_data(value, NULL);
 
     pcvariant_stat_set_extra_size(value, 0);
@@ -1609,6 +1750,9 @@ int pcvariant_set_sort(purc_variant_t value, void *ud,
 {
     PC_ASSERT(value != PURC_VARIANT_INVALID);
 
+    if (cmp == NULL && pcvar_sort_by_flags(value, (uintptr_t)ud) == 0)
+        return 0;
+
     variant_set_t data = pcvar_set_get_data(value);
     struct pcutils_array_list *al = &data->al;
 
@@ -1753,6 +1897,7 @@ next_node(struct set_iterator *it, struct set_node *curr)
     }
 
     if (it->it_type == SET_IT_RBTREE) {
+        pcvariant_set_ensure_order(it->set);
         struct rb_node *p = pcutils_rbtree_next(&curr->rbnode);
         if (!p)
             return NULL;
@@ -1787,6 +1932,7 @@ prev_node(struct set_iterator *it, struct set_node *curr)
     }
 
     if (it->it_type == SET_IT_RBTREE) {
+        pcvariant_set_ensure_order(it->set);
         struct rb_node *p = pcutils_rbtree_prev(&curr->rbnode);
         if (!p)
             return NULL;
@@ -1845,6 +1991,7 @@ pcvar_set_it_first(purc_variant_t set, enum set_it_type it_type)
         curr = container_of(alnode, struct set_node, alnode);
     }
     else if (it_type == SET_IT_RBTREE) {
+        pcvariant_set_ensure_order(set);
         struct rb_node *p = pcutils_rbtree_first(root);
         PC_ASSERT(p);
         curr = container_of(p, struct set_node, rbnode);
@@ -1890,6 +2037,7 @@ pcvar_set_it_last(purc_variant_t set, enum set_it_type it_type)
         curr = container_of(alnode, struct set_node, alnode);
     }
     else if (it_type == SET_IT_RBTREE) {
+        pcvariant_set_ensure_order(set);
         struct rb_node *p = pcutils_rbtree_last(root);
         PC_ASSERT(p);
         curr = container_of(p, struct set_node, rbnode);
@@ -2126,16 +2274,15 @@ pcvar_readjust_set(purc_variant_t set, struct set_node *node)
     PC_ASSERT(purc_variant_is_set(set));
     variant_set_t data = pcvar_set_get_data(set);
 
-    pcutils_rbtree_erase(&node->rbnode, &data->elems);
-
-    struct element_rb_node rbn;
-    find_element_rb_node(&rbn, set, node->val);
-    PC_ASSERT(rbn.entry == NULL);
+    /* the value of the member has been changed in place */
+    unlink_elem_node(data, node);
 
-    struct rb_node *entry = &node->rbnode;
+    struct element_pos pos;
+    struct set_node *found = locate_element(set, node->val, &pos);
+    PC_ASSERT(found == NULL);
+    UNUSED_VARIABLE(found);
 
-    pcutils_rbtree_link_node(entry, rbn.parent, rbn.pnode);
-    pcutils_rbtree_insert_color(entry, &data->elems);
+    link_elem_node(data, node, &pos);
 
     return 0;
 }
@@ -34,7 +34,7 @@ changed(purc_variant_t tuple, purc_variant_t pos,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return;
 
     purc_variant_t vals[] = { pos, o, n };
@@ -48,7 +48,7 @@ change(purc_variant_t tuple, purc_variant_t pos,
         purc_variant_t o, purc_variant_t n,
         bool check)
 {
-    if (!check)
+    if (!check || pos == PURC_VARIANT_INVALID)
         return true;
 
     purc_variant_t vals[] = { pos, o, n };
@@ -191,16 +191,25 @@ bool purc_variant_tuple_set(purc_variant_t tuple,
 
 
     purc_variant_t old = purc_variant_ref(members[idx]);
-    purc_variant_t pos = purc_variant_make_longint(idx);
+    // the position is only passed to the listeners
+    purc_variant_t pos = PURC_VARIANT_INVALID;
+    if (pcvar_is_observed(tuple)) {
+        pos = purc_variant_make_longint(idx);
+        if (pos == PURC_VARIANT_INVALID) {
+            purc_variant_unref(old);
+            return false;
+        }
+    }
+
     if (!change(tuple, pos, old, value, true)) {
         purc_variant_unref(old);
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
         return false;
     }
 
     if (check_change(tuple, idx, value)) {
         purc_variant_unref(old);
-        purc_variant_unref(pos);
+        PURC_VARIANT_SAFE_CLEAR(pos);
         return false;
     }
 
@@ -211,7 +220,7 @@ bool purc_variant_tuple_set(purc_variant_t tuple,
     changed(tuple, pos, old, value, true);
 
     purc_variant_unref(old);
-    purc_variant_unref(pos);
+    PURC_VARIANT_SAFE_CLEAR(pos);
     return true;
 }
 
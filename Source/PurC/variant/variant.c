@@ -112,6 +112,62 @@ void pcvariant_free(purc_variant *v) {
 }
 #endif
 
+static inline int node_size_class(size_t size)
+{
+    return (int)((size + (1 << NODE_SIZE_CLASS_SHIFT) - 1)
+            >> NODE_SIZE_CLASS_SHIFT) - 1;
+}
+
+void *pcvariant_node_alloc(size_t size)
+{
+    int cls = node_size_class(size);
+    if (cls >= NR_NODE_SIZE_CLASSES)
+        return calloc(1, size);
+
+    struct pcinst *inst = pcinst_current();
+    struct pcvariant_heap *heap = inst ? inst->variant_heap : NULL;
+    if (heap && heap->node_reserved[cls]) {
+        void *node = heap->node_reserved[cls];
+        heap->node_reserved[cls] = *(void **)node;
+        heap->nr_node_reserved[cls]--;
+
+        heap->stat.nr_reserved_nodes--;
+        heap->stat.sz_reserved_nodes -=
+            (size_t)(cls + 1) << NODE_SIZE_CLASS_SHIFT;
+
+        memset(node, 0, size);
+        return node;
+    }
+
+    /* always allocate the full size of the class,
+       so that the block can be reused for any size of the class. */
+    return calloc(1, (size_t)(cls + 1) << NODE_SIZE_CLASS_SHIFT);
+}
+
+void pcvariant_node_free(void *node, size_t size)
+{
+    if (node == NULL)
+        return;
+
+    int cls = node_size_class(size);
+    if (cls < NR_NODE_SIZE_CLASSES) {
+        struct pcinst *inst = pcinst_current();
+        struct pcvariant_heap *heap = inst ? inst->variant_heap : NULL;
+        if (heap && heap->nr_node_reserved[cls] < heap->max_node_reserved) {
+            *(void **)node = heap->node_reserved[cls];
+            heap->node_reserved[cls] = node;
+            heap->nr_node_reserved[cls]++;
+
+            heap->stat.nr_reserved_nodes++;
+            heap->stat.sz_reserved_nodes +=
+                (size_t)(cls + 1) << NODE_SIZE_CLASS_SHIFT;
+            return;
+        }
+    }
+
+    free(node);
+}
+
 purc_atom_t pcvariant_atom_grow;
 purc_atom_t pcvariant_atom_shrink;
 purc_atom_t pcvariant_atom_change;
@@ -176,6 +232,17 @@ static void _cleanup_instance(struct pcinst *inst)
     }
 #endif
 
+    for (int i = 0; i < NR_NODE_SIZE_CLASSES; i++) {
+        while (heap->node_reserved[i]) {
+            void *node = heap->node_reserved[i];
+            heap->node_reserved[i] = *(void **)node;
+            free(node);
+        }
+        heap->nr_node_reserved[i] = 0;
+    }
+    heap->stat.nr_reserved_nodes = 0;
+    heap->stat.sz_reserved_nodes = 0;
+
     assert(heap->v_undefined.refc == 0);
     assert(heap->v_null.refc == 0);
     assert(heap->v_true.refc == 0);
@@ -237,6 +304,9 @@ static int _init_instance(struct pcinst *curr_inst,
     stat->nr_reserved = 0;
     stat->nr_max_reserved = MAX_RESERVED_VARIANTS;
 
+    inst->variant_heap->max_node_reserved = MAX_RESERVED_NODES;
+    stat->nr_max_reserved_nodes = MAX_RESERVED_NODES;
+
 #if !USE(LOOP_BUFFER_FOR_RESERVED)
     INIT_LIST_HEAD(&inst->variant_heap->v_reserved);
 #endif
@@ -1620,37 +1690,63 @@ int purc_variant_compare_ex (purc_variant_t v1,
     return compare;
 }
 
-purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
+/* the eJSON parser handles the extensions and reports the errors */
+static purc_variant_t
+load_from_ejson_stream(purc_rwstream_t stream)
 {
-    if (stream  == NULL) {
-        return PURC_VARIANT_INVALID;
-    }
-
     purc_variant_t value = PURC_VARIANT_INVALID;
     struct pcvcm_node* root = NULL;
     struct pcejson* parser = NULL;
 
-    int ret = pcejson_parse (&root, &parser, stream, PCEJSON_DEFAULT_DEPTH);
-    if (ret != PCEJSON_SUCCESS) {
-        goto ret;
+    if (pcejson_parse (&root, &parser, stream, PCEJSON_DEFAULT_DEPTH) ==
+            PCEJSON_SUCCESS) {
+        value = pcvcm_eval (root, NULL, false);
     }
 
-    value = pcvcm_eval (root, NULL, false);
-
-ret:
     pcvcm_node_destroy (root);
     pcejson_destroy(parser);
     return value;
 }
 
+purc_variant_t purc_variant_load_from_json_stream(purc_rwstream_t stream)
+{
+    if (stream  == NULL) {
+        return PURC_VARIANT_INVALID;
+    }
+
+    /* try the strict JSON fast path first if the stream can be read again
+       from the current position by the eJSON parser */
+    off_t start = purc_rwstream_seek(stream, 0, SEEK_CUR);
+    if (start >= 0) {
+        purc_variant_t value = pcvariant_load_from_strict_json_stream(stream);
+        if (value != PURC_VARIANT_INVALID)
+            return value;
+
+        purc_clr_error();
+        if (purc_rwstream_seek(stream, start, SEEK_SET) != start)
+            return PURC_VARIANT_INVALID;
+    }
+    else {
+        purc_clr_error();
+    }
+
+    return load_from_ejson_stream(stream);
+}
+
 purc_variant_t purc_variant_make_from_json_string(const char* json, size_t sz)
 {
     purc_variant_t value;
+
+    value = pcvariant_make_from_strict_json(json, sz);
+    if (value != PURC_VARIANT_INVALID)
+        return value;
+
+    purc_clr_error();
     purc_rwstream_t rwstream = purc_rwstream_new_from_mem((void*)json, sz);
     if (rwstream == NULL)
         return PURC_VARIANT_INVALID;
 
-    value = purc_variant_load_from_json_stream(rwstream);
+    value = load_from_ejson_stream(rwstream);
     purc_rwstream_destroy(rwstream);
 
     return value;
@@ -2891,29 +2987,17 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
 {
     int diff;
 
-    variant_arr_t ld, rd;
-    ld = (variant_arr_t)l->sz_ptr[1];
-    rd = (variant_arr_t)r->sz_ptr[1];
-    PC_ASSERT(ld);
-    PC_ASSERT(rd);
-
-    struct pcutils_array_list *la = &ld->al;
-    struct pcutils_array_list *ra = &rd->al;
-
-    struct pcutils_array_list_node *lnode = pcutils_array_list_get_first(la);
-    struct pcutils_array_list_node *rnode = pcutils_array_list_get_first(ra);
+    purc_variant_t *members1, *members2;
+    size_t sz1, sz2;
 
-    for (;
-        lnode && rnode;
-        lnode = pcutils_array_list_get(la, lnode->idx + 1),
-        rnode = pcutils_array_list_get(ra, rnode->idx + 1))
-    {
-        struct arr_node *lo, *ro;
-        lo = container_of(lnode, struct arr_node, node);
-        ro = container_of(rnode, struct arr_node, node);
+    members1 = array_members(l, &sz1);
+    members2 = array_members(r, &sz2);
+    PC_ASSERT(members1 || sz1 == 0);
+    PC_ASSERT(members2 || sz2 == 0);
 
-        purc_variant_t lv = lo->val;
-        purc_variant_t rv = ro->val;
+    for (size_t n = 0; n < MIN(sz1, sz2); n++) {
+        purc_variant_t lv = members1[n];
+        purc_variant_t rv = members2[n];
         PC_ASSERT(lv != PURC_VARIANT_INVALID);
         PC_ASSERT(rv != PURC_VARIANT_INVALID);
 
@@ -2922,9 +3006,9 @@ cmp_by_arr(purc_variant_t l, purc_variant_t r,
             return diff;
     }
 
-    if (lnode)
+    if (sz1 > sz2)
         return 1;
-    else if (rnode)
+    else if (sz1 < sz2)
         return -1;
     else
         return 0;
@@ -2942,6 +3026,9 @@ cmp_by_set(purc_variant_t l, purc_variant_t r,
     PC_ASSERT(ld);
     PC_ASSERT(rd);
 
+    pcvariant_set_ensure_order(l);
+    pcvariant_set_ensure_order(r);
+
     struct rb_root *lroot = &ld->elems;
     struct rb_root *rroot = &rd->elems;
     struct rb_node *lnode = pcutils_rbtree_first(lroot);
@@ -3564,148 +3651,157 @@ purc_variant_linear_container_set(purc_variant_t container,
     return false;
 }
 
-static void
-do_stringify_md5(struct stringify_arg *arg, const void *src, size_t len)
-{
-    pcutils_md5_ctxt *ud;
-    ud = (pcutils_md5_ctxt*)(arg->arg);
-
-    if (len == 0)
-        len = strlen(src);
+/* A streaming 64-bit hash over the stringified text of a variant. It stops
+ * at the first null character, as the text comparison does, and does not
+ * depend on how the text is split into chunks. */
+struct text_hasher {
+    uint64_t        h;
+    uint64_t        len;
+    size_t          nr_tail;
+    bool            ended;
+    unsigned char   tail[8];
+};
 
-    pcutils_md5_hash(ud, src, len);
-}
+#define TEXT_HASH_SEED      0x9E3779B97F4A7C15ULL
 
-void pcvariant_md5_ex(char *md5, purc_variant_t val, const char *salt,
-    bool caseless, unsigned int serialize_flags)
+static inline uint64_t
+text_hash_round(uint64_t h, uint64_t block)
 {
-    PC_ASSERT(caseless == false);
-
-    PC_ASSERT(val != PURC_VARIANT_INVALID);
-
-    pcutils_md5_ctxt ud;
-
-    pcutils_md5_begin(&ud);
-
-    struct stringify_arg arg;
-    arg.cb    = do_stringify_md5;
-    arg.arg   = &ud;
-    arg.flags = serialize_flags;
-
-    variant_stringify(&arg, val);
-
-    if (salt)
-        pcutils_md5_hash(&ud, salt, strlen(salt));
-
-    unsigned char md5_digest[PCUTILS_MD5_DIGEST_SIZE];
-    pcutils_md5_end(&ud, md5_digest);
-
-    bool uppercase = true;
-    pcutils_bin2hex(md5_digest, PCUTILS_MD5_DIGEST_SIZE, md5, uppercase);
+    block *= 0xBF58476D1CE4E5B9ULL;
+    block ^= block >> 31;
+    h ^= block;
+    h = (h << 27) | (h >> 37);
+    return h * 0x94D049BB133111EBULL + TEXT_HASH_SEED;
 }
 
-void
-pcvariant_md5_by_set(char *md5, purc_variant_t val, purc_variant_t set)
+static void
+text_hash_update(struct text_hasher *th, const void *src, size_t len)
 {
-    PC_ASSERT(md5);
-    PC_ASSERT(val != PURC_VARIANT_INVALID);
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
-
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
-
-    if (data->unique_key == NULL) {
-        pcvariant_md5(md5, val);
+    if (th->ended)
         return;
-    }
 
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
-
-    if (val->type != PVT(_OBJECT)) {
-        pcvariant_md5(md5, undefined);
-        purc_variant_unref(undefined);
-        return;
+    const unsigned char *p = src;
+    const unsigned char *nul = memchr(p, 0, len);
+    if (nul) {
+        len = nul - p;
+        th->ended = true;
     }
+    th->len += len;
 
-    pcutils_md5_ctxt ud;
-
-    pcutils_md5_begin(&ud);
-
-    struct stringify_arg arg;
-    arg.cb    = do_stringify_md5;
-    arg.arg   = &ud;
-    arg.flags = 0;
+    uint64_t block;
+    if (th->nr_tail) {
+        size_t n = MIN(sizeof(th->tail) - th->nr_tail, len);
+        memcpy(th->tail + th->nr_tail, p, n);
+        th->nr_tail += n;
+        p += n;
+        len -= n;
+        if (th->nr_tail < sizeof(th->tail))
+            return;
 
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t v;
-        v = purc_variant_object_get_by_ckey(val, data->keynames[i]);
-        if (v == PURC_VARIANT_INVALID) {
-            v = undefined;
-        }
-        stringify_kv(&arg, data->keynames[i], v);
+        memcpy(&block, th->tail, sizeof(block));
+        th->h = text_hash_round(th->h, block);
+        th->nr_tail = 0;
     }
 
-    unsigned char md5_digest[PCUTILS_MD5_DIGEST_SIZE];
-    pcutils_md5_end(&ud, md5_digest);
-
-    bool uppercase = true;
-    pcutils_bin2hex(md5_digest, PCUTILS_MD5_DIGEST_SIZE, md5, uppercase);
+    while (len >= sizeof(block)) {
+        memcpy(&block, p, sizeof(block));
+        th->h = text_hash_round(th->h, block);
+        p += sizeof(block);
+        len -= sizeof(block);
+    }
 
-    purc_variant_unref(undefined);
+    if (len) {
+        memcpy(th->tail, p, len);
+        th->nr_tail = len;
+    }
 }
 
-int
-pcvariant_diff_by_set(const char *md5l, purc_variant_t l,
-        const char *md5r, purc_variant_t r, purc_variant_t set)
+static uint64_t
+text_hash_final(struct text_hasher *th)
 {
-    // TODO: https://gitlab.fmsoft.cn/hvml/hvml-docs/-/blob/master/zh/hvml-spec-v1.0-zh.md#21610-%E9%9B%86%E5%90%88%E5%8F%98%E9%87%8F
+    uint64_t block = 0;
+    memcpy(&block, th->tail, th->nr_tail);
 
-    PC_ASSERT(md5l);
-    PC_ASSERT(l != PURC_VARIANT_INVALID);
-    PC_ASSERT(md5r);
-    PC_ASSERT(r != PURC_VARIANT_INVALID);
+    uint64_t h = text_hash_round(th->h, block) ^ th->len;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
 
-    PC_ASSERT(set != PURC_VARIANT_INVALID);
+static void
+do_stringify_hash(struct stringify_arg *arg, const void *src, size_t len)
+{
+    if (len == 0)
+        len = strlen(src);
 
-    int diff;
+    text_hash_update((struct text_hasher*)arg->arg, src, len);
+}
 
-    variant_set_t data = pcvar_set_get_data(set);
-    PC_ASSERT(data);
+static size_t
+u64_to_decimal(char *buf, uint64_t u64)
+{
+    char tmp[24];
+    size_t n = 0;
+    do {
+        tmp[n++] = '0' + (u64 % 10);
+        u64 /= 10;
+    } while (u64);
 
-    if (data->unique_key == NULL) {
-        return pcvariant_diff(l, r);
-    }
+    for (size_t i = 0; i < n; i++)
+        buf[i] = tmp[n - i - 1];
+    return n;
+}
 
-    diff = strcmp(md5l, md5r);
-    if (diff)
-        return diff;
+uint64_t
+pcvariant_hash_text(purc_variant_t val)
+{
+    PC_ASSERT(val != PURC_VARIANT_INVALID);
 
-    purc_variant_t undefined = purc_variant_make_undefined();
-    PC_ASSERT(undefined);
+    struct text_hasher th = { .h = TEXT_HASH_SEED };
+    char buf[24];
+    size_t len;
 
-    for (size_t i=0; i<data->nr_keynames; ++i) {
-        purc_variant_t vl = PURC_VARIANT_INVALID;
-        purc_variant_t vr = PURC_VARIANT_INVALID;
+    switch (val->type) {
+    case PURC_VARIANT_TYPE_EXCEPTION:
+    case PURC_VARIANT_TYPE_ATOMSTRING:
+    case PURC_VARIANT_TYPE_STRING:
+    {
+        const char *str = purc_variant_get_string_const_ex(val, &len);
+        text_hash_update(&th, str, len);
+        break;
+    }
 
-        if (l->type == PVT(_OBJECT))
-            vl = purc_variant_object_get_by_ckey(l, data->keynames[i]);
-        if (r->type == PVT(_OBJECT))
-            vr = purc_variant_object_get_by_ckey(r, data->keynames[i]);
+    case PURC_VARIANT_TYPE_LONGINT:
+        if (val->i64 < 0) {
+            buf[0] = '-';
+            len = 1 + u64_to_decimal(buf + 1, -(uint64_t)val->i64);
+        }
+        else {
+            len = u64_to_decimal(buf, (uint64_t)val->i64);
+        }
+        text_hash_update(&th, buf, len);
+        break;
 
-        if (vl == PURC_VARIANT_INVALID)
-            vl = undefined;
-        if (vr == PURC_VARIANT_INVALID)
-            vr = undefined;
+    case PURC_VARIANT_TYPE_ULONGINT:
+        len = u64_to_decimal(buf, val->u64);
+        text_hash_update(&th, buf, len);
+        break;
 
-        diff = pcvariant_diff(vl, vr);
-        if (diff)
-            break;
+    default:
+    {
+        struct stringify_arg arg;
+        arg.cb    = do_stringify_hash;
+        arg.arg   = &th;
+        arg.flags = 0;
+        variant_stringify(&arg, val);
+        break;
+    }
     }
 
-    purc_variant_unref(undefined);
-
-    return diff;
+    return text_hash_final(&th);
 }
 
 bool pcvariant_is_scalar(purc_variant_t v)
@@ -365,7 +365,7 @@ push_frame(struct pcvcm_eval_ctxt *ctxt, struct pcvcm_eval_node *node,
     frame->node = node->node;
     frame->pos = 0;
     frame->return_pos = return_pos;
-    frame->nr_params = pcvcm_node_children_count(frame->node);
+    frame->nr_params = node->nr_children;
     frame->ops = pcvcm_eval_get_ops_by_node(frame->node);
     frame->args = PURC_VARIANT_INVALID;
     frame->step = STEP_AFTER_PUSH;
@@ -747,46 +747,86 @@ static void assign_idx_cb(struct pctree_node *node,  void *data)
     n->idx = (*idx)++;
 }
 
-static void build_eval_nodes_cb(struct pctree_node *node, void *data)
+static int32_t
+build_plan_children(struct pcvcm_eval_plan *plan, int32_t parent_idx,
+        int32_t pos)
 {
-    struct pcvcm_eval_ctxt *ctxt = (struct pcvcm_eval_ctxt *) data;
-    struct pcvcm_eval_node *p = ctxt->eval_nodes + ctxt->eval_nodes_insert_pos;
-    p->node = (struct pcvcm_node *)node;
-    p->idx = ctxt->eval_nodes_insert_pos;
-    p->result = PURC_VARIANT_INVALID;
-    p->first_child_idx = -1;
-    ctxt->eval_nodes_insert_pos++;
+    struct pcvcm_eval_node *parent = plan->nodes + parent_idx;
+    struct pcvcm_node *child = pcvcm_node_first_child(parent->node);
+    if (!child) {
+        return pos;
+    }
+
+    /* children of a node are laid out contiguously, then each child's own
+     * children follow in order */
+    int32_t first = pos;
+    parent->first_child_idx = first;
+    while (child) {
+        struct pcvcm_eval_node *p = plan->nodes + pos;
+        p->node = child;
+        p->result = PURC_VARIANT_INVALID;
+        p->idx = pos;
+        p->first_child_idx = -1;
+        p->nr_children = pcvcm_node_children_count(child);
+        pos++;
+        child = pcvcm_node_next_child(child);
+    }
+
+    for (int32_t i = first; i < first + parent->nr_children; i++) {
+        pos = build_plan_children(plan, i, pos);
+    }
+    return pos;
 }
 
-static void build_eval_node_children(struct pctree_node *node, void *data)
+static struct pcvcm_eval_plan *
+get_eval_plan(struct pcvcm_node *tree)
 {
-    if (!node->first_child) {
-        return;
+    if (tree->plan) {
+        return tree->plan;
     }
 
-    struct pcvcm_eval_ctxt *ctxt = (struct pcvcm_eval_ctxt *) data;
-    int32_t pos = ctxt->eval_nodes_insert_pos;
-    for (int32_t i = pos - 1 ; i >= 0; i--) {
-        struct pcvcm_eval_node *p = ctxt->eval_nodes + i;
-        if (p->node == (struct pcvcm_node *)node) {
-            p->first_child_idx = pos;
-            break;
-        }
+    if (tree->nr_nodes == -1) {
+        int idx = 0;
+        pctree_node_level_order_traversal(&tree->tree_node, assign_idx_cb,
+                &idx);
+        tree->nr_nodes = idx;
+    }
+
+    struct pcvcm_eval_plan *plan = (struct pcvcm_eval_plan *)malloc(
+            sizeof(*plan) + tree->nr_nodes * sizeof(struct pcvcm_eval_node));
+    if (!plan) {
+        purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+        return NULL;
     }
 
-    pctree_node_children_for_each(node, build_eval_nodes_cb, data);
-    pctree_node_children_for_each(node, build_eval_node_children, data);
+    plan->nr_nodes = tree->nr_nodes;
+    struct pcvcm_eval_node *p = plan->nodes;
+    p->node = tree;
+    p->result = PURC_VARIANT_INVALID;
+    p->idx = 0;
+    p->first_child_idx = -1;
+    p->nr_children = pcvcm_node_children_count(tree);
+    build_plan_children(plan, 0, 1);
+
+    tree->plan = plan;
+    return plan;
 }
 
 static void build_eval_nodes(struct pcvcm_eval_ctxt *ctxt,
-        struct pcvcm_node *node)
+        struct pcvcm_eval_plan *plan)
 {
-    struct pcvcm_eval_node *p = ctxt->eval_nodes + ctxt->eval_nodes_insert_pos;
-    p->node = (struct pcvcm_node *)node;
-    p->idx = ctxt->eval_nodes_insert_pos;
-    p->result = PURC_VARIANT_INVALID;
-    ctxt->eval_nodes_insert_pos++;
-    build_eval_node_children(&node->tree_node, ctxt);
+    int32_t offset = ctxt->eval_nodes_insert_pos;
+    struct pcvcm_eval_node *p = ctxt->eval_nodes + offset;
+    memcpy(p, plan->nodes, plan->nr_nodes * sizeof(struct pcvcm_eval_node));
+    if (offset) {
+        for (int32_t i = 0; i < plan->nr_nodes; i++, p++) {
+            p->idx += offset;
+            if (p->first_child_idx != -1) {
+                p->first_child_idx += offset;
+            }
+        }
+    }
+    ctxt->eval_nodes_insert_pos += plan->nr_nodes;
 }
 
 static bool _init_by_env = false;
@@ -807,6 +847,23 @@ is_log_enable()
 }
 
 
+static void
+free_eval_buffers(struct pcvcm_eval_ctxt *ctxt)
+{
+    free(ctxt->eval_nodes);
+    ctxt->eval_nodes = NULL;
+    free(ctxt->frames);
+    ctxt->frames = NULL;
+#ifdef PCVCM_KEEP_NAME
+    free(ctxt->names);
+    ctxt->names = NULL;
+#endif
+}
+
+/* Trees up to this size are evaluated with the eval nodes and frames on
+ * the C stack; larger ones use the heap. */
+#define NR_STACK_EVAL_NODES     32
+
 static int i = 0;
 purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
         struct pcvcm_eval_ctxt **ctxt_out, purc_variant_t args,
@@ -816,6 +873,8 @@ purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
     purc_variant_t result = PURC_VARIANT_INVALID;
     struct pcvcm_eval_ctxt contxt = {0};
     struct pcvcm_eval_ctxt *ctxt = &contxt;
+    struct pcvcm_eval_plan *plan = NULL;
+    bool on_heap = false;
     unsigned int enable_log = is_log_enable();
     int err;
     int32_t nr_nodes = 0;
@@ -833,36 +892,55 @@ purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
         result = silently ? purc_variant_make_undefined() :
             PURC_VARIANT_INVALID;
     }
-    else {
-        if (tree->nr_nodes == -1) {
-            int idx = 0;
-            pctree_node_level_order_traversal(&tree->tree_node, assign_idx_cb,
-                    &idx);
-            tree->nr_nodes = idx;
-        }
-        nr_nodes = tree->nr_nodes;
+    else if ((plan = get_eval_plan(tree))) {
+        nr_nodes = plan->nr_nodes;
     }
 
-    struct pcvcm_eval_node eval_nodes[nr_nodes];
-    struct pcvcm_eval_stack_frame frames[nr_nodes];
+    struct pcvcm_eval_node stack_eval_nodes[NR_STACK_EVAL_NODES];
+    struct pcvcm_eval_stack_frame stack_frames[NR_STACK_EVAL_NODES];
+#ifdef PCVCM_KEEP_NAME
+    const char *stack_names[NR_STACK_EVAL_NODES];
+#endif
+
+    if (nr_nodes > NR_STACK_EVAL_NODES) {
+        ctxt->eval_nodes = (struct pcvcm_eval_node *)malloc(
+                nr_nodes * sizeof(struct pcvcm_eval_node));
+        ctxt->frames = (struct pcvcm_eval_stack_frame *)malloc(
+                nr_nodes * sizeof(struct pcvcm_eval_stack_frame));
+#ifdef PCVCM_KEEP_NAME
+        ctxt->names = (const char **)calloc(nr_nodes, sizeof(char *));
+        if (!ctxt->names) {
+            nr_nodes = 0;
+        }
+#endif
+        if (!ctxt->eval_nodes || !ctxt->frames) {
+            nr_nodes = 0;
+        }
+        if (nr_nodes) {
+            on_heap = true;
+        }
+        else {
+            purc_set_error(PURC_ERROR_OUT_OF_MEMORY);
+            free_eval_buffers(ctxt);
+        }
+    }
+    else if (nr_nodes) {
+        ctxt->eval_nodes = stack_eval_nodes;
+        ctxt->frames = stack_frames;
 #ifdef PCVCM_KEEP_NAME
-    const char *names[nr_nodes];
+        ctxt->names = stack_names;
+        memset(stack_names, 0, sizeof(stack_names));
 #endif
+    }
 
     if (nr_nodes) {
         ctxt->enable_log = enable_log;
         ctxt->node = tree;
         ctxt->frame_idx = -1;
         ctxt->nr_eval_nodes = nr_nodes;
-        ctxt->eval_nodes = eval_nodes;
         ctxt->nr_frames = nr_nodes;
-        ctxt->frames = frames;
-#ifdef PCVCM_KEEP_NAME
-        ctxt->names = names;
-        memset(names, 0, sizeof(names));
-#endif
 
-        build_eval_nodes(ctxt, tree);
+        build_eval_nodes(ctxt, plan);
 
         result = eval_vcm(ctxt->eval_nodes, ctxt, args, find_var, find_var_ctxt, silently,
                 false, false);
@@ -899,10 +977,27 @@ purc_variant_t pcvcm_eval_full(struct pcvcm_node *tree,
     }
 
     if (err && ctxt_out) {
-        *ctxt_out = pcvcm_eval_ctxt_dup(ctxt);
+        if (on_heap) {
+            /* hand the heap buffers over to the context kept for again */
+            *ctxt_out = pcvcm_eval_ctxt_create();
+            if (*ctxt_out) {
+                **ctxt_out = *ctxt;
+                (*ctxt_out)->free_on_destroy = 1;
+            }
+            else {
+                pcvcm_eval_ctxt_destroy(ctxt);
+                free_eval_buffers(ctxt);
+            }
+        }
+        else {
+            *ctxt_out = pcvcm_eval_ctxt_dup(ctxt);
+        }
     }
     else if (ctxt) {
         pcvcm_eval_ctxt_destroy(ctxt);
+        if (on_heap) {
+            free_eval_buffers(ctxt);
+        }
         if (ctxt_out) {
             *ctxt_out = NULL;
         }
@@ -927,12 +1022,6 @@ purc_variant_t pcvcm_eval_again_full(struct pcvcm_node *tree,
 
     if (ctxt) {
         ctxt->enable_log = enable_log;
-        if (ctxt->node->nr_nodes == -1) {
-            int idx = 0;
-            pctree_node_level_order_traversal(&ctxt->node->tree_node, assign_idx_cb,
-                    &idx);
-            tree->nr_nodes = idx;
-        }
 
         /* clear AGAIN error */
         ctxt->err = purc_get_last_error();
@@ -977,14 +1066,12 @@ purc_variant_t pcvcm_eval_sub_expr_full(struct pcvcm_node *tree,
         goto out;
     }
     else {
-        if (tree->nr_nodes == -1) {
-            int idx = 0;
-            pctree_node_level_order_traversal(&tree->tree_node, assign_idx_cb,
-                    &idx);
-            tree->nr_nodes = idx;
+        struct pcvcm_eval_plan *plan = get_eval_plan(tree);
+        if (!plan) {
+            goto out;
         }
 
-        ctxt->nr_eval_nodes = ctxt->nr_eval_nodes + tree->nr_nodes;
+        ctxt->nr_eval_nodes = ctxt->nr_eval_nodes + plan->nr_nodes;
         ctxt->eval_nodes = (struct pcvcm_eval_node *) realloc(ctxt->eval_nodes,
                 ctxt->nr_eval_nodes * sizeof(struct pcvcm_eval_node));
 
@@ -1001,7 +1088,7 @@ purc_variant_t pcvcm_eval_sub_expr_full(struct pcvcm_node *tree,
         }
 
         size_t pos = ctxt->eval_nodes_insert_pos;
-        build_eval_nodes(ctxt, tree);
+        build_eval_nodes(ctxt, plan);
 
         struct pcvcm_eval_stack_frame *frame = push_frame(ctxt,
                 ctxt->eval_nodes + pos, 0);
@@ -83,6 +83,14 @@ struct pcvcm_eval_node {
     purc_variant_t          result;
     int32_t                 idx;
     int32_t                 first_child_idx;
+    int32_t                 nr_children;
+};
+
+/* The flattened layout of a vcm tree: built once per tree and copied into
+ * the eval nodes of every evaluation. */
+struct pcvcm_eval_plan {
+    int32_t                 nr_nodes;
+    struct pcvcm_eval_node  nodes[];
 };
 
 struct pcvcm_eval_stack_frame_ops;
@@ -52,15 +52,6 @@ static
 void pcvcm_node_serialize_to_rwstream(purc_rwstream_t rws,
         struct pcvcm_node *node, bool ignore_string_quoted);
 
-static struct pcvcm_node *
-pcvcm_node_next_child(struct pcvcm_node *node)
-{
-    if (node) {
-        return (struct pcvcm_node *)pctree_node_next(&node->tree_node);
-    }
-    return NULL;
-}
-
 static void
 write_child_node_rwstream_ex(purc_rwstream_t rws, struct pcvcm_node *node,
         bool print_comma, pcvcm_node_handle handle)
@@ -500,6 +500,7 @@ pcvcm_node_destroy_callback(struct pctree_node *n,  void *data)
         ) && node->sz_ptr[1]) {
         free((void*)node->sz_ptr[1]);
     }
+    free(node->plan);
     free(node);
 }
 
@@ -96,6 +96,11 @@ public:
 #if USE(GLIB_EVENT_LOOP)
     WTF_EXPORT_PRIVATE GMainContext* mainContext() const { return m_mainContext.get(); }
     WTF_EXPORT_PRIVATE void setIdleCallback(PurCWTF::Function<void()>&& function);
+    // Stop calling the idle callback until wakeUpIdleCallback() is called
+    // or the timeout expires; a negative or infinite timeout parks it forever.
+    WTF_EXPORT_PRIVATE void parkIdleCallback(Seconds timeout);
+    // Thread-safe; resumes a parked idle callback.
+    WTF_EXPORT_PRIVATE void wakeUpIdleCallback();
     WTF_EXPORT_PRIVATE uintptr_t addFdMonitor(gint fd, GIOCondition condition,
             Function<gboolean(gint, GIOCondition)>&& callback);
     WTF_EXPORT_PRIVATE void removeFdMonitor(uintptr_t handle);
@@ -240,6 +245,7 @@ private:
 
     GRefPtr<GSource> m_idleSource;
     Function<void()> m_idleCallback;
+    std::atomic<bool> m_idleWakeUpPending { false };
 
     Vector<RefPtr<GFdMonitor>> m_fdMonitors;
 #elif USE(GENERIC_EVENT_LOOP)
@@ -71,12 +71,18 @@ RunLoop::RunLoop()
     }, this, nullptr);
     g_source_attach(m_source.get(), m_mainContext.get());
 
-    m_idleSource = adoptGRef(g_idle_source_new());
+    // The idle source is driven by its ready time rather than being a plain
+    // idle source, so that the callback can be parked while there is nothing
+    // to do and resumed from any thread.
+    m_idleSource = adoptGRef(g_source_new(&runLoopSourceFunctions, sizeof(GSource)));
     g_source_set_priority(m_idleSource.get(), RunLoopSourcePriority::RunLoopDispatcher);
     g_source_set_name(m_idleSource.get(), "[PurCFetcher] RunLoop idle");
     g_source_set_can_recurse(m_idleSource.get(), TRUE);
     g_source_set_callback(m_idleSource.get(), [](gpointer userData) -> gboolean {
         RunLoop* runloop = static_cast<RunLoop*>(userData);
+        // Keep being called on every iteration unless the callback parks.
+        g_source_set_ready_time(runloop->m_idleSource.get(), 0);
+        runloop->m_idleWakeUpPending.store(false);
         if (runloop->m_idleCallback) {
             runloop->m_idleCallback();
         }
@@ -101,10 +107,29 @@ void RunLoop::setIdleCallback(PurCWTF::Function<void()>&& function)
     RunLoop& runloop = RunLoop::current();
     runloop.m_idleCallback = WTFMove(function);
     if (runloop.m_idleCallback && runloop.m_idleSource->context == NULL) {
+        g_source_set_ready_time(runloop.m_idleSource.get(), 0);
         g_source_attach(runloop.m_idleSource.get(), runloop.m_mainContext.get());
     }
 }
 
+void RunLoop::parkIdleCallback(Seconds timeout)
+{
+    gint64 readyTime = -1;
+    if (timeout >= 0_s && std::isfinite(timeout))
+        readyTime = g_get_monotonic_time() + timeout.microsecondsAs<gint64>();
+    g_source_set_ready_time(m_idleSource.get(), readyTime);
+
+    // A wake-up request may have raced with the decision to park.
+    if (m_idleWakeUpPending.exchange(false))
+        g_source_set_ready_time(m_idleSource.get(), 0);
+}
+
+void RunLoop::wakeUpIdleCallback()
+{
+    m_idleWakeUpPending.store(true);
+    g_source_set_ready_time(m_idleSource.get(), 0);
+}
+
 uintptr_t RunLoop::addFdMonitor(gint fd, GIOCondition condition,
             Function<gboolean(gint, GIOCondition)>&& callback)
 {
@@ -26,8 +26,12 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <strings.h>
 #include <gtest/gtest.h>
 
+#include <string>
+#include <vector>
+
 static const char *html_contents = ""
 "<!DOCTYPE HTML PUBLIC \"-//W3C//DTD HTML 4.01//EN\">"
 ""
@@ -668,3 +672,256 @@ TEST(document, elem_coll_by_id)
 }
 
 
+
+static ssize_t
+count_by_query(purc_document_t doc, pcdoc_element_t ancestor, const char *sel)
+{
+    pcdoc_selector_t selector = pcdoc_document_get_selector(doc, sel);
+    if (selector == nullptr)
+        return -1;
+
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_descendants(doc,
+            ancestor, selector);
+    ssize_t count = pcdoc_elem_coll_count(doc, coll);
+    pcdoc_elem_coll_delete(doc, coll);
+    pcdoc_selector_delete(selector);
+    return count;
+}
+
+TEST(document, elem_coll_indexed)
+{
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html_contents, strlen(html_contents));
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_selector_t s1 = pcdoc_document_get_selector(doc, "li.tocline1");
+    pcdoc_selector_t s2 = pcdoc_document_get_selector(doc, "li.tocline1");
+    ASSERT_NE(s1, nullptr);
+    ASSERT_EQ(s1, s2);
+    pcdoc_selector_delete(s1);
+    pcdoc_selector_delete(s2);
+
+    const char *sels[] = { "li", ".tocline1", "LI.TOCLINE1", "a", "ul li",
+        "*", "div#foo", ".nothing" };
+
+    // the first query walks the tree, the second one uses the index
+    ssize_t counts[PCA_TABLESIZE(sels)];
+    for (size_t i = 0; i < PCA_TABLESIZE(sels); i++) {
+        counts[i] = count_by_query(doc, NULL, sels[i]);
+        ASSERT_GE(counts[i], 0);
+    }
+    ASSERT_EQ(counts[1], 26);
+    for (size_t i = 0; i < PCA_TABLESIZE(sels); i++) {
+        ASSERT_EQ(count_by_query(doc, NULL, sels[i]), counts[i]) << sels[i];
+    }
+
+    // the index is limited to the descendants of the ancestor
+    pcdoc_selector_t selector = pcdoc_selector_new(".tocline1");
+    pcdoc_element_t first = pcdoc_find_element_in_document(doc, selector);
+    ASSERT_NE(first, nullptr);
+    pcdoc_selector_delete(selector);
+    ASSERT_EQ(count_by_query(doc, first, ".tocline1"), 1);
+    ASSERT_EQ(count_by_query(doc, first, ".tocline1"), 1);
+
+    // the index follows the changes of the document
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+    pcdoc_element_t li = pcdoc_element_new_element(doc, body,
+            PCDOC_OP_APPEND, "li", false);
+    ASSERT_NE(li, nullptr);
+    pcdoc_element_set_attribute(doc, li, PCDOC_OP_DISPLACE,
+            "class", "tocline1", 0);
+
+    ASSERT_EQ(count_by_query(doc, NULL, ".tocline1"), counts[1] + 1);
+    ASSERT_EQ(count_by_query(doc, NULL, ".tocline1"), counts[1] + 1);
+    ASSERT_EQ(count_by_query(doc, NULL, "li"), counts[0] + 1);
+
+    unsigned int refc = purc_document_delete(doc);
+    ASSERT_EQ(refc, 1);
+}
+
+struct walk_matched {
+    const char *tag;
+    const char *klass;
+    std::vector<pcdoc_element_t> elems;
+};
+
+static int
+walk_matched_cb(purc_document_t doc, pcdoc_element_t element, void *ctxt)
+{
+    struct walk_matched *data = (struct walk_matched *)ctxt;
+    const char *name;
+    size_t len;
+    bool found = true;
+
+    if (data->tag) {
+        pcdoc_element_get_tag_name(doc, element, &name, &len,
+                NULL, NULL, NULL, NULL);
+        found = (strlen(data->tag) == len &&
+                strncasecmp(name, data->tag, len) == 0);
+    }
+    else {
+        pcdoc_element_has_class(doc, element, data->klass, &found);
+    }
+
+    if (found)
+        data->elems.push_back(element);
+    return PCDOC_TRAVEL_GOON;
+}
+
+/* checks a query has the same elements as walking the tree */
+static void
+expect_same_as_walk(purc_document_t doc, const char *tag, const char *klass)
+{
+    struct walk_matched data = { tag, klass, {} };
+    pcdoc_travel_descendant_elements(doc, NULL, walk_matched_cb, &data, NULL);
+
+    std::string sel = tag ? std::string(tag) : std::string(".") + klass;
+    pcdoc_selector_t selector = pcdoc_document_get_selector(doc, sel.c_str());
+    ASSERT_NE(selector, nullptr);
+
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_descendants(doc,
+            NULL, selector);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, coll), (ssize_t)data.elems.size())
+        << sel;
+    for (size_t i = 0; i < data.elems.size(); i++) {
+        ASSERT_EQ(pcdoc_elem_coll_get(doc, coll, i), data.elems[i])
+            << sel << ": " << i;
+    }
+
+    pcdoc_elem_coll_delete(doc, coll);
+    pcdoc_selector_delete(selector);
+}
+
+TEST(document, elem_coll_indexed_changed)
+{
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html_contents, strlen(html_contents));
+    ASSERT_NE(doc, nullptr);
+
+    // the second query builds the index, which is patched from now on
+    ASSERT_EQ(count_by_query(doc, NULL, ".tocline1"), 26);
+    ASSERT_EQ(count_by_query(doc, NULL, ".tocline1"), 26);
+
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+    pcdoc_element_t li = pcdoc_element_new_element(doc, body,
+            PCDOC_OP_APPEND, "li", false);
+    ASSERT_NE(li, nullptr);
+    expect_same_as_walk(doc, "li", NULL);
+    pcdoc_element_set_attribute(doc, li, PCDOC_OP_DISPLACE,
+            "class", "tocline1 other", 0);
+    expect_same_as_walk(doc, NULL, "tocline1");
+    expect_same_as_walk(doc, NULL, "other");
+
+    // the elements of new contents are kept in document order
+    pcdoc_element_new_content(doc, body, PCDOC_OP_PREPEND,
+            "<ul><li class=\"tocline1\">a</li><li>b</li></ul>"
+            "<p class=\"tocline1 tocline1\">c</p>", 0);
+    expect_same_as_walk(doc, NULL, "tocline1");
+    expect_same_as_walk(doc, "li", NULL);
+    expect_same_as_walk(doc, "p", NULL);
+
+    // the old classes are dropped
+    pcdoc_selector_t selector = pcdoc_selector_new(".tocline1");
+    pcdoc_element_t first = pcdoc_find_element_in_document(doc, selector);
+    ASSERT_NE(first, nullptr);
+    pcdoc_selector_delete(selector);
+    pcdoc_element_set_attribute(doc, first, PCDOC_OP_DISPLACE,
+            "class", "other", 0);
+    expect_same_as_walk(doc, NULL, "tocline1");
+    expect_same_as_walk(doc, NULL, "other");
+
+    // the erased elements and their descendants are removed
+    pcdoc_element_erase(doc, li);
+    pcdoc_node node = pcdoc_element_first_child(doc, body);
+    ASSERT_EQ(node.type, PCDOC_NODE_ELEMENT);
+    pcdoc_element_erase(doc, node.elem);
+    expect_same_as_walk(doc, NULL, "tocline1");
+    expect_same_as_walk(doc, NULL, "other");
+    expect_same_as_walk(doc, "li", NULL);
+
+    pcdoc_element_clear(doc, body);
+    expect_same_as_walk(doc, NULL, "tocline1");
+    expect_same_as_walk(doc, "li", NULL);
+
+    purc_document_unref(doc);
+}
+
+/* checks the live collection has the same elements as a new query */
+static void
+expect_same_as_query(purc_document_t doc, pcdoc_elem_coll_t live,
+        const char *sel)
+{
+    pcdoc_selector_t selector = pcdoc_document_get_selector(doc, sel);
+    ASSERT_NE(selector, nullptr);
+
+    pcdoc_elem_coll_t coll = pcdoc_elem_coll_new_from_descendants(doc,
+            NULL, selector);
+    ssize_t count = pcdoc_elem_coll_count(doc, coll);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count) << sel;
+    for (ssize_t i = 0; i < count; i++) {
+        ASSERT_EQ(pcdoc_elem_coll_get(doc, live, i),
+                pcdoc_elem_coll_get(doc, coll, i)) << sel << ": " << i;
+    }
+
+    pcdoc_elem_coll_delete(doc, coll);
+    pcdoc_selector_delete(selector);
+}
+
+TEST(document, elem_coll_live)
+{
+    purc_document_t doc = purc_document_load(PCDOC_K_TYPE_HTML,
+            html_contents, strlen(html_contents));
+    ASSERT_NE(doc, nullptr);
+
+    pcdoc_selector_t selector = pcdoc_document_get_selector(doc, ".tocline1");
+    pcdoc_elem_coll_t live = pcdoc_elem_coll_new_from_descendants(doc,
+            NULL, selector);
+    pcdoc_selector_delete(selector);
+    ssize_t count = pcdoc_elem_coll_count(doc, live);
+    ASSERT_EQ(count, 26);
+
+    // appended elements are matched when their classes change
+    pcdoc_element_t body = purc_document_body(doc);
+    ASSERT_NE(body, nullptr);
+    pcdoc_element_t li = pcdoc_element_new_element(doc, body,
+            PCDOC_OP_APPEND, "li", false);
+    ASSERT_NE(li, nullptr);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count);
+    pcdoc_element_set_attribute(doc, li, PCDOC_OP_DISPLACE,
+            "class", "tocline1", 0);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count + 1);
+    ASSERT_EQ(pcdoc_elem_coll_get(doc, live, count), li);
+    expect_same_as_query(doc, live, ".tocline1");
+
+    // the elements of new contents are kept in document order
+    pcdoc_element_new_content(doc, body, PCDOC_OP_PREPEND,
+            "<ul><li class=\"tocline1\">a</li><li>b</li></ul>"
+            "<p class=\"tocline1\">c</p>", 0);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count + 3);
+    expect_same_as_query(doc, live, ".tocline1");
+
+    pcdoc_element_t first = pcdoc_elem_coll_get(doc, live, 0);
+    pcdoc_element_t second = pcdoc_elem_coll_get(doc, live, 1);
+    pcdoc_element_new_element(doc, first, PCDOC_OP_INSERTAFTER, "p", false);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count + 3);
+    pcdoc_element_set_attribute(doc, first, PCDOC_OP_DISPLACE,
+            "class", "other", 0);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count + 2);
+    ASSERT_EQ(pcdoc_elem_coll_get(doc, live, 0), second);
+    expect_same_as_query(doc, live, ".tocline1");
+
+    // the erased elements are removed
+    pcdoc_element_erase(doc, second);
+    pcdoc_element_erase(doc, li);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), count);
+    expect_same_as_query(doc, live, ".tocline1");
+
+    pcdoc_element_clear(doc, body);
+    ASSERT_EQ(pcdoc_elem_coll_count(doc, live), 0);
+    expect_same_as_query(doc, live, ".tocline1");
+
+    pcdoc_elem_coll_delete(doc, live);
+    purc_document_unref(doc);
+}
@@ -136,3 +136,106 @@ TEST(exe_key, files)
     ASSERT_TRUE(ok);
 }
 
+
+TEST(exe_key, iterate_same_rule)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_key",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_variant_t obj = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+            PURC_VARIANT_INVALID);
+    const char *keys[] = { "a", "b", "c" };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        purc_variant_object_set_by_static_ckey(obj, keys[i], v);
+        purc_variant_unref(v);
+    }
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("KEY", &ops));
+
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_ITERATE, obj, true);
+    ASSERT_NE(inst, nullptr);
+
+    const char *rule = "KEY: ALL";
+    size_t nr = 0;
+    purc_exec_iter_t it = ops->it_begin(inst, rule);
+    ASSERT_NE(it, nullptr);
+    ASSERT_NE(inst->rule, nullptr);
+    const char *parsed = inst->rule;
+    for (; it; it = ops->it_next(inst, it, rule)) {
+        ASSERT_NE(ops->it_value(inst, it), PURC_VARIANT_INVALID);
+        // the same rule is not parsed again
+        ASSERT_EQ(inst->rule, parsed);
+        nr++;
+    }
+    ASSERT_EQ(nr, PCA_TABLESIZE(keys));
+
+    ops->destroy(inst);
+    purc_variant_unref(obj);
+
+    ASSERT_TRUE(purc_cleanup());
+}
+
+TEST(exe_key, choose_after_input_changed)
+{
+    purc_instance_extra_info info = {};
+    int r = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test", "exe_key",
+            &info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    purc_variant_t obj = purc_variant_make_object(0, PURC_VARIANT_INVALID,
+            PURC_VARIANT_INVALID);
+    const char *keys[] = { "a", "b", "c" };
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        purc_variant_object_set_by_static_ckey(obj, keys[i], v);
+        purc_variant_unref(v);
+    }
+
+    purc_exec_ops_t ops;
+    ASSERT_TRUE(purc_get_executor("KEY", &ops));
+
+    purc_exec_inst_t inst = ops->create(PURC_EXEC_TYPE_CHOOSE, obj, true);
+    ASSERT_NE(inst, nullptr);
+
+    const char *rule = "KEY: ALL FOR VALUE";
+    size_t sz = 0;
+    purc_variant_t vals = ops->choose(inst, rule);
+    ASSERT_NE(vals, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_array_size(vals, &sz));
+    ASSERT_EQ(sz, (size_t)3);
+    purc_variant_unref(vals);
+    const char *parsed = inst->rule;
+
+    // a member added in between is seen by the next round
+    purc_variant_t v = purc_variant_make_longint(3);
+    purc_variant_object_set_by_static_ckey(obj, "d", v);
+    purc_variant_unref(v);
+
+    vals = ops->choose(inst, rule);
+    ASSERT_NE(vals, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_array_size(vals, &sz));
+    ASSERT_EQ(sz, (size_t)4);
+    purc_variant_unref(vals);
+    // while the rule is not parsed again
+    ASSERT_EQ(inst->rule, parsed);
+
+    // and so are the removed ones
+    for (size_t i = 0; i < PCA_TABLESIZE(keys); i++)
+        purc_variant_object_remove_by_ckey(obj, keys[i], false);
+
+    vals = ops->choose(inst, rule);
+    ASSERT_NE(vals, PURC_VARIANT_INVALID);
+    int64_t i64 = 0;
+    ASSERT_TRUE(purc_variant_cast_to_longint(vals, &i64, false));
+    ASSERT_EQ(i64, 3);
+    purc_variant_unref(vals);
+
+    ops->destroy(inst);
+    purc_variant_unref(obj);
+
+    ASSERT_TRUE(purc_cleanup());
+}
@@ -22,6 +22,8 @@
 #include "TestExtDVObj.h"
 #include "../helpers.h"
 
+#include <string>
+
 TEST(dvobjs, basic)
 {
     purc_instance_extra_info info = {};
@@ -45,3 +47,65 @@ TEST(dvobjs, hee)
     tester.run_testcases_in_file("sqlite");
 }
 
+
+/* five rows in chunks of two: three `sqlite:rows` events, then `sqlite:done` */
+static const char *query_hvml =
+    "<!DOCTYPE hvml SYSTEM 'v: SQLITE'>"
+    "<hvml target=\"void\">"
+    "  <body>"
+    "    <init as=\"conn\" with=\"$SQLITE.connect(':memory:')\" />"
+    "    <init as=\"cursor\" with=\"$conn.cursor()\" />"
+    "    <init as=\"firsts\" with=\"[]\" />"
+    "    <inherit>"
+    "        $cursor.execute('CREATE TABLE t (id integer)')"
+    "    </inherit>"
+    "    <inherit>"
+    "        $cursor.executemany('INSERT INTO t (id) VALUES (?)',"
+    "            [[1L], [2L], [3L], [4L], [5L]])"
+    "    </inherit>"
+    "    <observe on=\"$cursor\" for=\"sqlite:rows\">"
+    "        <update on=\"$firsts\" to=\"append\" with=\"$?[0][0]\" />"
+    "    </observe>"
+    "    <observe on=\"$cursor\" for=\"sqlite:done\">"
+    "        <exit with=\"$DATA.count($firsts): $firsts[0] $firsts[1] "
+    "$firsts[2] $?.rowcount\" />"
+    "    </observe>"
+    "    <inherit>"
+    "        $cursor.query('SELECT id FROM t ORDER BY id', null, 2)"
+    "    </inherit>"
+    "  </body>"
+    "</hvml>";
+
+static std::string query_result;
+
+static int query_cond_handler(purc_cond_k event, purc_coroutine_t cor,
+        void *data)
+{
+    (void)cor;
+    if (event == PURC_COND_COR_EXITED) {
+        struct purc_cor_exit_info *info = (struct purc_cor_exit_info *)data;
+        const char *result = NULL;
+        if (info->result && purc_variant_is_string(info->result)) {
+            result = purc_variant_get_string_const(info->result);
+        }
+        query_result = result ? result : "";
+    }
+
+    return 0;
+}
+
+TEST(dvobjs, query_events)
+{
+    setenv(PURC_ENVV_DVOBJS_PATH, SOPATH, 1);
+
+    PurCInstance purc(false);
+    ASSERT_TRUE(purc);
+
+    purc_vdom_t vdom = purc_load_hvml_from_string(query_hvml);
+    ASSERT_NE(vdom, nullptr);
+    ASSERT_NE(purc_schedule_vdom_null(vdom), nullptr);
+
+    query_result.clear();
+    purc_run((purc_cond_handler)query_cond_handler);
+    ASSERT_EQ(query_result, "3: 1 3 5 -1");
+}
@@ -31,6 +31,8 @@
 #include <gtest/gtest.h>
 #include <wtf/RunLoop.h>
 
+#include <string>
+
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -171,3 +173,67 @@ TEST(local_fetcher, async)
     purc_cleanup();
 #endif                        /* } */
 }
+
+static void write_file(const char *file, const char *content)
+{
+    FILE *fp = fopen(file, "wb");
+    ASSERT_NE(fp, nullptr);
+    fwrite(content, strlen(content), 1, fp);
+    fclose(fp);
+}
+
+static std::string fetch_file(struct pcfetcher_session *session,
+        const char *url, int *ret_code)
+{
+    struct pcfetcher_resp_header resp_header = {};
+    purc_rwstream_t resp = pcfetcher_request_sync(session, url,
+            PCFETCHER_METHOD_GET, NULL, 10, &resp_header);
+
+    std::string content;
+    *ret_code = resp_header.ret_code;
+    if (resp) {
+        char buf[64];
+        ssize_t nr;
+        while ((nr = purc_rwstream_read(resp, buf, sizeof(buf))) > 0)
+            content.append(buf, nr);
+        purc_rwstream_destroy(resp);
+    }
+    if (resp_header.mime_type) {
+        free(resp_header.mime_type);
+    }
+    return content;
+}
+
+TEST(local_fetcher, sync_cache_validation)
+{
+    purc_instance_extra_info info = {};
+    int ret = purc_init_ex(PURC_MODULE_HVML, "cn.fmsoft.hvml.test",
+            "local_fetcher", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *file = "/tmp/test_local_fetcher.json";
+    const char *url = "file:///tmp/test_local_fetcher.json";
+    struct pcfetcher_session *session = pcfetcher_session_create(NULL);
+    ASSERT_NE(session, nullptr);
+
+    int ret_code = 0;
+    write_file(file, "[1, 2, 3]");
+    ASSERT_EQ(fetch_file(session, url, &ret_code), "[1, 2, 3]");
+    ASSERT_EQ(ret_code, 200);
+
+    // served from the cache
+    ASSERT_EQ(fetch_file(session, url, &ret_code), "[1, 2, 3]");
+    ASSERT_EQ(ret_code, 200);
+
+    // the cached content must not survive a change of the file
+    write_file(file, "{ \"a\": 1 }");
+    ASSERT_EQ(fetch_file(session, url, &ret_code), "{ \"a\": 1 }");
+    ASSERT_EQ(ret_code, 200);
+
+    remove(file);
+    ASSERT_EQ(fetch_file(session, url, &ret_code), "");
+    ASSERT_EQ(ret_code, 404);
+
+    pcfetcher_session_destroy(session);
+    purc_cleanup();
+}
@@ -0,0 +1,146 @@
+/*
+** Copyright (C) 2022 FMSoft <https://www.fmsoft.cn>
+**
+** This file is a part of PurC (short for Purring Cat), an HVML interpreter.
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU Lesser General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU Lesser General Public License for more details.
+**
+** You should have received a copy of the GNU Lesser General Public License
+** along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "purc/purc.h"
+
+#include <gtest/gtest.h>
+
+/* private/msg-queue.h needs C11 atomics; declare what we use here */
+extern "C" {
+struct pcinst_msg_queue;
+
+struct pcinst_msg_queue *
+pcinst_msg_queue_create(void);
+
+ssize_t
+pcinst_msg_queue_destroy(struct pcinst_msg_queue *queue);
+
+int
+pcinst_msg_queue_append(struct pcinst_msg_queue *queue, pcrdr_msg *msg);
+
+pcrdr_msg *
+pcinst_msg_queue_get_msg(struct pcinst_msg_queue *queue);
+
+size_t
+pcinst_msg_queue_count(struct pcinst_msg_queue *queue);
+}
+
+static pcrdr_msg *
+make_event(purc_variant_t element, pcrdr_msg_event_reduce_opt reduce_opt,
+        int64_t data)
+{
+    pcrdr_msg *msg = pcrdr_make_event_message(
+            PCRDR_MSG_TARGET_COROUTINE,
+            1,
+            "change:grown", NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+
+    msg->reduceOpt = reduce_opt;
+    msg->elementType = PCRDR_MSG_ELEMENT_TYPE_VARIANT;
+    msg->elementValue = purc_variant_ref(element);
+    msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    msg->data = purc_variant_make_longint(data);
+    return msg;
+}
+
+static int64_t
+get_data(const pcrdr_msg *msg)
+{
+    int64_t i64 = 0;
+    purc_variant_cast_to_longint(msg->data, &i64, false);
+    return i64;
+}
+
+static void
+grow(purc_variant_t array)
+{
+    purc_variant_t v = purc_variant_make_null();
+    purc_variant_array_append(array, v);
+    purc_variant_unref(v);
+}
+
+/* the element of the events is a container changed while they are queued */
+TEST(instance, msg_queue_mutated_element)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            "msg_queue", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    struct pcinst_msg_queue *queue = pcinst_msg_queue_create();
+    ASSERT_NE(queue, nullptr);
+
+    purc_variant_t array = purc_variant_make_array_0();
+    purc_variant_t other = purc_variant_make_array_0();
+
+    pcinst_msg_queue_append(queue,
+            make_event(array, PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY, 1));
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 1);
+
+    // reduced into the queued one
+    grow(array);
+    pcinst_msg_queue_append(queue,
+            make_event(array, PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY, 2));
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 1);
+
+    grow(array);
+    pcinst_msg_queue_append(queue,
+            make_event(array, PCRDR_MSG_EVENT_REDUCE_OPT_IGNORE, 3));
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 1);
+
+    // not equal to the queued one
+    pcinst_msg_queue_append(queue,
+            make_event(other, PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY, 4));
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 2);
+
+    grow(array);
+    pcrdr_msg *msg = pcinst_msg_queue_get_msg(queue);
+    ASSERT_NE(msg, nullptr);
+    ASSERT_EQ(msg->elementValue, array);
+    ASSERT_EQ(get_data(msg), 2);
+    pcrdr_release_message(msg);
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 1);
+
+    // the removed event must not be found when reducing a new one
+    pcinst_msg_queue_append(queue,
+            make_event(array, PCRDR_MSG_EVENT_REDUCE_OPT_OVERLAY, 5));
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 2);
+
+    msg = pcinst_msg_queue_get_msg(queue);
+    ASSERT_NE(msg, nullptr);
+    ASSERT_EQ(msg->elementValue, other);
+    ASSERT_EQ(get_data(msg), 4);
+    pcrdr_release_message(msg);
+
+    grow(array);
+    msg = pcinst_msg_queue_get_msg(queue);
+    ASSERT_NE(msg, nullptr);
+    ASSERT_EQ(msg->elementValue, array);
+    ASSERT_EQ(get_data(msg), 5);
+    pcrdr_release_message(msg);
+
+    ASSERT_EQ(pcinst_msg_queue_count(queue), 0);
+    ASSERT_EQ(pcinst_msg_queue_get_msg(queue), nullptr);
+
+    pcinst_msg_queue_destroy(queue);
+    purc_variant_unref(other);
+    purc_variant_unref(array);
+
+    purc_cleanup();
+}
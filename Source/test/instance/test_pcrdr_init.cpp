@@ -59,3 +59,163 @@ TEST(interpreter, purc_init)
 
 
 
+static int
+count_response_handler(pcrdr_conn *conn, const char *request_id, int state,
+        void *context, const pcrdr_msg *response_msg)
+{
+    (void)conn;
+    (void)request_id;
+    (void)response_msg;
+
+    int *nr_results = (int *)context;
+    if (state == PCRDR_RESPONSE_RESULT)
+        (*nr_results)++;
+    return 0;
+}
+
+TEST(pcrdr, pipelined_requests)
+{
+    purc_instance_extra_info extra_info = {};
+    extra_info.renderer_comm = PURC_RDRCOMM_HEADLESS;
+
+    int r = purc_init_ex(PURC_MODULE_PCRDR, "cn.fmsoft.hvml.test",
+            "pipelined", &extra_info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    pcrdr_conn *conn = purc_get_conn_to_renderer();
+    ASSERT_NE(conn, nullptr);
+
+    const size_t max_pending = 4;
+    pcrdr_conn_set_max_pending_requests(conn, max_pending);
+
+    int nr_results = 0;
+    for (int i = 0; i < 10; i++) {
+        pcrdr_msg *msg = pcrdr_make_request_message(
+                PCRDR_MSG_TARGET_SESSION, 0,
+                PCRDR_OPERATION_DESTROYWORKSPACE, NULL, NULL,
+                PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+                PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+        ASSERT_NE(msg, nullptr);
+
+        r = pcrdr_send_request(conn, msg, PCRDR_DEF_TIME_EXPECTED,
+                &nr_results, count_response_handler);
+        pcrdr_release_message(msg);
+        ASSERT_EQ(r, 0);
+        ASSERT_LE(pcrdr_conn_pending_requests_count(conn), max_pending);
+    }
+
+    ASSERT_EQ(pcrdr_wait_pending_requests(conn), 0);
+    ASSERT_EQ(pcrdr_conn_pending_requests_count(conn), 0);
+    ASSERT_EQ(nr_results, 10);
+
+    purc_cleanup();
+}
+
+
+static int
+send_request(pcrdr_conn *conn, pcrdr_msg_target target, uint64_t target_value,
+        const char *operation, pcrdr_msg_element_type element_type,
+        const char *element, pcrdr_msg_data_type data_type,
+        purc_variant_t data, uint64_t *result_value)
+{
+    pcrdr_msg *msg = pcrdr_make_request_message(target, target_value,
+            operation, NULL, NULL, element_type, element, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    if (msg == NULL)
+        return -1;
+
+    msg->dataType = data_type;
+    if (data)
+        msg->data = purc_variant_ref(data);
+
+    pcrdr_msg *response = NULL;
+    int ret_code = -1;
+    if (pcrdr_send_request_and_wait_response(conn, msg,
+                PCRDR_DEF_TIME_EXPECTED, &response) == 0 && response) {
+        ret_code = response->retCode;
+        if (result_value)
+            *result_value = response->resultValue;
+        pcrdr_release_message(response);
+    }
+
+    pcrdr_release_message(msg);
+    return ret_code;
+}
+
+static purc_variant_t
+make_dom_op(const char *operation, const char *element, const char *property)
+{
+    purc_variant_t op = purc_variant_make_object(0,
+            PURC_VARIANT_INVALID, PURC_VARIANT_INVALID);
+    purc_variant_t v;
+
+    v = purc_variant_make_string(operation, false);
+    purc_variant_object_set_by_static_ckey(op, "operation", v);
+    purc_variant_unref(v);
+
+    v = purc_variant_make_string(element, false);
+    purc_variant_object_set_by_static_ckey(op, "element", v);
+    purc_variant_unref(v);
+
+    v = purc_variant_make_string(property, false);
+    purc_variant_object_set_by_static_ckey(op, "property", v);
+    purc_variant_unref(v);
+
+    return op;
+}
+
+TEST(pcrdr, batch_operations)
+{
+    purc_instance_extra_info extra_info = {};
+    extra_info.renderer_comm = PURC_RDRCOMM_HEADLESS;
+
+    int r = purc_init_ex(PURC_MODULE_PCRDR, "cn.fmsoft.hvml.test",
+            "batch", &extra_info);
+    ASSERT_EQ(r, PURC_ERROR_OK);
+
+    pcrdr_conn *conn = purc_get_conn_to_renderer();
+    ASSERT_NE(conn, nullptr);
+
+    uint64_t win = 0;
+    ASSERT_EQ(send_request(conn, PCRDR_MSG_TARGET_WORKSPACE, 0,
+                PCRDR_OPERATION_CREATEPLAINWINDOW, PCRDR_MSG_ELEMENT_TYPE_ID,
+                "batch", PCRDR_MSG_DATA_TYPE_VOID, NULL, &win), PCRDR_SC_OK);
+    ASSERT_NE(win, 0);
+
+    purc_variant_t html = purc_variant_make_string_static(
+            "<html><body><p hvml-handle='2'></p></body></html>", false);
+    uint64_t dom = 0;
+    ASSERT_EQ(send_request(conn, PCRDR_MSG_TARGET_PLAINWINDOW, win,
+                PCRDR_OPERATION_LOAD, PCRDR_MSG_ELEMENT_TYPE_HANDLE, "1",
+                PCRDR_MSG_DATA_TYPE_HTML, html, &dom), PCRDR_SC_OK);
+    purc_variant_unref(html);
+    ASSERT_NE(dom, 0);
+
+    purc_variant_t ops = purc_variant_make_array_0();
+    purc_variant_t op = make_dom_op(PCRDR_OPERATION_UPDATE, "2", "attr.class");
+    purc_variant_array_append(ops, op);
+    purc_variant_unref(op);
+    op = make_dom_op(PCRDR_OPERATION_APPEND, "2", "textContent");
+    purc_variant_array_append(ops, op);
+    purc_variant_unref(op);
+
+    ASSERT_EQ(send_request(conn, PCRDR_MSG_TARGET_DOM, dom,
+                PCRDR_OPERATION_BATCH, PCRDR_MSG_ELEMENT_TYPE_VOID, NULL,
+                PCRDR_MSG_DATA_TYPE_JSON, ops, NULL), PCRDR_SC_OK);
+
+    /* the DOM must exist */
+    ASSERT_EQ(send_request(conn, PCRDR_MSG_TARGET_DOM, dom + 1,
+                PCRDR_OPERATION_BATCH, PCRDR_MSG_ELEMENT_TYPE_VOID, NULL,
+                PCRDR_MSG_DATA_TYPE_JSON, ops, NULL), PCRDR_SC_NOT_FOUND);
+
+    /* only DOM mutations can be batched */
+    op = make_dom_op(PCRDR_OPERATION_CALLMETHOD, "2", "attr.class");
+    purc_variant_array_append(ops, op);
+    purc_variant_unref(op);
+    ASSERT_EQ(send_request(conn, PCRDR_MSG_TARGET_DOM, dom,
+                PCRDR_OPERATION_BATCH, PCRDR_MSG_ELEMENT_TYPE_VOID, NULL,
+                PCRDR_MSG_DATA_TYPE_JSON, ops, NULL), PCRDR_SC_BAD_REQUEST);
+    purc_variant_unref(ops);
+
+    purc_cleanup();
+}
@@ -288,3 +288,109 @@ TEST(instance, threads)
     purc_cleanup();
 }
 
+
+#define NR_PRODUCERS        4
+#define NR_MSGS_PER_PRODUCER 64
+
+static void* producer_thread_entry(void* arg)
+{
+    int nr = (int)(intptr_t)arg;
+    char runner_name[32];
+
+    snprintf(runner_name, sizeof(runner_name), "producer%d", nr);
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            runner_name, NULL);
+    if (ret != PURC_ERROR_OK)
+        return (void *)(intptr_t)-1;
+
+    size_t nr_moved = 0;
+    for (int i = 0; i < NR_MSGS_PER_PRODUCER; i++) {
+        pcrdr_msg *event;
+        event = pcrdr_make_event_message(
+                PCRDR_MSG_TARGET_INSTANCE,
+                nr,
+                "test", NULL,
+                PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+                PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+        event->resultValue = i;
+
+        nr_moved += purc_inst_move_message(main_inst, event);
+        pcrdr_release_message(event);
+    }
+
+    purc_cleanup();
+    return (void *)(intptr_t)nr_moved;
+}
+
+TEST(instance, producers)
+{
+    int ret;
+
+    ret = purc_init_ex(PURC_MODULE_VARIANT, "cn.fmsoft.purc.test",
+            "producers", NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_enable_log(true, false);
+
+    // room for exactly all messages of the producers
+    main_inst = purc_inst_create_move_buffer(0,
+            NR_PRODUCERS * NR_MSGS_PER_PRODUCER);
+    ASSERT_NE(main_inst, 0);
+
+    pthread_t producers[NR_PRODUCERS];
+    for (int i = 0; i < NR_PRODUCERS; i++) {
+        ret = pthread_create(&producers[i], NULL, producer_thread_entry,
+                (void *)(intptr_t)i);
+        ASSERT_EQ(ret, 0);
+    }
+
+    for (int i = 0; i < NR_PRODUCERS; i++) {
+        void *nr_moved;
+        pthread_join(producers[i], &nr_moved);
+        ASSERT_EQ((intptr_t)nr_moved, NR_MSGS_PER_PRODUCER);
+    }
+
+    size_t n;
+    ret = purc_inst_holding_messages_count(&n);
+    ASSERT_EQ(ret, 0);
+    ASSERT_EQ(n, NR_PRODUCERS * NR_MSGS_PER_PRODUCER);
+
+    // the buffer is full
+    pcrdr_msg *event;
+    event = pcrdr_make_event_message(
+            PCRDR_MSG_TARGET_INSTANCE,
+            NR_PRODUCERS,
+            "test", NULL,
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_VOID, NULL, 0);
+    ASSERT_EQ(purc_inst_move_message(main_inst, event), 0);
+    ASSERT_EQ(purc_get_last_error(), PURC_ERROR_TOO_SMALL_BUFF);
+
+    // the messages of every producer arrive in the order they were moved
+    uint64_t next_seq[NR_PRODUCERS] = { };
+    for (size_t i = 0; i < NR_PRODUCERS * NR_MSGS_PER_PRODUCER; i++) {
+        pcrdr_msg *msg = purc_inst_take_away_message(0);
+        ASSERT_NE(msg, nullptr);
+        ASSERT_EQ(msg->target, PCRDR_MSG_TARGET_INSTANCE);
+        ASSERT_LT(msg->targetValue, (uint64_t)NR_PRODUCERS);
+        ASSERT_EQ(msg->resultValue, next_seq[msg->targetValue]);
+        ASSERT_STREQ(purc_variant_get_string_const(msg->eventName), "test");
+
+        next_seq[msg->targetValue]++;
+        pcrdr_release_message(msg);
+    }
+
+    for (int i = 0; i < NR_PRODUCERS; i++) {
+        ASSERT_EQ(next_seq[i], (uint64_t)NR_MSGS_PER_PRODUCER);
+    }
+
+    // taking the messages away frees the room
+    ASSERT_EQ(purc_inst_move_message(main_inst, event), 1);
+    pcrdr_release_message(event);
+
+    n = purc_inst_destroy_move_buffer();
+    ASSERT_EQ(n, 1);
+
+    purc_cleanup();
+}
+
@@ -25,6 +25,12 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
 
 static const char *calculator_1 =
     "<!DOCTYPE hvml>"
@@ -639,3 +645,83 @@ TEST(interpreter, basic)
     purc_run(NULL);
 }
 
+
+/* the target of a batched operation is erased in the same time slice */
+static const char *erase_batched_target =
+    "<hvml target=\"html\">"
+    "    <head>"
+    "        <update on=\"$TIMERS\" to=\"displace\">"
+    "            ["
+    "                { \"id\" : \"tick\", \"interval\" : 10, \"active\" : \"yes\" },"
+    "            ]"
+    "        </update>"
+    "    </head>"
+    ""
+    "    <body>"
+    "        <p id=\"first\">first</p>"
+    "        <p id=\"second\">second</p>"
+    ""
+    "        <observe on=\"$TIMERS\" for=\"expired:tick\">"
+    "            <update on=\"#first\" at=\"attr.class\" with=\"class-before-erase\" />"
+    "            <erase on=\"#first\" />"
+    "            <p id=\"third\">third</p>"
+    "            <update on=\"#second\" at=\"attr.class\" with=\"class-after-erase\" />"
+    "            <update on=\"$TIMERS\" to=\"overwrite\">"
+    "                { \"id\" : \"tick\", \"active\" : \"no\" }"
+    "            </update>"
+    "            <forget on=\"$TIMERS\" for=\"expired:tick\"/>"
+    "        </observe>"
+    "    </body>"
+    "</hvml>";
+
+TEST(interpreter, erase_batched_target)
+{
+    const char *log_file = "/tmp/test_attach_rdr_erase_batched.log";
+    unlink(log_file);
+
+    {
+        unsigned int modules = (PURC_MODULE_HVML | PURC_MODULE_PCRDR) &
+            ~PURC_HAVE_FETCHER;
+
+        struct purc_instance_extra_info info = { };
+        info.renderer_comm = PURC_RDRCOMM_HEADLESS;
+        info.renderer_uri = "file:///tmp/test_attach_rdr_erase_batched.log";
+        info.workspace_name = "main";
+
+        PurCInstance purc(modules, "cn.fmsoft.hybridos.test",
+                "test_attach_rdr", &info);
+        ASSERT_TRUE(purc);
+
+        purc_vdom_t vdom = purc_load_hvml_from_string(erase_batched_target);
+        ASSERT_NE(vdom, nullptr);
+
+        purc_renderer_extra_info extra_info = {};
+        extra_info.title = "def_page_title";
+        purc_coroutine_t co = purc_schedule_vdom(vdom,
+                0, PURC_VARIANT_INVALID, PCRDR_PAGE_TYPE_PLAINWIN,
+                "main",         /* target_workspace */
+                NULL,           /* target_group */
+                "def_page",     /* page_name */
+                &extra_info, NULL, NULL);
+        ASSERT_NE(co, nullptr);
+
+        purc_run(NULL);
+    }
+
+    std::ifstream ifs(log_file);
+    ASSERT_TRUE(ifs.is_open());
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    std::string log = ss.str();
+
+    /* the operation on the erased element is sent before the element is
+       freed, so it is neither lost nor mixed up with the new element */
+    size_t before = log.find("class-before-erase");
+    size_t after = log.find("class-after-erase");
+    ASSERT_NE(before, std::string::npos);
+    ASSERT_NE(after, std::string::npos);
+    ASSERT_LT(before, after);
+    ASSERT_LT(log.find(">>>STT", before), after);
+
+    unlink(log_file);
+}
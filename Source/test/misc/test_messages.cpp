@@ -18,6 +18,7 @@
 */
 
 #include "purc/purc.h"
+#include "private/variant.h"
 
 #include <stdio.h>
 #include <errno.h>
@@ -93,3 +94,70 @@ TEST(instance, messages)
     purc_cleanup();
 }
 
+
+TEST(instance, messages_binary)
+{
+    int ret = purc_init_ex(PURC_MODULE_VARIANT, NULL, NULL, NULL);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *json = "{\"id\":\"foo\",\"list\":[1,-2.5,true,null],"
+        "\"text\":\"\\u4e2d\\u6587\"}";
+    pcrdr_msg *msg;
+    msg = pcrdr_make_request_message(PCRDR_MSG_TARGET_SESSION,
+            random(), "to_do_something", NULL, "request-id",
+            PCRDR_MSG_ELEMENT_TYPE_VOID, NULL, NULL,
+            PCRDR_MSG_DATA_TYPE_JSON, json, strlen(json));
+    ASSERT_NE(msg, nullptr);
+
+    /* what the connection does when the renderer accepts binary data */
+    msg->dataType = PCRDR_MSG_DATA_TYPE_BINARY;
+
+    pcrdr_msg *msg_parsed;
+    struct buff_info info_a = { buffer_a, sizeof (buffer_a), 0 };
+    struct buff_info info_b = { buffer_b, sizeof (buffer_b), 0 };
+
+    pcrdr_serialize_message(msg, write_to_buf, &info_a);
+    ASSERT_LT((size_t)info_a.pos, sizeof (buffer_a));
+    buffer_a[info_a.pos] = '\0';
+    ASSERT_NE(strstr(buffer_a, "dataType:binary"), nullptr);
+
+    /* the packet is parsed in place; keep a copy for the truncated one */
+    pcrdr_serialize_message(msg, write_to_buf, &info_b);
+    ASSERT_EQ(info_b.pos, info_a.pos);
+
+    ret = pcrdr_parse_packet(buffer_a, info_a.pos, &msg_parsed);
+    ASSERT_EQ(ret, 0);
+
+    /* the decoded data is handed over as JSON */
+    ASSERT_EQ(msg_parsed->dataType, PCRDR_MSG_DATA_TYPE_JSON);
+    ASSERT_TRUE(purc_variant_is_equal_to(msg->data, msg_parsed->data));
+
+    msg->dataType = PCRDR_MSG_DATA_TYPE_JSON;
+    ret = pcrdr_compare_messages(msg, msg_parsed);
+    ASSERT_EQ(ret, 0);
+
+    pcrdr_release_message(msg_parsed);
+
+    /* a truncated packet is rejected */
+    ret = pcrdr_parse_packet(buffer_b, info_b.pos - 1, &msg_parsed);
+    ASSERT_NE(ret, 0);
+
+    /* a message made from binary data is in the same state as a parsed one */
+    purc_rwstream_t rws = purc_rwstream_new_buffer(32, 0);
+    ASSERT_NE(rws, nullptr);
+    ASSERT_GT(pcvariant_serialize_binary(msg->data, rws), 0);
+    size_t sz;
+    const char *bin = (const char *)purc_rwstream_get_mem_buffer(rws, &sz);
+    msg_parsed = pcrdr_make_event_message(PCRDR_MSG_TARGET_SESSION,
+            random(), "changed", NULL, PCRDR_MSG_ELEMENT_TYPE_VOID,
+            NULL, NULL, PCRDR_MSG_DATA_TYPE_BINARY, bin, sz);
+    ASSERT_NE(msg_parsed, nullptr);
+    ASSERT_EQ(msg_parsed->dataType, PCRDR_MSG_DATA_TYPE_JSON);
+    ASSERT_TRUE(purc_variant_is_equal_to(msg->data, msg_parsed->data));
+    pcrdr_release_message(msg_parsed);
+    purc_rwstream_destroy(rws);
+
+    pcrdr_release_message(msg);
+
+    purc_cleanup();
+}
@@ -30,6 +30,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 
 void create_temp_file(const char* file, const char* buf, size_t buf_len)
@@ -463,6 +464,108 @@ TEST(mem_rwstream, read_utf8_char)
     ASSERT_EQ(ret, 0);
 }
 
+TEST(mem_rwstream, read_utf8_chars)
+{
+    char buf[] = "Th这\xFF测。";
+    size_t buf_len = strlen(buf);
+    uint32_t wcs[16];
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem (buf, buf_len);
+    ASSERT_NE(rws, nullptr);
+
+    // the block is cut in the middle of `这`; it must be completed but
+    // nothing beyond it consumed
+    ssize_t nr = purc_rwstream_read_utf8_chars (rws, wcs, 3);
+    ASSERT_EQ(nr, 3);
+    ASSERT_EQ(wcs[0], 'T');
+    ASSERT_EQ(wcs[1], 'h');
+    ASSERT_EQ(wcs[2], 0x8FD9);
+    ASSERT_EQ(purc_rwstream_tell (rws), 5);
+
+    nr = purc_rwstream_read_utf8_chars (rws, wcs, 16);
+    ASSERT_EQ(nr, 3);
+    ASSERT_EQ(wcs[0], PCRWSTREAM_INVALID_CHAR);
+    ASSERT_EQ(wcs[1], 0x6D4B);
+    ASSERT_EQ(wcs[2], 0x3002);
+
+    nr = purc_rwstream_read_utf8_chars (rws, wcs, 16);
+    ASSERT_EQ(nr, 0);
+
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+
+    // truncated by the end of the stream
+    char trunc[] = "ab\xE6\xB5";
+    rws = purc_rwstream_new_from_mem (trunc, strlen(trunc));
+    ASSERT_NE(rws, nullptr);
+
+    nr = purc_rwstream_read_utf8_chars (rws, wcs, 16);
+    ASSERT_EQ(nr, 3);
+    ASSERT_EQ(wcs[0], 'a');
+    ASSERT_EQ(wcs[1], 'b');
+    ASSERT_EQ(wcs[2], PCRWSTREAM_INVALID_CHAR);
+
+    nr = purc_rwstream_read_utf8_chars (rws, wcs, 16);
+    ASSERT_EQ(nr, 0);
+
+    ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+
+    // long ASCII runs over several blocks, a null byte in a run, and
+    // a character cut by the end of a block
+    char lng[3000];
+    memset(lng, 'a', sizeof(lng));
+    lng[100] = '\0';
+    memcpy(lng + 1023, "\xE8\xBF\x99", 3);
+    rws = purc_rwstream_new_from_mem (lng, sizeof(lng));
+    ASSERT_NE(rws, nullptr);
+
+    uint32_t lwcs[3000];
+    size_t total = 0;
+    while ((nr = purc_rwstream_read_utf8_chars (rws, lwcs + total,
+                    PCA_TABLESIZE(lwcs) - total)) > 0)
+        total += nr;
+    ASSERT_EQ(total, sizeof(lng) - 2);
+    for (size_t i = 0; i < total; i++) {
+        if (i == 100)
+            ASSERT_EQ(lwcs[i], 0u);
+        else if (i == 1023)
+            ASSERT_EQ(lwcs[i], 0x8FD9u);
+        else
+            ASSERT_EQ(lwcs[i], (uint32_t)'a');
+    }
+
+    ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+}
+
+TEST(fd_rwstream, read_utf8_chars_pipe)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    const char data[] = "这是";
+    ASSERT_EQ(write(fds[1], data, strlen(data)), (ssize_t)strlen(data));
+
+    purc_rwstream_t rws = purc_rwstream_new_from_unix_fd (fds[0]);
+    ASSERT_NE(rws, nullptr);
+
+    // a short read returns what is there instead of blocking for more
+    uint32_t wcs[64];
+    ssize_t nr = purc_rwstream_read_utf8_chars (rws, wcs, 64);
+    ASSERT_EQ(nr, 2);
+    ASSERT_EQ(wcs[0], 0x8FD9);
+    ASSERT_EQ(wcs[1], 0x662F);
+
+    close(fds[1]);
+    nr = purc_rwstream_read_utf8_chars (rws, wcs, 64);
+    ASSERT_EQ(nr, 0);
+
+    int ret = purc_rwstream_destroy (rws);
+    ASSERT_EQ(ret, 0);
+    close(fds[0]);
+}
+
 
 TEST(mem_rwstream, seek_tell)
 {
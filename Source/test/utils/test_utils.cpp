@@ -2315,3 +2315,79 @@ TEST(valid_css_identifier, normal)
     r = purc_is_valid_css_identifier(id);
     ASSERT_EQ(r, false);
 }
+
+TEST(utils, check_utf8)
+{
+    std::string s;
+    size_t nr_chars;
+    const char *end;
+
+    // long ASCII runs around multi-byte characters and block boundaries
+    for (size_t i = 0; i < 100; i++)
+        s += "abcdefghijklmnopqrstuvwxyz0123456789"[i % 36];
+    s.insert(37, "\xe4\xb8\xad");       // U+4E2D
+    s.insert(64, "\xc3\xa9");           // U+00E9
+    ASSERT_TRUE(pcutils_string_check_utf8_len(s.c_str(), s.size(),
+                &nr_chars, &end));
+    ASSERT_EQ(nr_chars, 102);
+    ASSERT_EQ(end, s.c_str() + s.size());
+    ASSERT_TRUE(pcutils_string_check_utf8(s.c_str(), -1, &nr_chars, NULL));
+    ASSERT_EQ(nr_chars, 102);
+
+    // a bad byte after a long ASCII run
+    std::string bad = s;
+    bad[90] = '\xff';
+    ASSERT_FALSE(pcutils_string_check_utf8_len(bad.c_str(), bad.size(),
+                &nr_chars, &end));
+    ASSERT_EQ(end, bad.c_str() + 90);
+    ASSERT_EQ(nr_chars, 87);
+    ASSERT_FALSE(pcutils_string_check_utf8(bad.c_str(), -1, NULL, &end));
+    ASSERT_EQ(end, bad.c_str() + 90);
+
+    // the validation stops at a null byte in a long ASCII run
+    std::string nul = s;
+    nul[80] = '\0';
+    ASSERT_FALSE(pcutils_string_check_utf8_len(nul.c_str(), nul.size(),
+                &nr_chars, &end));
+    ASSERT_EQ(end, nul.c_str() + 80);
+    ASSERT_EQ(nr_chars, 77);
+}
+
+// a benchmark; only run when LOOPS is given
+TEST(utils, check_utf8_perf)
+{
+    const char *loops = getenv("LOOPS");
+    if (!loops)
+        return;
+
+    size_t nr_loops = atoll(loops);
+    if (nr_loops <= 0) {
+        nr_loops = 1;
+    }
+
+    const char *samples[] = {
+        "The quick brown fox jumps over the lazy dog. ",
+        "\xe6\xb5\x8b\xe8\xaf\x95\xe4\xb8\xad\xe6\x96\x87 mixed text. ",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(samples); i++) {
+        std::string s;
+        while (s.size() < 1024 * 1024)
+            s += samples[i];
+
+        size_t nr_chars = 0;
+        struct timespec begin, end;
+        clock_gettime(CLOCK_MONOTONIC, &begin);
+        for (size_t n = 0; n < nr_loops; n++) {
+            ASSERT_TRUE(pcutils_string_check_utf8_len(s.c_str(), s.size(),
+                        &nr_chars, NULL));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        double secs = (end.tv_sec - begin.tv_sec) +
+            (end.tv_nsec - begin.tv_nsec) / 1e9;
+        fprintf(stderr, "sample %zu: %zu bytes, %zu chars, %zu loops: "
+                "%.3f MB/s\n", i, s.size(), nr_chars, nr_loops,
+                s.size() * nr_loops / (secs > 0 ? secs : 1e-9) / 1e6);
+    }
+}
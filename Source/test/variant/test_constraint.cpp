@@ -502,6 +502,88 @@ TEST(constraint, set_child_in_different_positions)
     PURC_VARIANT_SAFE_CLEAR(set);
 }
 
+TEST(constraint, set_child_in_different_arrays)
+{
+    PurCInstance purc;
+
+    const char *s;
+    purc_variant_t set, xu, xue, xz, xw;
+    purc_variant_t empty, hello;
+    purc_variant_t val, elem, arr1, arr2;
+    bool silently = true;
+    bool ok;
+
+    s = "{name:[x], extra:foo}";
+    xu = pcejson_parser_parse_string(s, 0, 0);
+    ASSERT_NE(xu, nullptr);
+
+    s = "{name:[y], extra:bar}";
+    xue = pcejson_parser_parse_string(s, 0, 0);
+    ASSERT_NE(xue, nullptr);
+
+    s = "{name:[y,[hello]], extra:baz}";
+    xz = pcejson_parser_parse_string(s, 0, 0);
+    ASSERT_NE(xz, nullptr);
+
+    s = "{name:[x,[hello,hello]], extra:qux}";
+    xw = pcejson_parser_parse_string(s, 0, 0);
+    ASSERT_NE(xw, nullptr);
+
+    set = purc_variant_make_set_by_ckey(4, "name", xu, xue, xz, xw);
+    ASSERT_NE(set, nullptr);
+
+    empty = purc_variant_make_array_0();
+    ASSERT_NE(empty, nullptr);
+
+    val = purc_variant_object_get_by_ckey(xu, "name");
+    elem = purc_variant_set_get_member_by_key_values(set, val, silently);
+    ASSERT_NE(elem, nullptr);
+    arr1 = purc_variant_object_get_by_ckey(elem, "name");
+    ASSERT_NE(arr1, nullptr);
+
+    val = purc_variant_object_get_by_ckey(xue, "name");
+    elem = purc_variant_set_get_member_by_key_values(set, val, silently);
+    ASSERT_NE(elem, nullptr);
+    arr2 = purc_variant_object_get_by_ckey(elem, "name");
+    ASSERT_NE(arr2, nullptr);
+
+    // the same child in two slots of one array, and in another array
+    ASSERT_TRUE(purc_variant_array_append(arr1, empty));
+    ASSERT_TRUE(purc_variant_array_append(arr1, empty));
+    ASSERT_TRUE(purc_variant_array_append(arr2, empty));
+    ASSERT_EQ(0, var_diff(set, "[!name,{name:[x,[],[]], extra:foo},{name:[y,[]], extra:bar},{name:[y,[hello]], extra:baz},{name:[x,[hello,hello]], extra:qux}]"));
+
+    // the child is still held by a slot of the first array
+    ASSERT_TRUE(purc_variant_array_remove(arr1, 1));
+    ASSERT_EQ(0, var_diff(set, "[!name,{name:[x,[]], extra:foo},{name:[y,[]], extra:bar},{name:[y,[hello]], extra:baz},{name:[x,[hello,hello]], extra:qux}]"));
+
+    // the second array would duplicate the key of the last member
+    hello = purc_variant_make_string("hello", true);
+    ASSERT_NE(hello, nullptr);
+    ok = purc_variant_array_append(empty, hello);
+    ASSERT_FALSE(ok);
+    ASSERT_EQ(0, var_diff(set, "[!name,{name:[x,[]], extra:foo},{name:[y,[]], extra:bar},{name:[y,[hello]], extra:baz},{name:[x,[hello,hello]], extra:qux}]"));
+
+    // the edge to the first array is kept when the second one drops it
+    ASSERT_TRUE(purc_variant_array_remove(arr2, 1));
+    ok = purc_variant_array_append(empty, hello);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(0, var_diff(set, "[!name,{name:[x,[hello]], extra:foo},{name:[y], extra:bar},{name:[y,[hello]], extra:baz},{name:[x,[hello,hello]], extra:qux}]"));
+
+    // the first array would duplicate the key of the last member
+    ok = purc_variant_array_append(empty, hello);
+    ASSERT_FALSE(ok);
+    ASSERT_EQ(0, var_diff(set, "[!name,{name:[x,[hello]], extra:foo},{name:[y], extra:bar},{name:[y,[hello]], extra:baz},{name:[x,[hello,hello]], extra:qux}]"));
+
+    PURC_VARIANT_SAFE_CLEAR(hello);
+    PURC_VARIANT_SAFE_CLEAR(empty);
+    PURC_VARIANT_SAFE_CLEAR(xw);
+    PURC_VARIANT_SAFE_CLEAR(xz);
+    PURC_VARIANT_SAFE_CLEAR(xue);
+    PURC_VARIANT_SAFE_CLEAR(xu);
+    PURC_VARIANT_SAFE_CLEAR(set);
+}
+
 TEST(constraint, perf)
 {
     PurCInstance purc;
@@ -20,12 +20,14 @@
 #include "purc/purc.h"
 
 #include "private/ejson.h"
+#include "private/variant.h"
 #include "private/utils.h"
 #include "purc/purc-rwstream.h"
 
 #include "../helpers.h"
 
 #include <stdio.h>
+#include <string>
 #include <gtest/gtest.h>
 
 using namespace std;
@@ -285,3 +287,118 @@ std::vector<ejson_test_data> read_ejson_test_data()
 INSTANTIATE_TEST_SUITE_P(ejson, variant_load_from_json,
         testing::ValuesIn(read_ejson_test_data()));
 
+
+TEST(variant, strict_json_fast_path)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test", "variant",
+            NULL);
+
+    /* strict JSON takes the fast path, the others fall back to eJSON; both
+     * must give what the eJSON parser gives */
+    const char *jsons[] = {
+        "{\"a\": [1, -2.5e3, 0.125, true, false, null], \"b\": {}}",
+        "\"escapes: \\\" \\\\ \\/ \\b \\f \\n \\r \\t \\u00e9\\u4e2d\"",
+        "[\"a long string without any escape, longer than one word\"]",
+        "{\"k\": 1, \"k\": 2}",
+        "  [ [], [[]], {\"x\": [{}]} ]  ",
+        "[1L, 2UL]",
+        "{'single': 'quoted'}",
+        "[0x10]",
+    };
+
+    for (size_t i = 0; i < PCA_TABLESIZE(jsons); i++) {
+        purc_variant_t v = purc_variant_make_from_json_string(jsons[i],
+                strlen(jsons[i]));
+        ASSERT_NE(v, PURC_VARIANT_INVALID) << jsons[i];
+
+        struct purc_ejson_parsing_tree *ptree;
+        ptree = purc_variant_ejson_parse_string(jsons[i], strlen(jsons[i]));
+        ASSERT_NE(ptree, nullptr) << jsons[i];
+        purc_variant_t expected = purc_ejson_parsing_tree_evalute(ptree,
+                NULL, NULL, false);
+        purc_ejson_parsing_tree_destroy(ptree);
+        ASSERT_NE(expected, PURC_VARIANT_INVALID) << jsons[i];
+
+        ASSERT_EQ(purc_variant_compare_ex(v, expected,
+                    PCVRNT_COMPARE_METHOD_AUTO), 0) << jsons[i];
+
+        purc_variant_unref(expected);
+        purc_variant_unref(v);
+    }
+
+    /* bad JSON still reports the error of the eJSON parser */
+    const char *bad = "[1, 2";
+    ASSERT_EQ(purc_variant_make_from_json_string(bad, strlen(bad)),
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(purc_get_last_error(), PURC_ERROR_OK);
+
+    /* only a terminating null character may follow the value */
+    purc_variant_t v = pcvariant_make_from_strict_json("[1] \0", 5);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    purc_variant_unref(v);
+    ASSERT_EQ(pcvariant_make_from_strict_json("[1]\0[2]", 7),
+            PURC_VARIANT_INVALID);
+    ASSERT_EQ(pcvariant_make_from_strict_json("[1]\0\0", 5),
+            PURC_VARIANT_INVALID);
+
+    purc_cleanup();
+}
+
+TEST(variant, strict_json_stream_window)
+{
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test", "variant",
+            NULL);
+
+    /* the strings and the numbers cross the boundaries of the window */
+    std::string json = "[";
+    for (int i = 0; i < 500; i++) {
+        json += "\"item \\u4e2d\\n ";
+        json += std::to_string(i);
+        json += "\", -12345.678e-3, ";
+    }
+    json += "\"";
+    json.append(10000, 'x');
+    json += "\"]";
+
+    purc_variant_t expected = purc_variant_make_from_json_string(
+            json.c_str(), json.length());
+    ASSERT_NE(expected, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_array_get_size(expected), (size_t)1001);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void *)json.c_str(),
+            json.length());
+    purc_variant_t v = pcvariant_load_from_strict_json_stream(rws);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_is_equal_to(v, expected));
+    purc_variant_unref(v);
+    purc_rwstream_destroy(rws);
+
+    rws = purc_rwstream_new_from_mem((void *)json.c_str(), json.length());
+    v = purc_variant_load_from_json_stream(rws);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_is_equal_to(v, expected));
+    purc_variant_unref(v);
+    purc_rwstream_destroy(rws);
+    purc_variant_unref(expected);
+
+    /* the eJSON parser reads the stream again from the start */
+    json.insert(json.length() - 1, ", 1L");
+    expected = purc_variant_make_from_json_string(json.c_str(),
+            json.length());
+    ASSERT_NE(expected, PURC_VARIANT_INVALID);
+
+    rws = purc_rwstream_new_from_mem((void *)json.c_str(), json.length());
+    ASSERT_EQ(pcvariant_load_from_strict_json_stream(rws),
+            PURC_VARIANT_INVALID);
+    purc_rwstream_destroy(rws);
+
+    rws = purc_rwstream_new_from_mem((void *)json.c_str(), json.length());
+    v = purc_variant_load_from_json_stream(rws);
+    ASSERT_NE(v, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_is_equal_to(v, expected));
+    purc_variant_unref(v);
+    purc_rwstream_destroy(rws);
+    purc_variant_unref(expected);
+
+    purc_cleanup();
+}
@@ -995,3 +995,147 @@ TEST(variant, serialize_object_with_empty_key2)
 
     purc_cleanup ();
 }
+
+// to test: the binary encoding keeps the types and values
+TEST(variant, serialize_binary)
+{
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "variant", NULL);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const char *json = "{\"name\":\"PurC\",\"list\":[1,-2.5,true,null,"
+        "{\"k\":\"\\u4e2d\\u6587\"}],\"empty\":{}}";
+    purc_variant_t obj = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(obj, PURC_VARIANT_INVALID);
+
+    purc_variant_t vs[] = {
+        purc_variant_make_longint(-1234567890123LL),
+        purc_variant_make_ulongint(UINT64_MAX),
+        purc_variant_make_longdouble(1.5L),
+        purc_variant_make_byte_sequence("\0\1\2\3", 4),
+        purc_variant_make_byte_sequence_empty(),
+        purc_variant_make_atom_string("atom", false),
+        purc_variant_make_exception(
+                purc_get_except_atom_by_id(PURC_EXCEPT_BAD_ENCODING)),
+        purc_variant_make_undefined(),
+        obj,
+    };
+    purc_variant_t tuple = purc_variant_make_tuple(PCA_TABLESIZE(vs), vs);
+    ASSERT_NE(tuple, PURC_VARIANT_INVALID);
+    for (size_t i = 0; i < PCA_TABLESIZE(vs); i++)
+        purc_variant_unref(vs[i]);
+
+    const char *o1 = "{\"id\":1,\"v\":\"a\"}";
+    const char *o2 = "{\"id\":2,\"v\":\"b\"}";
+    purc_variant_t m1 = purc_variant_make_from_json_string(o1, strlen(o1));
+    purc_variant_t m2 = purc_variant_make_from_json_string(o2, strlen(o2));
+    purc_variant_t set = purc_variant_make_set_by_ckey_ex(2, "id", true,
+            m1, m2);
+    ASSERT_NE(set, PURC_VARIANT_INVALID);
+    purc_variant_unref(m1);
+    purc_variant_unref(m2);
+
+    // members differing only in the second unique key
+    const char *o3 = "{\"id\":1,\"name\":\"a\"}";
+    const char *o4 = "{\"id\":1,\"name\":\"b\"}";
+    purc_variant_t m3 = purc_variant_make_from_json_string(o3, strlen(o3));
+    purc_variant_t m4 = purc_variant_make_from_json_string(o4, strlen(o4));
+    purc_variant_t set2 = purc_variant_make_set_by_ckey_ex(2, "id name",
+            false, m3, m4);
+    ASSERT_NE(set2, PURC_VARIANT_INVALID);
+    ASSERT_EQ(purc_variant_set_get_size(set2), 2);
+    purc_variant_unref(m3);
+    purc_variant_unref(m4);
+
+    purc_variant_t root = purc_variant_make_array(3, tuple, set, set2);
+    ASSERT_NE(root, PURC_VARIANT_INVALID);
+    purc_variant_unref(tuple);
+    purc_variant_unref(set);
+    purc_variant_unref(set2);
+
+    purc_rwstream_t rws = purc_rwstream_new_buffer(32, 0);
+    ASSERT_NE(rws, nullptr);
+    ssize_t n = pcvariant_serialize_binary(root, rws);
+    ASSERT_GT(n, 0);
+    // two values back to back
+    ASSERT_EQ(pcvariant_serialize_binary(root, rws), n);
+
+    size_t sz;
+    const char *buf = (const char *)purc_rwstream_get_mem_buffer(rws, &sz);
+    ASSERT_EQ(sz, (size_t)n * 2);
+
+    size_t consumed = 0;
+    purc_variant_t loaded = pcvariant_load_from_binary(buf, sz, false,
+            &consumed);
+    ASSERT_NE(loaded, PURC_VARIANT_INVALID);
+    ASSERT_EQ(consumed, (size_t)n);
+    ASSERT_TRUE(purc_variant_is_equal_to(root, loaded));
+
+    purc_variant_t t = purc_variant_array_get(loaded, 0);
+    ASSERT_TRUE(purc_variant_is_tuple(t));
+    ASSERT_EQ(purc_variant_tuple_get(t, 2)->type, PURC_VARIANT_TYPE_LONGDOUBLE);
+    ASSERT_EQ(purc_variant_tuple_get(t, 6)->type, PURC_VARIANT_TYPE_EXCEPTION);
+    ASSERT_EQ(purc_variant_tuple_get(t, 7)->type, PURC_VARIANT_TYPE_UNDEFINED);
+    purc_variant_t s = purc_variant_array_get(loaded, 1);
+    ASSERT_TRUE(purc_variant_is_set(s));
+    const char *keys = NULL;
+    ASSERT_TRUE(purc_variant_set_unique_keys(s, &keys));
+    ASSERT_STREQ(keys, "id");
+    s = purc_variant_array_get(loaded, 2);
+    ASSERT_TRUE(purc_variant_is_set(s));
+    ASSERT_EQ(purc_variant_set_get_size(s), 2);
+    // the members are still told apart by both keys
+    purc_variant_t m5 = purc_variant_make_from_json_string(o3, strlen(o3));
+    ASSERT_GE(purc_variant_set_add(s, m5, PCVRNT_CR_METHOD_OVERWRITE), 0);
+    ASSERT_EQ(purc_variant_set_get_size(s), 2);
+    purc_variant_unref(m5);
+    purc_variant_unref(loaded);
+
+    // the strings can refer to the buffer directly
+    loaded = pcvariant_load_from_binary(buf + n, sz - n, true, NULL);
+    ASSERT_NE(loaded, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_is_equal_to(root, loaded));
+    purc_variant_unref(loaded);
+
+    // the stream is read up to the end of each value
+    ASSERT_EQ(purc_rwstream_seek(rws, 0, SEEK_SET), 0);
+    for (int i = 0; i < 2; i++) {
+        loaded = pcvariant_load_from_binary_stream(rws);
+        ASSERT_NE(loaded, PURC_VARIANT_INVALID);
+        ASSERT_TRUE(purc_variant_is_equal_to(root, loaded));
+        purc_variant_unref(loaded);
+    }
+
+    // truncated data fails cleanly at any length
+    for (size_t len = 0; len < (size_t)n; len++) {
+        loaded = pcvariant_load_from_binary(buf, len, false, NULL);
+        ASSERT_EQ(loaded, PURC_VARIANT_INVALID);
+    }
+
+    purc_rwstream_destroy(rws);
+    purc_variant_unref(root);
+
+    // a string with an embedded null character is rejected
+    root = purc_variant_make_string("abcdef", false);
+    rws = purc_rwstream_new_buffer(32, 0);
+    ASSERT_NE(rws, nullptr);
+    n = pcvariant_serialize_binary(root, rws);
+    ASSERT_GT(n, 0);
+    purc_variant_unref(root);
+
+    char *bad = (char *)purc_rwstream_get_mem_buffer(rws, &sz);
+    char *str = (char *)memmem(bad, sz, "abcdef", 6);
+    ASSERT_NE(str, nullptr);
+    str[3] = '\0';
+    for (int i = 0; i < 2; i++) {
+        loaded = pcvariant_load_from_binary(bad, sz, i == 0, NULL);
+        ASSERT_EQ(loaded, PURC_VARIANT_INVALID);
+    }
+    ASSERT_EQ(purc_rwstream_seek(rws, 0, SEEK_SET), 0);
+    loaded = pcvariant_load_from_binary_stream(rws);
+    ASSERT_EQ(loaded, PURC_VARIANT_INVALID);
+    purc_rwstream_destroy(rws);
+
+    purc_cleanup ();
+}
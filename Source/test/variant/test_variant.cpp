@@ -65,6 +65,9 @@ TEST(variant, pcvariant_init_once)
     EXPECT_EQ (stat->sz_total_mem, 4 * size);
     EXPECT_EQ (stat->nr_reserved, 0);
     EXPECT_EQ (stat->nr_max_reserved, MAX_RESERVED_VARIANTS);
+    EXPECT_EQ (stat->nr_reserved_nodes, 0);
+    EXPECT_EQ (stat->sz_reserved_nodes, 0);
+    EXPECT_EQ (stat->nr_max_reserved_nodes, MAX_RESERVED_NODES);
 
 
     cleanup = purc_cleanup ();
@@ -1506,6 +1509,46 @@ TEST(variant, empty_object)
     purc_cleanup ();
 }
 
+TEST(variant, reserved_nodes)
+{
+    purc_instance_extra_info info = {};
+
+    int ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsfot.hvml.test", "variant", &info);
+    ASSERT_EQ (ret, PURC_ERROR_OK);
+
+    const struct purc_variant_stat *stat = purc_variant_usage_stat ();
+    ASSERT_NE(stat, nullptr);
+
+    for (int round = 0; round < 2; round++) {
+        purc_variant_t obj = purc_variant_make_object_0();
+        ASSERT_NE(obj, nullptr);
+
+        char key[32];
+        for (int i = 0; i < 64; i++) {
+            snprintf(key, sizeof(key), "key%d", i);
+            purc_variant_t v = purc_variant_make_longint(i);
+            ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, key, v));
+            purc_variant_unref(v);
+        }
+        purc_variant_unref(obj);
+
+        // the freed nodes are kept for reusing, but no more than the limit
+        ASSERT_LE(stat->nr_reserved_nodes,
+                NR_NODE_SIZE_CLASSES * stat->nr_max_reserved_nodes);
+        if (stat->nr_max_reserved_nodes == 0) {
+            ASSERT_EQ(stat->nr_reserved_nodes, 0);
+            ASSERT_EQ(stat->sz_reserved_nodes, 0);
+        }
+        else {
+            ASSERT_GT(stat->nr_reserved_nodes, 0);
+            ASSERT_GE(stat->sz_reserved_nodes,
+                stat->nr_reserved_nodes << NODE_SIZE_CLASS_SHIFT);
+        }
+    }
+
+    purc_cleanup ();
+}
+
 
 TEST(variant, variant_compare)
 {
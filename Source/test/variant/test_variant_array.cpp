@@ -533,3 +533,293 @@ TEST(variant_array, sort)
     ASSERT_STREQ(inbuf, outbuf);
 }
 
+
+TEST(variant_array, insert_remove_in_middle)
+{
+    purc_instance_extra_info info = {};
+    int ret = 0;
+    bool cleanup = false;
+
+    ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    // prepend and insert enough members to grow the storage a few times
+    const int count = 100;
+    for (int i = 0; i < count; i += 2) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_array_append(arr, v));
+        purc_variant_unref(v);
+    }
+    for (int i = 1; i < count; i += 2) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_array_insert_before(arr, i, v));
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_array_get_size(arr), count);
+
+    purc_variant_t val;
+    size_t idx;
+    foreach_value_in_variant_array(arr, val, idx)
+        int64_t i64;
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &i64, false));
+        ASSERT_EQ(i64, (int64_t)idx);
+    end_foreach;
+
+    // remove the odd members from the tail
+    foreach_value_in_variant_array_reverse_safe(arr, val, idx)
+        if (idx % 2) {
+            ASSERT_TRUE(purc_variant_array_remove(arr, idx));
+        }
+    end_foreach;
+    ASSERT_EQ(purc_variant_array_get_size(arr), count / 2);
+
+    for (int i = 0; i < count / 2; i++) {
+        int64_t i64;
+        val = purc_variant_array_get(arr, i);
+        ASSERT_NE(val, nullptr);
+        ASSERT_TRUE(purc_variant_cast_to_longint(val, &i64, false));
+        ASSERT_EQ(i64, i * 2);
+    }
+    ASSERT_EQ(purc_variant_array_get(arr, count / 2), nullptr);
+
+    purc_variant_t dup = purc_variant_container_clone(arr);
+    ASSERT_NE(dup, nullptr);
+    ASSERT_EQ(purc_variant_compare_ex(arr, dup, PCVRNT_COMPARE_METHOD_AUTO), 0);
+    ASSERT_TRUE(purc_variant_array_remove(dup, 0));
+    ASSERT_NE(purc_variant_compare_ex(arr, dup, PCVRNT_COMPARE_METHOD_AUTO), 0);
+
+    purc_variant_unref(dup);
+    purc_variant_unref(arr);
+
+    cleanup = purc_cleanup ();
+    ASSERT_EQ (cleanup, true);
+}
+
+TEST(variant_array, clone_on_write)
+{
+    purc_instance_extra_info info = {};
+    int ret = 0;
+    bool cleanup = false;
+
+    ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    purc_variant_t arr = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_NE(arr, nullptr);
+
+    const int count = 10;
+    for (int i = 0; i < count; i++) {
+        purc_variant_t v = purc_variant_make_longint(count - i);
+        ASSERT_TRUE(purc_variant_array_append(arr, v));
+        purc_variant_unref(v);
+    }
+
+    purc_variant_t first = purc_variant_array_get(arr, 0);
+    unsigned int refc = first->refc;
+
+    // the clones share the members until one of them is changed
+    purc_variant_t dup1 = purc_variant_container_clone(arr);
+    purc_variant_t dup2 = purc_variant_container_clone_recursively(arr);
+    ASSERT_NE(dup1, nullptr);
+    ASSERT_NE(dup2, nullptr);
+    ASSERT_TRUE(pcvariant_array_is_shared(arr));
+    ASSERT_TRUE(pcvariant_array_is_shared(dup1));
+    ASSERT_TRUE(pcvariant_array_is_shared(dup2));
+    ASSERT_EQ(first->refc, refc);
+    ASSERT_EQ(purc_variant_array_get(dup1, 0), first);
+    ASSERT_EQ(purc_variant_array_get_size(dup2), (size_t)count);
+
+    ASSERT_TRUE(purc_variant_array_remove(dup1, 0));
+    ASSERT_FALSE(pcvariant_array_is_shared(dup1));
+    ASSERT_TRUE(pcvariant_array_is_shared(arr));
+    ASSERT_EQ(purc_variant_array_get_size(dup1), (size_t)count - 1);
+    ASSERT_EQ(purc_variant_array_get_size(arr), (size_t)count);
+    ASSERT_EQ(purc_variant_array_get(arr, 0), first);
+    ASSERT_EQ(first->refc, refc);
+
+    ASSERT_EQ(pcvariant_array_sort(dup2, NULL, NULL), 0);
+    ASSERT_FALSE(pcvariant_array_is_shared(dup2));
+    ASSERT_FALSE(pcvariant_array_is_shared(arr));
+    ASSERT_EQ(purc_variant_array_get(arr, 0), first);
+    ASSERT_EQ(purc_variant_array_get(dup2, count - 1), first);
+    ASSERT_EQ(first->refc, refc + 1);
+
+    // a container member is never shared by a recursive clone
+    purc_variant_t sub = purc_variant_make_array(0, PURC_VARIANT_INVALID);
+    ASSERT_TRUE(purc_variant_array_append(dup1, sub));
+    purc_variant_unref(sub);
+    purc_variant_t dup3 = purc_variant_container_clone_recursively(dup1);
+    ASSERT_NE(dup3, nullptr);
+    ASSERT_FALSE(pcvariant_array_is_shared(dup1));
+    ASSERT_NE(purc_variant_array_get(dup3, count - 1), sub);
+
+    // releasing the original leaves the members to the other clone
+    purc_variant_t dup4 = purc_variant_container_clone(arr);
+    purc_variant_unref(arr);
+    ASSERT_FALSE(pcvariant_array_is_shared(dup4));
+    ASSERT_EQ(purc_variant_array_get(dup4, 0), first);
+    ASSERT_EQ(first->refc, refc + 1);
+
+    purc_variant_unref(dup4);
+    purc_variant_unref(dup3);
+    purc_variant_unref(dup2);
+    purc_variant_unref(dup1);
+
+    cleanup = purc_cleanup ();
+    ASSERT_EQ (cleanup, true);
+}
+
+static int
+make_k_key(purc_variant_t member, struct pcvrnt_sort_key *keys, void *ud)
+{
+    (void)ud;
+    purc_variant_t k = purc_variant_object_get_by_ckey(member, "k");
+    return pcvariant_make_sort_key(k, true, keys);
+}
+
+static int
+cmp_k_keys(const struct pcvrnt_sort_key *l, const struct pcvrnt_sort_key *r,
+        void *ud)
+{
+    (void)ud;
+    return (l->num > r->num) - (l->num < r->num);
+}
+
+TEST(variant_array, sort_by_keys)
+{
+    purc_instance_extra_info info = {};
+    int ret = 0;
+    bool cleanup = false;
+
+    ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *json = "[{\"k\":2,\"i\":0},{\"k\":1,\"i\":1},"
+        "{\"k\":2,\"i\":2},{\"k\":1,\"i\":3},{\"k\":0,\"i\":4}]";
+    purc_variant_t arr = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(arr, nullptr);
+
+    // the members with equal keys keep their original order
+    ASSERT_EQ(pcvariant_sort_by_keys(arr, 1, NULL, make_k_key, cmp_k_keys), 0);
+    const int order[] = { 4, 1, 3, 0, 2 };
+    for (size_t n = 0; n < PCA_TABLESIZE(order); n++) {
+        purc_variant_t i = purc_variant_object_get_by_ckey(
+                purc_variant_array_get(arr, n), "i");
+        ASSERT_NE(i, nullptr);
+        ASSERT_EQ((int)purc_variant_numerify(i), order[n]);
+    }
+    purc_variant_unref(arr);
+
+    // the default comparison precomputes the string keys
+    json = "[\"b\",\"A\",\"c\",\"a\"]";
+    arr = purc_variant_make_from_json_string(json, strlen(json));
+    ASSERT_NE(arr, nullptr);
+
+    uintptr_t flags = PCVRNT_SORT_DESC | PCVRNT_COMPARE_METHOD_CASELESS;
+    ASSERT_EQ(pcvariant_array_sort(arr, (void *)flags, NULL), 0);
+    const char *strs[] = { "c", "b", "A", "a" };
+    for (size_t n = 0; n < PCA_TABLESIZE(strs); n++) {
+        const char *str = purc_variant_get_string_const(
+                purc_variant_array_get(arr, n));
+        ASSERT_STREQ(str, strs[n]);
+    }
+    purc_variant_unref(arr);
+
+    cleanup = purc_cleanup ();
+    ASSERT_EQ (cleanup, true);
+}
+
+struct grow_counter {
+    size_t          nr_calls;
+    int64_t         last_pos;
+};
+
+static bool
+count_grown(purc_variant_t src, pcvar_op_t op, void *ctxt,
+        size_t nr_args, purc_variant_t *argv)
+{
+    (void)src;
+    (void)op;
+    struct grow_counter *counter = (struct grow_counter *)ctxt;
+    counter->nr_calls++;
+    if (nr_args > 0)
+        purc_variant_cast_to_longint(argv[0], &counter->last_pos, false);
+    return true;
+}
+
+TEST(variant_array, batched_notification)
+{
+    purc_instance_extra_info info = {};
+    int ret = 0;
+    bool cleanup = false;
+
+    ret = purc_init_ex (PURC_MODULE_VARIANT, "cn.fmsoft.hybridos.test",
+            "test_init", &info);
+    ASSERT_EQ(ret, PURC_ERROR_OK);
+
+    const char *json = "[1,2,3,4,5]";
+    purc_variant_t another = purc_variant_make_from_json_string(json,
+            strlen(json));
+    ASSERT_NE(another, nullptr);
+
+    purc_variant_t arr = purc_variant_make_array_0();
+    ASSERT_NE(arr, nullptr);
+
+    // nothing attached: no batch is started
+    pcvariant_begin_batch(arr);
+    ASSERT_TRUE(list_empty(&arr->listeners));
+    pcvariant_end_batch(arr);
+
+    struct grow_counter each = { 0, -1 };
+    struct grow_counter coalesced = { 0, -1 };
+    struct pcvar_listener *l1, *l2;
+    l1 = purc_variant_register_post_listener(arr, PCVAR_OPERATION_GROW,
+            count_grown, &each);
+    l2 = pcvariant_register_coalescing_listener(arr, PCVAR_OPERATION_GROW,
+            count_grown, &coalesced);
+    ASSERT_NE(l1, nullptr);
+    ASSERT_NE(l2, nullptr);
+
+    // out of a batch, every listener is called per member
+    ASSERT_TRUE(purc_variant_array_append(arr, purc_variant_array_get(another, 0)));
+    ASSERT_EQ(each.nr_calls, 1);
+    ASSERT_EQ(coalesced.nr_calls, 1);
+
+    // a bulk operation calls the coalescing listener only once,
+    // with the arguments of the last member
+    ASSERT_TRUE(pcvariant_array_append_another(arr, another, true));
+    ASSERT_EQ(purc_variant_array_get_size(arr), 6);
+    ASSERT_EQ(each.nr_calls, 6);
+    ASSERT_EQ(each.last_pos, 5);
+    ASSERT_EQ(coalesced.nr_calls, 2);
+    ASSERT_EQ(coalesced.last_pos, 5);
+
+    // batches nest
+    pcvariant_begin_batch(arr);
+    pcvariant_begin_batch(arr);
+    ASSERT_TRUE(purc_variant_array_append(arr, another));
+    pcvariant_end_batch(arr);
+    ASSERT_EQ(coalesced.nr_calls, 2);
+    ASSERT_TRUE(purc_variant_array_append(arr, another));
+    pcvariant_end_batch(arr);
+    ASSERT_EQ(each.nr_calls, 8);
+    ASSERT_EQ(coalesced.nr_calls, 3);
+    ASSERT_EQ(coalesced.last_pos, 7);
+
+    ASSERT_TRUE(purc_variant_revoke_listener(arr, l1));
+    ASSERT_TRUE(purc_variant_revoke_listener(arr, l2));
+    ASSERT_TRUE(list_empty(&arr->listeners));
+
+    purc_variant_unref(arr);
+    purc_variant_unref(another);
+
+    cleanup = purc_cleanup ();
+    ASSERT_EQ (cleanup, true);
+}
@@ -467,3 +467,65 @@ TEST(object, compare)
     purc_variant_unref(obj2);
 }
 
+
+TEST(object, hash_index)
+{
+    PurCInstance purc;
+
+    purc_variant_t obj = purc_variant_make_object_0();
+    ASSERT_NE(obj, nullptr);
+
+    // enough properties to build and enlarge the hash index
+    const int count = 100;
+    char key[32];
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        purc_variant_t v = purc_variant_make_longint(i);
+        ASSERT_TRUE(purc_variant_object_set_by_static_ckey(obj, key, v));
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_object_get_size(obj), count);
+
+    for (int i = 0; i < count; i++) {
+        int64_t i64;
+        snprintf(key, sizeof(key), "key%d", i);
+        purc_variant_t v = purc_variant_object_get_by_ckey(obj, key);
+        ASSERT_NE(v, nullptr);
+        ASSERT_TRUE(purc_variant_cast_to_longint(v, &i64, false));
+        ASSERT_EQ(i64, i);
+    }
+    ASSERT_EQ(purc_variant_object_get_by_ckey(obj, "key"), nullptr);
+    purc_clr_error();
+
+    for (int i = 0; i < count; i += 2) {
+        snprintf(key, sizeof(key), "key%d", i);
+        ASSERT_TRUE(purc_variant_object_remove_by_ckey(obj, key, false));
+    }
+    ASSERT_EQ(purc_variant_object_get_size(obj), count / 2);
+
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "key%d", i);
+        purc_variant_t v = purc_variant_object_get_by_ckey(obj, key);
+        if (i % 2) {
+            ASSERT_NE(v, nullptr);
+        }
+        else {
+            ASSERT_EQ(v, nullptr);
+            purc_clr_error();
+        }
+    }
+
+    // properties are still visited in the order of keys
+    const char *prev = NULL;
+    purc_variant_t k, v;
+    foreach_key_value_in_variant_object(obj, k, v)
+        (void)v;
+        const char *sk = purc_variant_get_string_const(k);
+        if (prev) {
+            ASSERT_LT(strcmp(prev, sk), 0);
+        }
+        prev = sk;
+    end_foreach;
+
+    purc_variant_unref(obj);
+}
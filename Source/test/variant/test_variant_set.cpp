@@ -959,6 +959,69 @@ TEST(set, undefined)
     purc_variant_unref(set2);
 }
 
+TEST(set, hash_index)
+{
+    PurCInstance purc;
+
+    const int count = 1000;
+    purc_variant_t set = purc_variant_make_set_by_ckey(0, "id",
+            PURC_VARIANT_INVALID);
+    ASSERT_NE(set, nullptr);
+
+    // insert in an order different from both the numeric and the text order
+    for (int i = 0; i < count; i++) {
+        int64_t id = (i * 337) % count;
+        purc_variant_t v = purc_variant_make_longint(id);
+        purc_variant_t obj = purc_variant_make_object_by_static_ckey(1,
+                "id", v);
+        ASSERT_EQ(purc_variant_set_add(set, obj, PCVRNT_CR_METHOD_COMPLAIN),
+                1);
+        purc_variant_unref(obj);
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_set_get_size(set), (size_t)count);
+
+    // members are unique by the text of the key: "42" equals 42L
+    purc_variant_t k = purc_variant_make_string("42", false);
+    purc_variant_t obj = purc_variant_make_object_by_static_ckey(1, "id", k);
+    ASSERT_EQ(purc_variant_set_add(set, obj, PCVRNT_CR_METHOD_IGNORE), 0);
+    ASSERT_EQ(purc_variant_set_add(set, obj, PCVRNT_CR_METHOD_OVERWRITE), 1);
+    ASSERT_EQ(purc_variant_set_get_size(set), (size_t)count);
+    purc_variant_unref(obj);
+
+    for (int i = 0; i < count; i++) {
+        purc_variant_t v = purc_variant_make_longint(i);
+        purc_variant_t m = purc_variant_set_get_member_by_key_values(set, v);
+        ASSERT_NE(m, nullptr);
+        if (i % 2) {
+            m = purc_variant_set_remove_member_by_key_values(set, v);
+            ASSERT_NE(m, nullptr);
+            purc_variant_unref(m);
+        }
+        purc_variant_unref(v);
+    }
+    ASSERT_EQ(purc_variant_set_get_size(set), (size_t)count / 2);
+    ASSERT_NE(purc_variant_set_get_member_by_key_values(set, k), nullptr);
+    purc_variant_unref(k);
+
+    // traversing in order still sorts the members by the key
+    purc_variant_t prev = PURC_VARIANT_INVALID, v;
+    size_t n = 0;
+    foreach_value_in_variant_set_order(set, v) {
+        if (prev) {
+            ASSERT_LT(purc_variant_compare_ex(
+                        purc_variant_object_get_by_ckey(prev, "id"),
+                        purc_variant_object_get_by_ckey(v, "id"),
+                        PCVRNT_COMPARE_METHOD_CASE), 0);
+        }
+        prev = v;
+        n++;
+    } end_foreach;
+    ASSERT_EQ(n, (size_t)count / 2);
+
+    purc_variant_unref(set);
+}
+
 #define SAFE_FREE(_p)            do {             \
     if (_p) {                                     \
         free(_p);                                 \
@@ -22,6 +22,7 @@
 #include "private/vcm.h"
 
 #include <gtest/gtest.h>
+#include <string>
 
 TEST(vcm, basic)
 {
@@ -341,3 +342,60 @@ TEST(vcm, again_ex)
 
     purc_cleanup();
 }
+
+TEST(vcm, again_large)
+{
+    std::string ejson = "[";
+    for (int i = 0; i < 200; i++) {
+        ejson += std::to_string(i) + ", ";
+    }
+    ejson += "{name:$AGAIN.name}]";
+
+    purc_init_ex(PURC_MODULE_EJSON, "cn.fmsoft.hybridos.test",
+            "vcm_eval", NULL);
+
+    purc_rwstream_t rws = purc_rwstream_new_from_mem((void*)ejson.c_str(),
+            ejson.length());
+    ASSERT_NE(rws, nullptr);
+
+    struct purc_ejson_parsing_tree *tree = purc_variant_ejson_parse_stream(rws);
+    ASSERT_NE(tree, nullptr);
+
+    purc_variant_t nv = vcm_again_variant_create();
+    ASSERT_NE(nv, nullptr);
+
+    /* the second round evaluates with the plan cached by the first one */
+    for (int round = 0; round < 2; round++) {
+        struct pcvcm_eval_ctxt *ctxt = NULL;
+        purc_variant_t v = pcvcm_eval_ex((struct pcvcm_node*)tree, &ctxt,
+                find_var, nv, false);
+        ASSERT_EQ(v, PURC_VARIANT_INVALID);
+        ASSERT_NE(ctxt, nullptr);
+        ASSERT_EQ(purc_get_last_error(), PURC_ERROR_AGAIN);
+
+        v =  pcvcm_eval_again_ex((struct pcvcm_node *)tree,
+            ctxt, find_var, nv, false, false);
+        ASSERT_NE(v, PURC_VARIANT_INVALID);
+        ASSERT_EQ(purc_variant_get_type(v), PURC_VARIANT_TYPE_ARRAY);
+        ASSERT_EQ(purc_variant_array_get_size(v), 201);
+
+        purc_variant_t last = purc_variant_array_get(v, 200);
+        purc_variant_t name = purc_variant_object_get_by_ckey(last, "name");
+        ASSERT_NE(name, PURC_VARIANT_INVALID);
+        ASSERT_STREQ(purc_variant_get_string_const(name), VCM_AGAIN_NAME);
+
+        double d = 0;
+        ASSERT_TRUE(purc_variant_cast_to_number(purc_variant_array_get(v, 199),
+                    &d, false));
+        ASSERT_EQ(d, 199);
+
+        pcvcm_eval_ctxt_destroy(ctxt);
+        purc_variant_unref(v);
+    }
+
+    purc_variant_unref(nv);
+    purc_ejson_parsing_tree_destroy(tree);
+    purc_rwstream_destroy(rws);
+
+    purc_cleanup();
+}